@@ -552,6 +552,11 @@ std::string SoapySDRPlay::getAntenna(const int direction, const size_t channel)
         return "";
     }
 
+    return getRxAntennaLocked(channel);
+}
+
+std::string SoapySDRPlay::getRxAntennaLocked(const size_t channel) const
+{
     if (device.hwVer == SDRPLAY_RSP2_ID)
     {
         if (chParams->rsp2TunerParams.amPortSel == sdrplay_api_Rsp2_AMPORT_1) {
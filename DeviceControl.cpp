@@ -25,6 +25,7 @@
  */
 
 #include "SoapySDRPlay.hpp"
+#include "MetricsExporter.hpp"
 #include <exception>
 #include <future>
 
@@ -217,6 +218,9 @@ SoapySDRPlay::SoapySDRPlay(const SoapySDR::Kwargs &args)
     rf_changed = 0;
     fs_changed = 0;
     useShort = true;
+    hybridTuning = false;
+    ncoOffsetHz = 0.0;
+    ncoPhaseIncrement = 0.0;
     bufferLength = bufferElems * elementsPerSample;
     cachedBufferThreshold = bufferLength.load();  // Initially no decimation
 
@@ -235,6 +239,9 @@ SoapySDRPlay::SoapySDRPlay(const SoapySDR::Kwargs &args)
     // RAII guard ensures device is released if anything below throws
     DeviceSelectionGuard guard(this);
 
+    metrics.reset(DeviceMetrics::create(serial, METRICS_ROLE_DRIVER, getHardwareKey()));
+    MetricsExporter::instance().startFromEnvironment();
+
     if (!antenna.empty())
     {
         setAntenna(SOAPY_SDR_RX, 0, antenna);
@@ -275,6 +282,8 @@ SoapySDRPlay::SoapySDRPlay(const SoapySDR::Kwargs &args)
 SoapySDRPlay::~SoapySDRPlay(void)
 {
     SoapySDRPlay_releaseSerial(cacheKey);
+    stopSweep();
+    stopTimedCommands();
     std::lock_guard <std::mutex> lock(_general_state_mutex);
 
     try
@@ -0,0 +1,327 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - Shared per-device metrics
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "DeviceMetrics.hpp"
+#include <SoapySDR/Logger.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <new>
+#include <set>
+
+static const char* const METRICS_PREFIX = "sdrplay_m_";
+
+// Pages published by this process
+static std::mutex& publishedMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::set<std::string>& publishedNames()
+{
+    static std::set<std::string> names;
+    return names;
+}
+
+// Pages created by this process, for forEach() (publishedMutex)
+static std::set<const DeviceMetrics*>& localPages()
+{
+    static std::set<const DeviceMetrics*> pages;
+    return pages;
+}
+
+const char* metricsUpdateTypeName(size_t type)
+{
+    switch (type)
+    {
+    case METRICS_UPDATE_FREQUENCY:   return "frequency";
+    case METRICS_UPDATE_GAIN:        return "gain";
+    case METRICS_UPDATE_AGC:         return "agc";
+    case METRICS_UPDATE_SAMPLE_RATE: return "sample_rate";
+    case METRICS_UPDATE_BANDWIDTH:   return "bandwidth";
+    case METRICS_UPDATE_PPM:         return "ppm";
+    default:                         return "other";
+    }
+}
+
+uint64_t MetricsHistogram::quantileUs(const uint64_t* counts, double quantile)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++)
+    {
+        total += counts[i];
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    const double target = std::min(std::max(quantile, 0.0), 1.0) * static_cast<double>(total);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++)
+    {
+        seen += counts[i];
+        if (counts[i] != 0 && static_cast<double>(seen) >= target)
+        {
+            return 1ULL << i;
+        }
+    }
+    return 1ULL << (METRICS_HISTOGRAM_BUCKETS - 1);
+}
+
+uint64_t MetricsHistogram::quantileUs(double quantile) const
+{
+    uint64_t counts[METRICS_HISTOGRAM_BUCKETS];
+    for (size_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++)
+    {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+    }
+    return quantileUs(counts, quantile);
+}
+
+int64_t DeviceMetrics::nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+std::string DeviceMetrics::pageName(const std::string& serial, pid_t pid)
+{
+    // Short enough for the 31 character limit of macOS shm names
+    return "/" + std::string(METRICS_PREFIX) + serial + "_" + std::to_string(pid);
+}
+
+DeviceMetrics::DeviceMetrics(const std::string& name, DeviceMetricsPage* page, size_t mappingSize,
+                             bool owner, bool local)
+    : name_(name)
+    , page_(page)
+    , mappingSize_(mappingSize)
+    , owner_(owner)
+    , local_(local)
+{
+    if (local_)
+    {
+        std::lock_guard<std::mutex> lock(publishedMutex());
+        localPages().insert(this);
+    }
+}
+
+static void initPage(DeviceMetricsPage* page, const std::string& serial, uint32_t role,
+                     const std::string& hardwareKey)
+{
+    // New pages are zero-filled, which is the initial value of every counter
+    page->version = METRICS_VERSION;
+    page->size = sizeof(DeviceMetricsPage);
+    page->role = role;
+    page->pid = static_cast<int32_t>(getpid());
+    std::strncpy(page->serial, serial.c_str(), METRICS_SERIAL_LEN - 1);
+    std::strncpy(page->hardwareKey, hardwareKey.c_str(), METRICS_SERIAL_LEN - 1);
+    page->startNs = DeviceMetrics::nowNs();
+    page->magic.store(METRICS_MAGIC, std::memory_order_release);
+}
+
+DeviceMetrics* DeviceMetrics::create(const std::string& serial, uint32_t role, const std::string& hardwareKey)
+{
+    const char* env = std::getenv("SOAPY_SDRPLAY_METRICS");
+    const bool publish = env == nullptr || (std::strcmp(env, "0") != 0 && std::strcmp(env, "off") != 0);
+
+    if (publish)
+    {
+        const std::string name = pageName(serial, getpid());
+        const size_t size = sizeof(DeviceMetricsPage);
+
+        // A page of the same name was left behind by an earlier process
+        // with our pid (pids are reused), or is used by another instance
+        // in this process, which then keeps its metrics private
+        int fd = -1;
+        {
+            std::lock_guard<std::mutex> lock(publishedMutex());
+            if (publishedNames().insert(name).second)
+            {
+                fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_EXCL, 0644);
+                if (fd < 0 && errno == EEXIST)
+                {
+                    shm_unlink(name.c_str());
+                    fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_EXCL, 0644);
+                }
+                if (fd < 0)
+                {
+                    publishedNames().erase(name);
+                }
+            }
+            else
+            {
+                errno = EEXIST;
+            }
+        }
+
+        if (fd >= 0)
+        {
+            void* mapping = MAP_FAILED;
+            if (ftruncate(fd, size) == 0)
+            {
+                mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            close(fd);
+            if (mapping != MAP_FAILED)
+            {
+                auto* page = new (mapping) DeviceMetricsPage;
+                initPage(page, serial, role, hardwareKey);
+                return new DeviceMetrics(name, page, size, true, true);
+            }
+            shm_unlink(name.c_str());
+            std::lock_guard<std::mutex> lock(publishedMutex());
+            publishedNames().erase(name);
+        }
+        SoapySDR_logf(SOAPY_SDR_DEBUG, "DeviceMetrics: Cannot publish %s: %s, keeping metrics private",
+                     name.c_str(), strerror(errno));
+    }
+
+    // Private page: anonymous memory is zero-filled like a new shm page
+    const size_t size = sizeof(DeviceMetricsPage);
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+    auto* page = new (mapping) DeviceMetricsPage;
+    initPage(page, serial, role, hardwareKey);
+    return new DeviceMetrics("", page, size, false, true);
+}
+
+DeviceMetrics* DeviceMetrics::open(const std::string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(DeviceMetricsPage))
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    const size_t size = sizeof(DeviceMetricsPage);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    auto* page = static_cast<DeviceMetricsPage*>(mapping);
+    if (page->magic.load(std::memory_order_acquire) != METRICS_MAGIC ||
+        page->version != METRICS_VERSION || page->size != size)
+    {
+        munmap(mapping, size);
+        return nullptr;
+    }
+    return new DeviceMetrics(name, page, size, false, false);
+}
+
+std::vector<std::string> DeviceMetrics::list()
+{
+    std::vector<std::string> names;
+#ifdef __linux__
+    DIR* dir = opendir("/dev/shm");
+    if (dir == nullptr)
+    {
+        return names;
+    }
+    const size_t prefixLen = std::strlen(METRICS_PREFIX);
+    while (struct dirent* entry = readdir(dir))
+    {
+        if (std::strncmp(entry->d_name, METRICS_PREFIX, prefixLen) == 0)
+        {
+            names.push_back("/" + std::string(entry->d_name));
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+#endif
+    return names;
+}
+
+bool DeviceMetrics::ownerAlive() const
+{
+    return kill(page_->pid, 0) == 0 || errno == EPERM;
+}
+
+void DeviceMetrics::forEach(const std::function<void(const DeviceMetrics&)>& fn)
+{
+    std::lock_guard<std::mutex> lock(publishedMutex());
+    for (const DeviceMetrics* metrics : localPages())
+    {
+        fn(*metrics);
+    }
+}
+
+DeviceMetrics::~DeviceMetrics()
+{
+    {
+        std::lock_guard<std::mutex> lock(publishedMutex());
+        localPages().erase(this);
+        if (owner_)
+        {
+            shm_unlink(name_.c_str());
+            publishedNames().erase(name_);
+        }
+    }
+    munmap(page_, mappingSize_);
+}
+
+void DeviceMetrics::recordUpdate(MetricsUpdateType type, int64_t ns, bool ok)
+{
+    // Not on the streaming path: skipped updates race with the one in
+    // progress, so use read-modify-write here
+    UpdateMetrics& update = page_->updates[type < METRICS_UPDATE_TYPES ? type : METRICS_UPDATE_OTHER];
+    if (!ok)
+    {
+        update.failures.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    update.count.fetch_add(1, std::memory_order_relaxed);
+    update.totalNs.fetch_add(static_cast<uint64_t>(ns), std::memory_order_relaxed);
+    update.lastNs.store(ns, std::memory_order_relaxed);
+    int64_t max = update.maxNs.load(std::memory_order_relaxed);
+    while (ns > max && !update.maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+    {
+    }
+    update.histogram.buckets[MetricsHistogram::bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,253 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - Shared per-device metrics
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+// Runtime metrics of one device in one process, published in a small POSIX
+// shared memory page ("/sdrplay_m_<serial>_<pid>") so that external tools
+// can watch a receiver without attaching to the process using it.
+//
+// The layout is fixed and versioned. Every field has a single writer, so
+// the hot path updates counters with relaxed loads and stores instead of
+// locked read-modify-write instructions; readers see each field atomically
+// but not a consistent snapshot across fields.
+
+constexpr uint32_t METRICS_MAGIC   = 0x4d525053;  // "SPRM"
+constexpr uint32_t METRICS_VERSION = 1;
+
+constexpr size_t METRICS_MAX_CHANNELS      = 2;
+constexpr size_t METRICS_HISTOGRAM_BUCKETS = 32;
+constexpr size_t METRICS_SERIAL_LEN        = 32;
+
+// Process publishing the page
+constexpr uint32_t METRICS_ROLE_DRIVER = 1;  // SoapySDRPlay (in-process or in a worker)
+constexpr uint32_t METRICS_ROLE_PROXY  = 2;  // SoapySDRPlayProxy reading a worker's rings
+
+// sdrplay_api_Update() calls grouped by what they change
+enum MetricsUpdateType
+{
+    METRICS_UPDATE_FREQUENCY,
+    METRICS_UPDATE_GAIN,
+    METRICS_UPDATE_AGC,
+    METRICS_UPDATE_SAMPLE_RATE,
+    METRICS_UPDATE_BANDWIDTH,
+    METRICS_UPDATE_PPM,
+    METRICS_UPDATE_OTHER,
+    METRICS_UPDATE_TYPES
+};
+
+const char* metricsUpdateTypeName(size_t type);
+
+// Add to a counter that only one thread writes
+inline void metricsAdd(std::atomic<uint64_t>& counter, uint64_t n)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// Log2 histogram of durations: bucket 0 counts values below 1 us, bucket
+// i >= 1 values in [2^(i-1), 2^i) us; the last bucket is open-ended
+struct MetricsHistogram
+{
+    std::atomic<uint64_t> buckets[METRICS_HISTOGRAM_BUCKETS];
+
+    static size_t bucketOf(int64_t ns)
+    {
+        uint64_t us = ns > 0 ? static_cast<uint64_t>(ns) / 1000 : 0;
+        size_t bucket = 0;
+        while (us != 0 && bucket < METRICS_HISTOGRAM_BUCKETS - 1)
+        {
+            us >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    // Single writer
+    void record(int64_t ns) { metricsAdd(buckets[bucketOf(ns)], 1); }
+
+    // Upper bound in us of the bucket holding the given quantile (0..1)
+    // of the counts; 0 if empty
+    static uint64_t quantileUs(const uint64_t* counts, double quantile);
+    uint64_t quantileUs(double quantile) const;
+};
+
+// Per channel (tuner); callback fields are written by the API callback
+// thread, reader fields by the thread reading the stream
+struct alignas(64) ChannelMetrics
+{
+    // Callback thread
+    std::atomic<uint64_t> callbacks;
+    std::atomic<uint64_t> samples;            // Samples received from the API
+    std::atomic<uint64_t> gaps;               // firstSampleNum discontinuities
+    std::atomic<uint64_t> gapSamples;         // Samples missing at those
+    std::atomic<int64_t> lastCallbackNs;      // CLOCK_MONOTONIC, 0 before the first callback
+    std::atomic<int64_t> intervalMeanNs;      // Smoothed inter-callback interval
+    std::atomic<int64_t> jitterNs;            // Smoothed deviation from the mean interval
+    std::atomic<int64_t> intervalMaxNs;
+    MetricsHistogram intervalHistogram;
+
+    // Reader thread
+    std::atomic<uint64_t> samplesDelivered;   // Samples handed to the application
+    std::atomic<uint64_t> overflows;          // Overflows reported to the application
+
+    // Writers of the queue hold the stream lock
+    std::atomic<uint32_t> queueDepth;         // Buffers (driver) or samples (proxy) waiting
+    std::atomic<uint32_t> queueCapacity;
+
+    // Health check thread
+    std::atomic<uint64_t> callbackRateMilliHz;
+
+    // Called from the API callback with the time it was entered; the
+    // smoothing follows the RFC 3550 interarrival jitter estimate
+    void recordCallback(int64_t nowNs, unsigned int numSamples)
+    {
+        metricsAdd(callbacks, 1);
+        metricsAdd(samples, numSamples);
+        const int64_t last = lastCallbackNs.load(std::memory_order_relaxed);
+        lastCallbackNs.store(nowNs, std::memory_order_relaxed);
+        if (last == 0)
+        {
+            return;
+        }
+
+        const int64_t interval = nowNs - last;
+        int64_t mean = intervalMeanNs.load(std::memory_order_relaxed);
+        mean = mean == 0 ? interval : mean + (interval - mean) / 16;
+        intervalMeanNs.store(mean, std::memory_order_relaxed);
+        const int64_t deviation = interval > mean ? interval - mean : mean - interval;
+        const int64_t jitter = jitterNs.load(std::memory_order_relaxed);
+        jitterNs.store(jitter + (deviation - jitter) / 16, std::memory_order_relaxed);
+        if (interval > intervalMaxNs.load(std::memory_order_relaxed))
+        {
+            intervalMaxNs.store(interval, std::memory_order_relaxed);
+        }
+        intervalHistogram.record(interval);
+    }
+
+    void recordGap(uint64_t lostSamples)
+    {
+        metricsAdd(gaps, 1);
+        metricsAdd(gapSamples, lostSamples);
+    }
+};
+
+// sdrplay_api_Update() latency of one update type, from the call until the
+// callback confirmed the change (or the wait timed out)
+struct UpdateMetrics
+{
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> failures;   // Skipped under contention or rejected by the API
+    std::atomic<uint64_t> totalNs;
+    std::atomic<int64_t> lastNs;
+    std::atomic<int64_t> maxNs;
+    MetricsHistogram histogram;
+};
+
+struct DeviceMetricsPage
+{
+    // Identification, written once before magic is published
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t size;                    // sizeof(DeviceMetricsPage) of the writer
+    uint32_t role;                    // METRICS_ROLE_*
+    int32_t pid;
+    char serial[METRICS_SERIAL_LEN];
+    char hardwareKey[METRICS_SERIAL_LEN];
+    int64_t startNs;                  // CLOCK_MONOTONIC at creation
+
+    // Configuration
+    std::atomic<uint32_t> sampleRate;
+    std::atomic<uint32_t> numChannels;
+    std::atomic<uint32_t> streaming;
+    std::atomic<uint32_t> healthStatus;   // DeviceHealthStatus (driver)
+
+    // Recovery
+    std::atomic<uint64_t> recoveryAttempts;      // Driver watchdog
+    std::atomic<uint64_t> successfulRecoveries;
+    std::atomic<uint64_t> workerRestarts;        // Proxy
+    std::atomic<int64_t> lastRecoveryNs;
+
+    // Serialised by the driver's API update mutex
+    UpdateMetrics updates[METRICS_UPDATE_TYPES];
+
+    ChannelMetrics channels[METRICS_MAX_CHANNELS];
+};
+
+class DeviceMetrics
+{
+public:
+    // Publish a page for this process and device. Falls back to a page in
+    // private memory (never null) if shared memory is unavailable or
+    // disabled with SOAPY_SDRPLAY_METRICS=0, so writers need no checks.
+    static DeviceMetrics* create(const std::string& serial, uint32_t role,
+                                 const std::string& hardwareKey = "");
+
+    // Map a page published by another process (read-only); null if the
+    // name does not hold a metrics page of this version
+    static DeviceMetrics* open(const std::string& name);
+
+    // Names of the pages currently published on this host (Linux only)
+    static std::vector<std::string> list();
+
+    // Call fn for every page created in this process (shared or private),
+    // holding a lock that only creation and destruction of pages also take
+    static void forEach(const std::function<void(const DeviceMetrics&)>& fn);
+
+    // True if the process that published the page is still running
+    bool ownerAlive() const;
+
+    ~DeviceMetrics();
+
+    DeviceMetricsPage* page() { return page_; }
+    const DeviceMetricsPage* page() const { return page_; }
+    ChannelMetrics& channel(size_t channel) { return page_->channels[channel < METRICS_MAX_CHANNELS ? channel : 0]; }
+
+    // Shared memory name, empty for a private page
+    const std::string& name() const { return name_; }
+
+    // Record one sdrplay_api_Update() call that took ns
+    void recordUpdate(MetricsUpdateType type, int64_t ns, bool ok);
+
+    // CLOCK_MONOTONIC in ns, comparable across processes
+    static int64_t nowNs();
+
+    static std::string pageName(const std::string& serial, pid_t pid);
+
+private:
+    DeviceMetrics(const std::string& name, DeviceMetricsPage* page, size_t mappingSize,
+                  bool owner, bool local);
+
+    std::string name_;
+    DeviceMetricsPage* page_;
+    size_t mappingSize_;
+    bool owner_;   // Unlinks the shared memory name
+    bool local_;   // Created by this process (listed by forEach())
+};
@@ -0,0 +1,466 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - Persistent enumeration cache
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "EnumerationCache.hpp"
+#include <SoapySDR/Logger.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#endif
+
+static const char* CACHE_FORMAT = "SoapySDRPlay enumeration cache 1";
+
+// USB vendor ID of all SDRplay receivers
+static const char* SDRPLAY_USB_VENDOR = "1df7";
+
+constexpr const char* EnumerationCache::DEFAULT_NAME;
+
+static std::string readFirstLine(const std::string& path)
+{
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+std::string EnumerationCache::defaultPath()
+{
+    const char* env = std::getenv("SOAPY_SDRPLAY_ENUM_CACHE");
+    if (env == nullptr || env[0] == '\0')
+    {
+        // only the user can create files in the runtime directory; the
+        // /tmp fallback is per user and checked on load
+        const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+        struct stat st;
+        if (runtimeDir != nullptr && runtimeDir[0] == '/' &&
+            stat(runtimeDir, &st) == 0 && S_ISDIR(st.st_mode))
+        {
+            return std::string(runtimeDir) + "/" + DEFAULT_NAME;
+        }
+        return "/tmp/soapy_sdrplay_enum." + std::to_string(getuid()) + ".cache";
+    }
+    const std::string val(env);
+    if (val == "0" || val == "off" || val == "false" || val == "no")
+    {
+        return "";
+    }
+    return val;
+}
+
+EnumerationCache::EnumerationCache(const std::string& path)
+    : path_(path)
+{
+}
+
+std::string EnumerationCache::serviceInstance()
+{
+#ifdef __linux__
+    // pid plus start time identifies one run of sdrplay_apiService
+    DIR* proc = opendir("/proc");
+    if (proc == nullptr)
+    {
+        return "none";
+    }
+    std::string instance = "none";
+    struct dirent* entry;
+    while ((entry = readdir(proc)) != nullptr)
+    {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9')
+        {
+            continue;
+        }
+        const std::string dir = std::string("/proc/") + entry->d_name;
+        // comm is truncated to 15 characters
+        if (readFirstLine(dir + "/comm").compare(0, 15, "sdrplay_apiServ") != 0)
+        {
+            continue;
+        }
+        // Field 22 of stat is the start time; skip past "(comm)" first
+        const std::string stat = readFirstLine(dir + "/stat");
+        const size_t commEnd = stat.rfind(')');
+        if (commEnd == std::string::npos)
+        {
+            continue;
+        }
+        std::istringstream fields(stat.substr(commEnd + 2));
+        std::string field;
+        for (int i = 3; i <= 22; i++)
+        {
+            fields >> field;
+        }
+        instance = std::string(entry->d_name) + ":" + field;
+        break;
+    }
+    closedir(proc);
+    return instance;
+#else
+    return "none";
+#endif
+}
+
+std::vector<std::string> EnumerationCache::usbDevices()
+{
+    std::vector<std::string> devices;
+#ifdef __linux__
+    const std::string base = "/sys/bus/usb/devices/";
+    DIR* dir = opendir(base.c_str());
+    if (dir == nullptr)
+    {
+        return devices;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        if (entry->d_name[0] == '.' || std::strchr(entry->d_name, ':') != nullptr)
+        {
+            continue;  // interfaces carry no idVendor
+        }
+        const std::string dev = base + entry->d_name;
+        if (readFirstLine(dev + "/idVendor") != SDRPLAY_USB_VENDOR)
+        {
+            continue;
+        }
+        // devnum changes on every re-plug, so a replaced receiver is noticed
+        devices.push_back(std::string(entry->d_name) + ":" + readFirstLine(dev + "/busnum") +
+                          ":" + readFirstLine(dev + "/devnum"));
+    }
+    closedir(dir);
+    std::sort(devices.begin(), devices.end());
+#endif
+    return devices;
+}
+
+std::string EnumerationCache::validityKey()
+{
+    std::string usb;
+    for (const auto& dev : usbDevices())
+    {
+        usb += (usb.empty() ? "" : ",") + dev;
+    }
+    return "service=" + serviceInstance() + " usb=" + usb;
+}
+
+bool EnumerationCache::load(DeviceMap& devices) const
+{
+#ifdef __linux__
+    if (!enabled())
+    {
+        return false;
+    }
+
+    // The file decides which devices are listed: only trust one that
+    // nobody but its owner (this user or root) can have written
+    const int fd = open(path_.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        (st.st_uid != getuid() && st.st_uid != 0) ||
+        (st.st_mode & (S_IWGRP | S_IWOTH)) != 0)
+    {
+        SoapySDR_logf(SOAPY_SDR_WARNING, "EnumerationCache: Ignoring %s (not a private file of this user)",
+                     path_.c_str());
+        close(fd);
+        return false;
+    }
+    std::string contents;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+    {
+        contents.append(buf, static_cast<size_t>(n));
+    }
+    close(fd);
+    if (n < 0)
+    {
+        return false;
+    }
+
+    std::istringstream in(contents);
+    std::string line;
+    if (!std::getline(in, line) || line != CACHE_FORMAT)
+    {
+        return false;
+    }
+    if (!std::getline(in, line) || line != validityKey())
+    {
+        SoapySDR_log(SOAPY_SDR_DEBUG, "EnumerationCache: Stale cache (service or USB devices changed)");
+        return false;
+    }
+
+    // One device per line: key, then key=value pairs, tab separated
+    DeviceMap loaded;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string key;
+        std::string field;
+        if (!std::getline(fields, key, '\t') || key.empty())
+        {
+            continue;
+        }
+        SoapySDR::Kwargs dev;
+        while (std::getline(fields, field, '\t'))
+        {
+            const size_t eq = field.find('=');
+            if (eq != std::string::npos)
+            {
+                dev[field.substr(0, eq)] = field.substr(eq + 1);
+            }
+        }
+        loaded[key] = dev;
+    }
+    devices.swap(loaded);
+    return true;
+#else
+    // Without hotplug notifications the cache could silently go stale
+    (void)devices;
+    return false;
+#endif
+}
+
+bool EnumerationCache::store(const DeviceMap& devices) const
+{
+#ifdef __linux__
+    if (!enabled())
+    {
+        return false;
+    }
+
+    std::vector<std::string> serials;
+    for (const auto& kv : devices)
+    {
+        auto it = kv.second.find("serial");
+        if (it != kv.second.end() &&
+            std::find(serials.begin(), serials.end(), it->second) == serials.end())
+        {
+            serials.push_back(it->second);
+        }
+    }
+    if (serials.size() < usbDevices().size())
+    {
+        SoapySDR_log(SOAPY_SDR_DEBUG, "EnumerationCache: Incomplete enumeration not cached");
+        return false;
+    }
+
+    std::ostringstream out;
+    out << CACHE_FORMAT << "\n" << validityKey() << "\n";
+    for (const auto& kv : devices)
+    {
+        out << kv.first;
+        for (const auto& arg : kv.second)
+        {
+            out << "\t" << arg.first << "=" << arg.second;
+        }
+        out << "\n";
+    }
+    const std::string contents = out.str();
+
+    // Write a private copy and rename it over the cache so readers never
+    // see a partial file. O_EXCL: never write through a file or link
+    // someone else left at the temporary path.
+    const std::string tmpPath = path_ + "." + std::to_string(getpid());
+    unlink(tmpPath.c_str());
+    const int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        return false;
+    }
+    size_t written = 0;
+    while (written < contents.size())
+    {
+        const ssize_t n = write(fd, contents.data() + written, contents.size() - written);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            break;
+        }
+        written += static_cast<size_t>(n);
+    }
+    close(fd);
+    if (written != contents.size())
+    {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    if (rename(tmpPath.c_str(), path_.c_str()) != 0)
+    {
+        SoapySDR_logf(SOAPY_SDR_DEBUG, "EnumerationCache: Failed to write %s: %s",
+                     path_.c_str(), strerror(errno));
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+#else
+    (void)devices;
+    return false;
+#endif
+}
+
+void EnumerationCache::invalidate() const
+{
+    if (enabled())
+    {
+        unlink(path_.c_str());
+    }
+}
+
+HotplugWatcher& HotplugWatcher::instance()
+{
+    static HotplugWatcher watcher;
+    return watcher;
+}
+
+HotplugWatcher::~HotplugWatcher()
+{
+    if (thread_.joinable())
+    {
+        const uint8_t byte = 0;
+        (void)write(wakeWrite_, &byte, 1);
+        thread_.join();
+    }
+    for (int fd : {socketFd_, wakeRead_, wakeWrite_})
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+}
+
+bool HotplugWatcher::isSdrplayUevent(const char* buf, size_t len)
+{
+    // "<action>@<devpath>" followed by NUL separated KEY=value pairs
+    const std::string header(buf, strnlen(buf, len));
+    if (header.compare(0, 4, "add@") != 0 && header.compare(0, 7, "remove@") != 0)
+    {
+        return false;
+    }
+
+    bool usbDevice = false;
+    bool sdrplay = false;
+    const std::string product = std::string("PRODUCT=") + SDRPLAY_USB_VENDOR + "/";
+    for (size_t pos = header.size() + 1; pos < len;)
+    {
+        const std::string field(buf + pos, strnlen(buf + pos, len - pos));
+        usbDevice |= field == "DEVTYPE=usb_device";
+        sdrplay |= field.compare(0, product.size(), product) == 0;
+        pos += field.size() + 1;
+    }
+    return usbDevice && sdrplay;
+}
+
+void HotplugWatcher::start(std::function<void()> callback)
+{
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_ || socketFd_ >= 0)
+    {
+        return;
+    }
+
+    socketFd_ = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (socketFd_ < 0)
+    {
+        SoapySDR_logf(SOAPY_SDR_DEBUG, "HotplugWatcher: netlink socket failed: %s", strerror(errno));
+        return;
+    }
+    struct sockaddr_nl addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;  // kernel uevents
+    int wakeFds[2];
+    if (bind(socketFd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        pipe2(wakeFds, O_CLOEXEC) != 0)
+    {
+        SoapySDR_logf(SOAPY_SDR_DEBUG, "HotplugWatcher: setup failed: %s", strerror(errno));
+        close(socketFd_);
+        socketFd_ = -1;
+        return;
+    }
+    wakeRead_ = wakeFds[0];
+    wakeWrite_ = wakeFds[1];
+
+    callback_ = callback;
+    running_ = true;
+    thread_ = std::thread(&HotplugWatcher::run, this);
+    SoapySDR_log(SOAPY_SDR_DEBUG, "HotplugWatcher: Watching for SDRplay USB hotplug");
+#else
+    (void)callback;
+#endif
+}
+
+void HotplugWatcher::run()
+{
+    char buf[8192];
+    struct pollfd fds[2];
+    fds[0].fd = socketFd_;
+    fds[0].events = POLLIN;
+    fds[1].fd = wakeRead_;
+    fds[1].events = POLLIN;
+
+    while (true)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents != 0)
+        {
+            break;
+        }
+        if (fds[0].revents & POLLIN)
+        {
+            const ssize_t len = read(socketFd_, buf, sizeof(buf));
+            if (len > 0 && isSdrplayUevent(buf, static_cast<size_t>(len)))
+            {
+                SoapySDR_log(SOAPY_SDR_INFO, "HotplugWatcher: SDRplay device added or removed");
+                callback_();
+            }
+        }
+    }
+    running_ = false;
+}
@@ -0,0 +1,118 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - Persistent enumeration cache
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <SoapySDR/Types.hpp>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Device enumeration results shared between processes through a small file,
+// so SoapySDR::Device::enumerate() does not have to go through
+// sdrplay_api_Open + GetDevices in every new process.
+//
+// The file records the SDRplay API service instance and the SDRplay USB
+// devices attached when it was written; it is ignored as soon as either
+// changes (service restart, receiver plugged or unplugged). It is private to
+// its owner: a file owned by another user (other than root) or writable by
+// group or others is never loaded.
+class EnumerationCache
+{
+public:
+    // Entries keyed like the in-memory cache: serial, or serial@mode (RSPduo)
+    typedef std::map<std::string, SoapySDR::Kwargs> DeviceMap;
+
+    static constexpr const char* DEFAULT_NAME = "soapy_sdrplay_enum.cache";
+
+    // Path from SOAPY_SDRPLAY_ENUM_CACHE, empty when set to 0/off. By default
+    // DEFAULT_NAME in $XDG_RUNTIME_DIR, or a per-user file in /tmp.
+    static std::string defaultPath();
+
+    explicit EnumerationCache(const std::string& path = defaultPath());
+
+    bool enabled() const { return !path_.empty(); }
+    const std::string& path() const { return path_; }
+
+    // Load the entries if they were recorded for the current service
+    // instance and USB devices
+    bool load(DeviceMap& devices) const;
+
+    // Record a complete enumeration. Skipped if it lists fewer receivers
+    // than are attached (e.g. one is claimed by another process).
+    bool store(const DeviceMap& devices) const;
+
+    void invalidate() const;
+
+    // Identity of the running SDRplay API service ("none" if not found)
+    static std::string serviceInstance();
+
+    // Attached SDRplay USB devices as "<sysfs name>:<busnum>:<devnum>"
+    static std::vector<std::string> usbDevices();
+
+    // Service instance and USB devices combined; a cache file is only valid
+    // while this stays the same
+    static std::string validityKey();
+
+private:
+    std::string path_;
+};
+
+// Watches kernel uevents (netlink) for SDRplay receivers being plugged in or
+// removed. Linux only; elsewhere start() is a no-op.
+class HotplugWatcher
+{
+public:
+    static HotplugWatcher& instance();
+
+    // Start the watcher thread; callback runs on the watcher thread for every
+    // SDRplay USB add/remove event. Later calls keep the first callback.
+    void start(std::function<void()> callback);
+
+    bool running() const { return running_.load(); }
+
+    // True for an add/remove uevent of an SDRplay USB device
+    static bool isSdrplayUevent(const char* buf, size_t len);
+
+private:
+    HotplugWatcher() = default;
+    ~HotplugWatcher();
+    HotplugWatcher(const HotplugWatcher&) = delete;
+    HotplugWatcher& operator=(const HotplugWatcher&) = delete;
+
+    void run();
+
+    std::mutex mutex_;
+    std::function<void()> callback_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    int socketFd_ = -1;
+    int wakeRead_ = -1;
+    int wakeWrite_ = -1;
+};
@@ -25,6 +25,7 @@
  */
 
 #include "SoapySDRPlay.hpp"
+#include <cmath>
 
 /*******************************************************************
  * Frequency API
@@ -45,6 +46,13 @@ void SoapySDRPlay::setFrequency(const int direction,
                                  const double frequency,
                                  const SoapySDR::Kwargs &args)
 {
+   // deferred until the command time when setCommandTime() is active
+   if (direction == SOAPY_SDR_RX && name == "RF" &&
+       queueTimedCommand(TimedCommand::Frequency, channel, name, frequency))
+   {
+      return;
+   }
+
    std::lock_guard <std::mutex> lock(_general_state_mutex);
 
 
@@ -58,6 +66,17 @@ void SoapySDRPlay::setFrequency(const int direction,
             SoapySDR_logf(SOAPY_SDR_WARNING, "RF center frequency out of range - frequency=%lg", frequency);
             return;
          }
+         // hybrid tuning: stay on the current LO and move the NCO instead
+         // as long as the new frequency is inside the usable passband
+         if (hybridTuning && streamActive)
+         {
+            const double offset = frequency - chParams->tunerParams.rfFreq.rfHz;
+            if (std::fabs(offset) <= getHybridTuningMaxOffset())
+            {
+               setNcoOffset(offset);
+               return;
+            }
+         }
          if (chParams->tunerParams.rfFreq.rfHz != (uint32_t)frequency)
          {
             chParams->tunerParams.rfFreq.rfHz = (uint32_t)frequency;
@@ -67,6 +86,7 @@ void SoapySDRPlay::setFrequency(const int direction,
                                 &rf_changed, "Tuner_Frf");
             }
          }
+         setNcoOffset(0.0);
       }
       // can't set ppm for RSPduo slaves
       else if ((name == "CORR") && deviceParams->devParams &&
@@ -94,7 +114,7 @@ double SoapySDRPlay::getFrequency(const int direction, const size_t channel, con
 
     if (name == "RF")
     {
-        return static_cast<double>(chParams->tunerParams.rfFreq.rfHz);
+        return static_cast<double>(chParams->tunerParams.rfFreq.rfHz) + ncoOffsetHz.load();
     }
     else if (name == "CORR")
     {
@@ -145,3 +165,34 @@ SoapySDR::ArgInfoList SoapySDRPlay::getFrequencyArgsInfo(const int direction, co
 
     return freqArgs;
 }
+
+/*******************************************************************
+ * Hybrid tuning helpers
+ ******************************************************************/
+
+// Largest NCO offset (either side of the LO) that still keeps the tuned
+// frequency inside the usable part of the IF passband
+double SoapySDRPlay::getHybridTuningMaxOffset() const
+{
+    double usable = getSampleRate(SOAPY_SDR_RX, 0);
+    const double analogBw = getBwValueFromEnum(chParams->tunerParams.bwType);
+    if (analogBw > 0 && analogBw < usable)
+    {
+        usable = analogBw;
+    }
+    return 0.5 * usable * HYBRID_TUNING_USABLE_FRACTION;
+}
+
+// Set the NCO offset and the phase increment picked up by rx_callback;
+// the mixer shifts the requested frequency down to DC, hence the sign
+void SoapySDRPlay::setNcoOffset(double offsetHz)
+{
+    ncoOffsetHz = offsetHz;
+    if (offsetHz == 0.0)
+    {
+        ncoPhaseIncrement = 0.0;
+        return;
+    }
+    const double fs = getSampleRate(SOAPY_SDR_RX, 0);
+    ncoPhaseIncrement = (fs > 0) ? (-2.0 * M_PI * offsetHz / fs) : 0.0;
+}
@@ -211,6 +211,12 @@ bool SoapySDRPlay::getGainMode(const int direction, const size_t channel) const
 
 void SoapySDRPlay::setGain(const int direction, const size_t channel, const std::string &name, const double value)
 {
+    // deferred until the command time when setCommandTime() is active
+    if (queueTimedCommand(TimedCommand::GainElement, channel, name, value))
+    {
+        return;
+    }
+
     std::lock_guard <std::mutex> lock(_general_state_mutex);
 
    bool doUpdate = false;
@@ -298,6 +304,11 @@ SoapySDR::Range SoapySDRPlay::getGainRange(const int direction, const size_t cha
 
 void SoapySDRPlay::setGain(const int direction, const size_t channel, const double value)
 {
+    if (queueTimedCommand(TimedCommand::Gain, channel, "", value))
+    {
+        return;
+    }
+
     std::lock_guard<std::mutex> lock(_general_state_mutex);
 
     // Map total gain to LNAstate and IFGR using proper gain tables
@@ -23,6 +23,7 @@
  */
 
 #include "SoapySDRPlay.hpp"
+#include "Trace.hpp"
 #include <cstdlib>
 
 /*******************************************************************
@@ -58,6 +59,7 @@ void SoapySDRPlay::updateHealthStatus(DeviceHealthStatus newStatus)
             healthInfo.lastHealthyTime = std::chrono::steady_clock::now();
         }
     }
+    metrics->page()->healthStatus.store(static_cast<uint32_t>(newStatus), std::memory_order_relaxed);
 
     if (oldStatus != newStatus) {
         notifyHealthCallbacks(newStatus);
@@ -102,7 +104,15 @@ void SoapySDRPlay::setWatchdogConfig(const WatchdogConfig& config)
 void SoapySDRPlay::saveCurrentSettings()
 {
     std::lock_guard<std::mutex> cacheLock(settingsCacheMutex);
-    std::lock_guard<std::mutex> stateLock(_general_state_mutex);
+
+    // Called from the watchdog thread, which closeStream() joins while
+    // holding _general_state_mutex: keep the previous settings rather than
+    // block on it
+    std::unique_lock<std::mutex> stateLock(_general_state_mutex, std::try_to_lock);
+    if (!stateLock.owns_lock()) {
+        SoapySDR_log(SOAPY_SDR_DEBUG, "Settings not saved - device state is busy");
+        return;
+    }
 
     // Save frequency settings
     settingsCache.rfFrequencyHz = chParams->tunerParams.rfFreq.rfHz;
@@ -166,7 +176,7 @@ void SoapySDRPlay::saveCurrentSettings()
     }
 
     // Save antenna name
-    settingsCache.antennaName = getAntenna(SOAPY_SDR_RX, 0);
+    settingsCache.antennaName = getRxAntennaLocked(0);
 
     settingsCache.savedAt = std::chrono::steady_clock::now();
     settingsCache.isValid = true;
@@ -286,6 +296,13 @@ void SoapySDRPlay::stopWatchdog()
 void SoapySDRPlay::watchdogThreadFunc()
 {
     SoapySDR_log(SOAPY_SDR_DEBUG, "Watchdog thread running");
+    Tracer::setThreadName("watchdog");
+
+    // Callback counts at the previous healthy check, for the callback rate
+    uint64_t rateCallbacks[2] = {
+        metrics->channel(0).callbacks.load(std::memory_order_relaxed),
+        metrics->channel(1).callbacks.load(std::memory_order_relaxed)};
+    auto rateTime = std::chrono::steady_clock::now();
 
     while (!watchdogShutdown.load())
     {
@@ -302,6 +319,8 @@ void SoapySDRPlay::watchdogThreadFunc()
             continue;
         }
 
+        TraceScope trace("watchdog_check");
+
         // Check each active stream for stale callbacks
         bool anyStale = false;
         {
@@ -313,6 +332,9 @@ void SoapySDRPlay::watchdogThreadFunc()
                 auto* stream = _streams[ch];
                 if (!stream) continue;
 
+                // gaps are only counted on the read paths
+                logSampleGaps(stream);
+
                 uint64_t currentTicks = stream->lastCallbackTicks.load();
 
                 // Check if callbacks have stopped
@@ -352,13 +374,27 @@ void SoapySDRPlay::watchdogThreadFunc()
                 std::lock_guard<std::mutex> lock(healthInfoMutex);
                 // Calculate callback rate from streams
                 uint64_t totalTicks = 0;
+                double totalRate = 0.0;
+                auto now = std::chrono::steady_clock::now();
+                double seconds = std::chrono::duration<double>(now - rateTime).count();
+                rateTime = now;
                 std::lock_guard<std::mutex> slock(_streams_mutex);
                 for (int ch = 0; ch < 2; ch++) {
                     if (_streams[ch]) {
                         totalTicks += _streams[ch]->lastCallbackTicks.load();
+
+                        ChannelMetrics& channelMetrics = metrics->channel(ch);
+                        uint64_t callbacks = channelMetrics.callbacks.load(std::memory_order_relaxed);
+                        double rate = (seconds > 0 && callbacks >= rateCallbacks[ch])
+                            ? (callbacks - rateCallbacks[ch]) / seconds : 0.0;
+                        rateCallbacks[ch] = callbacks;
+                        channelMetrics.callbackRateMilliHz.store(
+                            static_cast<uint64_t>(rate * 1000.0), std::memory_order_relaxed);
+                        totalRate += rate;
                     }
                 }
                 healthInfo.callbackCount = totalTicks;
+                healthInfo.callbackRate = totalRate;
             }
             updateHealthStatus(DeviceHealthStatus::Healthy);
         }
@@ -482,6 +518,13 @@ RecoveryResult SoapySDRPlay::attemptStreamRecovery()
         }
     }
 
+    DeviceMetricsPage* page = metrics->page();
+    page->recoveryAttempts.fetch_add(1, std::memory_order_relaxed);
+    if (result == RecoveryResult::Success) {
+        page->successfulRecoveries.fetch_add(1, std::memory_order_relaxed);
+        page->lastRecoveryNs.store(DeviceMetrics::nowNs(), std::memory_order_relaxed);
+    }
+
     return result;
 }
 
@@ -367,6 +367,14 @@ IPCPipePair* IPCPipePair::create()
     return pair;
 }
 
+IPCPipePair* IPCPipePair::adopt(int toChildFd, int fromChildFd)
+{
+    auto* pair = new IPCPipePair();
+    pair->toChild_.reset(new IPCPipe(toChildFd, true));
+    pair->fromChild_.reset(new IPCPipe(fromChildFd, true));
+    return pair;
+}
+
 IPCPipePair::~IPCPipePair()
 {
     // Unique_ptr will clean up
@@ -46,10 +46,17 @@ enum class IPCMessageType : uint32_t
     CMD_SET_ANTENNA = 9,
     CMD_SET_BANDWIDTH = 10,
     CMD_GET_STATUS = 11,
+    CMD_ASSIGN = 12,        // Bind a warm (pooled) worker to a device and ring buffer
+    CMD_WRITE_SETTING = 13, // Forward writeSetting(key, value)
+    CMD_READ_SETTING = 14,  // Forward readSetting(key), value returned in STATUS_ACK
+
+    // Broker requests (client → sdrplay_broker, over its Unix socket)
+    CMD_BROKER_LIST = 20,   // Enumerated devices, returned in STATUS_ACK
+    CMD_BROKER_LEASE = 21,  // Lease the worker of a device
 
     // Status messages (worker → proxy)
     STATUS_READY = 100,
-    STATUS_OPENED = 101,
+    STATUS_OPENED = 101,    // Carries the DeviceCapabilities snapshot
     STATUS_CONFIGURED = 102,
     STATUS_STARTED = 103,
     STATUS_STOPPED = 104,
@@ -57,6 +64,7 @@ enum class IPCMessageType : uint32_t
     STATUS_OVERFLOW = 106,
     STATUS_STATS = 107,
     STATUS_ACK = 108,
+    STATUS_LEASED = 109,    // Followed by the worker's pipe descriptors (SCM_RIGHTS)
 };
 
 // IPC message structure - simple binary protocol
@@ -151,6 +159,10 @@ public:
     // Returns null on failure
     static IPCPipePair* create();
 
+    // Wrap the parent-side descriptors of a worker spawned elsewhere (a
+    // worker leased from sdrplay_broker); takes ownership of both
+    static IPCPipePair* adopt(int toChildFd, int fromChildFd);
+
     ~IPCPipePair();
 
     // Parent side (proxy process)
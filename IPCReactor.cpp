@@ -0,0 +1,379 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - Shared status reactor for subprocess multi-device support
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "IPCReactor.hpp"
+#include <SoapySDR/Logger.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstring>
+#include <chrono>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+// Same limit as IPCPipe::receive()
+static constexpr uint32_t MAX_MESSAGE_SIZE = 1024 * 1024;
+
+// IPCStatusChannel implementation
+
+bool IPCStatusChannel::waitReply(IPCMessage& msg, unsigned int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]{
+        return !replies_.empty() || closed_;
+    });
+    if (replies_.empty())
+    {
+        return false;
+    }
+    msg = replies_.front();
+    replies_.pop_front();
+    return true;
+}
+
+void IPCStatusChannel::clearReplies()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    replies_.clear();
+}
+
+bool IPCStatusChannel::closed() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closed_;
+}
+
+IPCMessage IPCStatusChannel::lastStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastStats_;
+}
+
+void IPCStatusChannel::deliver(const IPCMessage& msg)
+{
+    // Overflow notices are sent by the worker's streaming loop at any time
+    // and are never a reply to a command
+    if (msg.type == IPCMessageType::STATUS_OVERFLOW)
+    {
+        overflowEvents_++;
+        droppedSamples_ += static_cast<uint64_t>(msg.getParamInt("dropped", 0));
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (msg.type == IPCMessageType::STATUS_STATS)
+    {
+        lastStats_ = msg;
+    }
+    replies_.push_back(msg);
+    cv_.notify_all();
+}
+
+void IPCStatusChannel::markClosed()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    cv_.notify_all();
+}
+
+// IPCReactor implementation
+
+IPCReactor& IPCReactor::instance()
+{
+    static IPCReactor reactor;
+    return reactor;
+}
+
+static void setCloseOnExec(int fd)
+{
+    // Keep the reactor's descriptors out of spawned workers
+    fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
+}
+
+IPCReactor::IPCReactor()
+{
+    int fds[2];
+    if (pipe(fds) == 0)
+    {
+        wakeRead_ = fds[0];
+        wakeWrite_ = fds[1];
+        for (int fd : fds)
+        {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+            setCloseOnExec(fd);
+        }
+    }
+    else
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "IPCReactor: pipe() failed: %s", strerror(errno));
+    }
+
+#ifdef __linux__
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd_ < 0)
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "IPCReactor: epoll_create1() failed: %s", strerror(errno));
+    }
+    else if (wakeRead_ >= 0)
+    {
+        struct epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = wakeRead_;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeRead_, &ev);
+    }
+#endif
+}
+
+IPCReactor::~IPCReactor()
+{
+    shutdown_ = true;
+    wake();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+
+    if (epollFd_ >= 0)
+    {
+        close(epollFd_);
+    }
+    if (wakeRead_ >= 0)
+    {
+        close(wakeRead_);
+    }
+    if (wakeWrite_ >= 0)
+    {
+        close(wakeWrite_);
+    }
+}
+
+std::shared_ptr<IPCStatusChannel> IPCReactor::attach(int fd)
+{
+    auto channel = std::make_shared<IPCStatusChannel>();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+#ifdef __linux__
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "IPCReactor: epoll_ctl(ADD, %d) failed: %s", fd, strerror(errno));
+        return nullptr;
+    }
+#endif
+    channels_[fd] = channel;
+
+    if (!thread_.joinable())
+    {
+        thread_ = std::thread(&IPCReactor::run, this);
+    }
+    else
+    {
+        wake();
+    }
+    return channel;
+}
+
+void IPCReactor::detach(int fd)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    removeLocked(fd);
+    wake();
+}
+
+size_t IPCReactor::channelCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return channels_.size();
+}
+
+void IPCReactor::removeLocked(int fd)
+{
+    if (channels_.erase(fd) == 0)
+    {
+        return;
+    }
+#ifdef __linux__
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+}
+
+void IPCReactor::wake()
+{
+    if (wakeWrite_ >= 0)
+    {
+        const uint8_t byte = 0;
+        (void)write(wakeWrite_, &byte, 1);
+    }
+}
+
+bool IPCReactor::readChannel(int fd, IPCStatusChannel& channel)
+{
+    std::vector<uint8_t>& rx = channel.rxBuffer_;
+    bool open = true;
+
+    uint8_t chunk[4096];
+    while (true)
+    {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n > 0)
+        {
+            rx.insert(rx.end(), chunk, chunk + n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        // EOF (worker exited) or error
+        open = false;
+        break;
+    }
+
+    // Dispatch complete frames; the worker's last messages before it exited
+    // are still delivered
+    size_t pos = 0;
+    while (rx.size() - pos >= 4)
+    {
+        uint32_t len;
+        std::memcpy(&len, &rx[pos], 4);
+        if (len > MAX_MESSAGE_SIZE)
+        {
+            SoapySDR_logf(SOAPY_SDR_ERROR, "IPCReactor: Message too large: %u bytes", len);
+            rx.clear();
+            return false;
+        }
+        if (rx.size() - pos - 4 < len)
+        {
+            break;
+        }
+        std::vector<uint8_t> frame(rx.begin() + pos + 4, rx.begin() + pos + 4 + len);
+        channel.deliver(IPCMessage::deserialize(frame));
+        pos += 4 + len;
+    }
+    rx.erase(rx.begin(), rx.begin() + pos);
+
+    return open;
+}
+
+void IPCReactor::run()
+{
+    std::vector<int> ready;
+
+    while (!shutdown_.load())
+    {
+        ready.clear();
+        bool woken = false;
+
+#ifdef __linux__
+        struct epoll_event events[32];
+        int n = epoll_wait(epollFd_, events, 32, -1);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            SoapySDR_logf(SOAPY_SDR_ERROR, "IPCReactor: epoll_wait() failed: %s", strerror(errno));
+            break;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            if (events[i].data.fd == wakeRead_)
+            {
+                woken = true;
+            }
+            else
+            {
+                ready.push_back(events[i].data.fd);
+            }
+        }
+#else
+        // poll() fallback: rebuild the descriptor set on every wakeup
+        std::vector<struct pollfd> pfds;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pfds.reserve(channels_.size() + 1);
+            pfds.push_back({ wakeRead_, POLLIN, 0 });
+            for (const auto& kv : channels_)
+            {
+                pfds.push_back({ kv.first, POLLIN, 0 });
+            }
+        }
+        int n = poll(pfds.data(), pfds.size(), -1);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            SoapySDR_logf(SOAPY_SDR_ERROR, "IPCReactor: poll() failed: %s", strerror(errno));
+            break;
+        }
+        woken = pfds[0].revents != 0;
+        for (size_t i = 1; i < pfds.size(); i++)
+        {
+            if (pfds[i].revents != 0)
+            {
+                ready.push_back(pfds[i].fd);
+            }
+        }
+#endif
+
+        if (woken)
+        {
+            uint8_t drain[64];
+            while (read(wakeRead_, drain, sizeof(drain)) > 0)
+            {
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int fd : ready)
+        {
+            // Skip descriptors detached since the wait returned
+            auto it = channels_.find(fd);
+            if (it == channels_.end())
+            {
+                continue;
+            }
+            if (!readChannel(fd, *it->second))
+            {
+                it->second->markClosed();
+                removeLocked(fd);
+            }
+        }
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - Shared status reactor for subprocess multi-device support
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include "IPCPipe.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Inbox for one worker's status pipe, filled by the reactor thread.
+// Replies to commands are queued for waitReply(); asynchronous
+// STATUS_OVERFLOW and STATUS_STATS messages are recorded as they arrive.
+class IPCStatusChannel
+{
+public:
+    // Wait for the next reply; false on timeout or once the worker closed
+    // its end of the pipe (exited) and no replies are left
+    bool waitReply(IPCMessage& msg, unsigned int timeoutMs);
+
+    // Drop replies left over from commands that timed out
+    void clearReplies();
+
+    bool closed() const;
+
+    uint64_t overflowEvents() const { return overflowEvents_.load(); }
+    uint64_t droppedSamples() const { return droppedSamples_.load(); }
+
+    // Most recent STATUS_STATS message (type STATUS_ACK if none yet)
+    IPCMessage lastStats() const;
+
+private:
+    friend class IPCReactor;
+
+    void deliver(const IPCMessage& msg);
+    void markClosed();
+
+    // Bytes read but not yet forming a complete frame (reactor thread only)
+    std::vector<uint8_t> rxBuffer_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<IPCMessage> replies_;
+    IPCMessage lastStats_;
+    bool closed_ = false;
+
+    std::atomic<uint64_t> overflowEvents_{0};
+    std::atomic<uint64_t> droppedSamples_{0};
+};
+
+// Per-process event loop owning the status pipes of all proxied workers.
+// One thread serves every device: epoll on Linux, poll() elsewhere.
+class IPCReactor
+{
+public:
+    static IPCReactor& instance();
+
+    // Start dispatching messages from fd (the read end of a status pipe).
+    // The caller keeps ownership of fd and must detach() before closing it.
+    std::shared_ptr<IPCStatusChannel> attach(int fd);
+    void detach(int fd);
+
+    size_t channelCount() const;
+
+private:
+    IPCReactor();
+    ~IPCReactor();
+    IPCReactor(const IPCReactor&) = delete;
+    IPCReactor& operator=(const IPCReactor&) = delete;
+
+    void run();
+    void wake();
+
+    // Read all available bytes and dispatch complete frames;
+    // returns false once the pipe is closed or broken
+    bool readChannel(int fd, IPCStatusChannel& channel);
+    void removeLocked(int fd);
+
+    int epollFd_ = -1;
+    int wakeRead_ = -1;
+    int wakeWrite_ = -1;
+
+    mutable std::mutex mutex_;
+    std::map<int, std::shared_ptr<IPCStatusChannel>> channels_;
+    std::thread thread_;
+    std::atomic<bool> shutdown_{false};
+};
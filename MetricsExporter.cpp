@@ -0,0 +1,805 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - OpenMetrics exporter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "MetricsExporter.hpp"
+#include "DeviceMetrics.hpp"
+#include <SoapySDR/Logger.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <vector>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // SO_NOSIGPIPE is set on the socket instead (macOS)
+#endif
+
+/*******************************************************************
+ * Page samples
+ ******************************************************************/
+
+// Plain copy of a page taken under the page registry lock, so that
+// rendering never touches a page that is being destroyed
+struct ChannelSample
+{
+    uint64_t callbacks;
+    uint64_t samples;
+    uint64_t delivered;
+    uint64_t gaps;
+    uint64_t gapSamples;
+    uint64_t overflows;
+    uint64_t callbackRateMilliHz;
+    int64_t jitterNs;
+    uint32_t queueDepth;
+    uint32_t queueCapacity;
+    uint64_t interval[METRICS_HISTOGRAM_BUCKETS];
+};
+
+struct UpdateSample
+{
+    uint64_t count;
+    uint64_t failures;
+    uint64_t totalNs;
+    uint64_t histogram[METRICS_HISTOGRAM_BUCKETS];
+};
+
+struct PageSample
+{
+    std::string serial;
+    std::string hardwareKey;
+    uint32_t role;
+    uint32_t sampleRate;
+    uint32_t numChannels;
+    uint32_t streaming;
+    uint32_t healthStatus;
+    uint64_t recoveryAttempts;
+    uint64_t successfulRecoveries;
+    uint64_t workerRestarts;
+    ChannelSample channels[METRICS_MAX_CHANNELS];
+    UpdateSample updates[METRICS_UPDATE_TYPES];
+};
+
+static void copyHistogram(const MetricsHistogram& histogram, uint64_t* counts)
+{
+    for (size_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++)
+    {
+        counts[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+    }
+}
+
+static PageSample samplePage(const DeviceMetricsPage& page)
+{
+    PageSample out;
+    out.serial = std::string(page.serial, strnlen(page.serial, METRICS_SERIAL_LEN));
+    out.hardwareKey = std::string(page.hardwareKey, strnlen(page.hardwareKey, METRICS_SERIAL_LEN));
+    out.role = page.role;
+    out.sampleRate = page.sampleRate.load(std::memory_order_relaxed);
+    out.numChannels = page.numChannels.load(std::memory_order_relaxed);
+    out.streaming = page.streaming.load(std::memory_order_relaxed);
+    out.healthStatus = page.healthStatus.load(std::memory_order_relaxed);
+    out.recoveryAttempts = page.recoveryAttempts.load(std::memory_order_relaxed);
+    out.successfulRecoveries = page.successfulRecoveries.load(std::memory_order_relaxed);
+    out.workerRestarts = page.workerRestarts.load(std::memory_order_relaxed);
+    for (size_t ch = 0; ch < METRICS_MAX_CHANNELS; ch++)
+    {
+        const ChannelMetrics& channel = page.channels[ch];
+        ChannelSample& c = out.channels[ch];
+        c.callbacks = channel.callbacks.load(std::memory_order_relaxed);
+        c.samples = channel.samples.load(std::memory_order_relaxed);
+        c.delivered = channel.samplesDelivered.load(std::memory_order_relaxed);
+        c.gaps = channel.gaps.load(std::memory_order_relaxed);
+        c.gapSamples = channel.gapSamples.load(std::memory_order_relaxed);
+        c.overflows = channel.overflows.load(std::memory_order_relaxed);
+        c.callbackRateMilliHz = channel.callbackRateMilliHz.load(std::memory_order_relaxed);
+        c.jitterNs = channel.jitterNs.load(std::memory_order_relaxed);
+        c.queueDepth = channel.queueDepth.load(std::memory_order_relaxed);
+        c.queueCapacity = channel.queueCapacity.load(std::memory_order_relaxed);
+        copyHistogram(channel.intervalHistogram, c.interval);
+    }
+    for (size_t type = 0; type < METRICS_UPDATE_TYPES; type++)
+    {
+        const UpdateMetrics& update = page.updates[type];
+        UpdateSample& u = out.updates[type];
+        u.count = update.count.load(std::memory_order_relaxed);
+        u.failures = update.failures.load(std::memory_order_relaxed);
+        u.totalNs = update.totalNs.load(std::memory_order_relaxed);
+        copyHistogram(update.histogram, u.histogram);
+    }
+    return out;
+}
+
+// Pages of this process, then the driver pages that the workers of this
+// process's proxies publish (found through /dev/shm, so Linux only)
+static std::vector<PageSample> collectPages()
+{
+    std::vector<PageSample> pages;
+    std::set<std::string> proxied;
+    DeviceMetrics::forEach([&](const DeviceMetrics& metrics) {
+        pages.push_back(samplePage(*metrics.page()));
+        if (metrics.page()->role == METRICS_ROLE_PROXY)
+        {
+            proxied.insert(pages.back().serial);
+        }
+    });
+
+    const pid_t self = getpid();
+    for (const std::string& name : DeviceMetrics::list())
+    {
+        std::unique_ptr<DeviceMetrics> remote(DeviceMetrics::open(name));
+        if (!remote || remote->page()->pid == self || remote->page()->role != METRICS_ROLE_DRIVER ||
+            proxied.count(remote->page()->serial) == 0 || !remote->ownerAlive())
+        {
+            continue;
+        }
+        pages.push_back(samplePage(*remote->page()));
+    }
+    return pages;
+}
+
+/*******************************************************************
+ * OpenMetrics text
+ ******************************************************************/
+
+static std::string escapeLabel(const std::string& value)
+{
+    std::string out;
+    for (char c : value)
+    {
+        if (c == '\\' || c == '"')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (c == '\n')
+        {
+            out += "\\n";
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    return out;
+}
+
+static std::string formatDouble(double value)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.9g", value);
+    return text;
+}
+
+class OpenMetricsWriter
+{
+public:
+    void family(const char* name, const char* type, const char* help, const char* unit = nullptr)
+    {
+        out_ += "# TYPE " + std::string(name) + " " + type + "\n";
+        if (unit != nullptr)
+        {
+            out_ += "# UNIT " + std::string(name) + " " + unit + "\n";
+        }
+        out_ += "# HELP " + std::string(name) + " " + help + "\n";
+    }
+
+    void sample(const std::string& name, const std::string& labels, const std::string& value)
+    {
+        out_ += name + "{" + labels + "} " + value + "\n";
+    }
+
+    void sample(const std::string& name, const std::string& labels, uint64_t value)
+    {
+        sample(name, labels, std::to_string(value));
+    }
+
+    // Log2 microsecond buckets as a cumulative histogram in seconds
+    void histogram(const std::string& name, const std::string& labels, const uint64_t* counts,
+                   const uint64_t* sumNs)
+    {
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i + 1 < METRICS_HISTOGRAM_BUCKETS; i++)
+        {
+            cumulative += counts[i];
+            sample(name + "_bucket", labels + ",le=\"" + formatDouble(static_cast<double>(1ULL << i) * 1e-6) + "\"",
+                   cumulative);
+        }
+        cumulative += counts[METRICS_HISTOGRAM_BUCKETS - 1];
+        sample(name + "_bucket", labels + ",le=\"+Inf\"", cumulative);
+        sample(name + "_count", labels, cumulative);
+        if (sumNs != nullptr)
+        {
+            sample(name + "_sum", labels, formatDouble(*sumNs * 1e-9));
+        }
+    }
+
+    std::string finish()
+    {
+        out_ += "# EOF\n";
+        return out_;
+    }
+
+private:
+    std::string out_;
+};
+
+static std::string pageLabels(const PageSample& page)
+{
+    return "serial=\"" + escapeLabel(page.serial) + "\",role=\"" +
+           (page.role == METRICS_ROLE_PROXY ? "proxy" : "driver") + "\"";
+}
+
+static size_t channelCount(const PageSample& page)
+{
+    return std::max<size_t>(1, std::min<size_t>(page.numChannels, METRICS_MAX_CHANNELS));
+}
+
+std::string MetricsExporter::render()
+{
+    std::vector<PageSample> pages = collectPages();
+
+    // Label sets must be unique: a second instance of a device in one
+    // process (kept private) would repeat them
+    std::set<std::string> seen;
+    std::vector<PageSample> unique;
+    for (PageSample& page : pages)
+    {
+        if (seen.insert(pageLabels(page)).second)
+        {
+            unique.push_back(std::move(page));
+        }
+    }
+    pages.swap(unique);
+
+    OpenMetricsWriter w;
+
+    w.family("sdrplay_device", "info", "Device identification");
+    for (const PageSample& page : pages)
+    {
+        w.sample("sdrplay_device_info", pageLabels(page) + ",hardware=\"" + escapeLabel(page.hardwareKey) + "\"", 1);
+    }
+
+    w.family("sdrplay_sample_rate_hertz", "gauge", "Configured output sample rate", "hertz");
+    for (const PageSample& page : pages)
+    {
+        w.sample("sdrplay_sample_rate_hertz", pageLabels(page), page.sampleRate);
+    }
+
+    w.family("sdrplay_streaming", "gauge", "1 while the stream is active");
+    for (const PageSample& page : pages)
+    {
+        w.sample("sdrplay_streaming", pageLabels(page), page.streaming);
+    }
+
+    w.family("sdrplay_health_status", "gauge",
+             "Driver health: 0 healthy, 1 warning, 2 stale, 3 recovering, 4 service unresponsive, 5 removed, 6 failed");
+    for (const PageSample& page : pages)
+    {
+        if (page.role == METRICS_ROLE_DRIVER)
+        {
+            w.sample("sdrplay_health_status", pageLabels(page), page.healthStatus);
+        }
+    }
+
+    // Per channel counters
+    struct ChannelCounter
+    {
+        const char* name;
+        const char* help;
+        uint64_t ChannelSample::*field;
+        bool driverOnly;
+    };
+    static const ChannelCounter counters[] = {
+        { "sdrplay_callbacks", "Stream callbacks from the SDRplay API", &ChannelSample::callbacks, true },
+        { "sdrplay_samples_received", "Samples received from the SDRplay API", &ChannelSample::samples, true },
+        { "sdrplay_samples_delivered", "Samples handed to the application", &ChannelSample::delivered, false },
+        { "sdrplay_overflows", "Overflows reported to the application", &ChannelSample::overflows, false },
+        { "sdrplay_sample_gaps", "Discontinuities in the sample sequence", &ChannelSample::gaps, false },
+        { "sdrplay_gap_samples", "Samples missing at discontinuities", &ChannelSample::gapSamples, false },
+    };
+    for (const ChannelCounter& counter : counters)
+    {
+        w.family(counter.name, "counter", counter.help);
+        for (const PageSample& page : pages)
+        {
+            if (counter.driverOnly && page.role != METRICS_ROLE_DRIVER)
+            {
+                continue;
+            }
+            for (size_t ch = 0; ch < channelCount(page); ch++)
+            {
+                w.sample(std::string(counter.name) + "_total", pageLabels(page) + ",channel=\"" + std::to_string(ch) + "\"",
+                         page.channels[ch].*counter.field);
+            }
+        }
+    }
+
+    w.family("sdrplay_queue_depth", "gauge", "Buffers (driver) or samples (proxy) waiting to be read");
+    for (const PageSample& page : pages)
+    {
+        for (size_t ch = 0; ch < channelCount(page); ch++)
+        {
+            w.sample("sdrplay_queue_depth", pageLabels(page) + ",channel=\"" + std::to_string(ch) + "\"",
+                     page.channels[ch].queueDepth);
+        }
+    }
+
+    w.family("sdrplay_queue_capacity", "gauge", "Capacity of the queue in the same unit as sdrplay_queue_depth");
+    for (const PageSample& page : pages)
+    {
+        for (size_t ch = 0; ch < channelCount(page); ch++)
+        {
+            w.sample("sdrplay_queue_capacity", pageLabels(page) + ",channel=\"" + std::to_string(ch) + "\"",
+                     page.channels[ch].queueCapacity);
+        }
+    }
+
+    w.family("sdrplay_callback_rate_hertz", "gauge", "Stream callbacks per second at the last health check", "hertz");
+    for (const PageSample& page : pages)
+    {
+        if (page.role != METRICS_ROLE_DRIVER)
+        {
+            continue;
+        }
+        for (size_t ch = 0; ch < channelCount(page); ch++)
+        {
+            w.sample("sdrplay_callback_rate_hertz", pageLabels(page) + ",channel=\"" + std::to_string(ch) + "\"",
+                     formatDouble(page.channels[ch].callbackRateMilliHz / 1000.0));
+        }
+    }
+
+    w.family("sdrplay_callback_jitter_seconds", "gauge", "Smoothed deviation of the callback interval from its mean", "seconds");
+    for (const PageSample& page : pages)
+    {
+        if (page.role != METRICS_ROLE_DRIVER)
+        {
+            continue;
+        }
+        for (size_t ch = 0; ch < channelCount(page); ch++)
+        {
+            w.sample("sdrplay_callback_jitter_seconds", pageLabels(page) + ",channel=\"" + std::to_string(ch) + "\"",
+                     formatDouble(page.channels[ch].jitterNs * 1e-9));
+        }
+    }
+
+    w.family("sdrplay_callback_interval_seconds", "histogram", "Time between stream callbacks", "seconds");
+    for (const PageSample& page : pages)
+    {
+        if (page.role != METRICS_ROLE_DRIVER)
+        {
+            continue;
+        }
+        for (size_t ch = 0; ch < channelCount(page); ch++)
+        {
+            w.histogram("sdrplay_callback_interval_seconds",
+                        pageLabels(page) + ",channel=\"" + std::to_string(ch) + "\"",
+                        page.channels[ch].interval, nullptr);
+        }
+    }
+
+    w.family("sdrplay_update_latency_seconds", "histogram",
+             "sdrplay_api_Update() latency until the callback confirmed the change", "seconds");
+    for (const PageSample& page : pages)
+    {
+        for (size_t type = 0; type < METRICS_UPDATE_TYPES; type++)
+        {
+            const UpdateSample& update = page.updates[type];
+            if (update.count == 0)
+            {
+                continue;
+            }
+            w.histogram("sdrplay_update_latency_seconds",
+                        pageLabels(page) + ",type=\"" + metricsUpdateTypeName(type) + "\"",
+                        update.histogram, &update.totalNs);
+        }
+    }
+
+    w.family("sdrplay_update_failures", "counter", "sdrplay_api_Update() calls skipped under contention or rejected");
+    for (const PageSample& page : pages)
+    {
+        if (page.role != METRICS_ROLE_DRIVER)
+        {
+            continue;
+        }
+        for (size_t type = 0; type < METRICS_UPDATE_TYPES; type++)
+        {
+            w.sample("sdrplay_update_failures_total",
+                     pageLabels(page) + ",type=\"" + metricsUpdateTypeName(type) + "\"",
+                     page.updates[type].failures);
+        }
+    }
+
+    w.family("sdrplay_recovery_attempts", "counter", "Stream recovery attempts by the driver watchdog");
+    for (const PageSample& page : pages)
+    {
+        if (page.role == METRICS_ROLE_DRIVER)
+        {
+            w.sample("sdrplay_recovery_attempts_total", pageLabels(page), page.recoveryAttempts);
+        }
+    }
+
+    w.family("sdrplay_recoveries", "counter", "Successful stream recoveries by the driver watchdog");
+    for (const PageSample& page : pages)
+    {
+        if (page.role == METRICS_ROLE_DRIVER)
+        {
+            w.sample("sdrplay_recoveries_total", pageLabels(page), page.successfulRecoveries);
+        }
+    }
+
+    w.family("sdrplay_worker_restarts", "counter", "Worker processes restarted by the proxy");
+    for (const PageSample& page : pages)
+    {
+        if (page.role == METRICS_ROLE_PROXY)
+        {
+            w.sample("sdrplay_worker_restarts_total", pageLabels(page), page.workerRestarts);
+        }
+    }
+
+    return w.finish();
+}
+
+/*******************************************************************
+ * Server
+ ******************************************************************/
+
+MetricsExporter& MetricsExporter::instance()
+{
+    // The page registry must outlive the exporter thread
+    DeviceMetrics::forEach([](const DeviceMetrics&) {});
+    static MetricsExporter exporter;
+    return exporter;
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+static void setCloseOnExec(int fd)
+{
+    // Keep the listening socket out of spawned workers
+    fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
+}
+
+static int listenUnix(const std::string& path)
+{
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    setCloseOnExec(fd);
+
+    // Replace a socket left behind by a process that exited, but not one
+    // that is still being served
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0)
+    {
+        close(fd);
+        errno = EADDRINUSE;
+        return -1;
+    }
+    close(fd);
+    unlink(path.c_str());
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    setCloseOnExec(fd);
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, 8) < 0)
+    {
+        const int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+static int listenLoopback(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    setCloseOnExec(fd);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, 8) < 0)
+    {
+        const int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+bool MetricsExporter::start(const std::string& endpoint)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_)
+    {
+        if (endpoint != endpoint_)
+        {
+            SoapySDR_logf(SOAPY_SDR_WARNING, "MetricsExporter: Already serving on %s, ignoring %s",
+                         endpoint_.c_str(), endpoint.c_str());
+        }
+        return endpoint == endpoint_;
+    }
+
+    std::string socketPath;
+    int port = -1;
+    if (endpoint.compare(0, 5, "unix:") == 0)
+    {
+        socketPath = endpoint.substr(5);
+    }
+    else if (!endpoint.empty() && endpoint[0] == '/')
+    {
+        socketPath = endpoint;
+    }
+    else
+    {
+        // "9464", "127.0.0.1:9464" or "localhost:9464": loopback only
+        const size_t colon = endpoint.rfind(':');
+        const std::string host = colon == std::string::npos ? "" : endpoint.substr(0, colon);
+        const std::string portText = colon == std::string::npos ? endpoint : endpoint.substr(colon + 1);
+        char* end = nullptr;
+        const long value = std::strtol(portText.c_str(), &end, 10);
+        if ((!host.empty() && host != "127.0.0.1" && host != "localhost") ||
+            portText.empty() || *end != '\0' || value <= 0 || value > 65535)
+        {
+            SoapySDR_logf(SOAPY_SDR_ERROR,
+                "MetricsExporter: Invalid endpoint '%s' (use unix:/path or a loopback port)", endpoint.c_str());
+            return false;
+        }
+        port = static_cast<int>(value);
+    }
+
+    const int fd = socketPath.empty() ? listenLoopback(port) : listenUnix(socketPath);
+    if (fd < 0)
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "MetricsExporter: Cannot listen on %s: %s",
+                     endpoint.c_str(), strerror(errno));
+        return false;
+    }
+    if (pipe(wakePipe_) < 0)
+    {
+        close(fd);
+        if (!socketPath.empty())
+        {
+            unlink(socketPath.c_str());
+        }
+        return false;
+    }
+    setCloseOnExec(wakePipe_[0]);
+    setCloseOnExec(wakePipe_[1]);
+
+    listenFd_ = fd;
+    endpoint_ = endpoint;
+    socketPath_ = socketPath;
+    running_ = true;
+    thread_ = std::thread(&MetricsExporter::threadFunc, this);
+    SoapySDR_logf(SOAPY_SDR_INFO, "MetricsExporter: Serving OpenMetrics on %s", endpoint.c_str());
+    return true;
+}
+
+void MetricsExporter::startFromEnvironment()
+{
+    const char* env = std::getenv("SOAPY_SDRPLAY_METRICS_EXPORT");
+    if (env == nullptr || env[0] == '\0' || std::strcmp(env, "0") == 0 || std::strcmp(env, "off") == 0)
+    {
+        return;
+    }
+    start(env);
+}
+
+void MetricsExporter::stop()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_)
+    {
+        return;
+    }
+    running_ = false;
+    const char wake = 1;
+    if (write(wakePipe_[1], &wake, 1) < 0)
+    {
+        // The thread also polls running_ on its timeout
+    }
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+    close(listenFd_);
+    close(wakePipe_[0]);
+    close(wakePipe_[1]);
+    listenFd_ = -1;
+    wakePipe_[0] = wakePipe_[1] = -1;
+    if (!socketPath_.empty())
+    {
+        unlink(socketPath_.c_str());
+    }
+    endpoint_.clear();
+    socketPath_.clear();
+}
+
+std::string MetricsExporter::endpoint() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return endpoint_;
+}
+
+void MetricsExporter::threadFunc()
+{
+    while (running_)
+    {
+        struct pollfd fds[2];
+        fds[0].fd = listenFd_;
+        fds[0].events = POLLIN;
+        fds[1].fd = wakePipe_[0];
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, 1000) <= 0 || (fds[1].revents & POLLIN))
+        {
+            continue;
+        }
+        if (fds[0].revents & POLLIN)
+        {
+            const int client = accept(listenFd_, nullptr, nullptr);
+            if (client >= 0)
+            {
+                setCloseOnExec(client);
+                serve(client);
+                close(client);
+            }
+        }
+    }
+}
+
+// A scrape must not hold up the exporter: each client gets this long in
+// total, and stop() cuts it short through the wake pipe
+static const int CLIENT_TIMEOUT_MS = 2000;
+
+// Wait for events on fd until the deadline; false on timeout or wake-up
+static bool waitReady(int fd, short events, int wakeFd, std::chrono::steady_clock::time_point deadline)
+{
+    const long long timeoutMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+    if (timeoutMs <= 0)
+    {
+        return false;
+    }
+    struct pollfd fds[2];
+    fds[0].fd = fd;
+    fds[0].events = events;
+    fds[0].revents = 0;
+    fds[1].fd = wakeFd;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+    if (poll(fds, 2, static_cast<int>(timeoutMs)) <= 0 || (fds[1].revents & POLLIN))
+    {
+        return false;
+    }
+    return fds[0].revents != 0;
+}
+
+static bool sendAll(int fd, const std::string& data, int wakeFd, std::chrono::steady_clock::time_point deadline)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        const ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            if (!waitReady(fd, POLLOUT, wakeFd, deadline))
+            {
+                return false;
+            }
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void MetricsExporter::serve(int fd)
+{
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CLIENT_TIMEOUT_MS);
+
+    // Read the request head, if the client sends one
+    std::string request;
+    char buffer[1024];
+    while (request.size() < 8192 && request.find("\r\n\r\n") == std::string::npos &&
+           request.find("\n\n") == std::string::npos)
+    {
+        const auto wait = std::min(deadline, std::chrono::steady_clock::now() + std::chrono::milliseconds(200));
+        if (!waitReady(fd, POLLIN, wakePipe_[0], wait))
+        {
+            break;
+        }
+        const ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0)
+        {
+            break;
+        }
+        request.append(buffer, static_cast<size_t>(n));
+    }
+
+    const std::string body = render();
+    if (request.compare(0, 4, "GET ") == 0)
+    {
+        sendAll(fd,
+            "HTTP/1.0 200 OK\r\n"
+            "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            "Connection: close\r\n\r\n" + body, wakePipe_[0], deadline);
+    }
+    else
+    {
+        sendAll(fd, body, wakePipe_[0], deadline);
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - OpenMetrics exporter
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Per-process exporter serving the metrics pages of this process (and, in
+// proxy mode, the driver pages of its workers) in the OpenMetrics text
+// format. Opt-in: started by the "metrics_export" device argument or
+// setting, or by SOAPY_SDRPLAY_METRICS_EXPORT.
+//
+// The endpoint is a Unix socket ("unix:/path" or "/path") or a TCP port
+// bound to the loopback interface ("9464" or "127.0.0.1:9464"). Requests
+// starting with "GET" get an HTTP response, anything else (or a client
+// that sends nothing) just the text.
+//
+// Scrapes read the pages with relaxed loads; nothing is added to the
+// streaming path.
+class MetricsExporter
+{
+public:
+    static MetricsExporter& instance();
+
+    // Start serving on endpoint; false if the endpoint is invalid or cannot
+    // be bound. An exporter that is already running keeps its endpoint.
+    bool start(const std::string& endpoint);
+
+    // Start from SOAPY_SDRPLAY_METRICS_EXPORT if it is set
+    void startFromEnvironment();
+
+    void stop();
+
+    bool running() const { return running_.load(); }
+    std::string endpoint() const;
+
+    // The OpenMetrics text of the current pages, ending with "# EOF"
+    static std::string render();
+
+    ~MetricsExporter();
+
+private:
+    MetricsExporter() = default;
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    void threadFunc();
+    void serve(int fd);
+
+    mutable std::mutex mutex_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    int listenFd_ = -1;
+    int wakePipe_[2] = {-1, -1};
+    std::string endpoint_;
+    std::string socketPath_;  // Unlinked on stop
+};
@@ -25,18 +25,21 @@
  */
 
 #include "SoapySDRPlay.hpp"
+#include "EnumerationCache.hpp"
 #include <SoapySDR/Registry.hpp>
 #include <mutex>
 #include <cstdlib>
 
 #ifdef ENABLE_SUBPROCESS_MULTIDEV
 #include "SoapySDRPlayProxy.hpp"
+#include "SDRplayBroker.hpp"
 #endif
 
 static std::map<std::string, SoapySDR::Kwargs> _cachedResults;
 static std::mutex _cachedResultsMutex;
 
 // Clear cached device results - called on device release to force fresh enumeration
+// The persistent cache stays: it is tied to the service instance and USB devices
 void clearCachedDeviceResults()
 {
     std::lock_guard<std::mutex> cacheLock(_cachedResultsMutex);
@@ -44,6 +47,32 @@ void clearCachedDeviceResults()
     SoapySDR_log(SOAPY_SDR_DEBUG, "Cleared cached device results");
 }
 
+// A receiver was plugged in or removed: both caches are stale
+static void onSdrplayHotplug()
+{
+    std::lock_guard<std::mutex> cacheLock(_cachedResultsMutex);
+    _cachedResults.clear();
+    EnumerationCache().invalidate();
+}
+
+// Fill _cachedResults from the enumeration cache shared between processes
+// Caller must hold _cachedResultsMutex
+static bool loadPersistentResults()
+{
+    EnumerationCache cache;
+    EnumerationCache::DeviceMap devices;
+    if (!cache.enabled() || !cache.load(devices))
+    {
+        return false;
+    }
+    _cachedResults = devices;
+    // Long-lived processes keep the results until hotplug says otherwise
+    HotplugWatcher::instance().start(&onSdrplayHotplug);
+    SoapySDR_logf(SOAPY_SDR_DEBUG, "findSDRPlay: Loaded %zu devices from %s",
+                  _cachedResults.size(), cache.path().c_str());
+    return true;
+}
+
 #ifdef ENABLE_SUBPROCESS_MULTIDEV
 // Check if subprocess multi-device mode is enabled
 // Forward declaration - moved here so findSDRPlay can use it
@@ -96,8 +125,27 @@ static std::vector<SoapySDR::Kwargs> findSDRPlay(const SoapySDR::Kwargs &args)
    // API calls that hang when devices are streaming
    if (proxyEnabled || proxyArg)
    {
+      // A running sdrplay_broker has the devices enumerated already
+      std::vector<SoapySDR::Kwargs> brokerDevices;
+      if (BrokerClient::list(brokerDevices))
+      {
+         SoapySDR_logf(SOAPY_SDR_DEBUG, "findSDRPlay: %zu devices from sdrplay_broker",
+                       brokerDevices.size());
+         for (auto& dev : brokerDevices)
+         {
+            dev.erase("leased");
+            dev["proxy"] = "true";
+            if (dev.count("label"))
+            {
+               dev["label"] = dev["label"] + " (proxy)";
+            }
+            results.push_back(dev);
+         }
+         return results;
+      }
+
       std::lock_guard<std::mutex> cacheLock(_cachedResultsMutex);
-      if (!_cachedResults.empty())
+      if (!_cachedResults.empty() || loadPersistentResults())
       {
          SoapySDR_logf(SOAPY_SDR_DEBUG, "findSDRPlay: Using cached results in proxy mode");
          for (const auto& kv : _cachedResults)
@@ -121,7 +169,7 @@ static std::vector<SoapySDR::Kwargs> findSDRPlay(const SoapySDR::Kwargs &args)
 
    // Always prefer cached results to avoid blocking streaming callbacks
    // Cache is populated on first enumeration and cleared on device release
-   if (!_cachedResults.empty())
+   if (!_cachedResults.empty() || loadPersistentResults())
    {
       SoapySDR_logf(SOAPY_SDR_DEBUG, "findSDRPlay: Using cached results (streaming-safe)");
       for (const auto& kv : _cachedResults)
@@ -319,6 +367,16 @@ static std::vector<SoapySDR::Kwargs> findSDRPlay(const SoapySDR::Kwargs &args)
       results.push_back(_cachedResults.at(serial));
    }
 
+   // Share an unfiltered enumeration with other processes
+   if (args.count("serial") == 0 && args.count("mode") == 0)
+   {
+      EnumerationCache cache;
+      if (cache.enabled() && cache.store(_cachedResults))
+      {
+         HotplugWatcher::instance().start(&onSdrplayHotplug);
+      }
+   }
+
    } catch (const std::exception &e) {
       SoapySDR_logf(SOAPY_SDR_ERROR, "SDRplay enumeration failed: %s", e.what());
       // Return cached results on error (may be empty)
@@ -38,6 +38,15 @@
 #include <chrono>
 #include <sstream>
 
+// CLOCK_MONOTONIC is shared by all processes, so producer and consumer
+// timestamps can be compared directly
+static int64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
 SharedRingBuffer::SharedRingBuffer(const std::string& name, void* mapping, size_t mappingSize,
                                    size_t numSamples, bool owner)
     : name_(name)
@@ -47,6 +56,7 @@ SharedRingBuffer::SharedRingBuffer(const std::string& name, void* mapping, size_
     , owner_(owner)
     , lastReadIdx_(0)
     , lastOverflowCount_(0)
+    , lastGapCount_(0)
 {
     header_ = static_cast<RingBufferHeader*>(mapping_);
     data_ = reinterpret_cast<std::complex<float>*>(
@@ -99,6 +109,15 @@ SharedRingBuffer* SharedRingBuffer::create(const std::string& name, size_t numSa
     new (&header->sampleRate) std::atomic<uint32_t>(0);
     new (&header->flags) std::atomic<uint32_t>(0);
     new (&header->timestampNs) std::atomic<int64_t>(0);
+    for (RingBufferGap& gap : header->gaps)
+    {
+        new (&gap.idx) std::atomic<uint64_t>(0);
+        new (&gap.samples) std::atomic<uint64_t>(0);
+    }
+    new (&header->gapCount) std::atomic<uint32_t>(0);
+    new (&header->producerState) std::atomic<uint32_t>(RINGBUF_STATE_NONE);
+    new (&header->heartbeatNs) std::atomic<int64_t>(0);
+    new (&header->streamHeartbeatNs) std::atomic<int64_t>(0);
 
     SoapySDR_logf(SOAPY_SDR_INFO, "SharedRingBuffer: Created %s with %zu samples (%.1f MB)",
                  name.c_str(), numSamples, totalSize / (1024.0 * 1024.0));
@@ -149,7 +168,10 @@ SharedRingBuffer* SharedRingBuffer::open(const std::string& name)
     SoapySDR_logf(SOAPY_SDR_INFO, "SharedRingBuffer: Opened %s with %zu samples",
                  name.c_str(), numSamples);
 
-    return new SharedRingBuffer(name, mapping, totalSize, numSamples, false);
+    auto* buffer = new SharedRingBuffer(name, mapping, totalSize, numSamples, false);
+    // A consumer attaching late should not report gaps from before it started
+    buffer->lastGapCount_ = buffer->header_->gapCount.load(std::memory_order_acquire);
+    return buffer;
 }
 
 SharedRingBuffer::~SharedRingBuffer()
@@ -245,10 +267,7 @@ size_t SharedRingBuffer::write(const std::complex<float>* samples, size_t count)
     header_->sampleCount.fetch_add(count, std::memory_order_relaxed);
 
     // Update timestamp
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    int64_t timestampNs = static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
-    header_->timestampNs.store(timestampNs, std::memory_order_relaxed);
+    header_->timestampNs.store(monotonicNs(), std::memory_order_relaxed);
 
     return count;
 }
@@ -310,8 +329,115 @@ void SharedRingBuffer::recordOverflow()
     setFlag(RINGBUF_FLAG_OVERFLOW);
 }
 
+void SharedRingBuffer::markGap(uint64_t lostSamples)
+{
+    const uint32_t number = header_->gapCount.load(std::memory_order_relaxed);
+    RingBufferGap& gap = header_->gaps[number % RINGBUF_GAP_SLOTS];
+    gap.idx.store(header_->writeIdx.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    gap.samples.store(lostSamples, std::memory_order_relaxed);
+    header_->gapCount.store(number + 1, std::memory_order_release);
+}
+
+uint64_t SharedRingBuffer::markResumeGap()
+{
+    uint64_t lostSamples = 0;
+    const int64_t lastWriteNs = header_->timestampNs.load(std::memory_order_relaxed);
+    if (lastWriteNs > 0)
+    {
+        const int64_t nowNs = monotonicNs();
+        if (nowNs > lastWriteNs)
+        {
+            lostSamples = static_cast<uint64_t>(
+                static_cast<double>(nowNs - lastWriteNs) * sampleRate() / 1e9);
+        }
+    }
+    markGap(lostSamples);
+    return lostSamples;
+}
+
+void SharedRingBuffer::heartbeat(uint32_t state)
+{
+    header_->producerState.store(state, std::memory_order_relaxed);
+    header_->heartbeatNs.store(monotonicNs(), std::memory_order_release);
+}
+
+void SharedRingBuffer::streamHeartbeat()
+{
+    header_->streamHeartbeatNs.store(monotonicNs(), std::memory_order_release);
+}
+
+int64_t SharedRingBuffer::heartbeatAgeMs() const
+{
+    const int64_t beatNs = header_->heartbeatNs.load(std::memory_order_acquire);
+    return beatNs > 0 ? (monotonicNs() - beatNs) / 1000000 : -1;
+}
+
+int64_t SharedRingBuffer::streamHeartbeatAgeMs() const
+{
+    const int64_t beatNs = header_->streamHeartbeatNs.load(std::memory_order_acquire);
+    return beatNs > 0 ? (monotonicNs() - beatNs) / 1000000 : -1;
+}
+
 // Consumer API
 
+uint32_t SharedRingBuffer::firstPendingGap(uint32_t gapCount) const
+{
+    return gapCount - lastGapCount_ > RINGBUF_GAP_SLOTS ? gapCount - RINGBUF_GAP_SLOTS : lastGapCount_;
+}
+
+bool SharedRingBuffer::readGap(uint32_t number, uint64_t& idx, uint64_t& samples) const
+{
+    const RingBufferGap& gap = header_->gaps[number % RINGBUF_GAP_SLOTS];
+    idx = gap.idx.load(std::memory_order_relaxed);
+    samples = gap.samples.load(std::memory_order_relaxed);
+    // Only valid if the producer has not reused the slot meanwhile
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header_->gapCount.load(std::memory_order_relaxed) - number <= RINGBUF_GAP_SLOTS;
+}
+
+size_t SharedRingBuffer::clampToGap(uint64_t readIdx, size_t count) const
+{
+    const uint32_t gapCount = header_->gapCount.load(std::memory_order_acquire);
+    for (uint32_t number = firstPendingGap(gapCount); number != gapCount; number++)
+    {
+        uint64_t gapIdx;
+        uint64_t samples;
+        if (readGap(number, gapIdx, samples) && gapIdx > readIdx)
+        {
+            return gapIdx < readIdx + count ? static_cast<size_t>(gapIdx - readIdx) : count;
+        }
+    }
+    return count;
+}
+
+bool SharedRingBuffer::takeGap(uint64_t& lostSamples)
+{
+    const uint32_t gapCount = header_->gapCount.load(std::memory_order_acquire);
+    uint64_t total = 0;
+    bool found = false;
+    for (uint32_t number = firstPendingGap(gapCount); number != gapCount; number++)
+    {
+        uint64_t gapIdx;
+        uint64_t samples;
+        if (!readGap(number, gapIdx, samples))
+        {
+            continue;
+        }
+        if (gapIdx > lastReadIdx_)
+        {
+            break;
+        }
+        lastGapCount_ = number + 1;
+        total += samples;
+        found = true;
+    }
+    if (found)
+    {
+        lostSamples = total;
+    }
+    return found;
+}
+
 size_t SharedRingBuffer::read(std::complex<float>* samples, size_t maxCount, long timeoutUs)
 {
     auto startTime = std::chrono::steady_clock::now();
@@ -325,7 +451,7 @@ size_t SharedRingBuffer::read(std::complex<float>* samples, size_t maxCount, lon
 
         if (avail > 0)
         {
-            size_t count = std::min(avail, maxCount);
+            size_t count = clampToGap(readIdx, std::min(avail, maxCount));
             size_t readPos = readIdx % numSamples_;
             size_t firstChunk = std::min(count, numSamples_ - readPos);
 
@@ -389,8 +515,8 @@ const std::complex<float>* SharedRingBuffer::getReadPtr(size_t* availableOut) co
 
     size_t readPos = lastReadIdx_ % numSamples_;
 
-    // Return contiguous chunk (up to end of buffer)
-    *availableOut = std::min(avail, numSamples_ - readPos);
+    // Return contiguous chunk (up to end of buffer or the next gap)
+    *availableOut = clampToGap(lastReadIdx_, std::min(avail, numSamples_ - readPos));
     return &data_[readPos];
 }
 
@@ -408,3 +534,8 @@ std::string generateShmName(const std::string& deviceSerial)
     oss << "/sdrplay_" << deviceSerial << "_" << getpid();
     return oss.str();
 }
+
+std::string channelShmName(const std::string& baseName, size_t channel)
+{
+    return channel == 0 ? baseName : baseName + "_ch" + std::to_string(channel);
+}
@@ -46,6 +46,22 @@ constexpr uint32_t RINGBUF_FLAG_ERROR      = 0x04;
 constexpr uint32_t RINGBUF_FLAG_RUNNING    = 0x08;
 constexpr uint32_t RINGBUF_FLAG_SHUTDOWN   = 0x10;
 
+// Producer (worker) state published with the heartbeat
+constexpr uint32_t RINGBUF_STATE_NONE      = 0;  // No producer attached yet
+constexpr uint32_t RINGBUF_STATE_IDLE      = 1;  // Command loop running, not streaming
+constexpr uint32_t RINGBUF_STATE_STREAMING = 2;  // Streaming loop running
+constexpr uint32_t RINGBUF_STATE_EXITING   = 3;  // Worker shutting down
+
+// Discontinuities the consumer has not reported yet: the n-th marked gap
+// (counting from 0) is kept in slot n % RINGBUF_GAP_SLOTS
+constexpr uint32_t RINGBUF_GAP_SLOTS = 8;
+
+struct RingBufferGap
+{
+    std::atomic<uint64_t> idx;            // Write index of the first sample after the discontinuity
+    std::atomic<uint64_t> samples;        // Samples lost at it
+};
+
 // Ring buffer header stored at offset 0 in shared memory
 // Uses atomic operations for lock-free SPSC access
 // Note: Size may vary by platform due to atomic alignment requirements
@@ -58,6 +74,11 @@ struct RingBufferHeader
     std::atomic<uint32_t> sampleRate;     // Current sample rate
     std::atomic<uint32_t> flags;          // State flags
     std::atomic<int64_t> timestampNs;     // Last write timestamp (nanoseconds)
+    RingBufferGap gaps[RINGBUF_GAP_SLOTS]; // The last RINGBUF_GAP_SLOTS discontinuities
+    std::atomic<uint32_t> gapCount;       // Discontinuities marked so far
+    std::atomic<uint32_t> producerState;  // RINGBUF_STATE_* of the worker
+    std::atomic<int64_t> heartbeatNs;     // Last command loop heartbeat (CLOCK_MONOTONIC)
+    std::atomic<int64_t> streamHeartbeatNs; // Last streaming loop heartbeat (CLOCK_MONOTONIC)
 };
 
 // Default ring buffer size: 256MB = 32M complex float samples
@@ -98,6 +119,19 @@ public:
     // Increment overflow counter
     void recordOverflow();
 
+    // Mark a discontinuity at the current write position (e.g. after a
+    // worker restart) so the consumer reports it instead of a reset
+    void markGap(uint64_t lostSamples);
+
+    // As markGap(), estimating the lost samples from the time since the
+    // last write and the current sample rate; returns the estimate
+    uint64_t markResumeGap();
+
+    // Liveness: the command loop publishes its state, the streaming loop
+    // its own heartbeat (so a hung readStream() is detected separately)
+    void heartbeat(uint32_t state);
+    void streamHeartbeat();
+
     // Consumer API (proxy process)
 
     // Read samples from the ring buffer
@@ -114,6 +148,11 @@ public:
     // Advance read position after zero-copy read
     void advanceRead(size_t count);
 
+    // Returns true once when the read position has reached a discontinuity
+    // marked by the producer; reads never span a discontinuity. Several
+    // gaps reached at once are reported together (their losses summed).
+    bool takeGap(uint64_t& lostSamples);
+
     // Common API
 
     // Get header (for status inspection)
@@ -134,6 +173,11 @@ public:
     // Get current write index (for health monitoring)
     uint64_t writeIndex() const { return header_->writeIdx.load(std::memory_order_acquire); }
 
+    // Producer state and heartbeat ages in ms (-1 if never published)
+    uint32_t producerState() const { return header_->producerState.load(std::memory_order_acquire); }
+    int64_t heartbeatAgeMs() const;
+    int64_t streamHeartbeatAgeMs() const;
+
     // Get buffer capacity in samples
     size_t capacity() const { return numSamples_; }
 
@@ -156,10 +200,24 @@ private:
     RingBufferHeader* header_;
     std::complex<float>* data_;
 
+    // Number of the oldest gap not reported yet. If the producer marked more
+    // than RINGBUF_GAP_SLOTS since the last report, the oldest are gone.
+    uint32_t firstPendingGap(uint32_t gapCount) const;
+
+    // Position and lost samples of gap number; false if its slot was reused
+    bool readGap(uint32_t number, uint64_t& idx, uint64_t& samples) const;
+
+    // Limit a read of count samples at readIdx to end at an unreported gap
+    size_t clampToGap(uint64_t readIdx, size_t count) const;
+
     // Last known read position (consumer only)
     uint64_t lastReadIdx_;
     uint64_t lastOverflowCount_;
+    uint32_t lastGapCount_;
 };
 
 // Utility function to generate unique shared memory name
 std::string generateShmName(const std::string& deviceSerial);
+
+// Shared memory name of a channel's ring (channel 0 uses the base name)
+std::string channelShmName(const std::string& baseName, size_t channel);
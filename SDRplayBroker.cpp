@@ -0,0 +1,735 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - Device broker daemon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "SDRplayBroker.hpp"
+#include "SoapySDRPlayWorker.hpp"
+#include <SoapySDR/Device.hpp>
+#include <SoapySDR/Logger.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+constexpr const char* BrokerClient::DEFAULT_SOCKET_PATH;
+
+static const unsigned int BROKER_REPLY_TIMEOUT_MS = 2000;
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // macOS: the broker ignores SIGPIPE instead
+#endif
+
+#ifndef MSG_CMSG_CLOEXEC
+#define MSG_CMSG_CLOEXEC 0
+#endif
+
+static void setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// SOCK_CLOEXEC and accept4() are not portable to macOS
+static int unixSocket()
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0)
+    {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+}
+
+bool sendDescriptors(int sock, const std::vector<int>& fds)
+{
+    char byte = 0;
+    struct iovec iov;
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+
+    std::vector<char> control(CMSG_SPACE(sizeof(int) * fds.size()), 0);
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+
+    ssize_t sent;
+    do
+    {
+        sent = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    return sent == 1;
+}
+
+bool receiveDescriptors(int sock, std::vector<int>& fds, unsigned int timeoutMs)
+{
+    struct pollfd pfd;
+    pfd.fd = sock;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, static_cast<int>(timeoutMs)) <= 0)
+    {
+        return false;
+    }
+
+    char byte = 0;
+    struct iovec iov;
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+
+    const size_t maxFds = 8;
+    std::vector<char> control(CMSG_SPACE(sizeof(int) * maxFds), 0);
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+
+    ssize_t received;
+    do
+    {
+        received = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    if (received != 1)
+    {
+        return false;
+    }
+
+    fds.clear();
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        {
+            const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const int* data = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+            fds.insert(fds.end(), data, data + count);
+        }
+    }
+    return !fds.empty();
+}
+
+bool peerCredentials(int sock, uid_t& uid, gid_t& gid)
+{
+#ifdef SO_PEERCRED
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 || len != sizeof(cred))
+    {
+        return false;
+    }
+    uid = cred.uid;
+    gid = cred.gid;
+    return true;
+#else
+    return getpeereid(sock, &uid, &gid) == 0;
+#endif
+}
+
+// BrokerClient implementation
+
+std::string BrokerClient::socketPath()
+{
+    const char* env = std::getenv("SOAPY_SDRPLAY_BROKER");
+    if (env == nullptr || env[0] == '\0')
+    {
+        return DEFAULT_SOCKET_PATH;
+    }
+    const std::string val(env);
+    if (val == "0" || val == "off" || val == "false" || val == "no")
+    {
+        return "";
+    }
+    return val;
+}
+
+int BrokerClient::connect(const std::string& path)
+{
+    struct sockaddr_un addr;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path))
+    {
+        return -1;
+    }
+
+    int fd = unixSocket();
+    if (fd < 0)
+    {
+        return -1;
+    }
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    // No broker: ENOENT or ECONNREFUSED right away
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    // The broker hands out device lists and worker pipes: anyone else could
+    // have created a socket at a shared path first
+    uid_t uid;
+    gid_t gid;
+    if (!peerCredentials(fd, uid, gid) || (uid != geteuid() && uid != 0))
+    {
+        SoapySDR_logf(SOAPY_SDR_WARNING, "BrokerClient: Ignoring %s, not served by this user or root",
+                     path.c_str());
+        close(fd);
+        return -1;
+    }
+    setNonBlocking(fd);
+    return fd;
+}
+
+bool BrokerClient::list(std::vector<SoapySDR::Kwargs>& devices, const std::string& path)
+{
+    const int fd = connect(path);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    IPCPipe sock(fd, true);
+    IPCMessage reply;
+    if (!sock.send(IPCMessage(IPCMessageType::CMD_BROKER_LIST), BROKER_REPLY_TIMEOUT_MS) ||
+        !sock.receive(reply, BROKER_REPLY_TIMEOUT_MS) ||
+        reply.type != IPCMessageType::STATUS_ACK)
+    {
+        return false;
+    }
+
+    devices.clear();
+    const int64_t count = reply.getParamInt("devices", 0);
+    for (int64_t i = 0; i < count; i++)
+    {
+        const std::string prefix = "dev." + std::to_string(i) + ".";
+        SoapySDR::Kwargs dev;
+        for (const auto& kv : reply.params)
+        {
+            if (kv.first.compare(0, prefix.size(), prefix) == 0)
+            {
+                dev[kv.first.substr(prefix.size())] = kv.second;
+            }
+        }
+        devices.push_back(dev);
+    }
+    return true;
+}
+
+pid_t BrokerClient::lease(const SoapySDR::Kwargs& args, IPCPipePair** pipePairOut,
+                          bool& ready, int& leaseFd, const std::string& path)
+{
+    const int fd = connect(path);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    IPCPipe sock(fd, false);
+    IPCMessage cmd(IPCMessageType::CMD_BROKER_LEASE);
+    cmd.setParam("serial", args.count("serial") ? args.at("serial") : "");
+    IPCMessage reply;
+    std::vector<int> fds;
+    if (!sock.send(cmd, BROKER_REPLY_TIMEOUT_MS) || !sock.receive(reply, BROKER_REPLY_TIMEOUT_MS))
+    {
+        close(fd);
+        return -1;
+    }
+    if (reply.type != IPCMessageType::STATUS_LEASED)
+    {
+        SoapySDR_logf(SOAPY_SDR_WARNING, "BrokerClient: Lease refused: %s",
+                     reply.getParam("message").c_str());
+        close(fd);
+        return -1;
+    }
+    if (!receiveDescriptors(fd, fds, BROKER_REPLY_TIMEOUT_MS) || fds.size() != 2)
+    {
+        for (int passed : fds)
+        {
+            close(passed);
+        }
+        close(fd);
+        return -1;
+    }
+
+    *pipePairOut = IPCPipePair::adopt(fds[0], fds[1]);
+    ready = reply.getParamInt("ready", 0) != 0;
+    leaseFd = fd;
+    return static_cast<pid_t>(reply.getParamInt("pid", -1));
+}
+
+// SDRplayBroker implementation
+
+std::vector<SoapySDR::Kwargs> SDRplayBroker::enumerateDevices()
+{
+    // Direct mode: the broker itself must not go through a proxy or broker
+    SoapySDR::Kwargs args;
+    args["driver"] = "sdrplay";
+    std::vector<SoapySDR::Kwargs> devices;
+    for (auto dev : SoapySDR::Device::enumerate(args))
+    {
+        dev.erase("proxy");
+        devices.push_back(dev);
+    }
+    return devices;
+}
+
+SDRplayBroker::SDRplayBroker(const std::string& socketPath, Enumerator enumerate)
+    : socketPath_(socketPath)
+    , enumerate_(enumerate)
+{
+    int fds[2];
+    if (pipe(fds) == 0)
+    {
+        wakeRead_ = fds[0];
+        wakeWrite_ = fds[1];
+        setNonBlocking(wakeRead_);
+        setNonBlocking(wakeWrite_);
+    }
+}
+
+SDRplayBroker::~SDRplayBroker()
+{
+    for (int fd : clients_)
+    {
+        close(fd);
+    }
+    for (auto& kv : devices_)
+    {
+        DeviceSlot& slot = kv.second;
+        if (slot.warmPid > 0)
+        {
+            WorkerSpawner::terminate(slot.warmPid);
+        }
+        if (slot.leasedPid > 0)
+        {
+            WorkerSpawner::terminate(slot.leasedPid);
+        }
+    }
+    if (listenFd_ >= 0)
+    {
+        close(listenFd_);
+        unlink(socketPath_.c_str());
+    }
+    for (int fd : {wakeRead_, wakeWrite_})
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+}
+
+void SDRplayBroker::stop()
+{
+    stop_ = true;
+    if (wakeWrite_ >= 0)
+    {
+        const uint8_t byte = 0;
+        (void)write(wakeWrite_, &byte, 1);
+    }
+}
+
+void SDRplayBroker::rescan()
+{
+    rescan_ = true;
+    if (wakeWrite_ >= 0)
+    {
+        const uint8_t byte = 0;
+        (void)write(wakeWrite_, &byte, 1);
+    }
+}
+
+bool SDRplayBroker::listen()
+{
+    struct sockaddr_un addr;
+    if (socketPath_.empty() || socketPath_.size() >= sizeof(addr.sun_path))
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "SDRplayBroker: Invalid socket path '%s'", socketPath_.c_str());
+        return false;
+    }
+
+    // Refuse to take over the socket of a broker that is still running
+    const int existing = BrokerClient::connect(socketPath_);
+    if (existing >= 0)
+    {
+        close(existing);
+        SoapySDR_logf(SOAPY_SDR_ERROR, "SDRplayBroker: A broker is already serving %s", socketPath_.c_str());
+        return false;
+    }
+    unlink(socketPath_.c_str());
+
+    listenFd_ = unixSocket();
+    if (listenFd_ < 0)
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "SDRplayBroker: socket() failed: %s", strerror(errno));
+        return false;
+    }
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath_.c_str(), sizeof(addr.sun_path) - 1);
+    if (bind(listenFd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listenFd_, 16) != 0)
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "SDRplayBroker: Cannot listen on %s: %s",
+                     socketPath_.c_str(), strerror(errno));
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    // Other users reach the broker through its group; accept() checks the peer
+    chmod(socketPath_.c_str(), 0660);
+    setNonBlocking(listenFd_);
+    return true;
+}
+
+void SDRplayBroker::refreshDevices()
+{
+    std::map<std::string, std::vector<SoapySDR::Kwargs>> found;
+    for (const auto& dev : enumerate_())
+    {
+        auto it = dev.find("serial");
+        if (it != dev.end())
+        {
+            found[it->second].push_back(dev);
+        }
+    }
+
+    // Drop devices that went away (their lease ends with the client)
+    for (auto it = devices_.begin(); it != devices_.end();)
+    {
+        if (found.count(it->first) == 0 && it->second.leaseFd < 0)
+        {
+            SoapySDR_logf(SOAPY_SDR_INFO, "SDRplayBroker: Device %s removed", it->first.c_str());
+            if (it->second.warmPid > 0)
+            {
+                WorkerSpawner::terminate(it->second.warmPid);
+            }
+            it = devices_.erase(it);
+            continue;
+        }
+        ++it;
+    }
+
+    for (auto& kv : found)
+    {
+        DeviceSlot& slot = devices_[kv.first];
+        if (slot.entries.empty())
+        {
+            SoapySDR_logf(SOAPY_SDR_INFO, "SDRplayBroker: Serving device %s", kv.first.c_str());
+        }
+        slot.entries = kv.second;
+        prepareWorker(slot);
+    }
+}
+
+void SDRplayBroker::prepareWorker(DeviceSlot& slot, bool retryNow)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (slot.warmPid > 0 || slot.leaseFd >= 0 || (!retryNow && now < slot.nextSpawn))
+    {
+        return;
+    }
+
+    IPCPipePair* pipes = nullptr;
+    slot.warmPid = WorkerSpawner::spawnWarm(&pipes);
+    if (slot.warmPid < 0)
+    {
+        SoapySDR_log(SOAPY_SDR_WARNING, "SDRplayBroker: Failed to spawn worker");
+        slot.nextSpawn = now + std::chrono::seconds(5);
+        return;
+    }
+    slot.warmPipes.reset(pipes);
+    slot.warmReady = false;
+}
+
+void SDRplayBroker::reapWorkers()
+{
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+    {
+        for (auto& kv : devices_)
+        {
+            DeviceSlot& slot = kv.second;
+            if (slot.warmPid == pid)
+            {
+                SoapySDR_logf(SOAPY_SDR_WARNING, "SDRplayBroker: Idle worker for %s exited",
+                             kv.first.c_str());
+                slot.warmPid = -1;
+                slot.warmPipes.reset();
+            }
+            else if (slot.leasedPid == pid)
+            {
+                // The client notices the closed pipe and leases again
+                slot.leasedPid = -1;
+            }
+        }
+    }
+}
+
+bool SDRplayBroker::leaseAlive(int fd) const
+{
+    char byte;
+    const ssize_t n = recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+}
+
+void SDRplayBroker::endLease(int fd)
+{
+    for (auto& kv : devices_)
+    {
+        DeviceSlot& slot = kv.second;
+        if (slot.leaseFd != fd)
+        {
+            continue;
+        }
+        SoapySDR_logf(SOAPY_SDR_INFO, "SDRplayBroker: Lease of %s ended", kv.first.c_str());
+        if (slot.leasedPid > 0)
+        {
+            WorkerSpawner::terminate(slot.leasedPid);
+        }
+        slot.leasedPid = -1;
+        slot.leaseFd = -1;
+        prepareWorker(slot);
+    }
+}
+
+void SDRplayBroker::handleList(IPCPipe& client)
+{
+    IPCMessage reply(IPCMessageType::STATUS_ACK);
+    int64_t index = 0;
+    for (const auto& kv : devices_)
+    {
+        for (const auto& dev : kv.second.entries)
+        {
+            const std::string prefix = "dev." + std::to_string(index++) + ".";
+            for (const auto& arg : dev)
+            {
+                reply.setParam(prefix + arg.first, arg.second);
+            }
+            reply.setParam(prefix + "leased", static_cast<int64_t>(kv.second.leaseFd >= 0 ? 1 : 0));
+        }
+    }
+    reply.setParam("devices", index);
+    client.send(reply, BROKER_REPLY_TIMEOUT_MS);
+}
+
+void SDRplayBroker::handleLease(IPCPipe& client, int fd, const IPCMessage& cmd)
+{
+    auto refuse = [&client](const std::string& message) {
+        IPCMessage reply(IPCMessageType::STATUS_ERROR);
+        reply.setParam("message", message);
+        client.send(reply, BROKER_REPLY_TIMEOUT_MS);
+    };
+
+    const std::string serial = cmd.getParam("serial");
+    auto it = devices_.find(serial);
+    if (it == devices_.end())
+    {
+        refuse("Unknown device " + serial);
+        return;
+    }
+    DeviceSlot& slot = it->second;
+
+    // A client that just closed its lease may ask again before the hangup
+    // was processed
+    if (slot.leaseFd >= 0 && slot.leaseFd != fd && !leaseAlive(slot.leaseFd))
+    {
+        const int stale = slot.leaseFd;
+        endLease(stale);
+        clients_.erase(std::remove(clients_.begin(), clients_.end(), stale), clients_.end());
+        close(stale);
+    }
+    if (slot.leaseFd >= 0)
+    {
+        refuse("Device " + serial + " is leased");
+        return;
+    }
+
+    prepareWorker(slot, true);
+    if (slot.warmPid < 0)
+    {
+        refuse("Failed to start worker for " + serial);
+        return;
+    }
+
+    if (!slot.warmReady && slot.warmPipes->childToParent()->hasData(0))
+    {
+        slot.warmReady = WorkerSpawner::waitForReady(slot.warmPipes->childToParent(), 100);
+    }
+
+    IPCMessage reply(IPCMessageType::STATUS_LEASED);
+    reply.setParam("pid", static_cast<int64_t>(slot.warmPid));
+    reply.setParam("ready", static_cast<int64_t>(slot.warmReady ? 1 : 0));
+    const std::vector<int> fds = { slot.warmPipes->parentToChild()->fd(),
+                                   slot.warmPipes->childToParent()->fd() };
+    if (!client.send(reply, BROKER_REPLY_TIMEOUT_MS) || !sendDescriptors(fd, fds))
+    {
+        return;
+    }
+
+    // The client owns the pipes now; our copies go away
+    slot.leasedPid = slot.warmPid;
+    slot.leaseFd = fd;
+    slot.warmPid = -1;
+    slot.warmPipes.reset();
+    slot.warmReady = false;
+    SoapySDR_logf(SOAPY_SDR_INFO, "SDRplayBroker: Leased %s (worker PID %d)",
+                 serial.c_str(), slot.leasedPid);
+}
+
+bool SDRplayBroker::handleClient(int fd)
+{
+    IPCPipe client(fd, false);
+    IPCMessage cmd;
+    if (!client.receive(cmd, BROKER_REPLY_TIMEOUT_MS))
+    {
+        return false;
+    }
+
+    switch (cmd.type)
+    {
+    case IPCMessageType::CMD_BROKER_LIST:
+        handleList(client);
+        break;
+    case IPCMessageType::CMD_BROKER_LEASE:
+        handleLease(client, fd, cmd);
+        break;
+    default:
+    {
+        IPCMessage reply(IPCMessageType::STATUS_ERROR);
+        reply.setParam("message", "Unknown request");
+        client.send(reply, BROKER_REPLY_TIMEOUT_MS);
+        break;
+    }
+    }
+    return true;
+}
+
+int SDRplayBroker::run()
+{
+    if (!listen())
+    {
+        return 1;
+    }
+    SoapySDR_logf(SOAPY_SDR_INFO, "SDRplayBroker: Listening on %s", socketPath_.c_str());
+
+    while (!stop_)
+    {
+        if (rescan_.exchange(false))
+        {
+            refreshDevices();
+        }
+        reapWorkers();
+
+        std::vector<struct pollfd> fds;
+        fds.push_back({ listenFd_, POLLIN, 0 });
+        fds.push_back({ wakeRead_, POLLIN, 0 });
+        for (int fd : clients_)
+        {
+            fds.push_back({ fd, POLLIN, 0 });
+        }
+
+        // Wake up now and then to reap workers and refill idle ones
+        if (poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR)
+        {
+            SoapySDR_logf(SOAPY_SDR_ERROR, "SDRplayBroker: poll() failed: %s", strerror(errno));
+            break;
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            uint8_t drain[64];
+            while (read(wakeRead_, drain, sizeof(drain)) > 0)
+            {
+            }
+        }
+
+        for (size_t i = 2; i < fds.size(); i++)
+        {
+            if (fds[i].revents == 0)
+            {
+                continue;
+            }
+            const int fd = fds[i].fd;
+            if (std::find(clients_.begin(), clients_.end(), fd) == clients_.end())
+            {
+                continue;  // Closed as a stale lease while handling another client
+            }
+            if ((fds[i].revents & POLLIN) == 0 || !handleClient(fd))
+            {
+                endLease(fd);
+                clients_.erase(std::remove(clients_.begin(), clients_.end(), fd), clients_.end());
+                close(fd);
+            }
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            int client;
+            while ((client = accept(listenFd_, nullptr, nullptr)) >= 0)
+            {
+                uid_t uid = static_cast<uid_t>(-1);
+                gid_t gid = static_cast<gid_t>(-1);
+                if (!peerCredentials(client, uid, gid) ||
+                    (uid != geteuid() && uid != 0 && gid != getegid()))
+                {
+                    SoapySDR_logf(SOAPY_SDR_WARNING, "SDRplayBroker: Refused client uid %u (not this user, root or group)",
+                                 static_cast<unsigned int>(uid));
+                    close(client);
+                    continue;
+                }
+                fcntl(client, F_SETFD, FD_CLOEXEC);
+                setNonBlocking(client);
+                clients_.push_back(client);
+            }
+        }
+
+        for (auto& kv : devices_)
+        {
+            prepareWorker(kv.second);
+        }
+    }
+
+    SoapySDR_log(SOAPY_SDR_INFO, "SDRplayBroker: Stopped");
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - Device broker daemon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "IPCPipe.hpp"
+
+#include <SoapySDR/Types.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+// sdrplay_broker: one daemon enumerates the devices once, keeps a warm
+// worker per device and leases workers to proxy clients over a Unix socket.
+//
+// Protocol (IPCMessage frames on the socket):
+//   CMD_BROKER_LIST                  -> STATUS_ACK "devices"=N,
+//                                       "dev.<i>.<key>"=value, "dev.<i>.leased"
+//   CMD_BROKER_LEASE "serial"        -> STATUS_LEASED "pid", "ready", then the
+//                                       worker's command and status pipe
+//                                       descriptors (SCM_RIGHTS); or STATUS_ERROR
+// A lease lasts as long as the connection it was granted on. Closing the
+// connection ends it and the broker terminates the worker, then prepares a
+// fresh one for the next client.
+//
+// Both ends check who is on the other side of the socket: clients only talk
+// to a broker run by themselves or root, and the broker only serves its own
+// user, root and members of its group (the socket is mode 0660).
+
+// Pass descriptors over a Unix socket (one data byte carries them)
+bool sendDescriptors(int sock, const std::vector<int>& fds);
+bool receiveDescriptors(int sock, std::vector<int>& fds, unsigned int timeoutMs);
+
+// Effective user and group of the process at the other end of a Unix socket
+bool peerCredentials(int sock, uid_t& uid, gid_t& gid);
+
+// Client side, used by the proxy
+class BrokerClient
+{
+public:
+    static constexpr const char* DEFAULT_SOCKET_PATH = "/tmp/soapy_sdrplay_broker.sock";
+
+    // Path from SOAPY_SDRPLAY_BROKER, empty when set to 0/off
+    static std::string socketPath();
+
+    // Connect to the broker; -1 if none is running
+    static int connect(const std::string& path = socketPath());
+
+    // Devices enumerated by the broker; false if no broker is running
+    static bool list(std::vector<SoapySDR::Kwargs>& devices,
+                     const std::string& path = socketPath());
+
+    // Lease the worker of the device in args. Returns the worker PID, or -1
+    // if no broker is running or the lease was refused. leaseFd holds the
+    // lease and must stay open until the worker is no longer needed.
+    static pid_t lease(const SoapySDR::Kwargs& args, IPCPipePair** pipePairOut,
+                       bool& ready, int& leaseFd, const std::string& path = socketPath());
+};
+
+// The daemon
+class SDRplayBroker
+{
+public:
+    typedef std::function<std::vector<SoapySDR::Kwargs>()> Enumerator;
+
+    // Enumerate through the SoapySDRPlay module (holds the API open)
+    static std::vector<SoapySDR::Kwargs> enumerateDevices();
+
+    explicit SDRplayBroker(const std::string& socketPath,
+                           Enumerator enumerate = &SDRplayBroker::enumerateDevices);
+    ~SDRplayBroker();
+
+    // Serve clients until stop(); returns non-zero if the socket cannot be bound
+    int run();
+
+    // Thread-safe and async-signal-safe
+    void stop();
+
+    // Re-enumerate on the next loop iteration (hotplug)
+    void rescan();
+
+private:
+    struct DeviceSlot
+    {
+        std::vector<SoapySDR::Kwargs> entries;  // One per mode (RSPduo)
+
+        // Warm worker waiting for the next lease
+        pid_t warmPid = -1;
+        std::unique_ptr<IPCPipePair> warmPipes;
+        bool warmReady = false;
+        std::chrono::steady_clock::time_point nextSpawn;  // Backoff after a failed spawn
+
+        // Current lease
+        int leaseFd = -1;
+        pid_t leasedPid = -1;
+    };
+
+    bool listen();
+    void refreshDevices();
+    void prepareWorker(DeviceSlot& slot, bool retryNow = false);
+    void reapWorkers();
+
+    // Handle one request; false once the client disconnected
+    bool handleClient(int fd);
+    void handleList(IPCPipe& client);
+    void handleLease(IPCPipe& client, int fd, const IPCMessage& cmd);
+    bool leaseAlive(int fd) const;
+    void endLease(int fd);
+
+    std::string socketPath_;
+    Enumerator enumerate_;
+    int listenFd_ = -1;
+    int wakeRead_ = -1;
+    int wakeWrite_ = -1;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> rescan_{true};
+
+    std::map<std::string, DeviceSlot> devices_;  // By serial
+    std::vector<int> clients_;
+};
@@ -29,18 +29,92 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <signal.h>
 #include <sys/file.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
-#include <sys/time.h>
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <climits>
 #include <cstring>
+#include <ctime>
+#include <new>
 #include <thread>
 #include <stdexcept>
 
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace
+{
+constexpr uint32_t LOCK_STATE_MAGIC = 0x534C434B;  // "SLCK"
+constexpr uint32_t LOCK_STATE_VERSION = 1;
+constexpr size_t LOCK_QUEUE_SLOTS = 64;
+
+// Successful operations halve the cooldown; below this it drops to zero
+constexpr double COOLDOWN_FLOOR_MS = 50.0;
+constexpr double COOLDOWN_MAX_MS = 30000.0;
+
+// Upper bound of a single blocking wait, so dead owners are noticed
+constexpr long MAX_WAIT_SLICE_MS = 100;
+
+struct LockWaiter
+{
+    int32_t pid;
+    uint32_t reserved;
+    uint64_t token;
+
+    bool matches(int32_t p, uint64_t t) const { return pid == p && token == t; }
+};
+
+int64_t monotonicNs()
+{
+    // CLOCK_MONOTONIC is system-wide, so timestamps compare across processes
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+bool processAlive(int32_t pid)
+{
+    return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+uint64_t nextToken()
+{
+    static std::atomic<uint64_t> counter(0);
+    return ++counter;
+}
+}
+
+// Layout of the mapped lock file. Everything but sequence is only accessed
+// with the lock file flock()ed.
+struct SDRplayLock::SharedState
+{
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> sequence;  // Bumped on every hand-over (futex word)
+    uint32_t queueLen;
+    LockWaiter owner;
+    int64_t lastReleaseNs;
+    double cooldownMs;
+    uint32_t failureStreak;
+    uint32_t reserved;
+    LockWaiter queue[LOCK_QUEUE_SLOTS];
+};
+
+constexpr double SDRplayLock::DEFAULT_COOLDOWN_MS;
+constexpr double SDRplayLock::MIN_BACKOFF_MS;
+
 SDRplayLock::SDRplayLock(const std::string& lockPath)
     : lockPath_(lockPath)
     , lockFd_(-1)
     , held_(false)
+    , token_(0)
+    , state_(nullptr)
 {
 }
 
@@ -50,18 +124,19 @@ SDRplayLock::~SDRplayLock()
     {
         release();
     }
+    if (state_)
+    {
+        munmap(state_, sizeof(SharedState));
+    }
     if (lockFd_ >= 0)
     {
         close(lockFd_);
     }
 }
 
-bool SDRplayLock::acquire(unsigned int timeoutMs, double cooldownMs)
+bool SDRplayLock::mapState()
 {
-    std::lock_guard<std::mutex> localGuard(localMutex_);
-
-    // Already held by this instance
-    if (held_)
+    if (state_)
     {
         return true;
     }
@@ -69,7 +144,7 @@ bool SDRplayLock::acquire(unsigned int timeoutMs, double cooldownMs)
     // Open or create the lock file
     if (lockFd_ < 0)
     {
-        lockFd_ = open(lockPath_.c_str(), O_CREAT | O_RDWR, 0666);
+        lockFd_ = open(lockPath_.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0666);
         if (lockFd_ < 0)
         {
             SoapySDR_logf(SOAPY_SDR_ERROR, "SDRplayLock: Failed to open lock file %s: %s",
@@ -78,50 +153,232 @@ bool SDRplayLock::acquire(unsigned int timeoutMs, double cooldownMs)
         }
     }
 
-    auto startTime = std::chrono::steady_clock::now();
+    if (flock(lockFd_, LOCK_EX) != 0)
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "SDRplayLock: flock failed: %s", strerror(errno));
+        return false;
+    }
 
-    // Try to acquire exclusive lock
-    while (true)
+    // Grow the file before mapping it; a short file would SIGBUS on access
+    struct stat st;
+    bool ok = fstat(lockFd_, &st) == 0 &&
+              (static_cast<size_t>(st.st_size) >= sizeof(SharedState) ||
+               ftruncate(lockFd_, sizeof(SharedState)) == 0);
+
+    void* mapping = MAP_FAILED;
+    if (ok)
+    {
+        mapping = mmap(nullptr, sizeof(SharedState), PROT_READ | PROT_WRITE,
+                       MAP_SHARED, lockFd_, 0);
+    }
+    if (mapping == MAP_FAILED)
     {
-        int result = flock(lockFd_, LOCK_EX | LOCK_NB);
-        if (result == 0)
+        SoapySDR_logf(SOAPY_SDR_ERROR, "SDRplayLock: Failed to map lock file %s: %s",
+                     lockPath_.c_str(), strerror(errno));
+        flock(lockFd_, LOCK_UN);
+        return false;
+    }
+
+    state_ = static_cast<SharedState*>(mapping);
+    if (state_->magic != LOCK_STATE_MAGIC || state_->version != LOCK_STATE_VERSION)
+    {
+        // Fresh file (or one left by an older version): start empty
+        new (state_) SharedState();
+        state_->magic = LOCK_STATE_MAGIC;
+        state_->version = LOCK_STATE_VERSION;
+    }
+
+    flock(lockFd_, LOCK_UN);
+    return true;
+}
+
+bool SDRplayLock::lockState()
+{
+    while (flock(lockFd_, LOCK_EX) != 0)
+    {
+        if (errno != EINTR)
         {
-            // Lock acquired
-            break;
+            SoapySDR_logf(SOAPY_SDR_ERROR, "SDRplayLock: flock failed: %s", strerror(errno));
+            return false;
         }
+    }
+    return true;
+}
+
+void SDRplayLock::unlockState()
+{
+    flock(lockFd_, LOCK_UN);
+}
 
-        if (errno != EWOULDBLOCK)
+bool SDRplayLock::reapDead()
+{
+    bool changed = false;
+
+    if (state_->owner.pid != 0 && !processAlive(state_->owner.pid))
+    {
+        SoapySDR_logf(SOAPY_SDR_WARNING, "SDRplayLock: Owner pid %d died holding the lock",
+                     state_->owner.pid);
+        state_->owner = LockWaiter();
+        changed = true;
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < state_->queueLen && i < LOCK_QUEUE_SLOTS; i++)
+    {
+        if (processAlive(state_->queue[i].pid))
+        {
+            state_->queue[kept++] = state_->queue[i];
+        }
+    }
+    if (kept != state_->queueLen)
+    {
+        state_->queueLen = static_cast<uint32_t>(kept);
+        changed = true;
+    }
+
+    if (changed)
+    {
+        state_->sequence.fetch_add(1, std::memory_order_release);
+    }
+    return changed;
+}
+
+void SDRplayLock::dequeueSelf()
+{
+    const int32_t pid = static_cast<int32_t>(getpid());
+    size_t kept = 0;
+    for (size_t i = 0; i < state_->queueLen; i++)
+    {
+        if (!state_->queue[i].matches(pid, token_))
+        {
+            state_->queue[kept++] = state_->queue[i];
+        }
+    }
+    state_->queueLen = static_cast<uint32_t>(kept);
+    state_->sequence.fetch_add(1, std::memory_order_release);
+}
+
+void SDRplayLock::waitForChange(uint32_t sequence, long waitMs)
+{
+    if (state_->sequence.load(std::memory_order_acquire) != sequence)
+    {
+        return;
+    }
+#ifdef __linux__
+    struct timespec ts;
+    ts.tv_sec = waitMs / 1000;
+    ts.tv_nsec = (waitMs % 1000) * 1000000L;
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state_->sequence), FUTEX_WAIT,
+            sequence, &ts, nullptr, 0);
+#else
+    // No cross-process wait primitive: short sleeps bounded by waitMs
+    std::this_thread::sleep_for(std::chrono::milliseconds(std::min(waitMs, 5L)));
+#endif
+}
+
+void SDRplayLock::wakeWaiters()
+{
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state_->sequence), FUTEX_WAKE,
+            INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+bool SDRplayLock::acquire(unsigned int timeoutMs, double cooldownMs)
+{
+    std::lock_guard<std::mutex> localGuard(localMutex_);
+
+    // Already held by this instance
+    if (held_)
+    {
+        return true;
+    }
+
+    if (!mapState())
+    {
+        return false;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    const int32_t pid = static_cast<int32_t>(getpid());
+    token_ = nextToken();
+
+    bool queued = false;
+    double cooldown = 0.0;
+    int64_t lastReleaseNs = 0;
+
+    while (true)
+    {
+        const uint32_t sequence = state_->sequence.load(std::memory_order_acquire);
+
+        if (!lockState())
         {
-            SoapySDR_logf(SOAPY_SDR_ERROR, "SDRplayLock: flock failed: %s", strerror(errno));
             return false;
         }
 
-        // Check timeout
+        const bool reaped = reapDead();
+
+        // Take a place at the back of the queue (retried while it is full)
+        if (!queued && state_->queueLen < LOCK_QUEUE_SLOTS)
+        {
+            LockWaiter self = LockWaiter();
+            self.pid = pid;
+            self.token = token_;
+            state_->queue[state_->queueLen++] = self;
+            queued = true;
+        }
+
+        // Granted once we are at the front and nobody owns the lock
+        const bool granted = queued && state_->owner.pid == 0 &&
+                             state_->queue[0].matches(pid, token_);
+        if (granted)
+        {
+            state_->owner = state_->queue[0];
+            std::move(state_->queue + 1, state_->queue + state_->queueLen, state_->queue);
+            state_->queueLen--;
+            cooldown = std::min(cooldownMs, state_->cooldownMs);
+            lastReleaseNs = state_->lastReleaseNs;
+        }
+
+        unlockState();
+        if (reaped)
+        {
+            wakeWaiters();
+        }
+        if (granted)
+        {
+            break;
+        }
+
+        long waitMs = MAX_WAIT_SLICE_MS;
         if (timeoutMs > 0)
         {
             auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::steady_clock::now() - startTime).count();
             if (elapsed >= timeoutMs)
             {
+                if (queued && lockState())
+                {
+                    dequeueSelf();
+                    unlockState();
+                    wakeWaiters();
+                }
                 SoapySDR_logf(SOAPY_SDR_WARNING, "SDRplayLock: Timeout waiting for lock (%u ms)", timeoutMs);
                 return false;
             }
+            waitMs = std::min(waitMs, static_cast<long>(timeoutMs - elapsed));
         }
 
-        // Brief sleep before retry
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        waitForChange(sequence, waitMs);
     }
 
     // Enforce cooldown - wait if last operation was too recent
-    if (cooldownMs > 0)
+    if (cooldown > 0 && lastReleaseNs > 0)
     {
-        auto lastOpTime = getLastOperationTime();
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastOpTime).count();
-
-        if (elapsed < cooldownMs)
+        const double elapsed = (monotonicNs() - lastReleaseNs) / 1e6;
+        if (elapsed < cooldown)
         {
-            auto waitMs = static_cast<int>(cooldownMs - elapsed);
+            auto waitMs = static_cast<int>(cooldown - elapsed);
             SoapySDR_logf(SOAPY_SDR_DEBUG, "SDRplayLock: Cooldown wait %d ms", waitMs);
             std::this_thread::sleep_for(std::chrono::milliseconds(waitMs));
         }
@@ -132,7 +389,7 @@ bool SDRplayLock::acquire(unsigned int timeoutMs, double cooldownMs)
     return true;
 }
 
-void SDRplayLock::release()
+void SDRplayLock::release(bool succeeded)
 {
     std::lock_guard<std::mutex> localGuard(localMutex_);
 
@@ -141,46 +398,66 @@ void SDRplayLock::release()
         return;
     }
 
-    // Update timestamp for cooldown tracking
-    updateTimestamp();
-
-    // Release the lock
-    if (lockFd_ >= 0)
+    if (lockState())
     {
-        flock(lockFd_, LOCK_UN);
+        if (state_->owner.matches(static_cast<int32_t>(getpid()), token_))
+        {
+            state_->owner = LockWaiter();
+        }
+        state_->lastReleaseNs = monotonicNs();
+
+        // Adapt the cooldown: halve it after a success, back off
+        // exponentially after consecutive failures
+        if (succeeded)
+        {
+            state_->failureStreak = 0;
+            state_->cooldownMs /= 2.0;
+            if (state_->cooldownMs < COOLDOWN_FLOOR_MS)
+            {
+                state_->cooldownMs = 0.0;
+            }
+        }
+        else
+        {
+            const uint32_t shift = std::min<uint32_t>(state_->failureStreak, 7);
+            state_->failureStreak++;
+            state_->cooldownMs = std::min(COOLDOWN_MAX_MS,
+                std::max(state_->cooldownMs, MIN_BACKOFF_MS * (1u << shift)));
+            SoapySDR_logf(SOAPY_SDR_DEBUG, "SDRplayLock: Operation failed, cooldown %.0f ms",
+                         state_->cooldownMs);
+        }
+
+        state_->sequence.fetch_add(1, std::memory_order_release);
+        unlockState();
+        wakeWaiters();
     }
 
     held_ = false;
     SoapySDR_logf(SOAPY_SDR_DEBUG, "SDRplayLock: Lock released");
 }
 
-std::chrono::steady_clock::time_point SDRplayLock::getLastOperationTime()
+double SDRplayLock::currentCooldownMs()
 {
-    struct stat st;
-    if (lockFd_ >= 0 && fstat(lockFd_, &st) == 0)
+    std::lock_guard<std::mutex> localGuard(localMutex_);
+    if (!mapState() || !lockState())
     {
-        // Convert mtime to steady_clock approximation
-        // Note: This is an approximation since mtime uses wall clock
-        auto now = std::chrono::steady_clock::now();
-        auto wallNow = std::chrono::system_clock::now();
-        auto mtime = std::chrono::system_clock::from_time_t(st.st_mtime);
-
-        auto wallElapsed = std::chrono::duration_cast<std::chrono::milliseconds>(wallNow - mtime);
-        return now - wallElapsed;
+        return 0.0;
     }
-
-    // If we can't stat, assume no cooldown needed
-    return std::chrono::steady_clock::time_point::min();
+    const double cooldown = state_->cooldownMs;
+    unlockState();
+    return cooldown;
 }
 
-void SDRplayLock::updateTimestamp()
+size_t SDRplayLock::queueDepth()
 {
-    if (lockFd_ >= 0)
+    std::lock_guard<std::mutex> localGuard(localMutex_);
+    if (!mapState() || !lockState())
     {
-        // Update file modification time to now
-        // Using futimes with NULL sets both atime and mtime to current time
-        futimes(lockFd_, nullptr);
+        return 0;
     }
+    const size_t depth = state_->queueLen;
+    unlockState();
+    return depth;
 }
 
 // SDRplayLockGuard implementation
@@ -188,6 +465,7 @@ void SDRplayLock::updateTimestamp()
 SDRplayLockGuard::SDRplayLockGuard(SDRplayLock& lock, unsigned int timeoutMs, double cooldownMs)
     : lock_(&lock)
     , acquired_(false)
+    , succeeded_(false)
 {
     if (!lock_->acquire(timeoutMs, cooldownMs))
     {
@@ -200,13 +478,14 @@ SDRplayLockGuard::~SDRplayLockGuard()
 {
     if (acquired_ && lock_)
     {
-        lock_->release();
+        lock_->release(succeeded_);
     }
 }
 
 SDRplayLockGuard::SDRplayLockGuard(SDRplayLockGuard&& other) noexcept
     : lock_(other.lock_)
     , acquired_(other.acquired_)
+    , succeeded_(other.succeeded_)
 {
     other.lock_ = nullptr;
     other.acquired_ = false;
@@ -218,10 +497,11 @@ SDRplayLockGuard& SDRplayLockGuard::operator=(SDRplayLockGuard&& other) noexcept
     {
         if (acquired_ && lock_)
         {
-            lock_->release();
+            lock_->release(succeeded_);
         }
         lock_ = other.lock_;
         acquired_ = other.acquired_;
+        succeeded_ = other.succeeded_;
         other.lock_ = nullptr;
         other.acquired_ = false;
     }
@@ -28,24 +28,37 @@
 #include <string>
 #include <chrono>
 #include <mutex>
+#include <cstddef>
+#include <cstdint>
 
-// Cross-process file-based lock for serializing SDRplay API operations
-// across multiple processes. Uses flock() on UNIX systems.
+// Cross-process lock for serializing SDRplay API operations across multiple
+// processes.
 //
 // Features:
-// - Exclusive lock acquisition with optional timeout
-// - Cooldown enforcement between operations (prevents API hammering)
+// - FIFO fairness: waiters take a place in a queue kept in the lock file
+//   (mapped shared) and are granted the lock strictly in arrival order
+// - Blocking waits (futex on Linux) with optional timeout, no polling
+// - Owners and waiters that die are reaped, so a crash cannot wedge the queue
+// - Adaptive cooldown between operations: shrinks after successful
+//   operations, backs off exponentially after API failures
 // - RAII-style lock guard for exception safety
 // - Reentrant within the same thread via local mutex
+//
+// flock() on the lock file only guards the shared queue state for a few
+// microseconds at a time; it is never held for the duration of an operation.
 class SDRplayLock
 {
 public:
     // Default lock file location
     static constexpr const char* DEFAULT_LOCK_PATH = "/tmp/soapy_sdrplay.lock";
 
-    // Default cooldown between operations (milliseconds)
+    // Upper bound of the cooldown between operations (milliseconds). The
+    // cooldown actually enforced adapts between 0 and this value.
     static constexpr double DEFAULT_COOLDOWN_MS = 2500.0;
 
+    // First backoff step after an API failure; doubles per consecutive failure
+    static constexpr double MIN_BACKOFF_MS = 250.0;
+
     // Constructor - uses default or custom lock path
     explicit SDRplayLock(const std::string& lockPath = DEFAULT_LOCK_PATH);
 
@@ -53,12 +66,13 @@ public:
 
     // Acquire exclusive lock with optional cooldown enforcement
     // Returns true on success, false on timeout
-    // timeoutMs: max wait time (0 = infinite)
-    // cooldownMs: minimum time between operations (0 = no cooldown)
+    // timeoutMs: max wait time for the lock (0 = infinite)
+    // cooldownMs: ceiling for the adaptive cooldown (0 = no cooldown)
     bool acquire(unsigned int timeoutMs = 0, double cooldownMs = DEFAULT_COOLDOWN_MS);
 
-    // Release the lock and update timestamp for cooldown tracking
-    void release();
+    // Release the lock and hand it to the next waiter. succeeded reports the
+    // outcome of the operation and drives the adaptive cooldown.
+    void release(bool succeeded = true);
 
     // Check if lock is currently held by this instance
     bool isHeld() const { return held_; }
@@ -66,17 +80,41 @@ public:
     // Get the lock file path
     const std::string& path() const { return lockPath_; }
 
+    // Cooldown the next acquirer will have to wait (before the ceiling is
+    // applied), shared by all processes using the lock file
+    double currentCooldownMs();
+
+    // Number of waiters queued for the lock
+    size_t queueDepth();
+
 private:
+    struct SharedState;
+
     std::string lockPath_;
     int lockFd_;
     bool held_;
+    uint64_t token_;
+    SharedState* state_;
     std::mutex localMutex_;  // For thread-safety within same process
 
-    // Get the last operation timestamp from lock file
-    std::chrono::steady_clock::time_point getLastOperationTime();
+    // Open and map the lock file, initializing the shared state if needed
+    bool mapState();
 
-    // Update the lock file modification time
-    void updateTimestamp();
+    // Short exclusive section guarding the shared state
+    bool lockState();
+    void unlockState();
+
+    // Drop dead owners and waiters; returns true if anything changed
+    bool reapDead();
+
+    // Remove this instance from the wait queue
+    void dequeueSelf();
+
+    // Block until the shared state changes or waitMs elapses
+    void waitForChange(uint32_t sequence, long waitMs);
+
+    // Wake every waiter blocked in waitForChange()
+    void wakeWaiters();
 };
 
 // RAII guard for SDRplayLock
@@ -89,9 +127,14 @@ public:
                               unsigned int timeoutMs = 0,
                               double cooldownMs = SDRplayLock::DEFAULT_COOLDOWN_MS);
 
-    // Release lock on destruction
+    // Release lock on destruction. Unless markSucceeded() was called (early
+    // return or exception) the operation counts as failed and the cooldown
+    // backs off.
     ~SDRplayLockGuard();
 
+    // Record that the guarded operation completed successfully
+    void markSucceeded() { succeeded_ = true; }
+
     // No copying
     SDRplayLockGuard(const SDRplayLockGuard&) = delete;
     SDRplayLockGuard& operator=(const SDRplayLockGuard&) = delete;
@@ -103,4 +146,5 @@ public:
 private:
     SDRplayLock* lock_;
     bool acquired_;
+    bool succeeded_;
 };
@@ -0,0 +1,69 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - sample conversion kernels
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+
+// Per-sample conversion loops of the streaming hot paths, kept here so that
+// sdrplay_bench_kernels measures the same code the driver and proxy run
+
+// Interleave the API's separate I and Q arrays into CS16
+inline void interleaveCS16(const short *xi, const short *xq, short *out, size_t numSamples)
+{
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        *out++ = xi[i];
+        *out++ = xq[i];
+    }
+}
+
+// Interleave the API's separate I and Q arrays into CF32 in [-1, 1)
+inline void interleaveCF32(const short *xi, const short *xq, float *out, size_t numSamples)
+{
+    // Use multiplication by reciprocal instead of division for performance
+    // (multiplication is faster than division in the hot path)
+    constexpr float SCALE = 1.0f / 32768.0f;
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        *out++ = static_cast<float>(xi[i]) * SCALE;
+        *out++ = static_cast<float>(xq[i]) * SCALE;
+    }
+}
+
+// CF32 to CS16, scaled by 32767 and clamped to the int16 range
+inline void convertCF32ToCS16(const std::complex<float> *in, int16_t *out, size_t numSamples)
+{
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        float re = in[i].real() * 32767.0f;
+        float im = in[i].imag() * 32767.0f;
+        re = std::max(-32768.0f, std::min(32767.0f, re));
+        im = std::max(-32768.0f, std::min(32767.0f, im));
+        out[2 * i] = static_cast<int16_t>(re);
+        out[2 * i + 1] = static_cast<int16_t>(im);
+    }
+}
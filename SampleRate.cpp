@@ -25,6 +25,7 @@
  */
 
 #include "SoapySDRPlay.hpp"
+#include "Trace.hpp"
 
 /*******************************************************************
  * Sample Rate API
@@ -101,7 +102,13 @@ void SoapySDRPlay::setSampleRate(const int direction, const size_t channel, cons
              executeApiUpdate(reasonForUpdate, sdrplay_api_Update_Ext1_None,
                               waitForUpdate ? &fs_changed : nullptr, "SampleRate");
           }
+          // the NCO phase increment is relative to the output sample rate
+          if (ncoOffsetHz != 0.0)
+          {
+             setNcoOffset(ncoOffsetHz);
+          }
        }
+       metrics->page()->sampleRate.store(static_cast<uint32_t>(output_sample_rate), std::memory_order_relaxed);
     }
 }
 
@@ -317,6 +324,18 @@ SoapySDR::RangeList SoapySDRPlay::getBandwidthRange(const int direction, const s
 * Bandwidth and API Update Helpers
 ******************************************************************/
 
+// Metrics bucket of an update, by the first reason that matches
+static MetricsUpdateType metricsUpdateType(sdrplay_api_ReasonForUpdateT reason)
+{
+    if (reason & sdrplay_api_Update_Tuner_Frf) return METRICS_UPDATE_FREQUENCY;
+    if (reason & sdrplay_api_Update_Tuner_Gr) return METRICS_UPDATE_GAIN;
+    if (reason & sdrplay_api_Update_Ctrl_Agc) return METRICS_UPDATE_AGC;
+    if (reason & (sdrplay_api_Update_Dev_Fs | sdrplay_api_Update_Ctrl_Decimation)) return METRICS_UPDATE_SAMPLE_RATE;
+    if (reason & sdrplay_api_Update_Tuner_BwType) return METRICS_UPDATE_BANDWIDTH;
+    if (reason & sdrplay_api_Update_Dev_Ppm) return METRICS_UPDATE_PPM;
+    return METRICS_UPDATE_OTHER;
+}
+
 // Helper to serialize sdrplay_api_Update calls and prevent rapid API calls from crashing
 // Uses try_lock with timeout to avoid blocking indefinitely when updates come rapidly
 // If changeFlag is non-null, waits for callback confirmation after update
@@ -325,12 +344,17 @@ bool SoapySDRPlay::executeApiUpdate(sdrplay_api_ReasonForUpdateT reason,
                                      std::atomic<int> *changeFlag,
                                      const char *updateName)
 {
+    TraceScope trace(updateName, reason);
+    const MetricsUpdateType metricsType = metricsUpdateType(reason);
+    const int64_t startNs = DeviceMetrics::nowNs();
+
     // Try to acquire the API update mutex with a short timeout
     // If another update is in progress, skip this one to avoid queueing up
     std::unique_lock<std::timed_mutex> apiLock(api_update_mutex, std::defer_lock);
     if (!apiLock.try_lock_for(std::chrono::milliseconds(50)))
     {
         SoapySDR_logf(SOAPY_SDR_DEBUG, "Skipping %s update - another update in progress", updateName);
+        metrics->recordUpdate(metricsType, 0, false);
         return false;
     }
 
@@ -340,11 +364,26 @@ bool SoapySDRPlay::executeApiUpdate(sdrplay_api_ReasonForUpdateT reason,
         *changeFlag = 0;
     }
 
+    // a timed command: rx_callback starts a new buffer at the packet
+    // flagged with rfChanged/grChanged and clears timedCommandInFlight
+    const bool timed = changeFlag != nullptr &&
+                       (reason & (sdrplay_api_Update_Tuner_Frf | sdrplay_api_Update_Tuner_Gr)) != 0 &&
+                       std::this_thread::get_id() == timedCommandThreadId.load();
+    if (timed)
+    {
+        timedCommandInFlight = true;
+    }
+
     SdrplayApiLockGuard apiDeviceLock(SDRPLAY_API_TIMEOUT_MS);
     sdrplay_api_ErrT err = sdrplay_api_Update(device.dev, device.tuner, reason, reasonExt);
     if (err != sdrplay_api_Success)
     {
         SoapySDR_logf(SOAPY_SDR_WARNING, "sdrplay_api_Update(%s) failed: %s", updateName, sdrplay_api_GetErrorString(err));
+        if (timed)
+        {
+            timedCommandInFlight = false;
+        }
+        metrics->recordUpdate(metricsType, 0, false);
         return false;
     }
 
@@ -356,9 +395,15 @@ bool SoapySDRPlay::executeApiUpdate(sdrplay_api_ReasonForUpdateT reason,
                                 [changeFlag]{ return *changeFlag != 0; }))
         {
             SoapySDR_logf(SOAPY_SDR_WARNING, "%s update timeout.", updateName);
+            // no flag arrived: a later unrelated change must not split a buffer
+            if (timed)
+            {
+                timedCommandInFlight = false;
+            }
         }
     }
 
+    metrics->recordUpdate(metricsType, DeviceMetrics::nowNs() - startNs, true);
     return true;
 }
 
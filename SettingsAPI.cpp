@@ -25,6 +25,12 @@
  */
 
 #include "SoapySDRPlay.hpp"
+#include "MetricsExporter.hpp"
+#include "Trace.hpp"
+#include <sstream>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
 
 #if defined(_M_X64) || defined(_M_IX86)
 #define strcasecmp _stricmp
@@ -41,6 +47,38 @@ static sdrplay_api_ErrT updateLocked(HANDLE dev,
    return sdrplay_api_Update(dev, tuner, reason, reasonExt);
 }
 
+// Parse a number that makes up the whole of str (surrounding blanks aside)
+static bool parseDouble(const std::string &str, double &value)
+{
+   const char *begin = str.c_str();
+   char *end = nullptr;
+   errno = 0;
+   value = std::strtod(begin, &end);
+   if (end == begin || errno == ERANGE)
+   {
+      return false;
+   }
+   return str.find_first_not_of(" \t", end - begin) == std::string::npos;
+}
+
+static bool parseUnsigned(const std::string &str, unsigned long &value)
+{
+   const size_t first = str.find_first_not_of(" \t");
+   if (first == std::string::npos || !std::isdigit(static_cast<unsigned char>(str[first])))
+   {
+      return false;
+   }
+   const char *begin = str.c_str();
+   char *end = nullptr;
+   errno = 0;
+   value = std::strtoul(begin, &end, 10);
+   if (errno == ERANGE)
+   {
+      return false;
+   }
+   return str.find_first_not_of(" \t", end - begin) == std::string::npos;
+}
+
 /*******************************************************************
 * Settings API
 ******************************************************************/
@@ -526,6 +564,60 @@ SoapySDR::ArgInfoList SoapySDRPlay::getSettingInfo(void) const
        setArgs.push_back(HDRBwArg);
     }
 
+    // Hybrid tuning (digital NCO fine-tune within the IF passband)
+    SoapySDR::ArgInfo hybridTuningArg;
+    hybridTuningArg.key = "hybrid_tuning";
+    hybridTuningArg.value = "false";
+    hybridTuningArg.name = "Hybrid Tuning";
+    hybridTuningArg.description = "Apply small retunes with a digital NCO instead of retuning the LO";
+    hybridTuningArg.type = SoapySDR::ArgInfo::BOOL;
+    setArgs.push_back(hybridTuningArg);
+
+    // Frequency sweep engine
+    SoapySDR::ArgInfo sweepArg;
+    sweepArg.key = "sweep";
+    sweepArg.value = "false";
+    sweepArg.name = "Sweep";
+    sweepArg.description = "Run the frequency sweep engine while streaming";
+    sweepArg.type = SoapySDR::ArgInfo::BOOL;
+    setArgs.push_back(sweepArg);
+
+    SoapySDR::ArgInfo sweepFrequenciesArg;
+    sweepFrequenciesArg.key = "sweep_frequencies";
+    sweepFrequenciesArg.value = "";
+    sweepFrequenciesArg.name = "Sweep Frequencies";
+    sweepFrequenciesArg.description = "Comma separated list of sweep frequencies in Hz";
+    sweepFrequenciesArg.type = SoapySDR::ArgInfo::STRING;
+    setArgs.push_back(sweepFrequenciesArg);
+
+    SoapySDR::ArgInfo sweepDwellArg;
+    sweepDwellArg.key = "sweep_dwell";
+    sweepDwellArg.value = "8192";
+    sweepDwellArg.name = "Sweep Dwell";
+    sweepDwellArg.description = "Samples delivered (or integrated) per sweep step";
+    sweepDwellArg.type = SoapySDR::ArgInfo::INT;
+    sweepDwellArg.range = SoapySDR::Range(1, 16777216);
+    setArgs.push_back(sweepDwellArg);
+
+    SoapySDR::ArgInfo sweepSettleArg;
+    sweepSettleArg.key = "sweep_settle";
+    sweepSettleArg.value = "2048";
+    sweepSettleArg.name = "Sweep Settle";
+    sweepSettleArg.description = "Samples discarded after each retune";
+    sweepSettleArg.type = SoapySDR::ArgInfo::INT;
+    sweepSettleArg.range = SoapySDR::Range(0, 16777216);
+    setArgs.push_back(sweepSettleArg);
+
+    SoapySDR::ArgInfo sweepOutputArg;
+    sweepOutputArg.key = "sweep_output";
+    sweepOutputArg.value = "samples";
+    sweepOutputArg.name = "Sweep Output";
+    sweepOutputArg.description = "Deliver dwell samples as END_BURST tagged blocks, or integrated power per step (read with sweep_power)";
+    sweepOutputArg.type = SoapySDR::ArgInfo::STRING;
+    sweepOutputArg.options = {"samples", "power"};
+    sweepOutputArg.optionNames = {"Samples", "Power"};
+    setArgs.push_back(sweepOutputArg);
+
     // Recovery and watchdog settings
     SoapySDR::ArgInfo watchdogEnabledArg;
     watchdogEnabledArg.key = "watchdog_enabled";
@@ -577,6 +669,38 @@ SoapySDR::ArgInfoList SoapySDRPlay::getSettingInfo(void) const
     usbResetArg.type = SoapySDR::ArgInfo::BOOL;
     setArgs.push_back(usbResetArg);
 
+    SoapySDR::ArgInfo metricsExportArg;
+    metricsExportArg.key = "metrics_export";
+    metricsExportArg.value = "";
+    metricsExportArg.name = "Metrics Export";
+    metricsExportArg.description = "Serve OpenMetrics for this process on a Unix socket (unix:/path) or loopback port; 0 stops";
+    metricsExportArg.type = SoapySDR::ArgInfo::STRING;
+    setArgs.push_back(metricsExportArg);
+
+    SoapySDR::ArgInfo traceArg;
+    traceArg.key = "trace";
+    traceArg.value = "false";
+    traceArg.name = "Event Trace";
+    traceArg.description = "Record callbacks, buffer handoffs, reads, API updates and IPC commands in memory";
+    traceArg.type = SoapySDR::ArgInfo::BOOL;
+    setArgs.push_back(traceArg);
+
+    SoapySDR::ArgInfo traceDumpArg;
+    traceDumpArg.key = "trace_dump";
+    traceDumpArg.value = "";
+    traceDumpArg.name = "Trace Dump";
+    traceDumpArg.description = "Write the recorded events to this file as Chrome trace JSON";
+    traceDumpArg.type = SoapySDR::ArgInfo::STRING;
+    setArgs.push_back(traceDumpArg);
+
+    SoapySDR::ArgInfo traceOverflowArg;
+    traceOverflowArg.key = "trace_overflow_dump";
+    traceOverflowArg.value = "";
+    traceOverflowArg.name = "Trace Dump on Overflow";
+    traceOverflowArg.description = "Write the recorded events to this file at the next overflow";
+    traceOverflowArg.type = SoapySDR::ArgInfo::STRING;
+    setArgs.push_back(traceOverflowArg);
+
     return setArgs;
 }
 
@@ -911,6 +1035,104 @@ void SoapySDRPlay::writeSetting(const std::string &key, const std::string &value
          }
       }
    }
+   else if (key == "hybrid_tuning")
+   {
+      hybridTuning = (value == "true");
+      // fold any NCO offset back into the LO so the tuned frequency is kept
+      if (!hybridTuning && ncoOffsetHz != 0.0)
+      {
+         chParams->tunerParams.rfFreq.rfHz = (uint32_t)(chParams->tunerParams.rfFreq.rfHz + ncoOffsetHz);
+         if (streamActive)
+         {
+            executeApiUpdate(sdrplay_api_Update_Tuner_Frf, sdrplay_api_Update_Ext1_None,
+                             &rf_changed, "Tuner_Frf");
+         }
+         setNcoOffset(0.0);
+      }
+   }
+   else if (key == "sweep")
+   {
+      if (value == "true")
+      {
+         startSweep();
+      }
+      else
+      {
+         stopSweep();
+      }
+   }
+   else if (key == "sweep_frequencies" || key == "sweep_dwell" ||
+            key == "sweep_settle" || key == "sweep_output")
+   {
+      // checked first: a rejected value leaves the sweep as it was
+      std::vector<double> frequencies;
+      unsigned long samples = 0;
+      if (key == "sweep_frequencies")
+      {
+         const SoapySDR::RangeList range = getFrequencyRange(SOAPY_SDR_RX, 0);
+         const double minimum = range.front().minimum();
+         const double maximum = range.back().maximum();
+         std::stringstream ss(value);
+         std::string item;
+         while (std::getline(ss, item, ','))
+         {
+            if (item.find_first_not_of(" \t") == std::string::npos)
+            {
+               continue;
+            }
+            double frequency = 0.0;
+            if (!parseDouble(item, frequency) || !(frequency >= minimum && frequency <= maximum))
+            {
+               SoapySDR_logf(SOAPY_SDR_ERROR, "sweep_frequencies: invalid frequency '%s' (%g to %g Hz)",
+                             item.c_str(), minimum, maximum);
+               return;
+            }
+            frequencies.push_back(frequency);
+         }
+         if (frequencies.empty())
+         {
+            SoapySDR_log(SOAPY_SDR_ERROR, "sweep_frequencies: no frequencies given");
+            return;
+         }
+      }
+      else if (key == "sweep_dwell" || key == "sweep_settle")
+      {
+         if (!parseUnsigned(value, samples) || (key == "sweep_dwell" && samples == 0))
+         {
+            SoapySDR_logf(SOAPY_SDR_ERROR, "%s: invalid sample count '%s'", key.c_str(), value.c_str());
+            return;
+         }
+      }
+      else if (value != "samples" && value != "power")
+      {
+         SoapySDR_logf(SOAPY_SDR_ERROR, "sweep_output: invalid mode '%s' (samples or power)", value.c_str());
+         return;
+      }
+
+      // the sweep configuration is only changed while the sweep is stopped
+      const bool wasRunning = sweepRunning.load();
+      stopSweep();
+      if (key == "sweep_frequencies")
+      {
+         sweepFrequencies.swap(frequencies);
+      }
+      else if (key == "sweep_dwell")
+      {
+         sweepDwellSamples = samples;
+      }
+      else if (key == "sweep_settle")
+      {
+         sweepSettleSamples = samples;
+      }
+      else
+      {
+         sweepPowerMode = (value == "power");
+      }
+      if (wasRunning)
+      {
+         startSweep();
+      }
+   }
    // Recovery and watchdog settings (no mutex needed, watchdogConfig is not shared with callbacks)
    else if (key == "watchdog_enabled")
    {
@@ -936,6 +1158,23 @@ void SoapySDRPlay::writeSetting(const std::string &key, const std::string &value
    {
       watchdogConfig.usbResetOnFailure = (value == "true");
    }
+   // One exporter per process, shared by all devices
+   else if (key == "metrics_export")
+   {
+      if (value.empty() || value == "0" || value == "off")
+      {
+         MetricsExporter::instance().stop();
+      }
+      else
+      {
+         MetricsExporter::instance().start(value);
+      }
+   }
+   // trace settings: one tracer per process, shared by all devices
+   else
+   {
+      Tracer::instance().writeSetting(key, value);
+   }
 }
 
 std::string SoapySDRPlay::readSetting(const std::string &key) const
@@ -1046,6 +1285,68 @@ std::string SoapySDRPlay::readSetting(const std::string &key) const
        }
        return "1.700";
     }
+    else if (key == "hybrid_tuning")
+    {
+       return hybridTuning ? "true" : "false";
+    }
+    else if (key == "nco_offset")
+    {
+       return std::to_string(ncoOffsetHz.load());
+    }
+    else if (key == "sweep")
+    {
+       return sweepRunning ? "true" : "false";
+    }
+    else if (key == "sweep_frequencies")
+    {
+       std::string result;
+       for (const double frequency : sweepFrequencies)
+       {
+          if (!result.empty()) result += ",";
+          result += std::to_string(static_cast<uint64_t>(frequency));
+       }
+       return result;
+    }
+    else if (key == "sweep_dwell")
+    {
+       return std::to_string(sweepDwellSamples);
+    }
+    else if (key == "sweep_settle")
+    {
+       return std::to_string(sweepSettleSamples);
+    }
+    else if (key == "sweep_output")
+    {
+       return sweepPowerMode ? "power" : "samples";
+    }
+    else if (key == "sweep_frequency")
+    {
+       // frequency of the sweep step the most recently read samples belong to
+       const size_t step = sweepReadStep.load();
+       return step < sweepFrequencies.size() ? std::to_string(static_cast<uint64_t>(sweepFrequencies[step])) : "";
+    }
+    else if (key == "sweep_power")
+    {
+       // "frequency:dBFS" pairs of the last completed sweep
+       std::lock_guard<std::mutex> sweepLock(sweepMutex);
+       std::string result;
+       for (size_t i = 0; i < sweepPower.size() && i < sweepFrequencies.size(); i++)
+       {
+          if (!result.empty()) result += ",";
+          result += std::to_string(static_cast<uint64_t>(sweepFrequencies[i])) + ":" + std::to_string(sweepPower[i]);
+       }
+       return result;
+    }
+    else if (key == "sweep_count")
+    {
+       std::lock_guard<std::mutex> sweepLock(sweepMutex);
+       return std::to_string(sweepCount);
+    }
+    else if (key == "last_command_time")
+    {
+       // hardware time (ns) of the first sample after the last timed command
+       return std::to_string(ticksToTimeNs(lastCommandTicks.load()));
+    }
     // Recovery and watchdog settings
     else if (key == "watchdog_enabled")
     {
@@ -1071,6 +1372,21 @@ std::string SoapySDRPlay::readSetting(const std::string &key) const
     {
        return watchdogConfig.usbResetOnFailure ? "true" : "false";
     }
+    else if (key == "metrics_export")
+    {
+       return MetricsExporter::instance().endpoint();
+    }
+    else if (key == "metrics_page")
+    {
+       // shared memory name of the published metrics, empty if private
+       return metrics->name();
+    }
+
+    std::string traceValue;
+    if (Tracer::instance().readSetting(key, traceValue))
+    {
+       return traceValue;
+    }
 
     // SoapySDR_logf(SOAPY_SDR_WARNING, "Unknown setting '%s'", key.c_str());
     return "";
@@ -34,6 +34,8 @@
 #include <atomic>
 #include <condition_variable>
 #include <string>
+#include <vector>
+#include <cstdint>
 #include <cstring>
 #include <algorithm>
 #include <set>
@@ -43,6 +45,9 @@
 
 #include <sdrplay_api.h>
 #include <functional>
+#include <memory>
+
+#include "DeviceMetrics.hpp"
 
 // Default timeout for SDRplay API operations (in milliseconds)
 // This prevents indefinite hangs when the SDRplay service is unresponsive
@@ -95,9 +100,18 @@ private:
 };
 
 #define DEFAULT_BUFFER_LENGTH     (65536)
+#define MIN_BUFFER_LENGTH         (256)
 #define DEFAULT_NUM_BUFFERS       (8)
 #define DEFAULT_ELEMS_PER_SAMPLE  (2)
 
+// Hybrid tuning: retunes within this fraction of the usable passband
+// (the smaller of output sample rate and analog bandwidth) are applied
+// by the digital NCO instead of the hardware LO
+#define HYBRID_TUNING_USABLE_FRACTION  (0.8)
+// NCO mixer block length; phasors within a block are precomputed so the
+// inner loop has no loop-carried dependency and can be vectorised
+#define NCO_BLOCK_SIZE                 (16)
+
 /*******************************************************************
  * Health Monitoring and Recovery Types
  ******************************************************************/
@@ -187,6 +201,29 @@ enum class RecoveryResult {
     InProgress
 };
 
+// Frequency sweep engine state, shared by the sweep thread and rx_callback.
+// The sweep thread only moves the state out of Idle/StepDone; rx_callback
+// owns every other transition.
+enum class SweepState {
+    Idle,          // sweep not started yet, waiting for the first step
+    Retuning,      // LO update issued, waiting for rfChanged in the callback
+    SettleStart,   // new frequency reached, start discarding settle samples
+    Settling,      // discarding settle samples
+    Dwell,         // delivering (or integrating) dwell samples
+    StepDone       // dwell complete, waiting for the sweep thread to retune
+};
+
+// Frequency or gain change deferred by setCommandTime() until the stream
+// reaches the given hardware sample tick
+struct TimedCommand {
+    enum Type { Frequency, GainElement, Gain };
+    uint64_t ticks;
+    Type type;
+    size_t channel;
+    std::string name;
+    double value;
+};
+
 // Ensure numBuffers is a power of 2 for efficient ring buffer operations
 static_assert((DEFAULT_NUM_BUFFERS & (DEFAULT_NUM_BUFFERS - 1)) == 0,
               "DEFAULT_NUM_BUFFERS must be a power of 2");
@@ -378,6 +415,18 @@ public:
     
     bool hasDCOffset(const int direction, const size_t channel) const;
 
+    /*******************************************************************
+     * Time API
+     ******************************************************************/
+
+    bool hasHardwareTime(const std::string &what = "") const;
+
+    long long getHardwareTime(const std::string &what = "") const;
+
+    void setHardwareTime(const long long timeNs, const std::string &what = "");
+
+    void setCommandTime(const long long timeNs, const std::string &what = "");
+
     /*******************************************************************
      * Settings API
      ******************************************************************/
@@ -416,6 +465,13 @@ public:
 
     void ev_callback(sdrplay_api_EventT eventId, sdrplay_api_TunerSelectT tuner, sdrplay_api_EventParamsT *params);
 
+    bool appendSamples(const short *xi, const short *xq, unsigned int numSamples,
+                       uint64_t ticks, SoapySDRPlayStream *stream);
+
+    void closeTailBuffer(SoapySDRPlayStream *stream, int flags);
+
+    void logSampleGaps(SoapySDRPlayStream *stream);
+
     /*******************************************************************
      * public utility static methods
      ******************************************************************/
@@ -458,6 +514,14 @@ private:
                           std::atomic<int> *changeFlag,
                           const char *updateName);
 
+    // Hybrid tuning helpers (caller must hold _general_state_mutex)
+    double getHybridTuningMaxOffset() const;
+
+    void setNcoOffset(double offsetHz);
+
+    // getAntenna() of the RX channel (caller must hold _general_state_mutex)
+    std::string getRxAntennaLocked(const size_t channel) const;
+
     static std::string makeAntennaPersistKey(const std::string &serial, const std::string &mode);
 
     std::string loadPersistedAntenna(const std::string &key, const size_t channel) const;
@@ -514,6 +578,13 @@ private:
 
     std::atomic_bool useShort;
 
+    // Hybrid tuning: small retunes are applied by a digital NCO in
+    // rx_callback; the hardware LO (rfFreq.rfHz) is only retuned when the
+    // requested frequency leaves the usable passband
+    std::atomic_bool hybridTuning;
+    std::atomic<double> ncoOffsetHz;        // requested frequency - LO frequency
+    std::atomic<double> ncoPhaseIncrement;  // radians per output sample
+
     const int uninitRetryDelay = 10;   // 10 seconds before trying uninit again 
 
     static std::unordered_map<std::string, sdrplay_api_DeviceT*> selectedRSPDevices;
@@ -558,6 +629,9 @@ private:
     void updateHealthStatus(DeviceHealthStatus newStatus);
     void notifyHealthCallbacks(DeviceHealthStatus status);
 
+    // Runtime metrics published in shared memory for external tools
+    std::unique_ptr<DeviceMetrics> metrics;
+
     // Settings cache for recovery
     DeviceSettingsCache settingsCache;
     mutable std::mutex settingsCacheMutex;
@@ -585,6 +659,71 @@ private:
     RecoveryResult attemptStreamRecovery();
     void handleStaleStream();
 
+    /*******************************************************************
+     * Frequency sweep engine (private, see Sweep.cpp)
+     ******************************************************************/
+
+    // Sweep configuration (guarded by _general_state_mutex, only changed
+    // while the sweep is stopped)
+    std::vector<double> sweepFrequencies;
+    unsigned long sweepDwellSamples = 8192;
+    unsigned long sweepSettleSamples = 2048;
+    bool sweepPowerMode = false;
+
+    // Sweep thread and state machine
+    std::thread sweepThread;
+    std::atomic<bool> sweepRunning{false};
+    std::atomic<bool> sweepShutdown{false};
+    std::atomic<SweepState> sweepState{SweepState::Idle};
+    std::atomic<size_t> sweepStep{0};
+    std::atomic<size_t> sweepReadStep{0};   // step of the buffer last handed to the reader
+    mutable std::mutex sweepMutex;
+    std::condition_variable sweepCv;
+
+    // rx_callback-only counters
+    unsigned long sweepSamplesLeft = 0;
+    double sweepPowerAccum = 0.0;
+    std::vector<double> sweepPowerPending;
+
+    // Integrated power of the last completed sweep in dBFS (sweepMutex)
+    std::vector<double> sweepPower;
+    uint64_t sweepCount = 0;
+
+    void startSweep();
+    void stopSweep();
+    void sweepThreadFunc();
+    void sweepCallback(short *xi, short *xq, sdrplay_api_StreamCbParamsT *params,
+                       unsigned int numSamples, uint64_t ticks, SoapySDRPlayStream *stream);
+
+    /*******************************************************************
+     * Hardware time and timed commands (private, see Time.cpp)
+     ******************************************************************/
+
+    // Hardware time is the callback sample counter (firstSampleNum extended
+    // to 64 bits) at the output sample rate, plus an offset from setHardwareTime()
+    std::atomic<uint64_t> hwTicks{0};             // tick after the last received sample
+    std::atomic<long long> hwTimeOffsetTicks{0};
+    std::atomic<long long> commandTimeNs{0};      // 0 = apply commands immediately
+
+    // Pending timed commands sorted by tick (timedCommandMutex)
+    std::vector<TimedCommand> timedCommands;
+    std::mutex timedCommandMutex;
+    std::condition_variable timedCommandCv;
+    std::atomic<uint64_t> nextCommandTicks{UINT64_MAX};
+    std::atomic<bool> timedCommandDue{false};
+    std::atomic<bool> timedCommandInFlight{false};
+    std::atomic<uint64_t> lastCommandTicks{0};    // first tick after the last timed change
+    std::thread timedCommandThread;
+    std::atomic<std::thread::id> timedCommandThreadId{std::thread::id()};
+    std::atomic<bool> timedCommandRunning{false};
+    std::atomic<bool> timedCommandShutdown{false};
+
+    long long ticksToTimeNs(uint64_t ticks) const;
+    uint64_t timeNsToTicks(long long timeNs) const;
+    bool queueTimedCommand(TimedCommand::Type type, size_t channel, const std::string &name, double value);
+    void stopTimedCommands();
+    void timedCommandThreadFunc();
+
 public:
 
     /*******************************************************************
@@ -627,10 +766,49 @@ public:
         // Sample gap detection - tracks expected next sample number
         unsigned int nextSampleNum{0};
         std::atomic<uint64_t> sampleGapCount{0};  // Total gaps detected
+        std::atomic<unsigned int> lastGapSamples{0};
+        uint64_t loggedGapCount{0};               // Watchdog side, see logSampleGaps()
+
+        // Published counters of this channel (see DeviceMetrics.hpp)
+        ChannelMetrics *metrics{nullptr};
 
         // Watchdog tracking
         uint64_t lastWatchdogTicks{0};
         std::chrono::steady_clock::time_point lastCallbackTime;
+
+        // Hybrid tuning NCO state (only touched by rx_callback under mutex)
+        // The block phasor is kept in double precision and renormalised
+        // every callback so it does not drift over long captures
+        double ncoIncrement{0.0};
+        double ncoPhaseRe{1.0};
+        double ncoPhaseIm{0.0};
+        double ncoBlockRotRe{1.0};
+        double ncoBlockRotIm{0.0};
+        float ncoRotRe[NCO_BLOCK_SIZE];
+        float ncoRotIm[NCO_BLOCK_SIZE];
+
+        // Per-buffer stream flags (e.g. SOAPY_SDR_END_BURST) reported with
+        // the last sample of the buffer, and the sweep step of its samples
+        std::vector<int> buffFlags;
+        std::vector<size_t> buffSweepStep;
+
+        // Hardware tick of the first sample of each buffer, the packet
+        // counter used to extend firstSampleNum to 64 bits, the tick of the
+        // next sample handed out by readStream() and the timed activation tick
+        std::vector<uint64_t> buffTicks;
+        uint64_t sampleTicks{0};
+        uint64_t readTicks{0};
+        uint64_t activateTicks{0};
+
+        // Finite burst (activateStream numElems): samples still to deliver;
+        // once it reaches zero the callback drops samples until the next
+        // activateStream() without tearing down the API stream
+        bool burstMode{false};
+        size_t burstRemaining{0};
+
+        // Hot standby: set by deactivateStream(); the API stream keeps
+        // running but rx_callback discards samples until activateStream()
+        bool standby{false};
     };
 
     SoapySDRPlayStream *_streams[2];
@@ -26,28 +26,81 @@
 
 #include "SoapySDRPlayProxy.hpp"
 #include "SDRplayLock.hpp"
+#include "IPCReactor.hpp"
+#include "SDRplayBroker.hpp"
+#include "MetricsExporter.hpp"
+#include "Trace.hpp"
+#include "SampleConvert.hpp"
 #include <SoapySDR/Logger.h>
 #include <SoapySDR/Formats.hpp>
 
 #include <stdexcept>
 #include <cstring>
+#include <cstdlib>
+#include <sys/wait.h>
+#include <unistd.h>
 
 // Global cross-process lock for serializing device opening
 // The SDRplay API service can't handle concurrent device selection reliably
 static SDRplayLock g_proxyDeviceOpenLock("/tmp/soapy_sdrplay_proxy.lock");
 
+// Channel list parameter of CMD_START
+static std::string joinChannels(const std::vector<size_t>& channels)
+{
+    std::string out;
+    for (size_t i = 0; i < channels.size(); i++)
+    {
+        if (i > 0) out += ',';
+        out += std::to_string(channels[i]);
+    }
+    return out;
+}
+
 SoapySDRPlayProxy::SoapySDRPlayProxy(const SoapySDR::Kwargs& args)
     : deviceArgs_(args)
 {
     serial_ = args.count("serial") ? args.at("serial") : "";
     shmName_ = generateShmName(serial_);
 
+    // Deadline for detecting a stalled worker: device arg, then environment
+    const char* deadlineEnv = std::getenv("SOAPY_SDRPLAY_WORKER_DEADLINE_MS");
+    if (args.count("worker_deadline_ms"))
+    {
+        workerDeadlineMs_ = static_cast<unsigned int>(std::strtoul(args.at("worker_deadline_ms").c_str(), nullptr, 10));
+    }
+    else if (deadlineEnv != nullptr)
+    {
+        workerDeadlineMs_ = static_cast<unsigned int>(std::strtoul(deadlineEnv, nullptr, 10));
+    }
+
     SoapySDR_logf(SOAPY_SDR_INFO, "SoapySDRPlayProxy: Creating proxy for device %s",
                  serial_.c_str());
+
+    metrics_.reset(DeviceMetrics::create(serial_, METRICS_ROLE_PROXY));
+
+    // The exporter runs in this process and also serves the worker's
+    // driver page, so the worker must not start one of its own
+    auto exportArg = deviceArgs_.find("metrics_export");
+    if (exportArg != deviceArgs_.end())
+    {
+        writeSetting(exportArg->first, exportArg->second);
+        deviceArgs_.erase(exportArg);
+    }
+    else
+    {
+        MetricsExporter::instance().startFromEnvironment();
+    }
+
+    // Start warm workers early so that they load in parallel with this
+    // and any other proxies being created
+    WorkerPool::instance().fill();
 }
 
 SoapySDRPlayProxy::~SoapySDRPlayProxy()
 {
+    stopMonitor();
+
+    std::lock_guard<std::recursive_mutex> lock(workerMutex_);
     if (streamActive_)
     {
         // Send stop command
@@ -64,18 +117,18 @@ SoapySDRPlayProxy::~SoapySDRPlayProxy()
             pipes_->parentToChild()->send(cmd, 1000);
         }
 
-        WorkerSpawner::terminate(workerPid_);
-        workerPid_ = -1;
+        terminateWorker();
     }
 
     ringBuffer_.reset();
-    pipes_.reset();
+    setPipes(nullptr);
 
     SoapySDR_logf(SOAPY_SDR_INFO, "SoapySDRPlayProxy: Destroyed");
 }
 
 void SoapySDRPlayProxy::ensureWorker()
 {
+    std::lock_guard<std::recursive_mutex> lock(workerMutex_);
     if (workerReady_)
     {
         return;
@@ -86,50 +139,130 @@ void SoapySDRPlayProxy::ensureWorker()
         // Worker exists but not ready - wait for it
         if (pipes_ && WorkerSpawner::waitForReady(pipes_->childToParent(), 10000))
         {
+            attachStatusChannel();
             workerReady_ = true;
+            workerStartTime_ = std::chrono::steady_clock::now();
+            startMonitor();
             return;
         }
         // Worker died or timed out
-        WorkerSpawner::terminate(workerPid_);
-        workerPid_ = -1;
+        terminateWorker();
     }
 
-    // Create shared memory
-    ringBuffer_.reset(SharedRingBuffer::create(shmName_));
-    if (!ringBuffer_)
+    // Create shared memory (a restarted worker reuses the existing ring)
+    const bool createdRing = !ringBuffer_;
+    if (createdRing)
+    {
+        ringBuffer_.reset(SharedRingBuffer::create(shmName_));
+        if (!ringBuffer_)
+        {
+            throw std::runtime_error("Failed to create shared memory");
+        }
+    }
+
+    // Prefer a worker leased from sdrplay_broker, then a pre-spawned warm
+    // worker from the pool
+    IPCPipePair* pipesPtr = nullptr;
+    bool ready = false;
+    int leaseFd = -1;
+    workerPid_ = BrokerClient::lease(deviceArgs_, &pipesPtr, ready, leaseFd);
+    if (workerPid_ > 0)
+    {
+        brokerLease_ = leaseFd;
+        if (adoptWorker(pipesPtr, ready, "Leased"))
+        {
+            return;
+        }
+    }
+
+    pipesPtr = nullptr;
+    workerPid_ = WorkerPool::instance().acquire(&pipesPtr, ready);
+    if (workerPid_ > 0 && adoptWorker(pipesPtr, ready, "Pooled"))
     {
-        throw std::runtime_error("Failed to create shared memory");
+        WorkerPool::instance().fill();
+        return;
     }
 
     // Spawn worker
-    IPCPipePair* pipesPtr = nullptr;
+    pipesPtr = nullptr;
     workerPid_ = WorkerSpawner::spawn(deviceArgs_, shmName_, &pipesPtr);
     if (workerPid_ < 0)
     {
-        ringBuffer_.reset();
+        if (createdRing)
+        {
+            ringBuffer_.reset();
+        }
         throw std::runtime_error("Failed to spawn worker process");
     }
 
-    pipes_.reset(pipesPtr);
+    setPipes(pipesPtr);
 
     // Wait for worker to be ready
     if (!WorkerSpawner::waitForReady(pipes_->childToParent(), 10000))
     {
-        WorkerSpawner::terminate(workerPid_);
-        workerPid_ = -1;
-        ringBuffer_.reset();
-        pipes_.reset();
+        terminateWorker();
+        if (createdRing)
+        {
+            ringBuffer_.reset();
+        }
+        setPipes(nullptr);
         throw std::runtime_error("Worker failed to start");
     }
 
+    attachStatusChannel();
     workerReady_ = true;
+    workerStartTime_ = std::chrono::steady_clock::now();
     SoapySDR_logf(SOAPY_SDR_INFO, "SoapySDRPlayProxy: Worker ready for device %s",
                  serial_.c_str());
+    startMonitor();
+}
+
+bool SoapySDRPlayProxy::adoptWorker(IPCPipePair* pipes, bool ready, const char* source)
+{
+    setPipes(pipes);
+    bool usable = ready || WorkerSpawner::waitForReady(pipes_->childToParent(), 10000);
+    if (usable)
+    {
+        attachStatusChannel();
+        usable = assignWorker();
+    }
+    if (!usable)
+    {
+        SoapySDR_logf(SOAPY_SDR_WARNING, "SoapySDRPlayProxy: %s worker unusable, spawning a new one", source);
+        terminateWorker();
+        setPipes(nullptr);
+        return false;
+    }
+
+    workerReady_ = true;
+    workerStartTime_ = std::chrono::steady_clock::now();
+    SoapySDR_logf(SOAPY_SDR_INFO, "SoapySDRPlayProxy: %s worker PID %d ready for device %s",
+                 source, workerPid_, serial_.c_str());
+    startMonitor();
+    return true;
+}
+
+void SoapySDRPlayProxy::terminateWorker()
+{
+    if (brokerLease_ >= 0)
+    {
+        // Leased workers are children of the broker: ending the lease makes
+        // the broker terminate the worker
+        close(brokerLease_);
+        brokerLease_ = -1;
+    }
+    else if (workerPid_ > 0)
+    {
+        WorkerSpawner::terminate(workerPid_);
+    }
+    workerPid_ = -1;
 }
 
 void SoapySDRPlayProxy::restartWorker()
 {
+    std::lock_guard<std::recursive_mutex> lock(workerMutex_);
     bool wasStreaming = streamActive_.load();
+    auto restartStart = std::chrono::steady_clock::now();
 
     // Mark worker as not ready
     workerReady_ = false;
@@ -140,15 +273,19 @@ void SoapySDRPlayProxy::restartWorker()
     {
         SoapySDR_logf(SOAPY_SDR_INFO, "SoapySDRPlayProxy: Terminating stalled worker PID %d",
                      workerPid_);
-        WorkerSpawner::terminate(workerPid_);
-        workerPid_ = -1;
     }
+    terminateWorker();
 
     // Close old pipes
-    pipes_.reset();
+    setPipes(nullptr);
 
-    // Recreate shared memory (clears buffer)
-    ringBuffer_.reset();
+    // Keep the shared memory ring: the consumer's read position and any
+    // buffered samples survive, and the new worker attaches to the same
+    // mapping. Clear the old producer's terminal state.
+    if (ringBuffer_)
+    {
+        ringBuffer_->clearFlag(RINGBUF_FLAG_SHUTDOWN | RINGBUF_FLAG_ERROR);
+    }
 
     try
     {
@@ -157,29 +294,26 @@ void SoapySDRPlayProxy::restartWorker()
 
         // Send CMD_CONFIGURE first to open device (same as setupStream does)
         SoapySDR_log(SOAPY_SDR_INFO, "SoapySDRPlayProxy: Configuring device in restarted worker");
-        IPCMessage configCmd(IPCMessageType::CMD_CONFIGURE);
-        configCmd.setParam("center_hz", centerFreq_);
-        configCmd.setParam("sample_rate", sampleRate_);
-        configCmd.setParam("bandwidth", bandwidth_);
-        configCmd.setParam("gain", gain_);
-        configCmd.setParam("agc", static_cast<int64_t>(agcEnabled_ ? 1 : 0));
-        configCmd.setParam("antenna", antenna_);
-
-        if (!sendCommand(configCmd))
+        if (!sendCommand(configureCommand()))
         {
             throw std::runtime_error("Failed to send configure command to restarted worker");
         }
 
-        if (!waitForStatus(IPCMessageType::STATUS_CONFIGURED, 15000))
+        IPCMessage configured;
+        if (!waitForStatus(IPCMessageType::STATUS_CONFIGURED, 15000, &configured))
         {
             throw std::runtime_error("Configure failed in restarted worker");
         }
+        updateGainRanges(configured);
 
-        // Restart streaming if it was active
+        // Restart streaming if it was active; the worker marks the samples
+        // lost in the meantime as a single gap in the ring
         if (wasStreaming)
         {
             SoapySDR_log(SOAPY_SDR_INFO, "SoapySDRPlayProxy: Restarting stream");
             IPCMessage startCmd(IPCMessageType::CMD_START);
+            startCmd.setParam("channels", joinChannels(streamChannels_));
+            startCmd.setParam("resume", static_cast<int64_t>(1));
             if (sendCommand(startCmd) && waitForStatus(IPCMessageType::STATUS_STARTED, 10000))
             {
                 streamActive_ = true;
@@ -190,7 +324,14 @@ void SoapySDRPlayProxy::restartWorker()
             }
         }
 
-        SoapySDR_log(SOAPY_SDR_INFO, "SoapySDRPlayProxy: Worker restart complete");
+        workerStartTime_ = std::chrono::steady_clock::now();
+        lastRecoveryMs_ = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - restartStart).count();
+        restartCount_++;
+        metricsAdd(metrics_->page()->workerRestarts, 1);
+        metrics_->page()->lastRecoveryNs.store(DeviceMetrics::nowNs(), std::memory_order_relaxed);
+        SoapySDR_logf(SOAPY_SDR_INFO, "SoapySDRPlayProxy: Worker restart complete in %lld ms",
+                     (long long)lastRecoveryMs_.load());
     }
     catch (const std::exception& e)
     {
@@ -199,13 +340,345 @@ void SoapySDRPlayProxy::restartWorker()
     }
 }
 
-bool SoapySDRPlayProxy::sendCommand(const IPCMessage& cmd, unsigned int timeoutMs)
+void SoapySDRPlayProxy::openDevice()
+{
+    // Serialize device opening across all proxy instances
+    // The SDRplay API service can't handle concurrent device selection reliably
+    SoapySDR_log(SOAPY_SDR_DEBUG, "SoapySDRPlayProxy: Acquiring device open lock...");
+    SDRplayLockGuard openLock(g_proxyDeviceOpenLock, 60000, 0);  // 60s timeout, no cooldown
+    SoapySDR_log(SOAPY_SDR_DEBUG, "SoapySDRPlayProxy: Device open lock acquired");
+
+    std::lock_guard<std::recursive_mutex> workerLock(workerMutex_);
+    ensureWorker();
+
+    if (!sendCommand(configureCommand()))
+    {
+        throw std::runtime_error("Failed to send configure command");
+    }
+
+    IPCMessage configured;
+    if (!waitForStatus(IPCMessageType::STATUS_CONFIGURED, 15000, &configured))
+    {
+        throw std::runtime_error("Configure failed");
+    }
+    updateGainRanges(configured);
+
+    openLock.markSucceeded();
+    SoapySDR_log(SOAPY_SDR_DEBUG, "SoapySDRPlayProxy: Device configured, releasing lock");
+}
+
+IPCMessage SoapySDRPlayProxy::configureCommand() const
+{
+    IPCMessage cmd(IPCMessageType::CMD_CONFIGURE);
+    cmd.setParam("center_hz", channels_[0].centerFreq);
+    cmd.setParam("sample_rate", sampleRate_);
+    cmd.setParam("bandwidth", bandwidth_);
+    cmd.setParam("gain", channels_[0].gain);
+    cmd.setParam("agc", static_cast<int64_t>(channels_[0].agcEnabled ? 1 : 0));
+    cmd.setParam("antenna", channels_[0].antenna);
+
+    // Further tuners (RSPduo dual tuner); ignored by single-channel devices
+    for (size_t ch = 1; ch < MAX_CHANNELS; ch++)
+    {
+        const std::string prefix = "ch" + std::to_string(ch) + ".";
+        cmd.setParam(prefix + "center_hz", channels_[ch].centerFreq);
+        cmd.setParam(prefix + "gain", channels_[ch].gain);
+        cmd.setParam(prefix + "agc", static_cast<int64_t>(channels_[ch].agcEnabled ? 1 : 0));
+        cmd.setParam(prefix + "antenna", channels_[ch].antenna);
+    }
+    for (const auto& kv : settings_)
+    {
+        cmd.setParam("setting." + kv.first, kv.second);
+    }
+    return cmd;
+}
+
+SoapySDRPlayProxy::ChannelSettings& SoapySDRPlayProxy::channelSettings(size_t channel)
+{
+    if (channel >= MAX_CHANNELS)
+    {
+        throw std::runtime_error("Invalid channel " + std::to_string(channel));
+    }
+    return channels_[channel];
+}
+
+const SoapySDRPlayProxy::ChannelSettings& SoapySDRPlayProxy::channelSettings(size_t channel) const
+{
+    if (channel >= MAX_CHANNELS)
+    {
+        throw std::runtime_error("Invalid channel " + std::to_string(channel));
+    }
+    return channels_[channel];
+}
+
+void SoapySDRPlayProxy::updateGainRanges(size_t channel, const IPCMessage& status, const std::string& prefix)
+{
+    DeviceCapabilities ranges;
+    ranges.gains = capabilities_.gains;
+    if (!ranges.decodeGainRanges(status, prefix))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(gainRangesMutex_);
+    ChannelSettings& settings = channelSettings(channel);
+    settings.gainRange = ranges.gainRange;
+    settings.elementGainRanges = ranges.elementGainRanges;
+    settings.haveGainRanges = true;
+}
+
+void SoapySDRPlayProxy::updateGainRanges(const IPCMessage& configured)
+{
+    for (size_t ch = 0; ch < MAX_CHANNELS; ch++)
+    {
+        updateGainRanges(ch, configured, "ch" + std::to_string(ch) + ".");
+    }
+}
+
+SharedRingBuffer* SoapySDRPlayProxy::channelRing(size_t channel)
+{
+    if (channel == 0)
+    {
+        return ringBuffer_.get();
+    }
+
+    std::unique_ptr<SharedRingBuffer>& ring = channelRings_[channel - 1];
+    if (!ring)
+    {
+        ring.reset(SharedRingBuffer::create(channelShmName(shmName_, channel)));
+        if (!ring)
+        {
+            throw std::runtime_error("Failed to create shared memory for channel " + std::to_string(channel));
+        }
+    }
+    return ring.get();
+}
+
+const DeviceCapabilities& SoapySDRPlayProxy::capabilities() const
+{
+    if (!haveCapabilities_ && !capabilityOpenFailed_)
+    {
+        // The snapshot arrives when the worker opens the device, so a
+        // capability query before setupStream() opens it now
+        try
+        {
+            const_cast<SoapySDRPlayProxy*>(this)->openDevice();
+        }
+        catch (const std::exception& e)
+        {
+            SoapySDR_logf(SOAPY_SDR_WARNING, "SoapySDRPlayProxy: Could not open device for capabilities: %s", e.what());
+            capabilityOpenFailed_ = true;
+        }
+    }
+
+    if (!haveCapabilities_)
+    {
+        static const DeviceCapabilities defaults = defaultCapabilities();
+        return defaults;
+    }
+    return capabilities_;
+}
+
+DeviceCapabilities SoapySDRPlayProxy::defaultCapabilities()
+{
+    DeviceCapabilities caps;
+    caps.hardwareKey = "RSP";
+    caps.antennas = { "Antenna A", "Antenna B", "Hi-Z" };
+    caps.gains = { "IFGR", "RFGR" };
+    caps.gainRange = SoapySDR::Range(0, 59);
+    caps.frequencies = { "RF" };
+    caps.frequencyRange = { SoapySDR::Range(1e3, 2e9) };
+    caps.sampleRates = { 62500, 96000, 125000, 192000, 250000, 500000, 1000000, 2000000, 3000000, 4000000, 5000000, 6000000, 7000000, 8000000, 9000000, 10000000 };
+    caps.sampleRateRange = { SoapySDR::Range(62500, 10000000) };
+    caps.bandwidths = { 200000, 300000, 600000, 1536000, 5000000, 6000000, 7000000, 8000000 };
+    caps.bandwidthRange = { SoapySDR::Range(200000, 8000000) };
+    return caps;
+}
+
+void SoapySDRPlayProxy::setPipes(IPCPipePair* pipes)
+{
+    // The reactor must stop watching the old status pipe before it is closed
+    if (statusChannel_ && pipes_ && pipes_->childToParent())
+    {
+        IPCReactor::instance().detach(pipes_->childToParent()->fd());
+    }
+    statusChannel_.reset();
+    pipes_.reset(pipes);
+}
+
+void SoapySDRPlayProxy::attachStatusChannel()
+{
+    // After READY (read directly by WorkerSpawner/WorkerPool) all further
+    // status messages are dispatched by the shared reactor thread
+    if (!statusChannel_ && pipes_ && pipes_->childToParent())
+    {
+        statusChannel_ = IPCReactor::instance().attach(pipes_->childToParent()->fd());
+    }
+}
+
+bool SoapySDRPlayProxy::assignWorker()
+{
+    IPCMessage cmd(IPCMessageType::CMD_ASSIGN);
+    cmd.setParam("serial", serial_);
+    cmd.setParam("shm_name", shmName_);
+    for (const auto& kv : deviceArgs_)
+    {
+        // Open arguments such as the RSPduo mode
+        if (kv.first != "driver" && kv.first != "serial")
+        {
+            cmd.setParam("arg." + kv.first, kv.second);
+        }
+    }
+    return sendCommand(cmd) && waitForStatus(IPCMessageType::STATUS_ACK, 5000);
+}
+
+void SoapySDRPlayProxy::startMonitor()
+{
+    if (workerDeadlineMs_ == 0 || monitorThread_.joinable())
+    {
+        return;
+    }
+
+    monitorShutdown_ = false;
+    monitorThread_ = std::thread(&SoapySDRPlayProxy::monitorThreadFunc, this);
+}
+
+void SoapySDRPlayProxy::stopMonitor()
+{
+    {
+        std::lock_guard<std::mutex> lock(monitorMutex_);
+        monitorShutdown_ = true;
+    }
+    monitorCv_.notify_all();
+    if (monitorThread_.joinable())
+    {
+        monitorThread_.join();
+    }
+}
+
+bool SoapySDRPlayProxy::checkWorkerHealth(std::string& reason)
+{
+    if (workerPid_ > 0)
+    {
+        int status = 0;
+        if (waitpid(workerPid_, &status, WNOHANG) == workerPid_)
+        {
+            // Already reaped: make sure restartWorker() does not signal the pid
+            workerPid_ = -1;
+            reason = "worker process exited";
+            return false;
+        }
+    }
+
+    if (statusChannel_ && statusChannel_->closed())
+    {
+        reason = "worker closed its status pipe";
+        return false;
+    }
+
+    if (!ringBuffer_)
+    {
+        return true;
+    }
+
+    // A fresh worker gets one deadline to publish its first heartbeat
+    const auto sinceStart = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - workerStartTime_).count();
+    if (sinceStart < workerDeadlineMs_)
+    {
+        return true;
+    }
+
+    const int64_t deadline = static_cast<int64_t>(workerDeadlineMs_);
+    const int64_t commandAge = ringBuffer_->heartbeatAgeMs();
+    if (commandAge > deadline)
+    {
+        reason = "command loop heartbeat is " + std::to_string(commandAge) + " ms old";
+        return false;
+    }
+
+    const int64_t streamAge = ringBuffer_->streamHeartbeatAgeMs();
+    if (ringBuffer_->producerState() == RINGBUF_STATE_STREAMING && streamActive_ && streamAge > deadline)
+    {
+        reason = "streaming loop heartbeat is " + std::to_string(streamAge) + " ms old";
+        return false;
+    }
+
+    return true;
+}
+
+void SoapySDRPlayProxy::logDiscontinuities()
+{
+    const uint64_t discontinuities = discontinuities_.load(std::memory_order_acquire);
+    if (discontinuities == loggedDiscontinuities_)
+    {
+        return;
+    }
+    SoapySDR_logf(SOAPY_SDR_WARNING, "SoapySDRPlayProxy: Stream discontinuity: %llu time(s), last %llu samples lost",
+                 (unsigned long long)(discontinuities - loggedDiscontinuities_),
+                 (unsigned long long)lastDiscontinuityLost_.load(std::memory_order_relaxed));
+    loggedDiscontinuities_ = discontinuities;
+}
+
+void SoapySDRPlayProxy::monitorThreadFunc()
+{
+    const auto interval = std::chrono::milliseconds(std::max(50u, workerDeadlineMs_ / 4));
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(monitorMutex_);
+            monitorCv_.wait_for(lock, interval, [this]{ return monitorShutdown_; });
+            if (monitorShutdown_)
+            {
+                break;
+            }
+        }
+
+        logDiscontinuities();
+
+        // A command exchange in progress has its own timeout, and the worker's
+        // command loop may legitimately be busy with it: check again later
+        std::unique_lock<std::recursive_mutex> lock(workerMutex_, std::try_to_lock);
+        if (!lock.owns_lock() || !workerReady_)
+        {
+            continue;
+        }
+
+        std::string reason;
+        if (checkWorkerHealth(reason))
+        {
+            continue;
+        }
+
+        SoapySDR_logf(SOAPY_SDR_WARNING, "SoapySDRPlayProxy: Worker for device %s unresponsive (%s), restarting",
+                     serial_.c_str(), reason.c_str());
+        try
+        {
+            restartWorker();
+        }
+        catch (const std::exception&)
+        {
+            // Logged by restartWorker(); retry after the next deadline
+            workerStartTime_ = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+bool SoapySDRPlayProxy::sendCommand(const IPCMessage& cmd, unsigned int timeoutMs) const
 {
+    TraceScope trace("ipc_send", static_cast<uint64_t>(cmd.type));
+
     if (!pipes_ || !pipes_->parentToChild())
     {
         return false;
     }
 
+    // Replies still queued belong to earlier commands that timed out
+    if (statusChannel_)
+    {
+        statusChannel_->clearReplies();
+    }
+
     if (!pipes_->parentToChild()->send(cmd, timeoutMs))
     {
         SoapySDR_logf(SOAPY_SDR_ERROR, "SoapySDRPlayProxy: Failed to send command");
@@ -215,8 +688,11 @@ bool SoapySDRPlayProxy::sendCommand(const IPCMessage& cmd, unsigned int timeoutM
     return true;
 }
 
-bool SoapySDRPlayProxy::waitForStatus(IPCMessageType expectedType, unsigned int timeoutMs)
+bool SoapySDRPlayProxy::waitForStatus(IPCMessageType expectedType, unsigned int timeoutMs,
+                                      IPCMessage* reply) const
 {
+    TraceScope trace("ipc_wait", static_cast<uint64_t>(expectedType));
+
     if (!pipes_ || !pipes_->childToParent())
     {
         return false;
@@ -239,8 +715,16 @@ bool SoapySDRPlayProxy::waitForStatus(IPCMessageType expectedType, unsigned int
         unsigned int remainingMs = static_cast<unsigned int>(timeoutMs - elapsed);
 
         IPCMessage status;
-        if (!pipes_->childToParent()->receive(status, remainingMs))
+        const bool received = statusChannel_ ? statusChannel_->waitReply(status, remainingMs)
+                                             : pipes_->childToParent()->receive(status, remainingMs);
+        if (!received)
         {
+            if (statusChannel_ && statusChannel_->closed())
+            {
+                SoapySDR_logf(SOAPY_SDR_ERROR, "SoapySDRPlayProxy: Worker closed its status pipe while waiting for status %d",
+                             static_cast<int>(expectedType));
+                return false;
+            }
             SoapySDR_logf(SOAPY_SDR_ERROR, "SoapySDRPlayProxy: Timeout waiting for status %d",
                          static_cast<int>(expectedType));
             return false;
@@ -255,9 +739,24 @@ bool SoapySDRPlayProxy::waitForStatus(IPCMessageType expectedType, unsigned int
 
         if (status.type == expectedType || status.type == IPCMessageType::STATUS_ACK)
         {
+            if (reply != nullptr)
+            {
+                *reply = status;
+            }
             return true;
         }
 
+        // The capability snapshot precedes STATUS_CONFIGURED after the first open
+        if (status.type == IPCMessageType::STATUS_OPENED)
+        {
+            if (!haveCapabilities_)
+            {
+                capabilities_ = DeviceCapabilities::decode(status);
+                haveCapabilities_ = true;
+            }
+            continue;
+        }
+
         // Got unexpected status - log and try again
         SoapySDR_logf(SOAPY_SDR_DEBUG, "SoapySDRPlayProxy: Discarding unexpected status %d while waiting for %d",
                      static_cast<int>(status.type), static_cast<int>(expectedType));
@@ -273,12 +772,12 @@ std::string SoapySDRPlayProxy::getDriverKey() const
 
 std::string SoapySDRPlayProxy::getHardwareKey() const
 {
-    return "RSP";
+    return capabilities().hardwareKey;
 }
 
 SoapySDR::Kwargs SoapySDRPlayProxy::getHardwareInfo() const
 {
-    SoapySDR::Kwargs info;
+    SoapySDR::Kwargs info = capabilities().hardwareInfo;
     info["serial"] = serial_;
     info["proxy"] = "true";
     return info;
@@ -288,7 +787,7 @@ SoapySDR::Kwargs SoapySDRPlayProxy::getHardwareInfo() const
 
 size_t SoapySDRPlayProxy::getNumChannels(const int direction) const
 {
-    return (direction == SOAPY_SDR_RX) ? 1 : 0;
+    return (direction == SOAPY_SDR_RX) ? capabilities().numChannels : 0;
 }
 
 SoapySDR::Kwargs SoapySDRPlayProxy::getChannelInfo(const int /* direction */, const size_t /* channel */) const
@@ -317,7 +816,7 @@ SoapySDR::ArgInfoList SoapySDRPlayProxy::getStreamArgsInfo(const int /* directio
 SoapySDR::Stream* SoapySDRPlayProxy::setupStream(
     const int direction,
     const std::string& format,
-    const std::vector<size_t>& /* channels */,
+    const std::vector<size_t>& channels,
     const SoapySDR::Kwargs& /* args */)
 {
     if (direction != SOAPY_SDR_RX)
@@ -335,47 +834,41 @@ SoapySDR::Stream* SoapySDRPlayProxy::setupStream(
         throw std::runtime_error("Only CF32 and CS16 formats are supported in proxy mode");
     }
 
-    // Serialize device opening across all proxy instances
-    // The SDRplay API service can't handle concurrent device selection reliably
-    {
-        SoapySDR_log(SOAPY_SDR_DEBUG, "SoapySDRPlayProxy: Acquiring device open lock...");
-        SDRplayLockGuard openLock(g_proxyDeviceOpenLock, 60000, 0);  // 60s timeout, no cooldown
-        SoapySDR_log(SOAPY_SDR_DEBUG, "SoapySDRPlayProxy: Device open lock acquired");
-
-        ensureWorker();
-
-        // Send configure command
-        IPCMessage cmd(IPCMessageType::CMD_CONFIGURE);
-        cmd.setParam("center_hz", centerFreq_);
-        cmd.setParam("sample_rate", sampleRate_);
-        cmd.setParam("bandwidth", bandwidth_);
-        cmd.setParam("gain", gain_);
-        cmd.setParam("agc", static_cast<int64_t>(agcEnabled_ ? 1 : 0));
-        cmd.setParam("antenna", antenna_);
+    openDevice();
 
-        if (!sendCommand(cmd))
+    const std::vector<size_t> streamChannels = channels.empty() ? std::vector<size_t>{0} : channels;
+    const size_t numChannels = getNumChannels(SOAPY_SDR_RX);
+    for (size_t ch : streamChannels)
+    {
+        if (ch >= numChannels)
         {
-            throw std::runtime_error("Failed to send configure command");
+            throw std::runtime_error("Invalid channel " + std::to_string(ch));
         }
+    }
 
-        if (!waitForStatus(IPCMessageType::STATUS_CONFIGURED, 15000))
+    auto* stream = new SoapySDRPlayProxyStream();
+    {
+        std::lock_guard<std::recursive_mutex> workerLock(workerMutex_);
+        for (size_t ch : streamChannels)
         {
-            throw std::runtime_error("Configure failed");
+            stream->rings.push_back(channelRing(ch));
+            stream->metrics.push_back(&metrics_->channel(ch));
+            stream->metrics.back()->queueCapacity.store(
+                static_cast<uint32_t>(stream->rings.back()->capacity()), std::memory_order_relaxed);
         }
-
-        SoapySDR_log(SOAPY_SDR_DEBUG, "SoapySDRPlayProxy: Device configured, releasing lock");
-    }  // Lock released here - device is fully configured
-
-    auto* stream = new SoapySDRPlayProxyStream();
-    stream->ringBuffer = ringBuffer_.get();
+        streamChannels_ = streamChannels;
+    }
+    metrics_->page()->numChannels.store(static_cast<uint32_t>(streamChannels.size()), std::memory_order_relaxed);
+    stream->ringBuffer = stream->rings[0];
     stream->lastReadIdx = 0;
     stream->lastOverflowCount = 0;
     stream->useCS16 = useCS16;
 
-    // Pre-allocate conversion buffer to MTU size to avoid repeated reallocations
+    // The conversion buffer is allocated once, at the MTU: reads never
+    // grow or shrink it
     if (useCS16)
     {
-        stream->conversionBuffer.reserve(getStreamMTU(nullptr));
+        stream->conversionBuffer.resize(getStreamMTU(nullptr));
     }
 
     return reinterpret_cast<SoapySDR::Stream*>(stream);
@@ -404,7 +897,9 @@ size_t SoapySDRPlayProxy::getStreamMTU(SoapySDR::Stream* /* stream */) const
 
 int SoapySDRPlayProxy::activateStream(SoapySDR::Stream* /* stream */, const int /* flags */, const long long /* timeNs */, const size_t /* numElems */)
 {
+    std::lock_guard<std::recursive_mutex> workerLock(workerMutex_);
     IPCMessage cmd(IPCMessageType::CMD_START);
+    cmd.setParam("channels", joinChannels(streamChannels_));
     if (!sendCommand(cmd))
     {
         return SOAPY_SDR_STREAM_ERROR;
@@ -416,11 +911,13 @@ int SoapySDRPlayProxy::activateStream(SoapySDR::Stream* /* stream */, const int
     }
 
     streamActive_ = true;
+    metrics_->page()->streaming.store(1, std::memory_order_relaxed);
     return 0;
 }
 
 int SoapySDRPlayProxy::deactivateStream(SoapySDR::Stream* /* stream */, const int /* flags */, const long long /* timeNs */)
 {
+    std::lock_guard<std::recursive_mutex> workerLock(workerMutex_);
     if (!streamActive_)
     {
         return 0;
@@ -434,9 +931,61 @@ int SoapySDRPlayProxy::deactivateStream(SoapySDR::Stream* /* stream */, const in
 
     waitForStatus(IPCMessageType::STATUS_STOPPED, 5000);
     streamActive_ = false;
+    metrics_->page()->streaming.store(0, std::memory_order_relaxed);
     return 0;
 }
 
+// Read up to numElems samples of one channel, converting to CS16 if needed
+static size_t readRingSamples(SoapySDRPlayProxyStream* proxyStream, SharedRingBuffer* ring,
+                              void* out, size_t numElems, long timeoutUs)
+{
+    if (!proxyStream->useCS16)
+    {
+        // Read directly as CF32
+        return ring->read(reinterpret_cast<std::complex<float>*>(out), numElems, timeoutUs);
+    }
+
+    // Read into conversion buffer, then convert CF32 -> CS16; a request
+    // larger than the MTU returns at most an MTU of samples
+    const size_t maxElems = std::min(numElems, proxyStream->conversionBuffer.size());
+    size_t count = ring->read(proxyStream->conversionBuffer.data(), maxElems, timeoutUs);
+
+    // Convert CF32 to CS16 (scale by 32767)
+    convertCF32ToCS16(proxyStream->conversionBuffer.data(), static_cast<int16_t*>(out), count);
+    return count;
+}
+
+bool SoapySDRPlayProxy::takeStreamGap(SoapySDRPlayProxyStream* proxyStream)
+{
+    // Every channel's ring carries the marker
+    uint64_t lostSamples = 0;
+    bool gap = false;
+    for (SharedRingBuffer* ring : proxyStream->rings)
+    {
+        uint64_t lost = 0;
+        if (ring->takeGap(lost))
+        {
+            lostSamples = std::max(lostSamples, lost);
+            gap = true;
+        }
+    }
+    if (!gap)
+    {
+        return false;
+    }
+
+    lostSamples_ += lostSamples;
+    for (ChannelMetrics* channelMetrics : proxyStream->metrics)
+    {
+        channelMetrics->recordGap(lostSamples);
+    }
+    Tracer::instance().overflow();
+    // logged by the monitor (logDiscontinuities()): no formatting here
+    lastDiscontinuityLost_.store(lostSamples, std::memory_order_relaxed);
+    discontinuities_.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
 int SoapySDRPlayProxy::readStream(
     SoapySDR::Stream* stream,
     void* const* buffs,
@@ -451,81 +1000,65 @@ int SoapySDRPlayProxy::readStream(
     flags = 0;
     timeNs = 0;
 
-    size_t count;
-
-    if (proxyStream->useCS16)
+    // Report a discontinuity (e.g. a worker restart) once, then continue
+    // with the samples after it
+    if (takeStreamGap(proxyStream))
     {
-        // Read into conversion buffer, then convert CF32 -> CS16
-        if (proxyStream->conversionBuffer.size() < numElems)
-        {
-            proxyStream->conversionBuffer.resize(numElems);
-        }
-        else if (proxyStream->conversionBuffer.capacity() > numElems * 4 &&
-                 proxyStream->conversionBuffer.capacity() > 65536)
-        {
-            // Shrink if capacity is 4x larger than needed and exceeds default MTU
-            // This prevents unbounded memory growth from occasional large reads
-            proxyStream->conversionBuffer.resize(numElems);
-            proxyStream->conversionBuffer.shrink_to_fit();
-        }
+        return SOAPY_SDR_OVERFLOW;
+    }
 
-        count = buffer->read(
-            proxyStream->conversionBuffer.data(),
-            numElems,
-            timeoutUs
-        );
+    size_t count = readRingSamples(proxyStream, buffer, buffs[0], numElems, timeoutUs);
 
-        if (count > 0)
+    // The worker writes the other channels before the first one, so the
+    // same number of samples is already waiting in their rings
+    const size_t elemSize = proxyStream->useCS16 ? 2 * sizeof(int16_t) : sizeof(std::complex<float>);
+    for (size_t i = 1; i < proxyStream->rings.size() && count > 0; i++)
+    {
+        auto* out = static_cast<uint8_t*>(buffs[i]);
+        size_t got = 0;
+        while (got < count)
         {
-            // Convert CF32 to CS16 (scale by 32767)
-            auto* output = reinterpret_cast<int16_t*>(buffs[0]);
-            for (size_t i = 0; i < count; i++)
+            size_t n = readRingSamples(proxyStream, proxyStream->rings[i], out + got * elemSize, count - got, timeoutUs);
+            if (n == 0)
             {
-                const auto& sample = proxyStream->conversionBuffer[i];
-                // Clamp and scale to int16 range
-                float re = sample.real() * 32767.0f;
-                float im = sample.imag() * 32767.0f;
-                re = std::max(-32768.0f, std::min(32767.0f, re));
-                im = std::max(-32768.0f, std::min(32767.0f, im));
-                output[2 * i] = static_cast<int16_t>(re);
-                output[2 * i + 1] = static_cast<int16_t>(im);
+                break;
             }
+            got += n;
+        }
+        if (got < count)
+        {
+            // Keep the channels aligned even if one ring dropped samples
+            std::memset(out + got * elemSize, 0, (count - got) * elemSize);
+            flags |= SOAPY_SDR_HAS_TIME;  // Use as overflow indicator
         }
-    }
-    else
-    {
-        // Read directly as CF32
-        count = buffer->read(
-            reinterpret_cast<std::complex<float>*>(buffs[0]),
-            numElems,
-            timeoutUs
-        );
     }
 
     if (count == 0)
     {
-        // Check if worker is still making progress
-        uint64_t currentWriteIdx = buffer->writeIndex();
-        if (currentWriteIdx == proxyStream->lastSeenWriteIdx)
+        // Without the monitor thread, fall back to detecting a stalled
+        // worker from the reads that time out
+        if (workerDeadlineMs_ == 0)
         {
-            proxyStream->staleWriteCount++;
-            if (proxyStream->staleWriteCount >= SoapySDRPlayProxyStream::MAX_STALE_READS)
+            uint64_t currentWriteIdx = buffer->writeIndex();
+            if (currentWriteIdx == proxyStream->lastSeenWriteIdx)
+            {
+                proxyStream->staleWriteCount++;
+                if (proxyStream->staleWriteCount >= SoapySDRPlayProxyStream::MAX_STALE_READS)
+                {
+                    SoapySDR_logf(SOAPY_SDR_WARNING,
+                        "SoapySDRPlayProxy: Ring buffer stalled (write index %llu unchanged for %d reads), restarting worker",
+                        (unsigned long long)currentWriteIdx, proxyStream->staleWriteCount);
+                    // The ring buffer (and this stream's read position) survives
+                    restartWorker();
+                    proxyStream->staleWriteCount = 0;
+                }
+            }
+            else
             {
-                SoapySDR_logf(SOAPY_SDR_WARNING,
-                    "SoapySDRPlayProxy: Ring buffer stalled (write index %llu unchanged for %d reads), restarting worker",
-                    (unsigned long long)currentWriteIdx, proxyStream->staleWriteCount);
-                restartWorker();
-                // Update stream's buffer pointer since restartWorker creates a new buffer
-                proxyStream->ringBuffer = ringBuffer_.get();
+                proxyStream->lastSeenWriteIdx = currentWriteIdx;
                 proxyStream->staleWriteCount = 0;
-                proxyStream->lastSeenWriteIdx = 0;
             }
         }
-        else
-        {
-            proxyStream->lastSeenWriteIdx = currentWriteIdx;
-            proxyStream->staleWriteCount = 0;
-        }
         return SOAPY_SDR_TIMEOUT;
     }
 
@@ -537,9 +1070,17 @@ int SoapySDRPlayProxy::readStream(
     if (currentOverflow > proxyStream->lastOverflowCount)
     {
         flags |= SOAPY_SDR_HAS_TIME;  // Use as overflow indicator
+        metricsAdd(proxyStream->metrics[0]->overflows, currentOverflow - proxyStream->lastOverflowCount);
         proxyStream->lastOverflowCount = currentOverflow;
     }
 
+    for (size_t i = 0; i < proxyStream->rings.size(); i++)
+    {
+        metricsAdd(proxyStream->metrics[i]->samplesDelivered, count);
+        proxyStream->metrics[i]->queueDepth.store(
+            static_cast<uint32_t>(proxyStream->rings[i]->available()), std::memory_order_relaxed);
+    }
+
     return static_cast<int>(count);
 }
 
@@ -564,6 +1105,19 @@ int SoapySDRPlayProxy::acquireReadBuffer(SoapySDR::Stream* stream, size_t& handl
     timeNs = 0;
     handle = 0;
 
+    // Direct access exposes a single ring; multi-channel streams use readStream()
+    if (proxyStream->rings.size() > 1)
+    {
+        return SOAPY_SDR_NOT_SUPPORTED;
+    }
+
+    // As in readStream(): getReadPtr() stops at a gap, which is reported
+    // once before the samples after it are handed out
+    if (takeStreamGap(proxyStream))
+    {
+        return SOAPY_SDR_OVERFLOW;
+    }
+
     // Get direct pointer to ring buffer
     size_t available = 0;
     const std::complex<float>* ptr = buffer->getReadPtr(&available);
@@ -583,9 +1137,18 @@ int SoapySDRPlayProxy::acquireReadBuffer(SoapySDR::Stream* stream, size_t& handl
             std::this_thread::sleep_for(std::chrono::microseconds(100));
             ptr = buffer->getReadPtr(&available);
         }
+
+        // The samples that arrived meanwhile may follow a gap
+        if (takeStreamGap(proxyStream))
+        {
+            return SOAPY_SDR_OVERFLOW;
+        }
     }
 
     buffs[0] = ptr;
+    proxyStream->acquiredElems = available;
+    metricsAdd(proxyStream->metrics[0]->samplesDelivered, available);
+    proxyStream->metrics[0]->queueDepth.store(static_cast<uint32_t>(buffer->available()), std::memory_order_relaxed);
     return static_cast<int>(available);
 }
 
@@ -594,27 +1157,28 @@ void SoapySDRPlayProxy::releaseReadBuffer(SoapySDR::Stream* stream, const size_t
     (void)handle;  // We only have one buffer
     auto* proxyStream = reinterpret_cast<SoapySDRPlayProxyStream*>(stream);
 
-    // This should advance by the amount actually consumed
-    // For now, assume full buffer was consumed
-    size_t available = 0;
-    proxyStream->ringBuffer->getReadPtr(&available);
-    proxyStream->ringBuffer->advanceRead(available);
+    // Advance by what acquireReadBuffer() handed out: samples written since
+    // (possibly after a gap) are left for the next acquire
+    proxyStream->ringBuffer->advanceRead(proxyStream->acquiredElems);
+    proxyStream->acquiredElems = 0;
 }
 
 // Antenna API
 
 std::vector<std::string> SoapySDRPlayProxy::listAntennas(const int /* direction */, const size_t /* channel */) const
 {
-    return { "Antenna A", "Antenna B", "Hi-Z" };
+    return capabilities().antennas;
 }
 
-void SoapySDRPlayProxy::setAntenna(const int /* direction */, const size_t /* channel */, const std::string& name)
+void SoapySDRPlayProxy::setAntenna(const int /* direction */, const size_t channel, const std::string& name)
 {
-    antenna_ = name;
+    channelSettings(channel).antenna = name;
 
     if (workerReady_)
     {
+        std::lock_guard<std::recursive_mutex> workerLock(workerMutex_);
         IPCMessage cmd(IPCMessageType::CMD_SET_ANTENNA);
+        cmd.setParam("channel", static_cast<int64_t>(channel));
         cmd.setParam("value", name);
         if (!sendCommand(cmd))
         {
@@ -627,9 +1191,9 @@ void SoapySDRPlayProxy::setAntenna(const int /* direction */, const size_t /* ch
     }
 }
 
-std::string SoapySDRPlayProxy::getAntenna(const int /* direction */, const size_t /* channel */) const
+std::string SoapySDRPlayProxy::getAntenna(const int /* direction */, const size_t channel) const
 {
-    return antenna_;
+    return channelSettings(channel).antenna;
 }
 
 // DC Offset Mode API
@@ -653,21 +1217,23 @@ bool SoapySDRPlayProxy::getDCOffsetMode(const int /* direction */, const size_t
 
 std::vector<std::string> SoapySDRPlayProxy::listGains(const int /* direction */, const size_t /* channel */) const
 {
-    return { "IFGR", "RFGR" };
+    return capabilities().gains;
 }
 
 bool SoapySDRPlayProxy::hasGainMode(const int /* direction */, const size_t /* channel */) const
 {
-    return true;
+    return capabilities().hasGainMode;
 }
 
-void SoapySDRPlayProxy::setGainMode(const int /* direction */, const size_t /* channel */, const bool automatic)
+void SoapySDRPlayProxy::setGainMode(const int /* direction */, const size_t channel, const bool automatic)
 {
-    agcEnabled_ = automatic;
+    channelSettings(channel).agcEnabled = automatic;
 
     if (workerReady_)
     {
+        std::lock_guard<std::recursive_mutex> workerLock(workerMutex_);
         IPCMessage cmd(IPCMessageType::CMD_SET_AGC);
+        cmd.setParam("channel", static_cast<int64_t>(channel));
         cmd.setParam("value", static_cast<int64_t>(automatic ? 1 : 0));
         if (!sendCommand(cmd))
         {
@@ -680,18 +1246,20 @@ void SoapySDRPlayProxy::setGainMode(const int /* direction */, const size_t /* c
     }
 }
 
-bool SoapySDRPlayProxy::getGainMode(const int /* direction */, const size_t /* channel */) const
+bool SoapySDRPlayProxy::getGainMode(const int /* direction */, const size_t channel) const
 {
-    return agcEnabled_;
+    return channelSettings(channel).agcEnabled;
 }
 
-void SoapySDRPlayProxy::setGain(const int /* direction */, const size_t /* channel */, const double value)
+void SoapySDRPlayProxy::setGain(const int /* direction */, const size_t channel, const double value)
 {
-    gain_ = value;
+    channelSettings(channel).gain = value;
 
     if (workerReady_)
     {
+        std::lock_guard<std::recursive_mutex> workerLock(workerMutex_);
         IPCMessage cmd(IPCMessageType::CMD_SET_GAIN);
+        cmd.setParam("channel", static_cast<int64_t>(channel));
         cmd.setParam("value", value);
         if (!sendCommand(cmd))
         {
@@ -704,49 +1272,82 @@ void SoapySDRPlayProxy::setGain(const int /* direction */, const size_t /* chann
     }
 }
 
-void SoapySDRPlayProxy::setGain(const int direction, const size_t channel, const std::string& /* name */, const double value)
+void SoapySDRPlayProxy::setGain(const int /* direction */, const size_t channel, const std::string& name, const double value)
 {
-    setGain(direction, channel, value);
+    if (workerReady_)
+    {
+        std::lock_guard<std::recursive_mutex> workerLock(workerMutex_);
+        IPCMessage cmd(IPCMessageType::CMD_SET_GAIN);
+        cmd.setParam("channel", static_cast<int64_t>(channel));
+        cmd.setParam("name", name);
+        cmd.setParam("value", value);
+        if (!sendCommand(cmd))
+        {
+            throw std::runtime_error("Failed to send setGain command to worker");
+        }
+        if (!waitForStatus(IPCMessageType::STATUS_ACK, 5000))
+        {
+            throw std::runtime_error("setGain command failed or timed out");
+        }
+    }
 }
 
-double SoapySDRPlayProxy::getGain(const int /* direction */, const size_t /* channel */) const
+double SoapySDRPlayProxy::getGain(const int /* direction */, const size_t channel) const
 {
-    return gain_;
+    return channelSettings(channel).gain;
 }
 
-double SoapySDRPlayProxy::getGain(const int /* direction */, const size_t /* channel */, const std::string& /* name */) const
+double SoapySDRPlayProxy::getGain(const int /* direction */, const size_t channel, const std::string& /* name */) const
 {
-    return gain_;
+    return channelSettings(channel).gain;
 }
 
-SoapySDR::Range SoapySDRPlayProxy::getGainRange(const int /* direction */, const size_t /* channel */) const
+SoapySDR::Range SoapySDRPlayProxy::getGainRange(const int /* direction */, const size_t channel) const
 {
-    return SoapySDR::Range(0, 59);
+    const DeviceCapabilities& caps = capabilities();
+    std::lock_guard<std::mutex> lock(gainRangesMutex_);
+    const ChannelSettings& settings = channelSettings(channel);
+    return settings.haveGainRanges ? settings.gainRange : caps.gainRange;
 }
 
-SoapySDR::Range SoapySDRPlayProxy::getGainRange(const int /* direction */, const size_t /* channel */, const std::string& /* name */) const
+SoapySDR::Range SoapySDRPlayProxy::getGainRange(const int /* direction */, const size_t channel, const std::string& name) const
 {
-    return SoapySDR::Range(0, 59);
+    const DeviceCapabilities& caps = capabilities();
+    std::lock_guard<std::mutex> lock(gainRangesMutex_);
+    const ChannelSettings& settings = channelSettings(channel);
+    const std::map<std::string, SoapySDR::Range>& ranges =
+        settings.haveGainRanges ? settings.elementGainRanges : caps.elementGainRanges;
+    auto it = ranges.find(name);
+    if (it != ranges.end())
+    {
+        return it->second;
+    }
+    return settings.haveGainRanges ? settings.gainRange : caps.gainRange;
 }
 
 // Frequency API
 
-void SoapySDRPlayProxy::setFrequency(const int /* direction */, const size_t /* channel */, const double frequency, const SoapySDR::Kwargs& /* args */)
+void SoapySDRPlayProxy::setFrequency(const int /* direction */, const size_t channel, const double frequency, const SoapySDR::Kwargs& /* args */)
 {
-    centerFreq_ = frequency;
+    channelSettings(channel).centerFreq = frequency;
 
     if (workerReady_)
     {
+        std::lock_guard<std::recursive_mutex> workerLock(workerMutex_);
         IPCMessage cmd(IPCMessageType::CMD_SET_FREQUENCY);
+        cmd.setParam("channel", static_cast<int64_t>(channel));
         cmd.setParam("value", frequency);
         if (!sendCommand(cmd))
         {
             throw std::runtime_error("Failed to send setFrequency command to worker");
         }
-        if (!waitForStatus(IPCMessageType::STATUS_ACK, 5000))
+        IPCMessage ack;
+        if (!waitForStatus(IPCMessageType::STATUS_ACK, 5000, &ack))
         {
             throw std::runtime_error("setFrequency command failed or timed out");
         }
+        // The RF gain range depends on the band
+        updateGainRanges(channel, ack);
     }
 }
 
@@ -755,29 +1356,31 @@ void SoapySDRPlayProxy::setFrequency(const int direction, const size_t channel,
     setFrequency(direction, channel, frequency, args);
 }
 
-double SoapySDRPlayProxy::getFrequency(const int /* direction */, const size_t /* channel */) const
+double SoapySDRPlayProxy::getFrequency(const int /* direction */, const size_t channel) const
 {
-    return centerFreq_;
+    return channelSettings(channel).centerFreq;
 }
 
-double SoapySDRPlayProxy::getFrequency(const int /* direction */, const size_t /* channel */, const std::string& /* name */) const
+double SoapySDRPlayProxy::getFrequency(const int /* direction */, const size_t channel, const std::string& /* name */) const
 {
-    return centerFreq_;
+    return channelSettings(channel).centerFreq;
 }
 
 std::vector<std::string> SoapySDRPlayProxy::listFrequencies(const int /* direction */, const size_t /* channel */) const
 {
-    return { "RF" };
+    return capabilities().frequencies;
 }
 
 SoapySDR::RangeList SoapySDRPlayProxy::getFrequencyRange(const int /* direction */, const size_t /* channel */) const
 {
-    return { SoapySDR::Range(1e3, 2e9) };
+    return capabilities().frequencyRange;
 }
 
-SoapySDR::RangeList SoapySDRPlayProxy::getFrequencyRange(const int /* direction */, const size_t /* channel */, const std::string& /* name */) const
+SoapySDR::RangeList SoapySDRPlayProxy::getFrequencyRange(const int /* direction */, const size_t /* channel */, const std::string& name) const
 {
-    return { SoapySDR::Range(1e3, 2e9) };
+    const DeviceCapabilities& caps = capabilities();
+    auto it = caps.elementFrequencyRanges.find(name);
+    return it != caps.elementFrequencyRanges.end() ? it->second : caps.frequencyRange;
 }
 
 SoapySDR::ArgInfoList SoapySDRPlayProxy::getFrequencyArgsInfo(const int /* direction */, const size_t /* channel */) const
@@ -787,13 +1390,16 @@ SoapySDR::ArgInfoList SoapySDRPlayProxy::getFrequencyArgsInfo(const int /* direc
 
 // Sample Rate API
 
-void SoapySDRPlayProxy::setSampleRate(const int /* direction */, const size_t /* channel */, const double rate)
+void SoapySDRPlayProxy::setSampleRate(const int /* direction */, const size_t channel, const double rate)
 {
     sampleRate_ = rate;
+    metrics_->page()->sampleRate.store(static_cast<uint32_t>(rate), std::memory_order_relaxed);
 
     if (workerReady_)
     {
+        std::lock_guard<std::recursive_mutex> workerLock(workerMutex_);
         IPCMessage cmd(IPCMessageType::CMD_SET_SAMPLE_RATE);
+        cmd.setParam("channel", static_cast<int64_t>(channel));
         cmd.setParam("value", rate);
         if (!sendCommand(cmd))
         {
@@ -813,23 +1419,25 @@ double SoapySDRPlayProxy::getSampleRate(const int /* direction */, const size_t
 
 std::vector<double> SoapySDRPlayProxy::listSampleRates(const int /* direction */, const size_t /* channel */) const
 {
-    return { 62500, 96000, 125000, 192000, 250000, 500000, 1000000, 2000000, 3000000, 4000000, 5000000, 6000000, 7000000, 8000000, 9000000, 10000000 };
+    return capabilities().sampleRates;
 }
 
 SoapySDR::RangeList SoapySDRPlayProxy::getSampleRateRange(const int /* direction */, const size_t /* channel */) const
 {
-    return { SoapySDR::Range(62500, 10000000) };
+    return capabilities().sampleRateRange;
 }
 
 // Bandwidth API
 
-void SoapySDRPlayProxy::setBandwidth(const int /* direction */, const size_t /* channel */, const double bw)
+void SoapySDRPlayProxy::setBandwidth(const int /* direction */, const size_t channel, const double bw)
 {
     bandwidth_ = bw;
 
     if (workerReady_)
     {
+        std::lock_guard<std::recursive_mutex> workerLock(workerMutex_);
         IPCMessage cmd(IPCMessageType::CMD_SET_BANDWIDTH);
+        cmd.setParam("channel", static_cast<int64_t>(channel));
         cmd.setParam("value", bw);
         if (!sendCommand(cmd))
         {
@@ -849,27 +1457,138 @@ double SoapySDRPlayProxy::getBandwidth(const int /* direction */, const size_t /
 
 std::vector<double> SoapySDRPlayProxy::listBandwidths(const int /* direction */, const size_t /* channel */) const
 {
-    return { 200000, 300000, 600000, 1536000, 5000000, 6000000, 7000000, 8000000 };
+    return capabilities().bandwidths;
 }
 
 SoapySDR::RangeList SoapySDRPlayProxy::getBandwidthRange(const int /* direction */, const size_t /* channel */) const
 {
-    return { SoapySDR::Range(200000, 8000000) };
+    return capabilities().bandwidthRange;
 }
 
 // Settings API
 
 SoapySDR::ArgInfoList SoapySDRPlayProxy::getSettingInfo() const
 {
-    return SoapySDR::ArgInfoList();
+    return capabilities().settingInfo;
 }
 
-void SoapySDRPlayProxy::writeSetting(const std::string& /* key */, const std::string& /* value */)
+void SoapySDRPlayProxy::writeSetting(const std::string& key, const std::string& value)
 {
-    // Settings not yet implemented in proxy mode
+    if (key == "metrics_export")
+    {
+        if (value.empty() || value == "0" || value == "off")
+        {
+            MetricsExporter::instance().stop();
+        }
+        else
+        {
+            MetricsExporter::instance().start(value);
+        }
+        return;
+    }
+
+    // The tracer of this process records the IPC commands and reads, the
+    // worker's the driver; the worker writes its dumps next to ours
+    std::string workerValue = value;
+    if (Tracer::instance().writeSetting(key, value) && key != "trace")
+    {
+        workerValue = value.empty() ? value : Tracer::workerPath(value);
+    }
+
+    std::lock_guard<std::recursive_mutex> workerLock(workerMutex_);
+
+    // Cached so that configure (including after a worker restart) replays
+    // it; a dump is not repeated
+    if (key != "trace_dump")
+    {
+        settings_[key] = workerValue;
+    }
+
+    if (workerReady_)
+    {
+        IPCMessage cmd(IPCMessageType::CMD_WRITE_SETTING);
+        cmd.setParam("key", key);
+        cmd.setParam("value", workerValue);
+        if (!sendCommand(cmd))
+        {
+            throw std::runtime_error("Failed to send writeSetting command to worker");
+        }
+        if (!waitForStatus(IPCMessageType::STATUS_ACK, 5000))
+        {
+            throw std::runtime_error("writeSetting command failed or timed out");
+        }
+    }
 }
 
-std::string SoapySDRPlayProxy::readSetting(const std::string& /* key */) const
+std::string SoapySDRPlayProxy::readSetting(const std::string& key) const
 {
-    return "";
+    // Worker recovery statistics
+    if (key == "worker_restarts")
+    {
+        return std::to_string(restartCount_.load());
+    }
+    else if (key == "recovery_time_ms")
+    {
+        return std::to_string(lastRecoveryMs_.load());
+    }
+    else if (key == "lost_samples")
+    {
+        return std::to_string(lostSamples_.load());
+    }
+    else if (key == "worker_state")
+    {
+        static const char* names[] = { "none", "idle", "streaming", "exiting" };
+        const uint32_t state = ringBuffer_ ? ringBuffer_->producerState() : RINGBUF_STATE_NONE;
+        return state <= RINGBUF_STATE_EXITING ? names[state] : "unknown";
+    }
+    else if (key == "worker_pid")
+    {
+        std::lock_guard<std::recursive_mutex> lock(workerMutex_);
+        return std::to_string(workerPid_);
+    }
+    else if (key == "overflow_events")
+    {
+        // STATUS_OVERFLOW notices from the worker, counted as they arrive
+        return std::to_string(statusChannel_ ? statusChannel_->overflowEvents() : 0);
+    }
+    else if (key == "dropped_samples")
+    {
+        return std::to_string(statusChannel_ ? statusChannel_->droppedSamples() : 0);
+    }
+    else if (key == "worker_heartbeat_age_ms")
+    {
+        return std::to_string(ringBuffer_ ? ringBuffer_->heartbeatAgeMs() : -1);
+    }
+    else if (key == "metrics_export")
+    {
+        return MetricsExporter::instance().endpoint();
+    }
+    else if (key == "metrics_page")
+    {
+        // This proxy's page; the worker publishes the driver's under its own pid
+        return metrics_->name();
+    }
+
+    std::string traceValue;
+    if (Tracer::instance().readSetting(key, traceValue))
+    {
+        return traceValue;
+    }
+
+    // Everything else is a driver setting read from the worker's device
+    std::lock_guard<std::recursive_mutex> workerLock(workerMutex_);
+    if (workerReady_)
+    {
+        IPCMessage cmd(IPCMessageType::CMD_READ_SETTING);
+        cmd.setParam("key", key);
+        IPCMessage reply;
+        if (sendCommand(cmd) && waitForStatus(IPCMessageType::STATUS_ACK, 5000, &reply))
+        {
+            return reply.getParam("value");
+        }
+    }
+
+    // Device not open yet: report the value that will be applied
+    auto it = settings_.find(key);
+    return it != settings_.end() ? it->second : "";
 }
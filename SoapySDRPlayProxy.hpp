@@ -29,10 +29,19 @@
 #include "IPCPipe.hpp"
 #include "RingBuffer.hpp"
 #include "SoapySDRPlayWorker.hpp"
+#include "IPCReactor.hpp"
+#include "DeviceMetrics.hpp"
 
 #include <memory>
 #include <string>
+#include <map>
+#include <vector>
 #include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+struct SoapySDRPlayProxyStream;
 
 // Proxy device that forwards to a worker subprocess
 // Implements SoapySDR::Device interface transparently
@@ -134,14 +143,53 @@ private:
     // Ensure worker is running
     void ensureWorker();
 
+    // Start the worker if needed and open/configure the device
+    void openDevice();
+
+    // CMD_CONFIGURE carrying the cached settings
+    IPCMessage configureCommand() const;
+
+    // Snapshot received with STATUS_OPENED (opens the device on first use);
+    // generic RSP values if the device cannot be opened
+    const DeviceCapabilities& capabilities() const;
+    static DeviceCapabilities defaultCapabilities();
+
     // Restart worker process (for recovery from stalls)
     void restartWorker();
 
+    // Bind a warm pooled worker to this device and ring buffer
+    bool assignWorker();
+
+    // Take over a warm worker (pooled or leased from sdrplay_broker) and
+    // assign it; terminates it and returns false if it is unusable
+    bool adoptWorker(IPCPipePair* pipes, bool ready, const char* source);
+
+    // Terminate the worker, or end its lease if the broker owns it
+    void terminateWorker();
+
+    // Replace the worker pipes, detaching the old status pipe from the reactor
+    void setPipes(IPCPipePair* pipes);
+
+    // Hand the status pipe to the shared reactor once READY was received
+    void attachStatusChannel();
+
+    // Worker liveness monitor: restarts a dead or stalled worker within
+    // workerDeadlineMs_, independently of how often readStream() is called
+    void startMonitor();
+    void stopMonitor();
+    void monitorThreadFunc();
+    bool checkWorkerHealth(std::string& reason);
+    void logDiscontinuities();
+
+    // Report the gaps at the read position of a stream's rings; true if any
+    bool takeStreamGap(SoapySDRPlayProxyStream* proxyStream);
+
     // Send command and wait for response
-    bool sendCommand(const IPCMessage& cmd, unsigned int timeoutMs = 5000);
+    bool sendCommand(const IPCMessage& cmd, unsigned int timeoutMs = 5000) const;
 
-    // Wait for specific status type
-    bool waitForStatus(IPCMessageType expectedType, unsigned int timeoutMs = 5000);
+    // Wait for specific status type, optionally returning the message
+    bool waitForStatus(IPCMessageType expectedType, unsigned int timeoutMs = 5000,
+                       IPCMessage* reply = nullptr) const;
 
     // Device arguments
     SoapySDR::Kwargs deviceArgs_;
@@ -149,34 +197,98 @@ private:
 
     // Worker process
     pid_t workerPid_ = -1;
+    int brokerLease_ = -1;  // Connection holding the worker's lease, if leased
     std::unique_ptr<IPCPipePair> pipes_;
+    std::shared_ptr<IPCStatusChannel> statusChannel_;  // Replies and async events from the reactor
 
-    // Shared memory
+    // Shared memory: ringBuffer_ carries channel 0 and the worker's
+    // heartbeat; further channels (RSPduo dual tuner) get their own ring
+    static constexpr size_t MAX_CHANNELS = 2;
     std::unique_ptr<SharedRingBuffer> ringBuffer_;
+    std::unique_ptr<SharedRingBuffer> channelRings_[MAX_CHANNELS - 1];
     std::string shmName_;
+    std::vector<size_t> streamChannels_{0};  // Channels of the current stream
+
+    // Ring for a channel, created on first use
+    SharedRingBuffer* channelRing(size_t channel);
+
+    // Per-tuner cached settings
+    struct ChannelSettings
+    {
+        double centerFreq = 100e6;
+        double gain = 40;
+        bool agcEnabled = true;
+        std::string antenna;
+
+        // Gain ranges at the current frequency, reported by the worker with
+        // each retune (guarded by gainRangesMutex_)
+        bool haveGainRanges = false;
+        SoapySDR::Range gainRange;
+        std::map<std::string, SoapySDR::Range> elementGainRanges;
+    };
+    ChannelSettings channels_[MAX_CHANNELS];
+    ChannelSettings& channelSettings(size_t channel);
+    const ChannelSettings& channelSettings(size_t channel) const;
+
+    // Take the gain ranges a worker status carries for a channel
+    void updateGainRanges(size_t channel, const IPCMessage& status, const std::string& prefix = "");
+    void updateGainRanges(const IPCMessage& configured);
+    mutable std::mutex gainRangesMutex_;
 
     // Cached settings
-    mutable double centerFreq_ = 100e6;
     mutable double sampleRate_ = 2e6;
     mutable double bandwidth_ = 0;
-    mutable double gain_ = 40;
-    mutable bool agcEnabled_ = true;
-    mutable std::string antenna_;
     mutable bool dcOffsetMode_ = true;
+    std::map<std::string, std::string> settings_;  // writeSetting() values, replayed on configure
+
+    // Device capabilities, immutable once received
+    mutable DeviceCapabilities capabilities_;
+    mutable std::atomic<bool> haveCapabilities_{false};
+    mutable bool capabilityOpenFailed_ = false;
 
     // State
     std::atomic<bool> workerReady_{false};
     std::atomic<bool> streamActive_{false};
+
+    // Serializes command/status exchanges and worker restarts between the
+    // API caller and the monitor thread (recursive: restartWorker() reuses
+    // the command helpers)
+    mutable std::recursive_mutex workerMutex_;
+
+    // Worker liveness monitor
+    unsigned int workerDeadlineMs_ = 2000;  // 0 disables the monitor
+    std::thread monitorThread_;
+    std::mutex monitorMutex_;
+    std::condition_variable monitorCv_;
+    bool monitorShutdown_ = false;
+    std::chrono::steady_clock::time_point workerStartTime_;
+
+    // Worker recovery statistics
+    std::atomic<uint64_t> restartCount_{0};
+    std::atomic<long long> lastRecoveryMs_{0};
+    std::atomic<uint64_t> lostSamples_{0};
+
+    // Discontinuities reported by the read paths, logged by the monitor
+    std::atomic<uint64_t> discontinuities_{0};
+    std::atomic<uint64_t> lastDiscontinuityLost_{0};
+    uint64_t loggedDiscontinuities_ = 0;  // Monitor thread only
+
+    // Metrics of what the application receives, published next to the
+    // worker's driver page
+    std::unique_ptr<DeviceMetrics> metrics_;
 };
 
 // Proxy stream handle
 struct SoapySDRPlayProxyStream
 {
-    SharedRingBuffer* ringBuffer;
+    SharedRingBuffer* ringBuffer;       // Ring of the first stream channel
+    std::vector<SharedRingBuffer*> rings;  // One ring per stream channel
+    std::vector<ChannelMetrics*> metrics;  // Published counters per stream channel
     size_t lastReadIdx;
     uint64_t lastOverflowCount;
     bool useCS16;  // True if output should be CS16, false for CF32
     std::vector<std::complex<float>> conversionBuffer;  // Buffer for CF32 to CS16 conversion
+    size_t acquiredElems = 0;  // Handed out by acquireReadBuffer()
 
     // Worker health monitoring
     uint64_t lastSeenWriteIdx = 0;      // Last write index observed
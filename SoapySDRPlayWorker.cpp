@@ -28,18 +28,28 @@
 #include <SoapySDR/Device.hpp>
 #include <SoapySDR/Logger.h>
 #include <SoapySDR/Formats.hpp>
+#include <SoapySDR/Modules.hpp>
 
 #include <unistd.h>
 #include <signal.h>
+#include <spawn.h>
 #include <sys/wait.h>
 
 #ifdef __APPLE__
 #include <mach-o/dyld.h>
+#include <crt_externs.h>
+#define environ (*_NSGetEnviron())
+#else
+extern char** environ;
 #endif
 #include <cstring>
 #include <cstdlib>
 #include <sstream>
+#include <iomanip>
 #include <vector>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
 
 // Argument markers for worker mode
 static const char* WORKER_MODE_ARG = "--sdrplay-worker";
@@ -47,6 +57,11 @@ static const char* WORKER_CMD_FD_ARG = "--cmd-fd";
 static const char* WORKER_STATUS_FD_ARG = "--status-fd";
 static const char* WORKER_SHM_ARG = "--shm-name";
 static const char* WORKER_SERIAL_ARG = "--serial";
+static const char* WORKER_WARM_ARG = "--warm";
+static const char* WORKER_DEVICE_ARG = "--device-arg";  // key=value, repeated
+
+// Upper bound for SOAPY_SDRPLAY_WORKER_POOL
+static const size_t MAX_WORKER_POOL_SIZE = 16;
 
 bool SoapySDRPlayWorker::isWorkerMode(int argc, char* argv[])
 {
@@ -66,6 +81,8 @@ int SoapySDRPlayWorker::runAsWorker(int argc, char* argv[])
     int statusFd = -1;
     std::string shmName;
     std::string serial;
+    bool warm = false;
+    SoapySDR::Kwargs extraArgs;
 
     for (int i = 1; i < argc; ++i)
     {
@@ -85,17 +102,34 @@ int SoapySDRPlayWorker::runAsWorker(int argc, char* argv[])
         {
             serial = argv[++i];
         }
+        else if (strcmp(argv[i], WORKER_WARM_ARG) == 0)
+        {
+            warm = true;
+        }
+        else if (strcmp(argv[i], WORKER_DEVICE_ARG) == 0 && i + 1 < argc)
+        {
+            const std::string kv = argv[++i];
+            const size_t eq = kv.find('=');
+            if (eq != std::string::npos)
+            {
+                extraArgs[kv.substr(0, eq)] = kv.substr(eq + 1);
+            }
+        }
     }
 
-    if (cmdFd < 0 || statusFd < 0 || shmName.empty() || serial.empty())
+    // A warm worker gets its serial and shared memory name via CMD_ASSIGN
+    if (cmdFd < 0 || statusFd < 0 || (!warm && (shmName.empty() || serial.empty())))
     {
         SoapySDR_logf(SOAPY_SDR_ERROR, "Worker: Invalid arguments");
         return 1;
     }
 
-    SoapySDR::Kwargs args;
-    args["driver"] = "sdrplay";  // Force direct driver lookup, skip enumeration
-    args["serial"] = serial;
+    SoapySDR::Kwargs args = extraArgs;  // e.g. the RSPduo mode
+    if (!warm)
+    {
+        args["driver"] = "sdrplay";  // Force direct driver lookup, skip enumeration
+        args["serial"] = serial;
+    }
 
     return workerMain(cmdFd, statusFd, shmName, args);
 }
@@ -113,8 +147,16 @@ SoapySDRPlayWorker::SoapySDRPlayWorker(int cmdReadFd, int statusWriteFd,
                                        const SoapySDR::Kwargs& deviceArgs)
     : cmdPipe_(new IPCPipe(cmdReadFd, true))
     , statusPipe_(new IPCPipe(statusWriteFd, true))
+    , shmName_(shmName)
     , deviceArgs_(deviceArgs)
+    , warm_(shmName.empty())
+    , parentPid_(getppid())
 {
+    if (warm_)
+    {
+        return;
+    }
+
     // Open existing shared memory (created by proxy)
     ringBuffer_.reset(SharedRingBuffer::open(shmName));
     if (!ringBuffer_)
@@ -133,25 +175,45 @@ SoapySDRPlayWorker::~SoapySDRPlayWorker()
         streamThread_.join();
     }
 
-    if (stream_ && device_)
+    if (device_)
     {
-        device_->deactivateStream(stream_);
-        device_->closeStream(stream_);
-        stream_ = nullptr;
+        for (SoapySDR::Stream* stream : streams_)
+        {
+            device_->deactivateStream(stream);
+            device_->closeStream(stream);
+        }
     }
+    streams_.clear();
 
     device_.reset();
 }
 
 int SoapySDRPlayWorker::run()
 {
-    SoapySDR_logf(SOAPY_SDR_INFO, "Worker: Starting for device %s",
-                 deviceArgs_["serial"].c_str());
+    if (warm_)
+    {
+        // Load the modules (and with them the SDRplay API library) now, so
+        // that only the device open is left once a device is assigned
+        SoapySDR_log(SOAPY_SDR_INFO, "Worker: Starting warm, waiting for device assignment");
+        SoapySDR::loadModules();
+    }
+    else
+    {
+        SoapySDR_logf(SOAPY_SDR_INFO, "Worker: Starting for device %s",
+                     deviceArgs_["serial"].c_str());
 
-    if (!ringBuffer_)
+        if (!ringBuffer_)
+        {
+            sendError("Failed to open shared memory");
+            return 1;
+        }
+    }
+
+    // Publish a fresh heartbeat before READY so the proxy monitor does not
+    // see the previous worker's stale one on a shared ring
+    if (ringBuffer_)
     {
-        sendError("Failed to open shared memory");
-        return 1;
+        ringBuffer_->heartbeat(RINGBUF_STATE_IDLE);
     }
 
     // Send ready status
@@ -161,14 +223,37 @@ int SoapySDRPlayWorker::run()
     // Main command loop
     while (running_)
     {
+        if (ringBuffer_)
+        {
+            ringBuffer_->heartbeat(streaming_ ? RINGBUF_STATE_STREAMING : RINGBUF_STATE_IDLE);
+        }
+
         IPCMessage cmd;
         if (!cmdPipe_->receive(cmd, 100))  // 100ms timeout for polling
         {
+            // Don't outlive the proxy (e.g. an idle pooled worker)
+            if (getppid() != parentPid_)
+            {
+                SoapySDR_log(SOAPY_SDR_WARNING, "Worker: Parent process exited");
+                running_ = false;
+            }
+            continue;
+        }
+
+        // Until CMD_ASSIGN a warm worker has no ring buffer to work with
+        if (!ringBuffer_ && cmd.type != IPCMessageType::CMD_ASSIGN &&
+            cmd.type != IPCMessageType::CMD_SHUTDOWN)
+        {
+            sendError("Worker not assigned to a device");
             continue;
         }
 
         switch (cmd.type)
         {
+            case IPCMessageType::CMD_ASSIGN:
+                handleAssign(cmd);
+                break;
+
             case IPCMessageType::CMD_CONFIGURE:
                 handleConfigure(cmd);
                 break;
@@ -214,6 +299,14 @@ int SoapySDRPlayWorker::run()
                 handleGetStatus(cmd);
                 break;
 
+            case IPCMessageType::CMD_WRITE_SETTING:
+                handleWriteSetting(cmd);
+                break;
+
+            case IPCMessageType::CMD_READ_SETTING:
+                handleReadSetting(cmd);
+                break;
+
             default:
                 SoapySDR_logf(SOAPY_SDR_WARNING, "Worker: Unknown command type %d",
                              static_cast<int>(cmd.type));
@@ -231,7 +324,18 @@ int SoapySDRPlayWorker::run()
         }
     }
 
-    ringBuffer_->setFlag(RINGBUF_FLAG_SHUTDOWN);
+    if (ringBuffer_)
+    {
+        ringBuffer_->heartbeat(RINGBUF_STATE_EXITING);
+        ringBuffer_->setFlag(RINGBUF_FLAG_SHUTDOWN);
+    }
+    for (auto& ring : channelRings_)
+    {
+        if (ring)
+        {
+            ring->setFlag(RINGBUF_FLAG_SHUTDOWN);
+        }
+    }
     SoapySDR_logf(SOAPY_SDR_INFO, "Worker: Exiting");
     return 0;
 }
@@ -254,7 +358,8 @@ void SoapySDRPlayWorker::handleConfigure(const IPCMessage& cmd)
         SDRplayLockGuard lockGuard(lock_, 10000);  // 10s timeout
 
         // Open device if not already open
-        if (!device_)
+        const bool opening = !device_;
+        if (opening)
         {
             SoapySDR_logf(SOAPY_SDR_INFO, "Worker: Opening device %s",
                          deviceArgs_["serial"].c_str());
@@ -265,8 +370,15 @@ void SoapySDRPlayWorker::handleConfigure(const IPCMessage& cmd)
                 sendError("Failed to open device");
                 return;
             }
+        }
 
-            sendStatus(IPCMessageType::STATUS_OPENED);
+        // Settings written through the proxy (also replayed after a restart)
+        for (const auto& kv : cmd.params)
+        {
+            if (kv.first.compare(0, 8, "setting.") == 0)
+            {
+                device_->writeSetting(kv.first.substr(8), kv.second);
+            }
         }
 
         // Apply settings
@@ -289,10 +401,49 @@ void SoapySDRPlayWorker::handleConfigure(const IPCMessage& cmd)
             device_->setGain(SOAPY_SDR_RX, 0, gain_);
         }
 
+        // Further tuners (RSPduo dual tuner)
+        for (size_t ch = 1; ch < device_->getNumChannels(SOAPY_SDR_RX); ch++)
+        {
+            const std::string prefix = "ch" + std::to_string(ch) + ".";
+            if (!cmd.hasParam(prefix + "center_hz"))
+            {
+                continue;
+            }
+            const std::string antenna = cmd.getParam(prefix + "antenna");
+            if (!antenna.empty())
+            {
+                device_->setAntenna(SOAPY_SDR_RX, ch, antenna);
+            }
+            device_->setFrequency(SOAPY_SDR_RX, ch, cmd.getParamDouble(prefix + "center_hz"));
+            const bool agc = cmd.getParamInt(prefix + "agc", 1) != 0;
+            device_->setGainMode(SOAPY_SDR_RX, ch, agc);
+            if (!agc)
+            {
+                device_->setGain(SOAPY_SDR_RX, ch, cmd.getParamDouble(prefix + "gain"));
+            }
+        }
+
         // Update ring buffer sample rate
         ringBuffer_->setSampleRate(static_cast<uint32_t>(sampleRate_));
 
-        sendStatus(IPCMessageType::STATUS_CONFIGURED);
+        if (opening)
+        {
+            // Send the capabilities once, with the settings applied, so the
+            // proxy can serve the queries locally
+            IPCMessage opened(IPCMessageType::STATUS_OPENED);
+            DeviceCapabilities::query(*device_).encode(opened);
+            statusPipe_->send(opened);
+        }
+
+        // The gain ranges of every tuner at the configured frequencies
+        IPCMessage configured(IPCMessageType::STATUS_CONFIGURED);
+        for (size_t ch = 0; ch < device_->getNumChannels(SOAPY_SDR_RX); ch++)
+        {
+            encodeGainRanges(configured, ch, "ch" + std::to_string(ch) + ".");
+        }
+
+        lockGuard.markSucceeded();
+        statusPipe_->send(configured);
     }
     catch (const std::exception& e)
     {
@@ -300,7 +451,7 @@ void SoapySDRPlayWorker::handleConfigure(const IPCMessage& cmd)
     }
 }
 
-void SoapySDRPlayWorker::handleStart(const IPCMessage& /* cmd */)
+void SoapySDRPlayWorker::handleStart(const IPCMessage& cmd)
 {
     SoapySDR_logf(SOAPY_SDR_DEBUG, "Worker: Handling start");
 
@@ -321,30 +472,88 @@ void SoapySDRPlayWorker::handleStart(const IPCMessage& /* cmd */)
         // Acquire cross-process lock
         SDRplayLockGuard lockGuard(lock_, 10000);
 
-        // Setup stream
-        if (!stream_)
+        // Channels to stream, one ring each (created by the proxy)
+        std::vector<size_t> channels;
+        std::istringstream channelList(cmd.getParam("channels", "0"));
+        std::string item;
+        while (std::getline(channelList, item, ','))
         {
-            stream_ = device_->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32);
-            if (!stream_)
+            channels.push_back(static_cast<size_t>(std::stoul(item)));
+        }
+        if (channels.empty())
+        {
+            channels.push_back(0);
+        }
+
+        std::vector<SharedRingBuffer*> rings;
+        for (size_t ch : channels)
+        {
+            SharedRingBuffer* ring = channelRing(ch);
+            if (!ring)
             {
-                sendError("Failed to setup stream");
+                sendError("Failed to open shared memory for channel " + std::to_string(ch));
                 return;
             }
+            rings.push_back(ring);
         }
 
-        // Activate stream
-        int ret = device_->activateStream(stream_);
-        if (ret != 0)
+        // Setup the streams (again if the channel set changed)
+        if (!streams_.empty() && channels != streamChannels_)
         {
-            sendError("Failed to activate stream: " + std::to_string(ret));
-            return;
+            for (SoapySDR::Stream* stream : streams_)
+            {
+                device_->closeStream(stream);
+            }
+            streams_.clear();
         }
+        if (streams_.empty())
+        {
+            for (size_t ch : channels)
+            {
+                SoapySDR::Stream* stream = device_->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, std::vector<size_t>{ch});
+                if (!stream)
+                {
+                    for (SoapySDR::Stream* opened : streams_)
+                    {
+                        device_->closeStream(opened);
+                    }
+                    streams_.clear();
+                    sendError("Failed to setup stream");
+                    return;
+                }
+                streams_.push_back(stream);
+            }
+            streamChannels_ = channels;
+        }
+        streamRings_ = rings;
+
+        // Activate the streams, the first channel last: the others then
+        // hold samples from its first one on
+        for (size_t i = streams_.size(); i-- > 0;)
+        {
+            int ret = device_->activateStream(streams_[i]);
+            if (ret != 0)
+            {
+                sendError("Failed to activate stream: " + std::to_string(ret));
+                return;
+            }
+        }
+
+        // A restarted worker continues a ring the consumer is still reading:
+        // mark the samples lost during the restart before the first write
+        resumeGap_ = cmd.getParamInt("resume", 0) != 0;
 
         // Start streaming thread
         streaming_ = true;
-        ringBuffer_->setFlag(RINGBUF_FLAG_RUNNING);
+        ringBuffer_->streamHeartbeat();
+        ringBuffer_->heartbeat(RINGBUF_STATE_STREAMING);
+        for (SharedRingBuffer* ring : streamRings_)
+        {
+            ring->setFlag(RINGBUF_FLAG_RUNNING);
+        }
         streamThread_ = std::thread(&SoapySDRPlayWorker::streamingLoop, this);
 
+        lockGuard.markSucceeded();
         sendStatus(IPCMessageType::STATUS_STARTED);
     }
     catch (const std::exception& e)
@@ -364,16 +573,22 @@ void SoapySDRPlayWorker::handleStop(const IPCMessage& /* cmd */)
     }
 
     streaming_ = false;
-    ringBuffer_->clearFlag(RINGBUF_FLAG_RUNNING);
+    for (SharedRingBuffer* ring : streamRings_)
+    {
+        ring->clearFlag(RINGBUF_FLAG_RUNNING);
+    }
 
     if (streamThread_.joinable())
     {
         streamThread_.join();
     }
 
-    if (device_ && stream_)
+    if (device_)
     {
-        device_->deactivateStream(stream_);
+        for (SoapySDR::Stream* stream : streams_)
+        {
+            device_->deactivateStream(stream);
+        }
     }
 
     sendStatus(IPCMessageType::STATUS_STOPPED);
@@ -381,15 +596,21 @@ void SoapySDRPlayWorker::handleStop(const IPCMessage& /* cmd */)
 
 void SoapySDRPlayWorker::handleSetFrequency(const IPCMessage& cmd)
 {
+    const size_t channel = static_cast<size_t>(cmd.getParamInt("channel", 0));
     double freq = cmd.getParamDouble("value", centerFreq_);
-    centerFreq_ = freq;
+    if (channel == 0)
+    {
+        centerFreq_ = freq;
+    }
 
     if (device_)
     {
         try
         {
-            device_->setFrequency(SOAPY_SDR_RX, 0, freq);
-            sendAck();
+            device_->setFrequency(SOAPY_SDR_RX, channel, freq);
+            IPCMessage ack(IPCMessageType::STATUS_ACK);
+            encodeGainRanges(ack, channel);
+            statusPipe_->send(ack);
         }
         catch (const std::exception& e)
         {
@@ -404,15 +625,26 @@ void SoapySDRPlayWorker::handleSetFrequency(const IPCMessage& cmd)
 
 void SoapySDRPlayWorker::handleSetSampleRate(const IPCMessage& cmd)
 {
+    const size_t channel = static_cast<size_t>(cmd.getParamInt("channel", 0));
     double rate = cmd.getParamDouble("value", sampleRate_);
-    sampleRate_ = rate;
+    if (channel == 0)
+    {
+        sampleRate_ = rate;
+    }
 
     if (device_)
     {
         try
         {
-            device_->setSampleRate(SOAPY_SDR_RX, 0, rate);
+            device_->setSampleRate(SOAPY_SDR_RX, channel, rate);
             ringBuffer_->setSampleRate(static_cast<uint32_t>(rate));
+            for (auto& ring : channelRings_)
+            {
+                if (ring)
+                {
+                    ring->setSampleRate(static_cast<uint32_t>(rate));
+                }
+            }
             sendAck();
         }
         catch (const std::exception& e)
@@ -428,14 +660,25 @@ void SoapySDRPlayWorker::handleSetSampleRate(const IPCMessage& cmd)
 
 void SoapySDRPlayWorker::handleSetGain(const IPCMessage& cmd)
 {
+    const size_t channel = static_cast<size_t>(cmd.getParamInt("channel", 0));
     double gainVal = cmd.getParamDouble("value", gain_);
-    gain_ = gainVal;
+    if (channel == 0)
+    {
+        gain_ = gainVal;
+    }
 
     if (device_)
     {
         try
         {
-            device_->setGain(SOAPY_SDR_RX, 0, gainVal);
+            if (cmd.hasParam("name"))
+            {
+                device_->setGain(SOAPY_SDR_RX, channel, cmd.getParam("name"), gainVal);
+            }
+            else
+            {
+                device_->setGain(SOAPY_SDR_RX, channel, gainVal);
+            }
             sendAck();
         }
         catch (const std::exception& e)
@@ -451,14 +694,18 @@ void SoapySDRPlayWorker::handleSetGain(const IPCMessage& cmd)
 
 void SoapySDRPlayWorker::handleSetAgc(const IPCMessage& cmd)
 {
+    const size_t channel = static_cast<size_t>(cmd.getParamInt("channel", 0));
     bool enabled = cmd.getParamInt("value", agcEnabled_ ? 1 : 0) != 0;
-    agcEnabled_ = enabled;
+    if (channel == 0)
+    {
+        agcEnabled_ = enabled;
+    }
 
     if (device_)
     {
         try
         {
-            device_->setGainMode(SOAPY_SDR_RX, 0, enabled);
+            device_->setGainMode(SOAPY_SDR_RX, channel, enabled);
             sendAck();
         }
         catch (const std::exception& e)
@@ -474,14 +721,18 @@ void SoapySDRPlayWorker::handleSetAgc(const IPCMessage& cmd)
 
 void SoapySDRPlayWorker::handleSetAntenna(const IPCMessage& cmd)
 {
+    const size_t channel = static_cast<size_t>(cmd.getParamInt("channel", 0));
     std::string ant = cmd.getParam("value", antenna_);
-    antenna_ = ant;
+    if (channel == 0)
+    {
+        antenna_ = ant;
+    }
 
     if (device_)
     {
         try
         {
-            device_->setAntenna(SOAPY_SDR_RX, 0, ant);
+            device_->setAntenna(SOAPY_SDR_RX, channel, ant);
             sendAck();
         }
         catch (const std::exception& e)
@@ -497,14 +748,18 @@ void SoapySDRPlayWorker::handleSetAntenna(const IPCMessage& cmd)
 
 void SoapySDRPlayWorker::handleSetBandwidth(const IPCMessage& cmd)
 {
+    const size_t channel = static_cast<size_t>(cmd.getParamInt("channel", 0));
     double bw = cmd.getParamDouble("value", bandwidth_);
-    bandwidth_ = bw;
+    if (channel == 0)
+    {
+        bandwidth_ = bw;
+    }
 
     if (device_)
     {
         try
         {
-            device_->setBandwidth(SOAPY_SDR_RX, 0, bw);
+            device_->setBandwidth(SOAPY_SDR_RX, channel, bw);
             sendAck();
         }
         catch (const std::exception& e)
@@ -518,6 +773,46 @@ void SoapySDRPlayWorker::handleSetBandwidth(const IPCMessage& cmd)
     }
 }
 
+void SoapySDRPlayWorker::handleWriteSetting(const IPCMessage& cmd)
+{
+    if (!device_)
+    {
+        // Applied from the proxy's CMD_CONFIGURE once the device is open
+        sendAck();
+        return;
+    }
+
+    try
+    {
+        device_->writeSetting(cmd.getParam("key"), cmd.getParam("value"));
+        sendAck();
+    }
+    catch (const std::exception& e)
+    {
+        sendError(std::string("Write setting failed: ") + e.what());
+    }
+}
+
+void SoapySDRPlayWorker::handleReadSetting(const IPCMessage& cmd)
+{
+    if (!device_)
+    {
+        sendError("Device not open");
+        return;
+    }
+
+    try
+    {
+        IPCMessage ack(IPCMessageType::STATUS_ACK);
+        ack.setParam("value", device_->readSetting(cmd.getParam("key")));
+        statusPipe_->send(ack);
+    }
+    catch (const std::exception& e)
+    {
+        sendError(std::string("Read setting failed: ") + e.what());
+    }
+}
+
 void SoapySDRPlayWorker::handleGetStatus(const IPCMessage& /* cmd */)
 {
     IPCMessage status(IPCMessageType::STATUS_STATS);
@@ -531,6 +826,45 @@ void SoapySDRPlayWorker::handleGetStatus(const IPCMessage& /* cmd */)
     statusPipe_->send(status);
 }
 
+void SoapySDRPlayWorker::handleAssign(const IPCMessage& cmd)
+{
+    if (ringBuffer_)
+    {
+        sendError("Worker already assigned");
+        return;
+    }
+
+    const std::string serial = cmd.getParam("serial");
+    const std::string shmName = cmd.getParam("shm_name");
+    if (serial.empty() || shmName.empty())
+    {
+        sendError("Invalid assignment");
+        return;
+    }
+
+    ringBuffer_.reset(SharedRingBuffer::open(shmName));
+    if (!ringBuffer_)
+    {
+        sendError("Failed to open shared memory " + shmName);
+        return;
+    }
+
+    const std::string argPrefix = "arg.";
+    for (const auto& kv : cmd.params)
+    {
+        if (kv.first.compare(0, argPrefix.size(), argPrefix) == 0)
+        {
+            deviceArgs_[kv.first.substr(argPrefix.size())] = kv.second;
+        }
+    }
+    deviceArgs_["driver"] = "sdrplay";  // Force direct driver lookup, skip enumeration
+    deviceArgs_["serial"] = serial;
+    shmName_ = shmName;
+    SoapySDR_logf(SOAPY_SDR_INFO, "Worker: Assigned to device %s", serial.c_str());
+    ringBuffer_->heartbeat(RINGBUF_STATE_IDLE);
+    sendAck();
+}
+
 void SoapySDRPlayWorker::sendStatus(IPCMessageType type, const std::string& message)
 {
     IPCMessage status(type);
@@ -546,7 +880,10 @@ void SoapySDRPlayWorker::sendError(const std::string& message)
     SoapySDR_logf(SOAPY_SDR_ERROR, "Worker: %s", message.c_str());
     IPCMessage status(IPCMessageType::STATUS_ERROR);
     status.setParam("message", message);
-    ringBuffer_->setFlag(RINGBUF_FLAG_ERROR);
+    if (ringBuffer_)
+    {
+        ringBuffer_->setFlag(RINGBUF_FLAG_ERROR);
+    }
     statusPipe_->send(status);
 }
 
@@ -556,30 +893,134 @@ void SoapySDRPlayWorker::sendAck()
     statusPipe_->send(ack);
 }
 
+void SoapySDRPlayWorker::encodeGainRanges(IPCMessage& msg, size_t channel, const std::string& prefix)
+{
+    DeviceCapabilities ranges;
+    ranges.gains = device_->listGains(SOAPY_SDR_RX, channel);
+    ranges.queryGainRanges(*device_, channel);
+    ranges.encodeGainRanges(msg, prefix);
+}
+
+SharedRingBuffer* SoapySDRPlayWorker::channelRing(size_t channel)
+{
+    if (channel == 0)
+    {
+        return ringBuffer_.get();
+    }
+
+    if (channelRings_.size() < channel)
+    {
+        channelRings_.resize(channel);
+    }
+    std::unique_ptr<SharedRingBuffer>& ring = channelRings_[channel - 1];
+    if (!ring)
+    {
+        ring.reset(SharedRingBuffer::open(channelShmName(shmName_, channel)));
+        if (ring)
+        {
+            ring->setSampleRate(static_cast<uint32_t>(sampleRate_));
+        }
+    }
+    return ring.get();
+}
+
 void SoapySDRPlayWorker::streamingLoop()
 {
     SoapySDR_logf(SOAPY_SDR_INFO, "Worker: Streaming loop started");
 
     constexpr size_t BUFFER_SIZE = 65536;
-    std::vector<std::complex<float>> buffer(BUFFER_SIZE);
-    void* buffs[] = { buffer.data() };
+    const size_t numChannels = streamRings_.size();
+    std::vector<std::vector<std::complex<float>>> buffers(numChannels, std::vector<std::complex<float>>(BUFFER_SIZE));
+    void* buffs[] = { buffers[0].data() };
+    std::vector<ChannelBacklog> backlogs(numChannels);
+    bool aligned = false;
+    for (size_t i = 1; i < numChannels; i++)
+    {
+        backlogs[i].samples.resize(BUFFER_SIZE);
+    }
+
+    // Overflow notices allocate (IPCMessage), so under sustained overload
+    // the drops are summed and sent at most once per interval
+    constexpr auto OVERFLOW_NOTICE_INTERVAL = std::chrono::milliseconds(100);
+    uint64_t pendingDropped = 0;
+    std::chrono::steady_clock::time_point lastNotice;
+    auto sendOverflow = [this, &pendingDropped, &lastNotice]() {
+        IPCMessage overflow(IPCMessageType::STATUS_OVERFLOW);
+        overflow.setParam("dropped", static_cast<int64_t>(pendingDropped));
+        statusPipe_->send(overflow);
+        pendingDropped = 0;
+        lastNotice = std::chrono::steady_clock::now();
+    };
 
     while (streaming_)
     {
+        ringBuffer_->streamHeartbeat();
+
         int flags = 0;
         long long timeNs = 0;
 
-        int ret = device_->readStream(stream_, buffs, BUFFER_SIZE, flags, timeNs, 100000);
+        int ret = device_->readStream(streams_[0], buffs, BUFFER_SIZE, flags, timeNs, 100000);
 
         if (ret > 0)
         {
-            size_t written = ringBuffer_->write(buffer.data(), ret);
-            if (written < static_cast<size_t>(ret))
+            if (resumeGap_)
             {
-                // Overflow
-                IPCMessage overflow(IPCMessageType::STATUS_OVERFLOW);
-                overflow.setParam("dropped", static_cast<int64_t>(ret - written));
-                statusPipe_->send(overflow);
+                uint64_t lost = 0;
+                for (SharedRingBuffer* ring : streamRings_)
+                {
+                    lost = ring->markResumeGap();
+                }
+                SoapySDR_logf(SOAPY_SDR_INFO, "Worker: Resumed stream, %llu samples lost",
+                             (unsigned long long)lost);
+                resumeGap_ = false;
+            }
+
+            // The other channels' samples of the same times; those a
+            // channel lacks are zeros and counted as dropped. The rings
+            // start once every channel has samples: each stream drops what
+            // it buffered before its first read, so they start apart.
+            size_t first = 0;
+            size_t dropped = 0;
+            if (numChannels > 1)
+            {
+                const double rate = device_->getSampleRate(SOAPY_SDR_RX, 0);
+                if (!aligned)
+                {
+                    for (size_t i = 1; i < numChannels; i++)
+                    {
+                        if (fillBacklog(i, backlogs[i]))
+                        {
+                            const long long lead = std::llround((backlogs[i].timeNs - timeNs) * 1e-9 * rate) +
+                                                   static_cast<long long>(backlogs[i].start);
+                            first = std::max(first, static_cast<size_t>(std::max(0LL, lead)));
+                        }
+                    }
+                    if (first >= static_cast<size_t>(ret))
+                    {
+                        continue;
+                    }
+                    aligned = true;
+                }
+                for (size_t i = 1; i < numChannels; i++)
+                {
+                    dropped = std::max(dropped, readAligned(i, backlogs[i], timeNs, first, rate,
+                                                            static_cast<size_t>(ret) - first, buffers[i].data()));
+                }
+            }
+
+            // The first channel is written last: once the proxy sees its
+            // samples, the other channels' rings already hold theirs
+            const size_t count = static_cast<size_t>(ret) - first;
+            for (size_t i = numChannels; i-- > 0;)
+            {
+                const std::complex<float>* samples = buffers[i].data() + (i == 0 ? first : 0);
+                size_t written = streamRings_[i]->write(samples, count);
+                dropped = std::max(dropped, count - written);
+            }
+            pendingDropped += dropped;
+            if (pendingDropped > 0 && std::chrono::steady_clock::now() - lastNotice >= OVERFLOW_NOTICE_INTERVAL)
+            {
+                sendOverflow();
             }
         }
         else if (ret == SOAPY_SDR_TIMEOUT)
@@ -591,10 +1032,312 @@ void SoapySDRPlayWorker::streamingLoop()
             SoapySDR_logf(SOAPY_SDR_WARNING, "Worker: readStream error %d", ret);
         }
     }
+    if (pendingDropped > 0)
+    {
+        sendOverflow();
+    }
 
     SoapySDR_logf(SOAPY_SDR_INFO, "Worker: Streaming loop ended");
 }
 
+bool SoapySDRPlayWorker::fillBacklog(size_t index, ChannelBacklog& backlog)
+{
+    if (backlog.count != 0)
+    {
+        return true;
+    }
+    void* buffs[] = { backlog.samples.data() };
+    int flags = 0;
+    long long timeNs = 0;
+    int ret = device_->readStream(streams_[index], buffs, backlog.samples.size(), flags, timeNs, 100000);
+    if (ret <= 0)
+    {
+        return false;
+    }
+    backlog.start = 0;
+    backlog.count = static_cast<size_t>(ret);
+    backlog.timeNs = timeNs;
+    return true;
+}
+
+size_t SoapySDRPlayWorker::readAligned(size_t index, ChannelBacklog& backlog, long long timeNs, size_t first,
+                                       double rate, size_t numElems, std::complex<float>* out)
+{
+    size_t filled = 0;
+    size_t zeros = 0;
+    while (filled < numElems && streaming_ && fillBacklog(index, backlog))
+    {
+        // Position of the next backlog sample relative to out[filled]
+        const long long offset = std::llround((backlog.timeNs - timeNs) * 1e-9 * rate) +
+                                 static_cast<long long>(backlog.start) - static_cast<long long>(first + filled);
+        if (offset < 0)
+        {
+            // Before the first channel's samples (e.g. it overflowed)
+            const size_t skip = std::min(static_cast<size_t>(-offset), backlog.count);
+            backlog.start += skip;
+            backlog.count -= skip;
+        }
+        else if (offset > 0)
+        {
+            // Missing from this channel
+            const size_t missing = std::min(static_cast<size_t>(offset), numElems - filled);
+            std::fill(out + filled, out + filled + missing, std::complex<float>());
+            filled += missing;
+            zeros += missing;
+        }
+        else
+        {
+            const size_t n = std::min(backlog.count, numElems - filled);
+            std::copy(backlog.samples.begin() + backlog.start, backlog.samples.begin() + backlog.start + n, out + filled);
+            filled += n;
+            backlog.start += n;
+            backlog.count -= n;
+        }
+    }
+
+    std::fill(out + filled, out + numElems, std::complex<float>());
+    return zeros + (numElems - filled);
+}
+
+// DeviceCapabilities implementation
+//
+// Values are stored as "cap.*" message parameters: lists are joined with
+// newlines, ranges are "min max step" and range lists are joined with ';'.
+
+static std::string joinList(const std::vector<std::string>& items)
+{
+    std::string out;
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        if (i > 0) out += '\n';
+        out += items[i];
+    }
+    return out;
+}
+
+static std::vector<std::string> splitList(const std::string& str, char sep = '\n')
+{
+    std::vector<std::string> items;
+    if (str.empty())
+    {
+        return items;
+    }
+    size_t start = 0;
+    while (true)
+    {
+        size_t end = str.find(sep, start);
+        items.push_back(str.substr(start, end - start));
+        if (end == std::string::npos) break;
+        start = end + 1;
+    }
+    return items;
+}
+
+static std::string encodeRange(const SoapySDR::Range& range)
+{
+    std::ostringstream oss;
+    oss << std::setprecision(17) << range.minimum() << ' ' << range.maximum() << ' ' << range.step();
+    return oss.str();
+}
+
+static SoapySDR::Range decodeRange(const std::string& str)
+{
+    double minimum = 0.0, maximum = 0.0, step = 0.0;
+    std::istringstream iss(str);
+    iss >> minimum >> maximum >> step;
+    return SoapySDR::Range(minimum, maximum, step);
+}
+
+static std::string encodeRangeList(const SoapySDR::RangeList& ranges)
+{
+    std::string out;
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        if (i > 0) out += ';';
+        out += encodeRange(ranges[i]);
+    }
+    return out;
+}
+
+static SoapySDR::RangeList decodeRangeList(const std::string& str)
+{
+    SoapySDR::RangeList ranges;
+    for (const auto& item : splitList(str, ';'))
+    {
+        ranges.push_back(decodeRange(item));
+    }
+    return ranges;
+}
+
+static std::string encodeDoubles(const std::vector<double>& values)
+{
+    std::ostringstream oss;
+    oss << std::setprecision(17);
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        if (i > 0) oss << ' ';
+        oss << values[i];
+    }
+    return oss.str();
+}
+
+static std::vector<double> decodeDoubles(const std::string& str)
+{
+    std::vector<double> values;
+    std::istringstream iss(str);
+    double value;
+    while (iss >> value)
+    {
+        values.push_back(value);
+    }
+    return values;
+}
+
+DeviceCapabilities DeviceCapabilities::query(SoapySDR::Device& device, size_t channel)
+{
+    DeviceCapabilities caps;
+    caps.numChannels = device.getNumChannels(SOAPY_SDR_RX);
+    caps.hardwareKey = device.getHardwareKey();
+    caps.hardwareInfo = device.getHardwareInfo();
+    caps.antennas = device.listAntennas(SOAPY_SDR_RX, channel);
+    caps.gains = device.listGains(SOAPY_SDR_RX, channel);
+    caps.hasGainMode = device.hasGainMode(SOAPY_SDR_RX, channel);
+    caps.queryGainRanges(device, channel);
+    caps.frequencies = device.listFrequencies(SOAPY_SDR_RX, channel);
+    caps.frequencyRange = device.getFrequencyRange(SOAPY_SDR_RX, channel);
+    for (const auto& name : caps.frequencies)
+    {
+        caps.elementFrequencyRanges[name] = device.getFrequencyRange(SOAPY_SDR_RX, channel, name);
+    }
+    caps.sampleRates = device.listSampleRates(SOAPY_SDR_RX, channel);
+    caps.sampleRateRange = device.getSampleRateRange(SOAPY_SDR_RX, channel);
+    caps.bandwidths = device.listBandwidths(SOAPY_SDR_RX, channel);
+    caps.bandwidthRange = device.getBandwidthRange(SOAPY_SDR_RX, channel);
+    caps.settingInfo = device.getSettingInfo();
+    return caps;
+}
+
+void DeviceCapabilities::encode(IPCMessage& msg) const
+{
+    msg.setParam("cap.channels", static_cast<int64_t>(numChannels));
+    msg.setParam("cap.hardware_key", hardwareKey);
+    for (const auto& kv : hardwareInfo)
+    {
+        msg.setParam("cap.info." + kv.first, kv.second);
+    }
+    msg.setParam("cap.antennas", joinList(antennas));
+    msg.setParam("cap.gains", joinList(gains));
+    msg.setParam("cap.gain_mode", static_cast<int64_t>(hasGainMode ? 1 : 0));
+    encodeGainRanges(msg);
+    msg.setParam("cap.frequencies", joinList(frequencies));
+    msg.setParam("cap.frequency_range", encodeRangeList(frequencyRange));
+    for (const auto& kv : elementFrequencyRanges)
+    {
+        msg.setParam("cap.frequency_range." + kv.first, encodeRangeList(kv.second));
+    }
+    msg.setParam("cap.sample_rates", encodeDoubles(sampleRates));
+    msg.setParam("cap.sample_rate_range", encodeRangeList(sampleRateRange));
+    msg.setParam("cap.bandwidths", encodeDoubles(bandwidths));
+    msg.setParam("cap.bandwidth_range", encodeRangeList(bandwidthRange));
+
+    msg.setParam("cap.settings", static_cast<int64_t>(settingInfo.size()));
+    for (size_t i = 0; i < settingInfo.size(); i++)
+    {
+        const SoapySDR::ArgInfo& info = settingInfo[i];
+        const std::string prefix = "cap.setting." + std::to_string(i) + ".";
+        msg.setParam(prefix + "key", info.key);
+        msg.setParam(prefix + "value", info.value);
+        msg.setParam(prefix + "name", info.name);
+        msg.setParam(prefix + "description", info.description);
+        msg.setParam(prefix + "units", info.units);
+        msg.setParam(prefix + "type", static_cast<int64_t>(info.type));
+        msg.setParam(prefix + "range", encodeRange(info.range));
+        msg.setParam(prefix + "options", joinList(info.options));
+        msg.setParam(prefix + "option_names", joinList(info.optionNames));
+    }
+}
+
+DeviceCapabilities DeviceCapabilities::decode(const IPCMessage& msg)
+{
+    DeviceCapabilities caps;
+    caps.numChannels = static_cast<size_t>(msg.getParamInt("cap.channels", 1));
+    caps.hardwareKey = msg.getParam("cap.hardware_key");
+    const std::string infoPrefix = "cap.info.";
+    for (const auto& kv : msg.params)
+    {
+        if (kv.first.compare(0, infoPrefix.size(), infoPrefix) == 0)
+        {
+            caps.hardwareInfo[kv.first.substr(infoPrefix.size())] = kv.second;
+        }
+    }
+    caps.antennas = splitList(msg.getParam("cap.antennas"));
+    caps.gains = splitList(msg.getParam("cap.gains"));
+    caps.hasGainMode = msg.getParamInt("cap.gain_mode", 1) != 0;
+    caps.decodeGainRanges(msg);
+    caps.frequencies = splitList(msg.getParam("cap.frequencies"));
+    caps.frequencyRange = decodeRangeList(msg.getParam("cap.frequency_range"));
+    for (const auto& name : caps.frequencies)
+    {
+        caps.elementFrequencyRanges[name] = decodeRangeList(msg.getParam("cap.frequency_range." + name));
+    }
+    caps.sampleRates = decodeDoubles(msg.getParam("cap.sample_rates"));
+    caps.sampleRateRange = decodeRangeList(msg.getParam("cap.sample_rate_range"));
+    caps.bandwidths = decodeDoubles(msg.getParam("cap.bandwidths"));
+    caps.bandwidthRange = decodeRangeList(msg.getParam("cap.bandwidth_range"));
+
+    const int64_t numSettings = msg.getParamInt("cap.settings", 0);
+    for (int64_t i = 0; i < numSettings; i++)
+    {
+        const std::string prefix = "cap.setting." + std::to_string(i) + ".";
+        SoapySDR::ArgInfo info;
+        info.key = msg.getParam(prefix + "key");
+        info.value = msg.getParam(prefix + "value");
+        info.name = msg.getParam(prefix + "name");
+        info.description = msg.getParam(prefix + "description");
+        info.units = msg.getParam(prefix + "units");
+        info.type = static_cast<SoapySDR::ArgInfo::Type>(msg.getParamInt(prefix + "type", SoapySDR::ArgInfo::STRING));
+        info.range = decodeRange(msg.getParam(prefix + "range"));
+        info.options = splitList(msg.getParam(prefix + "options"));
+        info.optionNames = splitList(msg.getParam(prefix + "option_names"));
+        caps.settingInfo.push_back(info);
+    }
+    return caps;
+}
+
+void DeviceCapabilities::queryGainRanges(SoapySDR::Device& device, size_t channel)
+{
+    gainRange = device.getGainRange(SOAPY_SDR_RX, channel);
+    elementGainRanges.clear();
+    for (const auto& name : gains)
+    {
+        elementGainRanges[name] = device.getGainRange(SOAPY_SDR_RX, channel, name);
+    }
+}
+
+void DeviceCapabilities::encodeGainRanges(IPCMessage& msg, const std::string& prefix) const
+{
+    msg.setParam(prefix + "cap.gain_range", encodeRange(gainRange));
+    for (const auto& kv : elementGainRanges)
+    {
+        msg.setParam(prefix + "cap.gain_range." + kv.first, encodeRange(kv.second));
+    }
+}
+
+bool DeviceCapabilities::decodeGainRanges(const IPCMessage& msg, const std::string& prefix)
+{
+    if (!msg.hasParam(prefix + "cap.gain_range"))
+    {
+        return false;
+    }
+    gainRange = decodeRange(msg.getParam(prefix + "cap.gain_range"));
+    elementGainRanges.clear();
+    for (const auto& name : gains)
+    {
+        elementGainRanges[name] = decodeRange(msg.getParam(prefix + "cap.gain_range." + name));
+    }
+    return true;
+}
+
 // WorkerSpawner implementation
 
 // Find the worker executable in standard locations
@@ -641,6 +1384,70 @@ static std::string findWorkerExecutable()
     return "";
 }
 
+pid_t WorkerSpawner::spawnProcess(const std::vector<std::string>& args, IPCPipePair* pipes)
+{
+    // Find worker executable
+    std::string workerPath = findWorkerExecutable();
+    if (workerPath.empty())
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "WorkerSpawner: Cannot find sdrplay_worker executable. "
+                     "Set SOAPY_SDRPLAY_WORKER environment variable or install to standard location.");
+        return -1;
+    }
+
+    SoapySDR_logf(SOAPY_SDR_INFO, "WorkerSpawner: Using worker executable: %s", workerPath.c_str());
+
+    std::string cmdFdStr = std::to_string(pipes->childReadFd());
+    std::string statusFdStr = std::to_string(pipes->childWriteFd());
+
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(workerPath.c_str()));
+    argv.push_back(const_cast<char*>(WORKER_MODE_ARG));
+    argv.push_back(const_cast<char*>(WORKER_CMD_FD_ARG));
+    argv.push_back(const_cast<char*>(cmdFdStr.c_str()));
+    argv.push_back(const_cast<char*>(WORKER_STATUS_FD_ARG));
+    argv.push_back(const_cast<char*>(statusFdStr.c_str()));
+    for (const auto& arg : args)
+    {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    // CRITICAL: Clear proxy mode env var so worker doesn't try to create another proxy
+    std::vector<char*> envp;
+    static const char MULTIDEV_ENV[] = "SOAPY_SDRPLAY_MULTIDEV=";
+    for (char** env = environ; env && *env; ++env)
+    {
+        if (strncmp(*env, MULTIDEV_ENV, sizeof(MULTIDEV_ENV) - 1) != 0)
+        {
+            envp.push_back(*env);
+        }
+    }
+    envp.push_back(nullptr);
+
+    // The parent-side pipe ends must not stay open in the worker
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addclose(&actions, pipes->parentToChild()->fd());
+    posix_spawn_file_actions_addclose(&actions, pipes->childToParent()->fd());
+
+    // posix_spawn avoids copying the page tables of a large host process
+    // (and reports exec failures to the caller)
+    pid_t pid = -1;
+    int err = posix_spawn(&pid, workerPath.c_str(), &actions, nullptr, argv.data(), envp.data());
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (err != 0)
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "WorkerSpawner: posix_spawn() failed: %s", strerror(err));
+        return -1;
+    }
+
+    // Parent process
+    pipes->closeChildSide();
+    return pid;
+}
+
 pid_t WorkerSpawner::spawn(const SoapySDR::Kwargs& deviceArgs,
                            const std::string& shmName,
                            IPCPipePair** pipePairOut)
@@ -653,62 +1460,51 @@ pid_t WorkerSpawner::spawn(const SoapySDR::Kwargs& deviceArgs,
         return -1;
     }
 
-    // Find worker executable
-    std::string workerPath = findWorkerExecutable();
-    if (workerPath.empty())
+    std::string serial = deviceArgs.count("serial") ? deviceArgs.at("serial") : "";
+    std::vector<std::string> args = { WORKER_SHM_ARG, shmName, WORKER_SERIAL_ARG, serial };
+    for (const auto& kv : deviceArgs)
     {
-        SoapySDR_logf(SOAPY_SDR_ERROR, "WorkerSpawner: Cannot find sdrplay_worker executable. "
-                     "Set SOAPY_SDRPLAY_WORKER environment variable or install to standard location.");
-        delete pipes;
-        return -1;
+        if (kv.first != "driver" && kv.first != "serial")
+        {
+            args.push_back(WORKER_DEVICE_ARG);
+            args.push_back(kv.first + "=" + kv.second);
+        }
     }
 
-    SoapySDR_logf(SOAPY_SDR_INFO, "WorkerSpawner: Using worker executable: %s", workerPath.c_str());
-
-    pid_t pid = fork();
-
+    pid_t pid = spawnProcess(args, pipes);
     if (pid < 0)
     {
-        SoapySDR_logf(SOAPY_SDR_ERROR, "WorkerSpawner: fork() failed: %s", strerror(errno));
         delete pipes;
         return -1;
     }
 
-    if (pid == 0)
-    {
-        // Child process
-        pipes->closeParentSide();
-
-        // CRITICAL: Clear proxy mode env var so worker doesn't try to create another proxy
-        unsetenv("SOAPY_SDRPLAY_MULTIDEV");
+    *pipePairOut = pipes;
 
-        // Build argument list
-        std::string cmdFdStr = std::to_string(pipes->childReadFd());
-        std::string statusFdStr = std::to_string(pipes->childWriteFd());
+    SoapySDR_logf(SOAPY_SDR_INFO, "WorkerSpawner: Spawned worker PID %d for device %s",
+                 pid, serial.empty() ? "unknown" : serial.c_str());
 
-        std::string serial = deviceArgs.count("serial") ? deviceArgs.at("serial") : "";
+    return pid;
+}
 
-        // Exec worker executable
-        execl(workerPath.c_str(), workerPath.c_str(),
-              WORKER_MODE_ARG,
-              WORKER_CMD_FD_ARG, cmdFdStr.c_str(),
-              WORKER_STATUS_FD_ARG, statusFdStr.c_str(),
-              WORKER_SHM_ARG, shmName.c_str(),
-              WORKER_SERIAL_ARG, serial.c_str(),
-              nullptr);
+pid_t WorkerSpawner::spawnWarm(IPCPipePair** pipePairOut)
+{
+    IPCPipePair* pipes = IPCPipePair::create();
+    if (!pipes)
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "WorkerSpawner: Failed to create pipes");
+        return -1;
+    }
 
-        // If exec fails
-        SoapySDR_logf(SOAPY_SDR_ERROR, "WorkerSpawner: exec failed: %s", strerror(errno));
-        _exit(1);
+    pid_t pid = spawnProcess(std::vector<std::string>{ WORKER_WARM_ARG }, pipes);
+    if (pid < 0)
+    {
+        delete pipes;
+        return -1;
     }
 
-    // Parent process
-    pipes->closeChildSide();
     *pipePairOut = pipes;
 
-    SoapySDR_logf(SOAPY_SDR_INFO, "WorkerSpawner: Spawned worker PID %d for device %s",
-                 pid, deviceArgs.count("serial") ? deviceArgs.at("serial").c_str() : "unknown");
-
+    SoapySDR_logf(SOAPY_SDR_DEBUG, "WorkerSpawner: Spawned warm worker PID %d", pid);
     return pid;
 }
 
@@ -746,16 +1542,16 @@ void WorkerSpawner::terminate(pid_t pid)
     // Try graceful shutdown first
     kill(pid, SIGTERM);
 
-    // Wait briefly
+    // Wait briefly (polled finely, worker restarts wait on this)
     int status;
-    for (int i = 0; i < 10; ++i)
+    for (int i = 0; i < 100; ++i)
     {
         if (waitpid(pid, &status, WNOHANG) == pid)
         {
             SoapySDR_logf(SOAPY_SDR_DEBUG, "WorkerSpawner: Worker %d terminated", pid);
             return;
         }
-        usleep(100000);  // 100ms
+        usleep(10000);  // 10ms
     }
 
     // Force kill
@@ -763,3 +1559,135 @@ void WorkerSpawner::terminate(pid_t pid)
     kill(pid, SIGKILL);
     waitpid(pid, &status, 0);
 }
+
+// WorkerPool implementation
+
+WorkerPool& WorkerPool::instance()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+size_t WorkerPool::configuredSize()
+{
+    const char* envVal = std::getenv("SOAPY_SDRPLAY_WORKER_POOL");
+    if (envVal == nullptr)
+    {
+        return 0;
+    }
+
+    char* end = nullptr;
+    long val = std::strtol(envVal, &end, 10);
+    if (end == envVal || *end != '\0' || val <= 0)
+    {
+        return 0;
+    }
+    return std::min(static_cast<size_t>(val), MAX_WORKER_POOL_SIZE);
+}
+
+WorkerPool::WorkerPool()
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& worker : idle_)
+    {
+        IPCMessage cmd(IPCMessageType::CMD_SHUTDOWN);
+        worker.pipes->parentToChild()->send(cmd, 100);
+        WorkerSpawner::terminate(worker.pid);
+    }
+    idle_.clear();
+}
+
+void WorkerPool::fill()
+{
+    const size_t size = configuredSize();
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (idle_.size() < size)
+    {
+        IPCPipePair* pipes = nullptr;
+        pid_t pid = WorkerSpawner::spawnWarm(&pipes);
+        if (pid < 0)
+        {
+            SoapySDR_log(SOAPY_SDR_WARNING, "WorkerPool: Failed to spawn warm worker");
+            return;
+        }
+
+        IdleWorker worker;
+        worker.pid = pid;
+        worker.pipes.reset(pipes);
+        worker.ready = false;
+        idle_.push_back(std::move(worker));
+    }
+}
+
+pid_t WorkerPool::acquire(IPCPipePair** pipePairOut, bool& ready)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Drop workers that have exited, pick up STATUS_READY from the rest
+    for (auto it = idle_.begin(); it != idle_.end();)
+    {
+        int status;
+        if (waitpid(it->pid, &status, WNOHANG) == it->pid)
+        {
+            it = idle_.erase(it);
+            continue;
+        }
+        if (!it->ready && it->pipes->childToParent()->hasData(0))
+        {
+            if (!WorkerSpawner::waitForReady(it->pipes->childToParent(), 100))
+            {
+                WorkerSpawner::terminate(it->pid);
+                it = idle_.erase(it);
+                continue;
+            }
+            it->ready = true;
+        }
+        ++it;
+    }
+
+    if (idle_.empty())
+    {
+        return -1;
+    }
+
+    // Prefer a worker that has finished loading
+    auto chosen = idle_.begin();
+    for (auto it = idle_.begin(); it != idle_.end(); ++it)
+    {
+        if (it->ready)
+        {
+            chosen = it;
+            break;
+        }
+    }
+
+    pid_t pid = chosen->pid;
+    ready = chosen->ready;
+    *pipePairOut = chosen->pipes.release();
+    idle_.erase(chosen);
+
+    SoapySDR_logf(SOAPY_SDR_DEBUG, "WorkerPool: Handing out worker PID %d (%s, %zu left)",
+                  pid, ready ? "ready" : "starting", idle_.size());
+    return pid;
+}
+
+size_t WorkerPool::idleCount()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
+
+std::vector<pid_t> WorkerPool::idlePids()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<pid_t> pids;
+    for (const auto& worker : idle_)
+    {
+        pids.push_back(worker.pid);
+    }
+    return pids;
+}
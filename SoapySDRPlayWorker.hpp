@@ -31,10 +31,51 @@
 #include <SoapySDR/Device.hpp>
 #include <SoapySDR/Types.h>
 
+#include <complex>
 #include <string>
 #include <memory>
 #include <atomic>
 #include <thread>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <sys/types.h>
+
+// Static capabilities of the opened device, sent once by the worker with
+// STATUS_OPENED so that the proxy answers capability queries without IPC
+struct DeviceCapabilities
+{
+    size_t numChannels = 1;
+    std::string hardwareKey;
+    SoapySDR::Kwargs hardwareInfo;
+    std::vector<std::string> antennas;
+    std::vector<std::string> gains;
+    bool hasGainMode = true;
+    SoapySDR::Range gainRange;
+    std::map<std::string, SoapySDR::Range> elementGainRanges;
+    std::vector<std::string> frequencies;
+    SoapySDR::RangeList frequencyRange;
+    std::map<std::string, SoapySDR::RangeList> elementFrequencyRanges;
+    std::vector<double> sampleRates;
+    SoapySDR::RangeList sampleRateRange;
+    std::vector<double> bandwidths;
+    SoapySDR::RangeList bandwidthRange;
+    SoapySDR::ArgInfoList settingInfo;
+
+    // Query the RX channel of an opened device
+    static DeviceCapabilities query(SoapySDR::Device& device, size_t channel = 0);
+
+    // Store in / load from the parameters of an IPC message
+    void encode(IPCMessage& msg) const;
+    static DeviceCapabilities decode(const IPCMessage& msg);
+
+    // The gain ranges follow the tuned frequency (LNA states per band), so
+    // the worker sends them again whenever it retunes. decodeGainRanges()
+    // needs the gain names and returns false if the message has no ranges.
+    void queryGainRanges(SoapySDR::Device& device, size_t channel);
+    void encodeGainRanges(IPCMessage& msg, const std::string& prefix = "") const;
+    bool decodeGainRanges(const IPCMessage& msg, const std::string& prefix = "");
+};
 
 // Worker subprocess that owns the actual SDRplay device
 // Runs in an isolated process, communicates with proxy via IPC
@@ -42,7 +83,8 @@ class SoapySDRPlayWorker
 {
 public:
     // Main entry point for worker subprocess
-    // Called after fork/exec with file descriptors passed as arguments
+    // Called after spawn with file descriptors passed as arguments
+    // An empty shmName starts a warm worker that waits for CMD_ASSIGN
     static int workerMain(int cmdReadFd, int statusWriteFd,
                           const std::string& shmName,
                           const SoapySDR::Kwargs& deviceArgs);
@@ -73,21 +115,54 @@ private:
     void handleSetAntenna(const IPCMessage& cmd);
     void handleSetBandwidth(const IPCMessage& cmd);
     void handleGetStatus(const IPCMessage& cmd);
+    void handleAssign(const IPCMessage& cmd);
+    void handleWriteSetting(const IPCMessage& cmd);
+    void handleReadSetting(const IPCMessage& cmd);
 
     // Send status/error messages
     void sendStatus(IPCMessageType type, const std::string& message = "");
     void sendError(const std::string& message);
     void sendAck();
 
+    // Add a channel's current gain ranges to a status message
+    void encodeGainRanges(IPCMessage& msg, size_t channel, const std::string& prefix = "");
+
     // Streaming thread
     void streamingLoop();
 
+    // Samples of a stream channel after the first, read ahead of it
+    struct ChannelBacklog
+    {
+        std::vector<std::complex<float>> samples;
+        size_t start = 0;       // First unused sample
+        size_t count = 0;       // Unused samples
+        long long timeNs = 0;   // Time of samples[0]
+    };
+
+    // Read the next samples of stream channel index if its backlog is
+    // empty; false if there are none
+    bool fillBacklog(size_t index, ChannelBacklog& backlog);
+
+    // Fill out with numElems samples of stream channel index, for the
+    // first channel's samples from first on of a read at timeNs; zeros
+    // where that channel has none. Returns the number of zeros.
+    size_t readAligned(size_t index, ChannelBacklog& backlog, long long timeNs, size_t first, double rate,
+                       size_t numElems, std::complex<float>* out);
+
+    // Ring for a channel (channel 0 is ringBuffer_), opened on first use
+    SharedRingBuffer* channelRing(size_t channel);
+
     // IPC communication
     std::unique_ptr<IPCPipe> cmdPipe_;
     std::unique_ptr<IPCPipe> statusPipe_;
 
-    // Shared memory ring buffer
+    // Shared memory ring buffers: ringBuffer_ carries channel 0 and the
+    // heartbeat, channelRings_[n - 1] carries channel n
+    std::string shmName_;
     std::unique_ptr<SharedRingBuffer> ringBuffer_;
+    std::vector<std::unique_ptr<SharedRingBuffer>> channelRings_;
+    std::vector<size_t> streamChannels_;        // Channels of streams_
+    std::vector<SharedRingBuffer*> streamRings_; // Ring per stream channel
 
     // Cross-process lock
     SDRplayLock lock_;
@@ -95,12 +170,17 @@ private:
     // Device
     SoapySDR::Kwargs deviceArgs_;
     std::unique_ptr<SoapySDR::Device> device_;
-    SoapySDR::Stream* stream_ = nullptr;
+    // One driver stream per channel (the driver streams each RSPduo tuner
+    // on its own); the channels are aligned by their sample times
+    std::vector<SoapySDR::Stream*> streams_;
 
     // State
+    bool warm_ = false;        // started by the worker pool, no device yet
+    pid_t parentPid_ = -1;     // exit when the proxy process goes away
     std::atomic<bool> running_{false};
     std::atomic<bool> streaming_{false};
     std::thread streamThread_;
+    bool resumeGap_ = false;   // mark a ring gap before the first write
 
     // Cached settings
     double centerFreq_ = 100e6;
@@ -122,9 +202,61 @@ public:
                        const std::string& shmName,
                        IPCPipePair** pipePairOut);
 
+    // Spawn a warm worker that loads the modules and then waits for
+    // CMD_ASSIGN (see WorkerPool)
+    static pid_t spawnWarm(IPCPipePair** pipePairOut);
+
     // Wait for worker to become ready (receive STATUS_READY message)
     static bool waitForReady(IPCPipe* statusPipe, unsigned int timeoutMs = 10000);
 
     // Terminate a worker process
     static void terminate(pid_t pid);
+
+private:
+    // posix_spawn the worker executable with the given extra arguments
+    static pid_t spawnProcess(const std::vector<std::string>& args, IPCPipePair* pipes);
+};
+
+// Pool of pre-spawned warm workers for proxy mode
+// Enabled with SOAPY_SDRPLAY_WORKER_POOL=N: up to N idle workers that have
+// already been exec'd and loaded the SoapySDR modules are kept ready, so
+// opening a proxy device skips process startup. The pool is refilled in
+// the background whenever a worker is handed out (to the size configured
+// at that time).
+class WorkerPool
+{
+public:
+    static WorkerPool& instance();
+
+    // Pool size from SOAPY_SDRPLAY_WORKER_POOL (0 = disabled)
+    static size_t configuredSize();
+
+    // Spawn workers until the pool holds its configured size
+    void fill();
+
+    // Take an idle worker; returns -1 if none is available
+    // ready is set if the worker has already sent STATUS_READY
+    pid_t acquire(IPCPipePair** pipePairOut, bool& ready);
+
+    // Number of idle workers currently held
+    size_t idleCount();
+
+    // PIDs of the idle workers currently held
+    std::vector<pid_t> idlePids();
+
+private:
+    WorkerPool();
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    struct IdleWorker
+    {
+        pid_t pid;
+        std::unique_ptr<IPCPipePair> pipes;
+        bool ready;
+    };
+
+    std::mutex mutex_;
+    std::vector<IdleWorker> idle_;
 };
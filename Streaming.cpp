@@ -25,8 +25,12 @@
  */
 
 #include "SoapySDRPlay.hpp"
+#include "SampleConvert.hpp"
+#include "Trace.hpp"
 #include <iostream>
 #include <future>
+#include <cmath>
+#include <cstdlib>
 
 /*******************************************************************
  * Timeout-protected API wrappers
@@ -113,6 +117,16 @@ SoapySDR::ArgInfoList SoapySDRPlay::getStreamArgsInfo(const int direction, const
 {
     SoapySDR::ArgInfoList streamArgs;
 
+    SoapySDR::ArgInfo bufflenArg;
+    bufflenArg.key = "bufflen";
+    bufflenArg.value = std::to_string(DEFAULT_BUFFER_LENGTH);
+    bufflenArg.name = "Buffer Length";
+    bufflenArg.description = "Samples per buffer handed to readStream(); smaller buffers lower the latency";
+    bufflenArg.units = "samples";
+    bufflenArg.type = SoapySDR::ArgInfo::INT;
+    bufflenArg.range = SoapySDR::Range(MIN_BUFFER_LENGTH, DEFAULT_BUFFER_LENGTH);
+    streamArgs.push_back(bufflenArg);
+
     return streamArgs;
 }
 
@@ -123,6 +137,7 @@ SoapySDR::ArgInfoList SoapySDRPlay::getStreamArgsInfo(const int direction, const
 static void _rx_callback_A(short *xi, short *xq, sdrplay_api_StreamCbParamsT *params,
                            unsigned int numSamples, unsigned int reset, void *cbContext)
 {
+    TraceScope trace("rx_callback", numSamples);
     auto *self = static_cast<SoapySDRPlay *>(cbContext);
     SoapySDRPlay::SoapySDRPlayStream *stream = nullptr;
     std::unique_lock<std::mutex> streamLock;
@@ -140,6 +155,7 @@ static void _rx_callback_A(short *xi, short *xq, sdrplay_api_StreamCbParamsT *pa
 static void _rx_callback_B(short *xi, short *xq, sdrplay_api_StreamCbParamsT *params,
                            unsigned int numSamples, unsigned int reset, void *cbContext)
 {
+    TraceScope trace("rx_callback", numSamples);
     auto *self = static_cast<SoapySDRPlay *>(cbContext);
     SoapySDRPlay::SoapySDRPlayStream *stream = nullptr;
     std::unique_lock<std::mutex> streamLock;
@@ -161,6 +177,85 @@ static void _ev_callback(sdrplay_api_EventT eventId, sdrplay_api_TunerSelectT tu
     return self->ev_callback(eventId, tuner, params);
 }
 
+/*******************************************************************
+ * Hybrid tuning NCO mixer
+ ******************************************************************/
+
+static inline void storeSample(float v, float *dptr)
+{
+    *dptr = v;
+}
+
+static inline void storeSample(float v, short *dptr)
+{
+    // rotating a full scale I/Q pair can exceed the int16 range by sqrt(2)
+    if (v > 32767.0f) v = 32767.0f;
+    else if (v < -32768.0f) v = -32768.0f;
+    *dptr = static_cast<short>(std::lrint(v));
+}
+
+// Rebuild the per-block phasor table after the NCO frequency changed;
+// the running phase is kept so retunes are phase-continuous
+static void ncoPrepare(SoapySDRPlay::SoapySDRPlayStream *stream, double increment)
+{
+    stream->ncoIncrement = increment;
+    for (int k = 0; k < NCO_BLOCK_SIZE; k++)
+    {
+        stream->ncoRotRe[k] = static_cast<float>(std::cos(increment * k));
+        stream->ncoRotIm[k] = static_cast<float>(std::sin(increment * k));
+    }
+    stream->ncoBlockRotRe = std::cos(increment * NCO_BLOCK_SIZE);
+    stream->ncoBlockRotIm = std::sin(increment * NCO_BLOCK_SIZE);
+}
+
+// Mix xi/xq with the stream NCO and store interleaved output samples.
+// The scale factor is folded into the block phasor, so the inner loop
+// costs one complex multiply per sample and vectorises cleanly.
+template <typename T>
+static void ncoMix(const short *xi, const short *xq, T *dptr, unsigned int numSamples,
+                   float scale, SoapySDRPlay::SoapySDRPlayStream *stream)
+{
+    double pRe = stream->ncoPhaseRe;
+    double pIm = stream->ncoPhaseIm;
+    unsigned int i = 0;
+    while (i < numSamples)
+    {
+        const unsigned int n = std::min(static_cast<unsigned int>(NCO_BLOCK_SIZE), numSamples - i);
+        const float bRe = static_cast<float>(pRe) * scale;
+        const float bIm = static_cast<float>(pIm) * scale;
+        const short *bxi = xi + i;
+        const short *bxq = xq + i;
+        T *bdptr = dptr + 2 * i;
+        for (unsigned int k = 0; k < n; k++)
+        {
+            const float cRe = bRe * stream->ncoRotRe[k] - bIm * stream->ncoRotIm[k];
+            const float cIm = bRe * stream->ncoRotIm[k] + bIm * stream->ncoRotRe[k];
+            const float sI = static_cast<float>(bxi[k]);
+            const float sQ = static_cast<float>(bxq[k]);
+            storeSample(sI * cRe - sQ * cIm, &bdptr[2 * k]);
+            storeSample(sI * cIm + sQ * cRe, &bdptr[2 * k + 1]);
+        }
+
+        // advance the block phasor by n samples
+        double rRe = stream->ncoBlockRotRe;
+        double rIm = stream->ncoBlockRotIm;
+        if (n != NCO_BLOCK_SIZE)
+        {
+            rRe = std::cos(stream->ncoIncrement * n);
+            rIm = std::sin(stream->ncoIncrement * n);
+        }
+        const double nRe = pRe * rRe - pIm * rIm;
+        pIm = pRe * rIm + pIm * rRe;
+        pRe = nRe;
+        i += n;
+    }
+
+    // renormalise once per callback to stop amplitude drift
+    const double mag = std::sqrt(pRe * pRe + pIm * pIm);
+    stream->ncoPhaseRe = pRe / mag;
+    stream->ncoPhaseIm = pIm / mag;
+}
+
 void SoapySDRPlay::rx_callback(short *xi, short *xq,
                                sdrplay_api_StreamCbParamsT *params,
                                unsigned int numSamples,
@@ -179,6 +274,7 @@ void SoapySDRPlay::rx_callback(short *xi, short *xq,
 
     // Track callback activity for stale callback detection
     stream->lastCallbackTicks.fetch_add(1, std::memory_order_relaxed);
+    stream->metrics->recordCallback(DeviceMetrics::nowNs(), numSamples);
 
     // Sample gap detection - check if samples are continuous
     if (stream->nextSampleNum != 0 && params->firstSampleNum != stream->nextSampleNum)
@@ -193,12 +289,34 @@ void SoapySDRPlay::rx_callback(short *xi, short *xq,
             // Handle wraparound (unsigned overflow)
             gap = UINT_MAX - (stream->nextSampleNum - params->firstSampleNum) + 1;
         }
-        stream->sampleGapCount.fetch_add(1, std::memory_order_relaxed);
-        SoapySDR_logf(SOAPY_SDR_WARNING, "Sample gap detected: %u samples missing [expected %u, got %u]",
-                      gap, stream->nextSampleNum, params->firstSampleNum);
+        // logged by the watchdog (logSampleGaps()): formatting a message
+        // would allocate in the callback thread
+        stream->lastGapSamples.store(gap, std::memory_order_relaxed);
+        stream->sampleGapCount.fetch_add(1, std::memory_order_release);
+        stream->metrics->recordGap(gap);
+        // the samples after the gap start a new buffer so that each
+        // buffer's timestamp stays exact
+        closeTailBuffer(stream, 0);
     }
     stream->nextSampleNum = params->firstSampleNum + numSamples;
 
+    // extend the 32-bit firstSampleNum to a 64-bit hardware tick count
+    uint64_t ticks = (stream->sampleTicks & ~static_cast<uint64_t>(0xffffffff)) | params->firstSampleNum;
+    if (ticks + 0x80000000ULL < stream->sampleTicks)
+    {
+        ticks += 0x100000000ULL;
+    }
+    stream->sampleTicks = ticks;
+    const uint64_t endTicks = ticks + numSamples;
+    hwTicks.store(endTicks, std::memory_order_relaxed);
+
+    // wake the command thread once a timed command is due
+    if (endTicks >= nextCommandTicks.load(std::memory_order_relaxed))
+    {
+        timedCommandDue = true;
+        timedCommandCv.notify_one();
+    }
+
     bool notify = false;
     if (gr_changed == 0 && params->grChanged != 0)
     {
@@ -220,10 +338,75 @@ void SoapySDRPlay::rx_callback(short *xi, short *xq,
         update_cv.notify_all();
     }
 
+    // hot standby: the device stays initialised, samples are not kept
+    if (stream->standby)
+    {
+        return;
+    }
+
+    // a timed command took effect with this packet: start a new buffer
+    // so that its timestamp is the time of the change
+    if (timedCommandInFlight.load(std::memory_order_relaxed) && (params->rfChanged || params->grChanged))
+    {
+        closeTailBuffer(stream, 0);
+        lastCommandTicks = ticks;
+        timedCommandInFlight = false;
+    }
+
+    // timed activation: drop samples before the requested start time
+    if (endTicks <= stream->activateTicks)
+    {
+        return;
+    }
+    if (ticks < stream->activateTicks)
+    {
+        const unsigned int skip = static_cast<unsigned int>(stream->activateTicks - ticks);
+        xi += skip;
+        xq += skip;
+        numSamples -= skip;
+        ticks += skip;
+    }
+
+    // the sweep engine decides which samples are kept (settle/dwell)
+    if (sweepRunning && stream->channel == 0)
+    {
+        sweepCallback(xi, xq, params, numSamples, ticks, stream);
+        return;
+    }
+
+    // finite burst: deliver exactly numElems samples, then go idle
+    if (stream->burstMode)
+    {
+        if (stream->burstRemaining == 0)
+        {
+            return;
+        }
+        numSamples = static_cast<unsigned int>(std::min<size_t>(numSamples, stream->burstRemaining));
+        if (!appendSamples(xi, xq, numSamples, ticks, stream))
+        {
+            return;
+        }
+        stream->burstRemaining -= numSamples;
+        if (stream->burstRemaining == 0)
+        {
+            closeTailBuffer(stream, SOAPY_SDR_END_BURST);
+        }
+        return;
+    }
+
+    appendSamples(xi, xq, numSamples, ticks, stream);
+}
+
+// Copy samples into the stream's buffer queue; stream->mutex must be held
+bool SoapySDRPlay::appendSamples(const short *xi, const short *xq,
+                                 unsigned int numSamples,
+                                 uint64_t ticks,
+                                 SoapySDRPlayStream *stream)
+{
     if (stream->count == numBuffers)
     {
         stream->overflowEvent = true;
-        return;
+        return false;
     }
 
     const size_t spaceReqd = static_cast<size_t>(numSamples) * elementsPerSample;
@@ -231,9 +414,14 @@ void SoapySDRPlay::rx_callback(short *xi, short *xq,
     size_t threshold = static_cast<size_t>(cachedBufferThreshold.load(std::memory_order_relaxed));
     if (threshold == 0) threshold = static_cast<size_t>(bufferLength.load());  // Fallback if not yet initialized
 
-    // copy into the buffer queue
-    unsigned int i = 0;
+    // pick up NCO retunes from setFrequency() (hybrid tuning)
+    const double ncoIncrement = ncoPhaseIncrement.load(std::memory_order_relaxed);
+    if (ncoIncrement != stream->ncoIncrement)
+    {
+        ncoPrepare(stream, ncoIncrement);
+    }
 
+    // copy into the buffer queue
     if (useShort)
     {
         {
@@ -244,28 +432,34 @@ void SoapySDRPlay::rx_callback(short *xi, short *xq,
                 // Use bitwise AND instead of modulo for power-of-2 numBuffers (faster)
                 stream->tail = (stream->tail + 1) & (numBuffers - 1);
                 stream->count++;
+                stream->metrics->queueDepth.store(static_cast<uint32_t>(stream->count), std::memory_order_relaxed);
 
                 auto &nextBuff = stream->shortBuffs[stream->tail];
                 if (stream->count == numBuffers && spaceReqd > nextBuff.capacity() - nextBuff.size())
                 {
                     stream->overflowEvent = true;
-                    return;
+                    return false;
                 }
 
                 // notify readStream()
+                Tracer::instant("buffer_ready", stream->count);
                 stream->cond.notify_one();
             }
         }
 
         // get current fill buffer
         auto &buff = stream->shortBuffs[stream->tail];
+        if (buff.empty())
+        {
+            stream->buffTicks[stream->tail] = ticks;
+        }
 
         // Check if resize would exceed capacity (would cause reallocation)
         size_t newSize = buff.size() + spaceReqd;
         if (newSize > buff.capacity())
         {
             stream->overflowEvent = true;
-            return;
+            return false;
         }
 
         // resize within pre-allocated capacity (no reallocation)
@@ -273,10 +467,13 @@ void SoapySDRPlay::rx_callback(short *xi, short *xq,
 
         short *dptr = buff.data();
         dptr += (buff.size() - spaceReqd);
-        for (i = 0; i < numSamples; i++)
+        if (ncoIncrement != 0.0)
+        {
+            ncoMix(xi, xq, dptr, numSamples, 1.0f, stream);
+        }
+        else
         {
-            *dptr++ = xi[i];
-            *dptr++ = xq[i];
+            interleaveCS16(xi, xq, dptr, numSamples);
         }
     }
     else
@@ -289,46 +486,74 @@ void SoapySDRPlay::rx_callback(short *xi, short *xq,
                 // Use bitwise AND instead of modulo for power-of-2 numBuffers (faster)
                 stream->tail = (stream->tail + 1) & (numBuffers - 1);
                 stream->count++;
+                stream->metrics->queueDepth.store(static_cast<uint32_t>(stream->count), std::memory_order_relaxed);
 
                 auto &nextBuff = stream->floatBuffs[stream->tail];
                 if (stream->count == numBuffers && spaceReqd > nextBuff.capacity() - nextBuff.size())
                 {
                     stream->overflowEvent = true;
-                    return;
+                    return false;
                 }
 
                 // notify readStream()
+                Tracer::instant("buffer_ready", stream->count);
                 stream->cond.notify_one();
             }
         }
 
         // get current fill buffer
         auto &buff = stream->floatBuffs[stream->tail];
+        if (buff.empty())
+        {
+            stream->buffTicks[stream->tail] = ticks;
+        }
 
         // Check if resize would exceed capacity (would cause reallocation)
         size_t newSize = buff.size() + spaceReqd;
         if (newSize > buff.capacity())
         {
             stream->overflowEvent = true;
-            return;
+            return false;
         }
 
         // resize within pre-allocated capacity (no reallocation)
         buff.resize(newSize);
 
-        // Use multiplication by reciprocal instead of division for performance
-        // (multiplication is faster than division in the hot path)
-        constexpr float SCALE = 1.0f / 32768.0f;
         float *dptr = buff.data();
         dptr += (buff.size() - spaceReqd);
-        for (i = 0; i < numSamples; i++)
+        if (ncoIncrement != 0.0)
         {
-            *dptr++ = static_cast<float>(xi[i]) * SCALE;
-            *dptr++ = static_cast<float>(xq[i]) * SCALE;
+            ncoMix(xi, xq, dptr, numSamples, 1.0f / 32768.0f, stream);
+        }
+        else
+        {
+            interleaveCF32(xi, xq, dptr, numSamples);
         }
     }
 
-    return;
+    return true;
+}
+
+// Hand the partially filled tail buffer over to the reader so that the
+// next samples start a new buffer; flags are reported with its last sample
+void SoapySDRPlay::closeTailBuffer(SoapySDRPlayStream *stream, int flags)
+{
+    const size_t size = useShort ? stream->shortBuffs[stream->tail].size()
+                                 : stream->floatBuffs[stream->tail].size();
+    if (size == 0)
+    {
+        return;
+    }
+    if (stream->count == numBuffers)
+    {
+        stream->overflowEvent = true;
+        return;
+    }
+    stream->buffFlags[stream->tail] |= flags;
+    stream->tail = (stream->tail + 1) & (numBuffers - 1);
+    stream->count++;
+    stream->metrics->queueDepth.store(static_cast<uint32_t>(stream->count), std::memory_order_relaxed);
+    stream->cond.notify_one();
 }
 
 void SoapySDRPlay::ev_callback(sdrplay_api_EventT eventId, sdrplay_api_TunerSelectT tuner, sdrplay_api_EventParamsT *params)
@@ -455,6 +680,9 @@ SoapySDRPlay::SoapySDRPlayStream::SoapySDRPlayStream(size_t channel,
     for (auto &buff : shortBuffs) buff.reserve(bufferLength);
     floatBuffs.resize(numBuffers);
     for (auto &buff : floatBuffs) buff.reserve(bufferLength);
+    buffFlags.assign(numBuffers, 0);
+    buffSweepStep.assign(numBuffers, 0);
+    buffTicks.assign(numBuffers, 0);
 }
 
 SoapySDRPlay::SoapySDRPlayStream::~SoapySDRPlayStream()
@@ -480,17 +708,26 @@ SoapySDR::Stream *SoapySDRPlay::setupStream(const int direction,
        throw std::runtime_error("setupStream invalid channel selection");
     }
 
+    // samples per buffer (the buffers are allocated for the default)
+    unsigned long elems = bufferElems;
+    const auto bufflen = args.find("bufflen");
+    if (bufflen != args.end())
+    {
+        elems = std::strtoul(bufflen->second.c_str(), nullptr, 10);
+        elems = std::max<unsigned long>(MIN_BUFFER_LENGTH, std::min<unsigned long>(elems, bufferElems));
+    }
+
     // check the format
     if (format == "CS16")
     {
         useShort = true;
-        bufferLength = bufferElems * elementsPerSample;
+        bufferLength = elems * elementsPerSample;
         SoapySDR_log(SOAPY_SDR_INFO, "Using format CS16.");
     }
     else if (format == "CF32")
     {
         useShort = false;
-        bufferLength = bufferElems * elementsPerSample;
+        bufferLength = elems * elementsPerSample;
         SoapySDR_log(SOAPY_SDR_INFO, "Using format CF32.");
     }
     else
@@ -513,8 +750,11 @@ SoapySDR::Stream *SoapySDRPlay::setupStream(const int direction,
     }
     if (sdrplay_stream == nullptr)
     {
-        sdrplay_stream = new SoapySDRPlayStream(channel, numBuffers, bufferLength);
+        sdrplay_stream = new SoapySDRPlayStream(channel, numBuffers, bufferElems * elementsPerSample);
     }
+    sdrplay_stream->metrics = &metrics->channel(channel);
+    sdrplay_stream->metrics->queueCapacity.store(static_cast<uint32_t>(numBuffers), std::memory_order_relaxed);
+    metrics->page()->numChannels.store(static_cast<uint32_t>(nchannels), std::memory_order_relaxed);
     return reinterpret_cast<SoapySDR::Stream *>(sdrplay_stream);
 }
 
@@ -564,8 +804,9 @@ void SoapySDRPlay::closeStream(SoapySDR::Stream *stream)
         // otherwise a callback in flight could access freed memory.
         if (activeStreams == 0)
         {
-            // Stop watchdog before stopping stream
+            // Stop watchdog and sweep before stopping stream
             stopWatchdog();
+            stopSweep();
 
             // Use timeout-protected Uninit to prevent hanging
             int retryCount = 0;
@@ -589,6 +830,7 @@ void SoapySDRPlay::closeStream(SoapySDR::Stream *stream)
                 SoapySDR_log(SOAPY_SDR_ERROR, "Exceeded max retries waiting for slave device - forcing close");
             }
             streamActive = false;
+            metrics->page()->streaming.store(0, std::memory_order_relaxed);
         }
 
         delete sdrplay_stream;
@@ -600,8 +842,9 @@ void SoapySDRPlay::closeStream(SoapySDR::Stream *stream)
         // Handle case where we didn't delete a stream but all streams are now inactive
         if (activeStreams == 0)
         {
-            // Stop watchdog before stopping stream
+            // Stop watchdog and sweep before stopping stream
             stopWatchdog();
+            stopSweep();
 
             // Use timeout-protected Uninit to prevent hanging
             int retryCount = 0;
@@ -625,14 +868,15 @@ void SoapySDRPlay::closeStream(SoapySDR::Stream *stream)
                 SoapySDR_log(SOAPY_SDR_ERROR, "Exceeded max retries waiting for slave device - forcing close");
             }
             streamActive = false;
+            metrics->page()->streaming.store(0, std::memory_order_relaxed);
         }
     }
 }
 
 size_t SoapySDRPlay::getStreamMTU(SoapySDR::Stream *stream) const
 {
-    // is a constant in practice
-    return bufferElems;
+    // set by the "bufflen" stream argument
+    return bufferLength / elementsPerSample;
 }
 
 int SoapySDRPlay::activateStream(SoapySDR::Stream *stream,
@@ -640,14 +884,30 @@ int SoapySDRPlay::activateStream(SoapySDR::Stream *stream,
                                  const long long timeNs,
                                  const size_t numElems)
 {
-    if (flags != 0)
+    if ((flags & ~(SOAPY_SDR_HAS_TIME | SOAPY_SDR_END_BURST)) != 0)
+    {
+        SoapySDR_log(SOAPY_SDR_ERROR, "error in activateStream() - only SOAPY_SDR_HAS_TIME and SOAPY_SDR_END_BURST are supported");
+        return SOAPY_SDR_NOT_SUPPORTED;
+    }
+    if ((flags & SOAPY_SDR_END_BURST) != 0 && numElems == 0)
     {
-        SoapySDR_log(SOAPY_SDR_ERROR, "error in activateStream() - flags != 0");
+        SoapySDR_log(SOAPY_SDR_ERROR, "error in activateStream() - SOAPY_SDR_END_BURST requires numElems > 0");
         return SOAPY_SDR_NOT_SUPPORTED;
     }
 
     SoapySDRPlayStream *sdrplay_stream = reinterpret_cast<SoapySDRPlayStream *>(stream);
 
+    // timed activation: rx_callback drops samples before this tick
+    // finite burst: rx_callback stops after numElems samples; a stream that
+    // is already running is simply re-armed below, without a new Init()
+    {
+        std::lock_guard<std::mutex> streamLock(sdrplay_stream->mutex);
+        sdrplay_stream->activateTicks = (flags & SOAPY_SDR_HAS_TIME) ? timeNsToTicks(timeNs) : 0;
+        sdrplay_stream->burstMode = (flags & SOAPY_SDR_END_BURST) != 0;
+        sdrplay_stream->burstRemaining = numElems;
+        sdrplay_stream->standby = false;
+    }
+
     sdrplay_api_ErrT err;
 
     std::unique_lock<std::mutex> lock(_general_state_mutex);
@@ -656,8 +916,13 @@ int SoapySDRPlay::activateStream(SoapySDR::Stream *stream,
         std::lock_guard<std::mutex> streamsLock(_streams_mutex);
         sdrplay_stream->reset = true;
         sdrplay_stream->nElems = 0;
-        _streams[sdrplay_stream->channel] = sdrplay_stream;
-        _streamsRefCount[sdrplay_stream->channel]++;
+        // re-activating the same stream (e.g. to re-arm a burst) must not
+        // take another reference, or closeStream() would never release it
+        if (_streams[sdrplay_stream->channel] != sdrplay_stream)
+        {
+            _streams[sdrplay_stream->channel] = sdrplay_stream;
+            _streamsRefCount[sdrplay_stream->channel]++;
+        }
     }
 
     if (streamActive)
@@ -687,6 +952,9 @@ int SoapySDRPlay::activateStream(SoapySDR::Stream *stream,
     deviceParams->devParams->mode = sdrplay_api_BULK;
 #endif
 
+    // callbacks are not running yet: the first one starts a new interval
+    sdrplay_stream->metrics->lastCallbackNs.store(0, std::memory_order_relaxed);
+
     // Use timeout-protected Init to prevent hanging if service is unresponsive
     err = initWithTimeout(device.dev, &cbFns, static_cast<void *>(this), SDRPLAY_API_TIMEOUT_MS);
     if (err != sdrplay_api_Success)
@@ -711,9 +979,15 @@ int SoapySDRPlay::activateStream(SoapySDR::Stream *stream,
     }
 
     streamActive = true;
+    metrics->page()->streaming.store(1, std::memory_order_relaxed);
 
     // Notify any threads waiting in readStream() that the stream is now active
     update_cv.notify_all();
+    {
+        // and the sweep thread, which only steps while streaming
+        std::lock_guard<std::mutex> sweepLock(sweepMutex);
+        sweepCv.notify_all();
+    }
 
     // Re-apply persistent antenna settings after stream activation
     // (some hardware may reset antenna during Init)
@@ -762,7 +1036,17 @@ int SoapySDRPlay::deactivateStream(SoapySDR::Stream *stream, const int flags, co
         return SOAPY_SDR_NOT_SUPPORTED;
     }
 
-    // do nothing because deactivateStream() can be called multiple times
+    SoapySDRPlayStream *sdrplay_stream = reinterpret_cast<SoapySDRPlayStream *>(stream);
+    if (sdrplay_stream == nullptr)
+    {
+        return SOAPY_SDR_STREAM_ERROR;
+    }
+
+    // Hot standby: keep the API stream initialised (no Uninit) and only
+    // close the gate in rx_callback, so the next activateStream() resumes
+    // immediately. deactivateStream() can be called multiple times.
+    std::lock_guard<std::mutex> lock(sdrplay_stream->mutex);
+    sdrplay_stream->standby = true;
     return 0;
 }
 
@@ -811,6 +1095,8 @@ int SoapySDRPlay::readStream(SoapySDR::Stream *stream,
             return ret;
         }
         sdrplay_stream->nElems = ret;
+        // END_BURST belongs to the last fragment of the buffer (see below)
+        flags &= ~SOAPY_SDR_END_BURST;
     }
 
     size_t returnedElems = std::min(sdrplay_stream->nElems.load(), numElems);
@@ -837,6 +1123,9 @@ int SoapySDRPlay::readStream(SoapySDR::Stream *stream,
 
     // bump variables for next call into readStream
     sdrplay_stream->nElems -= returnedElems;
+    flags |= SOAPY_SDR_HAS_TIME;
+    timeNs = ticksToTimeNs(sdrplay_stream->readTicks);
+    sdrplay_stream->readTicks += returnedElems;
 
     // scope lock here to update stream->currentBuff position
     {
@@ -860,6 +1149,10 @@ int SoapySDRPlay::readStream(SoapySDR::Stream *stream,
     }
     else
     {
+        {
+            std::lock_guard <std::mutex> lock(sdrplay_stream->mutex);
+            flags |= sdrplay_stream->buffFlags[sdrplay_stream->currentHandle];
+        }
         this->releaseReadBuffer(stream, sdrplay_stream->currentHandle);
     }
     return static_cast<int>(returnedElems);
@@ -910,6 +1203,19 @@ int SoapySDRPlay::getDirectAccessBufferAddrs(SoapySDR::Stream *stream, const siz
     return 0;
 }
 
+void SoapySDRPlay::logSampleGaps(SoapySDRPlayStream *stream)
+{
+    const uint64_t gaps = stream->sampleGapCount.load(std::memory_order_acquire);
+    if (gaps == stream->loggedGapCount)
+    {
+        return;
+    }
+    SoapySDR_logf(SOAPY_SDR_WARNING, "Sample gap detected: %llu gap(s), last %u samples missing",
+                  (unsigned long long)(gaps - stream->loggedGapCount),
+                  stream->lastGapSamples.load(std::memory_order_relaxed));
+    stream->loggedGapCount = gaps;
+}
+
 int SoapySDRPlay::acquireReadBuffer(SoapySDR::Stream *stream,
                                     size_t &handle,
                                     const void **buffs,
@@ -933,6 +1239,7 @@ int SoapySDRPlay::acquireReadBuffer(SoapySDR::Stream *stream,
         sdrplay_stream->tail = 0;
         sdrplay_stream->head = 0;
         sdrplay_stream->count = 0;
+        sdrplay_stream->metrics->queueDepth.store(0, std::memory_order_relaxed);
         if (useShort)
         {
             for (auto &buff : sdrplay_stream->shortBuffs) buff.clear();
@@ -941,6 +1248,7 @@ int SoapySDRPlay::acquireReadBuffer(SoapySDR::Stream *stream,
         {
             for (auto &buff : sdrplay_stream->floatBuffs) buff.clear();
         }
+        std::fill(sdrplay_stream->buffFlags.begin(), sdrplay_stream->buffFlags.end(), 0);
         sdrplay_stream->overflowEvent = false;
         sdrplay_stream->nextSampleNum = 0;  // Reset sample tracking after drain
         if (sdrplay_stream->reset)
@@ -949,6 +1257,9 @@ int SoapySDRPlay::acquireReadBuffer(SoapySDR::Stream *stream,
         }
         else
         {
+           metricsAdd(sdrplay_stream->metrics->overflows, 1);
+           lock.unlock();
+           Tracer::instance().overflow();
            SoapySDR_log(SOAPY_SDR_SSI, "O");
            return SOAPY_SDR_OVERFLOW;
         }
@@ -958,6 +1269,8 @@ int SoapySDRPlay::acquireReadBuffer(SoapySDR::Stream *stream,
     // Use predicate form to handle spurious wakeups correctly
     if (sdrplay_stream->count == 0)
     {
+        TraceScope trace("read_wait");
+
         // Track callback activity to detect if callbacks stop firing
         uint64_t ticksBefore = sdrplay_stream->lastCallbackTicks.load(std::memory_order_relaxed);
 
@@ -995,17 +1308,19 @@ int SoapySDRPlay::acquireReadBuffer(SoapySDR::Stream *stream,
     {
         buffs[0] = static_cast<void *>(sdrplay_stream->floatBuffs[handle].data());
     }
-    flags = 0;
+    flags = sdrplay_stream->buffFlags[handle] | SOAPY_SDR_HAS_TIME;
+    timeNs = ticksToTimeNs(sdrplay_stream->buffTicks[handle]);
+    sdrplay_stream->readTicks = sdrplay_stream->buffTicks[handle];
+    sweepReadStep = sdrplay_stream->buffSweepStep[handle];
 
     // Use bitwise AND instead of modulo for power-of-2 numBuffers (faster)
     sdrplay_stream->head = (sdrplay_stream->head + 1) & (numBuffers - 1);
 
     // return number available
-    if (useShort)
-    {
-        return static_cast<int>(sdrplay_stream->shortBuffs[handle].size() / elementsPerSample);
-    }
-    return static_cast<int>(sdrplay_stream->floatBuffs[handle].size() / elementsPerSample);
+    const size_t numSamples = (useShort ? sdrplay_stream->shortBuffs[handle].size()
+                                        : sdrplay_stream->floatBuffs[handle].size()) / elementsPerSample;
+    metricsAdd(sdrplay_stream->metrics->samplesDelivered, numSamples);
+    return static_cast<int>(numSamples);
 }
 
 void SoapySDRPlay::releaseReadBuffer(SoapySDR::Stream *stream, const size_t handle)
@@ -1037,5 +1352,7 @@ void SoapySDRPlay::releaseReadBuffer(SoapySDR::Stream *stream, const size_t hand
         }
         sdrplay_stream->floatBuffs[handle].clear();
     }
+    sdrplay_stream->buffFlags[handle] = 0;
     sdrplay_stream->count--;
+    sdrplay_stream->metrics->queueDepth.store(static_cast<uint32_t>(sdrplay_stream->count), std::memory_order_relaxed);
 }
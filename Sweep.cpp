@@ -0,0 +1,271 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - Frequency sweep engine for SoapySDRPlay3
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "SoapySDRPlay.hpp"
+#include <cmath>
+
+/*******************************************************************
+ * Frequency Sweep Engine
+ *
+ * The sweep thread steps the LO through sweepFrequencies. After each
+ * retune rx_callback waits for the API's rfChanged flag, which marks the
+ * first packet at the new frequency, discards sweepSettleSamples and then
+ * either queues sweepDwellSamples for the reader (one END_BURST tagged
+ * block per step) or integrates their power.
+ ******************************************************************/
+
+void SoapySDRPlay::startSweep()
+{
+    if (sweepRunning.load())
+    {
+        return;
+    }
+    if (sweepFrequencies.empty() || sweepDwellSamples == 0)
+    {
+        SoapySDR_log(SOAPY_SDR_WARNING, "Sweep not started - sweep_frequencies and sweep_dwell must be set");
+        return;
+    }
+
+    sweepPowerPending.assign(sweepFrequencies.size(), 0.0);
+    {
+        std::lock_guard<std::mutex> lock(sweepMutex);
+        sweepPower.clear();
+        sweepCount = 0;
+    }
+    sweepStep = 0;
+    sweepState = SweepState::Idle;
+    sweepShutdown = false;
+    sweepRunning = true;
+    sweepThread = std::thread(&SoapySDRPlay::sweepThreadFunc, this);
+
+    SoapySDR_logf(SOAPY_SDR_DEBUG, "Sweep started (%zu steps, dwell=%lu, settle=%lu)",
+                  sweepFrequencies.size(), sweepDwellSamples, sweepSettleSamples);
+}
+
+void SoapySDRPlay::stopSweep()
+{
+    if (!sweepRunning.load())
+    {
+        return;
+    }
+
+    sweepShutdown = true;
+    {
+        std::lock_guard<std::mutex> lock(sweepMutex);
+        sweepCv.notify_all();
+    }
+    if (sweepThread.joinable())
+    {
+        sweepThread.join();
+    }
+
+    sweepRunning = false;
+    sweepState = SweepState::Idle;
+    SoapySDR_log(SOAPY_SDR_DEBUG, "Sweep stopped");
+}
+
+void SoapySDRPlay::sweepThreadFunc()
+{
+    auto retuneStart = std::chrono::steady_clock::now();
+
+    // wait a while before retrying a step that could not be started
+    auto backOff = [this]() {
+        std::unique_lock<std::mutex> lk(sweepMutex);
+        sweepCv.wait_for(lk, std::chrono::milliseconds(10), [this]{ return sweepShutdown.load(); });
+    };
+
+    while (!sweepShutdown.load())
+    {
+        // a step is started once the previous one is done and the stream
+        // is active (activateStream() notifies); Retuning is polled for
+        // the rfChanged timeout
+        {
+            std::unique_lock<std::mutex> lk(sweepMutex);
+            sweepCv.wait_for(lk, std::chrono::milliseconds(50), [this]{
+                const SweepState state = sweepState.load();
+                return sweepShutdown.load() ||
+                       ((state == SweepState::Idle || state == SweepState::StepDone) && streamActive.load());
+            });
+        }
+        if (sweepShutdown.load())
+        {
+            break;
+        }
+
+        SweepState state = sweepState.load();
+        if (state == SweepState::Retuning)
+        {
+            // rfChanged never arrived (e.g. the update was merged by the
+            // API); fall back to the settle period alone
+            if (std::chrono::steady_clock::now() - retuneStart > std::chrono::milliseconds(2 * updateTimeout))
+            {
+                SweepState expected = SweepState::Retuning;
+                if (sweepState.compare_exchange_strong(expected, SweepState::SettleStart))
+                {
+                    SoapySDR_log(SOAPY_SDR_WARNING, "Sweep: no rfChanged after retune - relying on settle time");
+                }
+            }
+            continue;
+        }
+        if ((state != SweepState::Idle && state != SweepState::StepDone) || !streamActive.load())
+        {
+            continue;
+        }
+
+        // closeStream() joins this thread while holding _general_state_mutex,
+        // so never block on it here
+        std::unique_lock<std::mutex> lock(_general_state_mutex, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            backOff();
+            continue;
+        }
+
+        const size_t numSteps = sweepFrequencies.size();
+        const size_t next = (state == SweepState::Idle) ? 0 : (sweepStep.load() + 1) % numSteps;
+        const double frequency = sweepFrequencies[next];
+        sweepStep = next;
+        setNcoOffset(0.0);
+
+        if (chParams->tunerParams.rfFreq.rfHz == (uint32_t)frequency)
+        {
+            sweepState = SweepState::SettleStart;
+            continue;
+        }
+
+        // switch to Retuning before the update so that no sample of the
+        // old frequency is attributed to the new step
+        const double previousFrequency = chParams->tunerParams.rfFreq.rfHz;
+        chParams->tunerParams.rfFreq.rfHz = (uint32_t)frequency;
+        sweepState = SweepState::Retuning;
+        retuneStart = std::chrono::steady_clock::now();
+        if (!executeApiUpdate(sdrplay_api_Update_Tuner_Frf, sdrplay_api_Update_Ext1_None,
+                              nullptr, "Sweep_Tuner_Frf"))
+        {
+            // retry the same step on the next pass
+            chParams->tunerParams.rfFreq.rfHz = previousFrequency;
+            sweepStep = (next + numSteps - 1) % numSteps;
+            sweepState = (next == 0) ? SweepState::Idle : SweepState::StepDone;
+            lock.unlock();
+            backOff();
+        }
+    }
+}
+
+// Called from rx_callback with stream->mutex held
+void SoapySDRPlay::sweepCallback(short *xi, short *xq,
+                                 sdrplay_api_StreamCbParamsT *params,
+                                 unsigned int numSamples,
+                                 uint64_t ticks,
+                                 SoapySDRPlayStream *stream)
+{
+    unsigned int pos = 0;
+    while (pos < numSamples)
+    {
+        SweepState state = sweepState.load();
+        if (state == SweepState::Retuning)
+        {
+            if (params->rfChanged == 0)
+            {
+                return;
+            }
+            // rfChanged marks the first packet at the new frequency
+            sweepState.compare_exchange_strong(state, SweepState::SettleStart);
+        }
+        else if (state == SweepState::SettleStart)
+        {
+            sweepSamplesLeft = sweepSettleSamples;
+            sweepPowerAccum = 0.0;
+            sweepState = (sweepSamplesLeft > 0) ? SweepState::Settling : SweepState::Dwell;
+            if (sweepSamplesLeft == 0)
+            {
+                sweepSamplesLeft = sweepDwellSamples;
+            }
+        }
+        else if (state == SweepState::Settling)
+        {
+            const unsigned int n = static_cast<unsigned int>(
+                std::min<unsigned long>(sweepSamplesLeft, numSamples - pos));
+            pos += n;
+            sweepSamplesLeft -= n;
+            if (sweepSamplesLeft == 0)
+            {
+                sweepSamplesLeft = sweepDwellSamples;
+                sweepState = SweepState::Dwell;
+            }
+        }
+        else if (state == SweepState::Dwell)
+        {
+            const unsigned int n = static_cast<unsigned int>(
+                std::min<unsigned long>(sweepSamplesLeft, numSamples - pos));
+            const size_t step = sweepStep.load();
+            if (sweepPowerMode)
+            {
+                double acc = 0.0;
+                for (unsigned int i = pos; i < pos + n; i++)
+                {
+                    acc += static_cast<double>(xi[i]) * xi[i] + static_cast<double>(xq[i]) * xq[i];
+                }
+                sweepPowerAccum += acc;
+            }
+            else if (appendSamples(xi + pos, xq + pos, n, ticks + pos, stream))
+            {
+                stream->buffSweepStep[stream->tail] = step;
+            }
+            pos += n;
+            sweepSamplesLeft -= n;
+
+            if (sweepSamplesLeft == 0)
+            {
+                if (sweepPowerMode)
+                {
+                    // mean power relative to int16 full scale
+                    const double meanPower = sweepPowerAccum / (static_cast<double>(sweepDwellSamples) * 32768.0 * 32768.0);
+                    sweepPowerPending[step] = 10.0 * std::log10(std::max(meanPower, 1e-20));
+                    if (step + 1 == sweepPowerPending.size())
+                    {
+                        std::lock_guard<std::mutex> lock(sweepMutex);
+                        sweepPower = sweepPowerPending;
+                        sweepCount++;
+                    }
+                }
+                else
+                {
+                    closeTailBuffer(stream, SOAPY_SDR_END_BURST);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(sweepMutex);
+                    sweepState = SweepState::StepDone;
+                    sweepCv.notify_one();
+                }
+                return;
+            }
+        }
+        else
+        {
+            // Idle / StepDone: nothing to keep until the next retune
+            return;
+        }
+    }
+}
@@ -0,0 +1,185 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - Hardware time and timed commands for SoapySDRPlay3
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "SoapySDRPlay.hpp"
+#include <SoapySDR/Time.hpp>
+#include <algorithm>
+
+/*******************************************************************
+ * Time API
+ *
+ * Hardware time is derived from the sample counter reported by the
+ * stream callback (firstSampleNum), so it advances only while streaming
+ * and has single-sample resolution at the output sample rate.
+ ******************************************************************/
+
+bool SoapySDRPlay::hasHardwareTime(const std::string &what) const
+{
+    return what.empty();
+}
+
+long long SoapySDRPlay::getHardwareTime(const std::string &what) const
+{
+    return ticksToTimeNs(hwTicks.load());
+}
+
+void SoapySDRPlay::setHardwareTime(const long long timeNs, const std::string &what)
+{
+    // map the current sample counter to the requested time
+    const double rate = getSampleRate(SOAPY_SDR_RX, 0);
+    hwTimeOffsetTicks = SoapySDR::timeNsToTicks(timeNs, rate) - static_cast<long long>(hwTicks.load());
+}
+
+void SoapySDRPlay::setCommandTime(const long long timeNs, const std::string &what)
+{
+    // frequency and gain changes made after this call are deferred until
+    // the stream reaches timeNs; a time of 0 returns to immediate mode
+    commandTimeNs = timeNs;
+}
+
+long long SoapySDRPlay::ticksToTimeNs(uint64_t ticks) const
+{
+    const double rate = getSampleRate(SOAPY_SDR_RX, 0);
+    return SoapySDR::ticksToTimeNs(static_cast<long long>(ticks) + hwTimeOffsetTicks.load(), rate);
+}
+
+uint64_t SoapySDRPlay::timeNsToTicks(long long timeNs) const
+{
+    const double rate = getSampleRate(SOAPY_SDR_RX, 0);
+    const long long ticks = SoapySDR::timeNsToTicks(timeNs, rate) - hwTimeOffsetTicks.load();
+    return ticks > 0 ? static_cast<uint64_t>(ticks) : 0;
+}
+
+/*******************************************************************
+ * Timed command queue
+ *
+ * rx_callback only compares the stream position with nextCommandTicks
+ * and wakes the command thread, which issues the sdrplay_api_Update()
+ * (API calls are not made from the streaming callback). The callback
+ * then starts a new buffer at the packet flagged with rfChanged or
+ * grChanged, so the first readStream() after the change carries the
+ * exact hardware time at which it took effect.
+ ******************************************************************/
+
+// Returns true if the change was queued instead of applied immediately
+bool SoapySDRPlay::queueTimedCommand(TimedCommand::Type type, size_t channel,
+                                     const std::string &name, double value)
+{
+    const long long timeNs = commandTimeNs.load();
+    if (timeNs == 0 || std::this_thread::get_id() == timedCommandThreadId.load())
+    {
+        return false;
+    }
+
+    TimedCommand cmd;
+    cmd.ticks = timeNsToTicks(timeNs);
+    cmd.type = type;
+    cmd.channel = channel;
+    cmd.name = name;
+    cmd.value = value;
+
+    std::lock_guard<std::mutex> lock(timedCommandMutex);
+    auto pos = std::upper_bound(timedCommands.begin(), timedCommands.end(), cmd,
+                                [](const TimedCommand &a, const TimedCommand &b) { return a.ticks < b.ticks; });
+    timedCommands.insert(pos, cmd);
+    nextCommandTicks = timedCommands.front().ticks;
+
+    if (!timedCommandRunning.exchange(true))
+    {
+        timedCommandShutdown = false;
+        timedCommandThread = std::thread(&SoapySDRPlay::timedCommandThreadFunc, this);
+        timedCommandThreadId = timedCommandThread.get_id();
+    }
+    return true;
+}
+
+void SoapySDRPlay::stopTimedCommands()
+{
+    if (!timedCommandRunning.load())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(timedCommandMutex);
+        timedCommandShutdown = true;
+        timedCommands.clear();
+        nextCommandTicks = UINT64_MAX;
+        timedCommandCv.notify_all();
+    }
+    if (timedCommandThread.joinable())
+    {
+        timedCommandThread.join();
+    }
+    timedCommandRunning = false;
+}
+
+void SoapySDRPlay::timedCommandThreadFunc()
+{
+    std::vector<TimedCommand> due;
+
+    while (!timedCommandShutdown.load())
+    {
+        {
+            std::unique_lock<std::mutex> lock(timedCommandMutex);
+            timedCommandCv.wait_for(lock, std::chrono::milliseconds(50), [this]{
+                return timedCommandShutdown.load() || timedCommandDue.load();
+            });
+            if (timedCommandShutdown.load())
+            {
+                break;
+            }
+            timedCommandDue = false;
+
+            const uint64_t now = hwTicks.load();
+            auto it = timedCommands.begin();
+            while (it != timedCommands.end() && it->ticks <= now)
+            {
+                ++it;
+            }
+            due.assign(timedCommands.begin(), it);
+            timedCommands.erase(timedCommands.begin(), it);
+            nextCommandTicks = timedCommands.empty() ? UINT64_MAX : timedCommands.front().ticks;
+        }
+
+        // executeApiUpdate() marks the command in flight once it has
+        // issued the update (an unchanged value or a stopped stream skips it)
+        for (const auto &cmd : due)
+        {
+            if (cmd.type == TimedCommand::Frequency)
+            {
+                setFrequency(SOAPY_SDR_RX, cmd.channel, cmd.name, cmd.value);
+            }
+            else if (cmd.type == TimedCommand::GainElement)
+            {
+                setGain(SOAPY_SDR_RX, cmd.channel, cmd.name, cmd.value);
+            }
+            else
+            {
+                setGain(SOAPY_SDR_RX, cmd.channel, cmd.value);
+            }
+        }
+        due.clear();
+    }
+}
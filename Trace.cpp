@@ -0,0 +1,385 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - Event tracer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "Trace.hpp"
+#include "DeviceMetrics.hpp"
+#include <SoapySDR/Logger.h>
+
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+
+std::atomic<bool> Tracer::enabled_{false};
+
+/*******************************************************************
+ * Per-thread rings
+ ******************************************************************/
+
+struct TraceEvent
+{
+    std::atomic<int64_t> ns;
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> arg;
+    std::atomic<char> phase;
+};
+
+// Written by its thread only. claimed is raised before a slot is
+// overwritten and head after, so a dump knows which of the events it
+// copied may have changed under it.
+struct Tracer::Ring
+{
+    TraceEvent events[TRACE_RING_EVENTS];
+    std::atomic<uint64_t> claimed{0};
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> start{0};  // First event of the current thread
+    std::atomic<uint32_t> tid{0};
+    std::atomic<const char*> threadName{nullptr};
+    std::atomic<bool> inUse{true};
+};
+
+namespace
+{
+// Hands the ring of an exiting thread back for reuse
+struct ThreadRing
+{
+    Tracer::Ring* ring = nullptr;
+    const char* name = nullptr;
+
+    ~ThreadRing()
+    {
+        if (ring != nullptr)
+        {
+            ring->inUse.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadRing t_ring;
+
+struct EventCopy
+{
+    int64_t ns;
+    const char* name;
+    uint64_t arg;
+    char phase;
+};
+
+void appendJsonString(std::string& out, const char* str)
+{
+    out += '"';
+    for (const char* c = str; *c != '\0'; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            out += '\\';
+        }
+        out += (static_cast<unsigned char>(*c) < 0x20) ? ' ' : *c;
+    }
+    out += '"';
+}
+}
+
+Tracer& Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Ring* Tracer::threadRing()
+{
+    if (t_ring.ring != nullptr)
+    {
+        return t_ring.ring;
+    }
+
+    Tracer& tracer = instance();
+    std::lock_guard<std::mutex> lock(tracer.mutex_);
+    Ring* ring = nullptr;
+    for (Ring* candidate : tracer.rings_)
+    {
+        if (!candidate->inUse.load(std::memory_order_acquire))
+        {
+            ring = candidate;
+            break;
+        }
+    }
+    if (ring == nullptr)
+    {
+        ring = new Ring();
+        tracer.rings_.push_back(ring);
+    }
+    else
+    {
+        // events of the previous thread are dropped
+        ring->start.store(ring->head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        ring->inUse.store(true, std::memory_order_relaxed);
+    }
+    ring->tid.store(tracer.nextTid_++, std::memory_order_relaxed);
+    ring->threadName.store(t_ring.name, std::memory_order_relaxed);
+    t_ring.ring = ring;
+    return ring;
+}
+
+void Tracer::record(char phase, const char* name, uint64_t arg)
+{
+    Ring* ring = threadRing();
+    const uint64_t index = ring->head.load(std::memory_order_relaxed);
+    ring->claimed.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    TraceEvent& event = ring->events[index % TRACE_RING_EVENTS];
+    event.ns.store(DeviceMetrics::nowNs(), std::memory_order_relaxed);
+    event.name.store(name, std::memory_order_relaxed);
+    event.arg.store(arg, std::memory_order_relaxed);
+    event.phase.store(phase, std::memory_order_relaxed);
+    ring->head.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::setThreadName(const char* name)
+{
+    t_ring.name = name;
+    if (t_ring.ring != nullptr)
+    {
+        t_ring.ring->threadName.store(name, std::memory_order_relaxed);
+    }
+}
+
+void Tracer::setEnabled(bool enabled)
+{
+    if (enabled_.exchange(enabled) != enabled)
+    {
+        SoapySDR_logf(SOAPY_SDR_INFO, "Event tracing %s", enabled ? "enabled" : "disabled");
+    }
+}
+
+/*******************************************************************
+ * Chrome trace export
+ ******************************************************************/
+
+std::string Tracer::render() const
+{
+    std::vector<Ring*> rings;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rings = rings_;
+    }
+
+    const long pid = static_cast<long>(getpid());
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    char line[160];
+    std::vector<EventCopy> events;
+    events.reserve(TRACE_RING_EVENTS);
+
+    for (const Ring* ring : rings)
+    {
+        const uint64_t start = ring->start.load(std::memory_order_relaxed);
+        const uint32_t tid = ring->tid.load(std::memory_order_relaxed);
+        const char* threadName = ring->threadName.load(std::memory_order_relaxed);
+        const uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t low = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+        low = std::max(low, start);
+
+        events.clear();
+        for (uint64_t i = low; i < head; i++)
+        {
+            const TraceEvent& event = ring->events[i % TRACE_RING_EVENTS];
+            EventCopy copy;
+            copy.ns = event.ns.load(std::memory_order_relaxed);
+            copy.name = event.name.load(std::memory_order_relaxed);
+            copy.arg = event.arg.load(std::memory_order_relaxed);
+            copy.phase = event.phase.load(std::memory_order_relaxed);
+            events.push_back(copy);
+        }
+
+        // drop the events the writer may have overwritten while copying
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t claimed = ring->claimed.load(std::memory_order_relaxed);
+        const uint64_t valid = claimed > TRACE_RING_EVENTS ? claimed - TRACE_RING_EVENTS : 0;
+        const size_t skip = valid > low ? static_cast<size_t>(std::min<uint64_t>(valid - low, events.size())) : 0;
+
+        if (threadName != nullptr && skip < events.size())
+        {
+            std::snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%u,\"args\":{\"name\":",
+                          first ? "" : ",", pid, tid);
+            out += line;
+            appendJsonString(out, threadName);
+            out += "}}";
+            first = false;
+        }
+
+        // an end whose begin was overwritten would close an unrelated scope
+        int depth = 0;
+        for (size_t i = skip; i < events.size(); i++)
+        {
+            const EventCopy& event = events[i];
+            if (event.phase == 'E')
+            {
+                if (depth == 0)
+                {
+                    continue;
+                }
+                depth--;
+            }
+            else if (event.phase == 'B')
+            {
+                depth++;
+            }
+
+            out += first ? "{\"name\":" : ",{\"name\":";
+            first = false;
+            appendJsonString(out, event.name);
+            std::snprintf(line, sizeof(line), ",\"ph\":\"%c\",\"ts\":%lld.%03lld,\"pid\":%ld,\"tid\":%u",
+                          event.phase, static_cast<long long>(event.ns / 1000),
+                          static_cast<long long>(event.ns % 1000), pid, tid);
+            out += line;
+            if (event.phase == 'i')
+            {
+                out += ",\"s\":\"t\"";
+            }
+            if (event.arg != 0)
+            {
+                std::snprintf(line, sizeof(line), ",\"args\":{\"arg\":%llu}",
+                              static_cast<unsigned long long>(event.arg));
+                out += line;
+            }
+            out += '}';
+        }
+    }
+
+    out += "]}\n";
+    return out;
+}
+
+bool Tracer::dump(const std::string& path) const
+{
+    const std::string json = render();
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr)
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "Cannot write trace to %s", path.c_str());
+        return false;
+    }
+    const bool ok = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+    if (std::fclose(file) != 0 || !ok)
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "Cannot write trace to %s", path.c_str());
+        return false;
+    }
+    SoapySDR_logf(SOAPY_SDR_INFO, "Trace written to %s", path.c_str());
+    return true;
+}
+
+void Tracer::armOverflowDump(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    overflowPath_ = path;
+    overflowArmed_.store(!path.empty());
+}
+
+std::string Tracer::overflowDumpPath() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return overflowPath_;
+}
+
+void Tracer::overflow()
+{
+    instant("overflow");
+    if (!overflowArmed_.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path.swap(overflowPath_);
+        overflowArmed_.store(false);
+    }
+    if (!path.empty())
+    {
+        dump(path);
+    }
+}
+
+/*******************************************************************
+ * Settings
+ ******************************************************************/
+
+bool Tracer::writeSetting(const std::string& key, const std::string& value)
+{
+    if (key == "trace")
+    {
+        setEnabled(value == "true" || value == "1" || value == "on");
+    }
+    else if (key == "trace_dump")
+    {
+        if (!value.empty())
+        {
+            dump(value);
+        }
+    }
+    else if (key == "trace_overflow_dump")
+    {
+        armOverflowDump(value);
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool Tracer::readSetting(const std::string& key, std::string& value) const
+{
+    if (key == "trace")
+    {
+        value = enabled() ? "true" : "false";
+    }
+    else if (key == "trace_dump")
+    {
+        value.clear();
+    }
+    else if (key == "trace_overflow_dump")
+    {
+        value = overflowDumpPath();
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+std::string Tracer::workerPath(const std::string& path)
+{
+    const size_t slash = path.find_last_of('/');
+    const size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash) || dot == slash + 1)
+    {
+        return path + "-worker";
+    }
+    return path.substr(0, dot) + "-worker" + path.substr(dot);
+}
@@ -0,0 +1,135 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 - Event tracer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Per-process in-memory tracer of the streaming and control paths: the
+// API callbacks, the handoff of buffers to the reader, the reader's waits,
+// sdrplay_api_Update() calls, watchdog checks and IPC commands. Opt-in:
+// enabled by the "trace" setting. Events are dumped as Chrome trace JSON
+// (chrome://tracing, ui.perfetto.dev) by the "trace_dump" setting, or
+// once at the next overflow after "trace_overflow_dump" armed it.
+//
+// Each thread records into its own fixed ring (TRACE_RING_EVENTS, the
+// oldest events are overwritten) with relaxed stores and one release of
+// its head; no locks and, after the first event of a thread, no
+// allocations. A dump copies the rings and drops what a writer may have
+// overwritten meanwhile. Disabled, an event costs one relaxed load.
+//
+// Timestamps are CLOCK_MONOTONIC, so the dumps of a proxy and of its
+// worker line up when loaded together.
+class Tracer
+{
+public:
+    static constexpr size_t TRACE_RING_EVENTS = 8192;  // Per thread
+
+    static Tracer& instance();
+
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled);
+
+    // Instant event of the calling thread (begin/end pairs: TraceScope).
+    // name must outlive the tracer (a literal): only the pointer is kept.
+    static void instant(const char* name, uint64_t arg = 0) { if (enabled()) record('i', name, arg); }
+
+    // Name the calling thread in dumps (a literal, as for events)
+    static void setThreadName(const char* name);
+
+    // The events of all threads as Chrome trace JSON
+    std::string render() const;
+
+    // Write render() to path; false if it cannot be written
+    bool dump(const std::string& path) const;
+
+    // Dump to path once, at the next overflow ("" disarms)
+    void armOverflowDump(const std::string& path);
+    std::string overflowDumpPath() const;
+
+    // Record an overflow seen by a reader and write the armed dump. Call it
+    // without holding stream locks: the dump writes a file.
+    void overflow();
+
+    // The "trace", "trace_dump" and "trace_overflow_dump" settings, shared
+    // by the driver and the proxy; false if key is not one of them
+    bool writeSetting(const std::string& key, const std::string& value);
+    bool readSetting(const std::string& key, std::string& value) const;
+
+    // Where a proxy's worker writes its events for a dump to path:
+    // "-worker" is inserted before the extension
+    static std::string workerPath(const std::string& path);
+
+    struct Ring;  // Trace.cpp
+
+private:
+    friend class TraceScope;
+
+    Tracer() = default;
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    static void record(char phase, const char* name, uint64_t arg);
+    static Ring* threadRing();
+
+    static std::atomic<bool> enabled_;
+
+    mutable std::mutex mutex_;
+    std::vector<Ring*> rings_;  // Never freed: rings of exited threads are reused
+    uint32_t nextTid_ = 1;
+    std::atomic<bool> overflowArmed_{false};
+    std::string overflowPath_;
+};
+
+// Begin and end event around a scope; nothing if tracing is disabled when
+// the scope starts, and always the end if it began
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name, uint64_t arg = 0)
+        : name_(Tracer::enabled() ? name : nullptr)
+    {
+        if (name_ != nullptr)
+        {
+            Tracer::record('B', name_, arg);
+        }
+    }
+
+    ~TraceScope()
+    {
+        if (name_ != nullptr)
+        {
+            Tracer::record('E', name_, 0);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+};
@@ -0,0 +1,68 @@
+/*
+ * SDRplay Broker Daemon - Main Entry Point
+ *
+ * Enumerates the SDRplay devices once, keeps a warm worker per device and
+ * leases the workers to proxy clients over a Unix socket.
+ */
+
+#include "SDRplayBroker.hpp"
+#include "EnumerationCache.hpp"
+#include <SoapySDR/Logger.h>
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static SDRplayBroker* g_broker = nullptr;
+
+static void handleSignal(int)
+{
+    if (g_broker)
+    {
+        g_broker->stop();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string socketPath = BrokerClient::socketPath();
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+        {
+            socketPath = argv[++i];
+        }
+        else
+        {
+            SoapySDR_logf(SOAPY_SDR_ERROR,
+                "Usage: %s [--socket PATH]\n"
+                "Serves SDRplay devices to SoapySDRPlay proxy clients (default socket %s,\n"
+                "or SOAPY_SDRPLAY_BROKER).", argv[0], BrokerClient::DEFAULT_SOCKET_PATH);
+            return 1;
+        }
+    }
+
+    // The broker talks to the devices directly: no proxy, no broker
+    unsetenv("SOAPY_SDRPLAY_MULTIDEV");
+    setenv("SOAPY_SDRPLAY_BROKER", "off", 1);
+
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    SDRplayBroker broker(socketPath);
+    g_broker = &broker;
+
+    // Re-enumerate when a receiver is plugged in or removed
+    HotplugWatcher::instance().start([]() {
+        if (g_broker)
+        {
+            g_broker->rescan();
+        }
+    });
+
+    const int result = broker.run();
+    g_broker = nullptr;
+    return result;
+}
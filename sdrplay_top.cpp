@@ -0,0 +1,594 @@
+/*
+ * sdrplay_top - Live per-device performance monitor
+ *
+ * Reads the metrics pages published by SoapySDRPlay processes and workers
+ * (DeviceMetrics.hpp) and the headers of the proxy shared memory rings
+ * (RingBufferHeader), and shows throughput, queue fill, overflows, gaps,
+ * callback timing and control update latency like top.
+ */
+
+#include "DeviceMetrics.hpp"
+#include "RingBuffer.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void handleSignal(int)
+{
+    g_stop = 1;
+}
+
+// DeviceHealthStatus order (SoapySDRPlay.hpp)
+static const char* healthName(uint32_t status)
+{
+    static const char* names[] = { "healthy", "warning", "stale", "recovering", "unresponsive", "removed", "failed" };
+    return status < sizeof(names) / sizeof(names[0]) ? names[status] : "?";
+}
+
+static const char* ringStateName(uint32_t state)
+{
+    static const char* names[] = { "none", "idle", "streaming", "exiting" };
+    return state <= RINGBUF_STATE_EXITING ? names[state] : "?";
+}
+
+static bool processAlive(pid_t pid)
+{
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+// 2.05M, 512k, 12
+static std::string formatRate(double value)
+{
+    char text[32];
+    if (value >= 1e6)
+    {
+        std::snprintf(text, sizeof(text), "%.2fM", value / 1e6);
+    }
+    else if (value >= 1e3)
+    {
+        std::snprintf(text, sizeof(text), "%.1fk", value / 1e3);
+    }
+    else
+    {
+        std::snprintf(text, sizeof(text), "%.0f", value);
+    }
+    return text;
+}
+
+// Microseconds as us or ms
+static std::string formatUs(double us)
+{
+    char text[32];
+    if (us >= 10000.0)
+    {
+        std::snprintf(text, sizeof(text), "%.0fms", us / 1000.0);
+    }
+    else if (us >= 1000.0)
+    {
+        std::snprintf(text, sizeof(text), "%.1fms", us / 1000.0);
+    }
+    else
+    {
+        std::snprintf(text, sizeof(text), "%.0fus", us);
+    }
+    return text;
+}
+
+/*******************************************************************
+ * Snapshots
+ ******************************************************************/
+
+struct ChannelSnapshot
+{
+    uint64_t callbacks = 0;
+    uint64_t samples = 0;
+    uint64_t delivered = 0;
+    uint64_t gaps = 0;
+    uint64_t overflows = 0;
+    uint64_t histogram[METRICS_HISTOGRAM_BUCKETS] = {};
+};
+
+struct PageSnapshot
+{
+    std::chrono::steady_clock::time_point time;
+    ChannelSnapshot channels[METRICS_MAX_CHANNELS];
+};
+
+struct RingSnapshot
+{
+    std::chrono::steady_clock::time_point time;
+    uint64_t writeIdx = 0;
+    uint64_t overflows = 0;
+};
+
+static void readHistogram(const MetricsHistogram& histogram, uint64_t* counts)
+{
+    for (size_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++)
+    {
+        counts[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+    }
+}
+
+static PageSnapshot snapshot(const DeviceMetricsPage* page)
+{
+    PageSnapshot snap;
+    snap.time = std::chrono::steady_clock::now();
+    for (size_t ch = 0; ch < METRICS_MAX_CHANNELS; ch++)
+    {
+        const ChannelMetrics& channel = page->channels[ch];
+        ChannelSnapshot& out = snap.channels[ch];
+        out.callbacks = channel.callbacks.load(std::memory_order_relaxed);
+        out.samples = channel.samples.load(std::memory_order_relaxed);
+        out.delivered = channel.samplesDelivered.load(std::memory_order_relaxed);
+        out.gaps = channel.gaps.load(std::memory_order_relaxed);
+        out.overflows = channel.overflows.load(std::memory_order_relaxed);
+        readHistogram(channel.intervalHistogram, out.histogram);
+    }
+    return snap;
+}
+
+// Read-only view of a ring's header; the sample data is never mapped
+class RingView
+{
+public:
+    static RingView* open(const std::string& name)
+    {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < HEADER_SIZE)
+        {
+            close(fd);
+            return nullptr;
+        }
+        void* mapping = mmap(nullptr, HEADER_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        const size_t capacity = (static_cast<size_t>(st.st_size) - HEADER_SIZE) / sizeof(std::complex<float>);
+        return new RingView(static_cast<const RingBufferHeader*>(mapping), capacity);
+    }
+
+    ~RingView()
+    {
+        munmap(const_cast<RingBufferHeader*>(header_), HEADER_SIZE);
+    }
+
+    const RingBufferHeader* header() const { return header_; }
+    size_t capacity() const { return capacity_; }
+
+private:
+    RingView(const RingBufferHeader* header, size_t capacity)
+        : header_(header)
+        , capacity_(capacity)
+    {
+    }
+
+    const RingBufferHeader* header_;
+    size_t capacity_;
+};
+
+// Proxy rings are "/sdrplay_<serial>_<pid>[_ch<n>]" (generateShmName())
+static std::vector<std::string> listRings()
+{
+    std::vector<std::string> names;
+#ifdef __linux__
+    DIR* dir = opendir("/dev/shm");
+    if (dir == nullptr)
+    {
+        return names;
+    }
+    while (struct dirent* entry = readdir(dir))
+    {
+        if (std::strncmp(entry->d_name, "sdrplay_", 8) == 0 &&
+            std::strncmp(entry->d_name, "sdrplay_m_", 10) != 0)
+        {
+            names.push_back("/" + std::string(entry->d_name));
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+#endif
+    return names;
+}
+
+static pid_t ringPid(const std::string& name)
+{
+    std::string base = name;
+    size_t sep = base.rfind('_');
+    if (sep != std::string::npos && base.compare(sep + 1, 2, "ch") == 0)
+    {
+        base.erase(sep);
+        sep = base.rfind('_');
+    }
+    return sep == std::string::npos ? -1 : static_cast<pid_t>(std::atoi(base.c_str() + sep + 1));
+}
+
+/*******************************************************************
+ * Display
+ ******************************************************************/
+
+struct Options
+{
+    double delaySeconds = 1.0;
+    long iterations = -1;
+    bool batch = false;
+    bool all = false;       // Include pages of processes that have exited
+    std::string serial;     // Only this device
+};
+
+class Monitor
+{
+public:
+    explicit Monitor(const Options& options)
+        : options_(options)
+    {
+    }
+
+    void refresh(std::string& out);
+
+private:
+    void devices(std::string& out);
+    void updates(std::string& out, const std::vector<std::unique_ptr<DeviceMetrics>>& pages);
+    void rings(std::string& out);
+
+    const Options& options_;
+    std::map<std::string, PageSnapshot> pages_;
+    std::map<std::string, RingSnapshot> rings_;
+};
+
+static void appendf(std::string& out, const char* format, ...)
+{
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    out += line;
+}
+
+void Monitor::refresh(std::string& out)
+{
+    char clock[16];
+    const time_t now = time(nullptr);
+    std::strftime(clock, sizeof(clock), "%H:%M:%S", localtime(&now));
+    appendf(out, "sdrplay_top - %s, refresh %.1fs\n\n", clock, options_.delaySeconds);
+    devices(out);
+    rings(out);
+}
+
+void Monitor::devices(std::string& out)
+{
+    std::vector<std::unique_ptr<DeviceMetrics>> pages;
+    for (const std::string& name : DeviceMetrics::list())
+    {
+        std::unique_ptr<DeviceMetrics> metrics(DeviceMetrics::open(name));
+        if (!metrics)
+        {
+            continue;
+        }
+        if (!options_.serial.empty() && options_.serial != metrics->page()->serial)
+        {
+            continue;
+        }
+        if (!options_.all && !metrics->ownerAlive())
+        {
+            continue;
+        }
+        pages.push_back(std::move(metrics));
+    }
+
+    appendf(out, "%-7s %-6s %-12s %-8s %2s %-10s %8s %8s %8s %5s %6s %7s %6s %7s %7s %7s\n",
+            "PID", "ROLE", "SERIAL", "HW", "CH", "STATE", "RATE", "RX/s", "OUT/s", "%RATE",
+            "QUEUE", "OVF/s", "GAP/s", "JITTER", "INT.p50", "INT.p99");
+
+    std::map<std::string, PageSnapshot> seen;
+    for (const auto& metrics : pages)
+    {
+        const DeviceMetricsPage* page = metrics->page();
+        const PageSnapshot current = snapshot(page);
+        const auto previous = pages_.find(metrics->name());
+        const bool havePrevious = previous != pages_.end();
+        const double seconds = havePrevious
+            ? std::chrono::duration<double>(current.time - previous->second.time).count() : 0.0;
+        seen[metrics->name()] = current;
+
+        const bool driver = page->role == METRICS_ROLE_DRIVER;
+        std::string state = page->streaming.load(std::memory_order_relaxed) ? "streaming" : "idle";
+        if (!metrics->ownerAlive())
+        {
+            state = "exited";
+        }
+        else if (driver && page->healthStatus.load(std::memory_order_relaxed) != 0)
+        {
+            state = healthName(page->healthStatus.load(std::memory_order_relaxed));
+        }
+        const double rate = page->sampleRate.load(std::memory_order_relaxed);
+        const size_t numChannels = std::max<size_t>(1, std::min<size_t>(
+            page->numChannels.load(std::memory_order_relaxed), METRICS_MAX_CHANNELS));
+
+        for (size_t ch = 0; ch < numChannels; ch++)
+        {
+            const ChannelMetrics& channel = page->channels[ch];
+            const ChannelSnapshot& now = current.channels[ch];
+
+            std::string rx = "-", delivered = "-", percent = "-", overflows = "-", gaps = "-";
+            std::string p50 = "-", p99 = "-";
+            if (havePrevious && seconds > 0)
+            {
+                const ChannelSnapshot& before = previous->second.channels[ch];
+                const double rxRate = (now.samples - before.samples) / seconds;
+                const double outRate = (now.delivered - before.delivered) / seconds;
+                if (driver)
+                {
+                    rx = formatRate(rxRate);
+                }
+                delivered = formatRate(outRate);
+                if (rate > 0)
+                {
+                    char text[16];
+                    std::snprintf(text, sizeof(text), "%.0f", 100.0 * (driver ? rxRate : outRate) / rate);
+                    percent = text;
+                }
+                char text[16];
+                std::snprintf(text, sizeof(text), "%.1f", (now.overflows - before.overflows) / seconds);
+                overflows = text;
+                std::snprintf(text, sizeof(text), "%.1f", (now.gaps - before.gaps) / seconds);
+                gaps = text;
+
+                // Interval percentiles over the refresh period
+                uint64_t window[METRICS_HISTOGRAM_BUCKETS];
+                for (size_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++)
+                {
+                    window[i] = now.histogram[i] - before.histogram[i];
+                }
+                if (now.callbacks != before.callbacks)
+                {
+                    p50 = formatUs(static_cast<double>(MetricsHistogram::quantileUs(window, 0.5)));
+                    p99 = formatUs(static_cast<double>(MetricsHistogram::quantileUs(window, 0.99)));
+                }
+            }
+
+            const uint32_t depth = channel.queueDepth.load(std::memory_order_relaxed);
+            const uint32_t capacity = channel.queueCapacity.load(std::memory_order_relaxed);
+            char queue[16] = "-";
+            if (capacity != 0)
+            {
+                std::snprintf(queue, sizeof(queue), "%.0f%%", 100.0 * depth / capacity);
+            }
+
+            appendf(out, "%-7d %-6s %-12.12s %-8.8s %2zu %-10.10s %8s %8s %8s %5s %6s %7s %6s %7s %7s %7s\n",
+                    page->pid, driver ? "driver" : "proxy", page->serial, page->hardwareKey[0] ? page->hardwareKey : "-",
+                    ch, state.c_str(), rate > 0 ? formatRate(rate).c_str() : "-", rx.c_str(), delivered.c_str(),
+                    percent.c_str(), queue, overflows.c_str(), gaps.c_str(),
+                    driver ? formatUs(channel.jitterNs.load(std::memory_order_relaxed) / 1000.0).c_str() : "-",
+                    p50.c_str(), p99.c_str());
+        }
+
+        const uint64_t restarts = page->workerRestarts.load(std::memory_order_relaxed);
+        const uint64_t recoveries = page->recoveryAttempts.load(std::memory_order_relaxed);
+        if (restarts != 0 || recoveries != 0)
+        {
+            appendf(out, "%-7s recovery attempts %llu (%llu successful), worker restarts %llu\n", "",
+                    static_cast<unsigned long long>(recoveries),
+                    static_cast<unsigned long long>(page->successfulRecoveries.load(std::memory_order_relaxed)),
+                    static_cast<unsigned long long>(restarts));
+        }
+    }
+    if (pages.empty())
+    {
+        appendf(out, "(no metrics pages%s)\n",
+#ifdef __linux__
+                ""
+#else
+                ": listing is only supported on Linux"
+#endif
+                );
+    }
+    pages_.swap(seen);
+
+    updates(out, pages);
+}
+
+void Monitor::updates(std::string& out, const std::vector<std::unique_ptr<DeviceMetrics>>& pages)
+{
+    bool header = false;
+    for (const auto& metrics : pages)
+    {
+        const DeviceMetricsPage* page = metrics->page();
+        for (size_t type = 0; type < METRICS_UPDATE_TYPES; type++)
+        {
+            const UpdateMetrics& update = page->updates[type];
+            const uint64_t count = update.count.load(std::memory_order_relaxed);
+            const uint64_t failures = update.failures.load(std::memory_order_relaxed);
+            if (count == 0 && failures == 0)
+            {
+                continue;
+            }
+            if (!header)
+            {
+                appendf(out, "\n%-7s %-12s %-12s %8s %8s %8s %8s %8s %8s\n",
+                        "PID", "SERIAL", "UPDATE", "COUNT", "FAILED", "MEAN", "P50", "P99", "MAX");
+                header = true;
+            }
+            uint64_t counts[METRICS_HISTOGRAM_BUCKETS];
+            readHistogram(update.histogram, counts);
+            const double meanUs = count ? update.totalNs.load(std::memory_order_relaxed) / 1000.0 / count : 0.0;
+            // Percentiles are bucket upper bounds: never above the maximum
+            const double maxUs = update.maxNs.load(std::memory_order_relaxed) / 1000.0;
+            const double p50 = std::min(maxUs, static_cast<double>(MetricsHistogram::quantileUs(counts, 0.5)));
+            const double p99 = std::min(maxUs, static_cast<double>(MetricsHistogram::quantileUs(counts, 0.99)));
+            appendf(out, "%-7d %-12.12s %-12s %8llu %8llu %8s %8s %8s %8s\n",
+                    page->pid, page->serial, metricsUpdateTypeName(type),
+                    static_cast<unsigned long long>(count), static_cast<unsigned long long>(failures),
+                    formatUs(meanUs).c_str(), formatUs(p50).c_str(), formatUs(p99).c_str(), formatUs(maxUs).c_str());
+        }
+    }
+}
+
+void Monitor::rings(std::string& out)
+{
+    bool header = false;
+    std::map<std::string, RingSnapshot> seen;
+    for (const std::string& name : listRings())
+    {
+        if (!options_.serial.empty() && name.find("/sdrplay_" + options_.serial + "_") != 0)
+        {
+            continue;
+        }
+        const pid_t pid = ringPid(name);
+        if (!options_.all && !processAlive(pid))
+        {
+            continue;
+        }
+        std::unique_ptr<RingView> ring(RingView::open(name));
+        if (!ring)
+        {
+            continue;
+        }
+        const RingBufferHeader* h = ring->header();
+
+        RingSnapshot current;
+        current.time = std::chrono::steady_clock::now();
+        current.writeIdx = h->writeIdx.load(std::memory_order_acquire);
+        current.overflows = h->overflowCount.load(std::memory_order_relaxed);
+        seen[name] = current;
+
+        std::string rate = "-", overflows = "-";
+        const auto previous = rings_.find(name);
+        if (previous != rings_.end())
+        {
+            const double seconds = std::chrono::duration<double>(current.time - previous->second.time).count();
+            if (seconds > 0)
+            {
+                rate = formatRate((current.writeIdx - previous->second.writeIdx) / seconds);
+                char text[16];
+                std::snprintf(text, sizeof(text), "%.1f", (current.overflows - previous->second.overflows) / seconds);
+                overflows = text;
+            }
+        }
+
+        const uint64_t readIdx = h->readIdx.load(std::memory_order_relaxed);
+        const uint64_t fill = current.writeIdx > readIdx ? current.writeIdx - readIdx : 0;
+        const int64_t heartbeat = h->heartbeatNs.load(std::memory_order_relaxed);
+        std::string heartbeatAge = "-";
+        if (heartbeat != 0)
+        {
+            heartbeatAge = formatUs((DeviceMetrics::nowNs() - heartbeat) / 1000.0);
+        }
+
+        if (!header)
+        {
+            appendf(out, "\n%-28s %-7s %-10s %8s %8s %6s %6s %6s %8s\n",
+                    "RING", "PID", "WORKER", "RATE", "WRITE/s", "FILL", "OVF/s", "GAPS", "HB.AGE");
+            header = true;
+        }
+        appendf(out, "%-28.28s %-7d %-10s %8s %8s %5.1f%% %6s %6u %8s\n",
+                name.c_str(), static_cast<int>(pid),
+                ringStateName(h->producerState.load(std::memory_order_relaxed)),
+                formatRate(h->sampleRate.load(std::memory_order_relaxed)).c_str(), rate.c_str(),
+                ring->capacity() ? 100.0 * std::min<uint64_t>(fill, ring->capacity()) / ring->capacity() : 0.0,
+                overflows.c_str(), h->gapCount.load(std::memory_order_relaxed), heartbeatAge.c_str());
+    }
+    rings_.swap(seen);
+}
+
+static void usage(const char* argv0)
+{
+    std::fprintf(stderr,
+        "Usage: %s [-d SECONDS] [-n ITERATIONS] [-b] [-a] [-s SERIAL]\n"
+        "Live throughput, queue fill, overflows, gaps, callback timing and control\n"
+        "update latency of the SoapySDRPlay devices open on this host.\n"
+        "  -d SECONDS     refresh interval (default 1)\n"
+        "  -n ITERATIONS  exit after this many refreshes\n"
+        "  -b             batch mode: append refreshes instead of redrawing\n"
+        "  -a             include devices of processes that have exited\n"
+        "  -s SERIAL      only this device\n", argv0);
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:n:bas:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd': options.delaySeconds = std::max(0.1, std::atof(optarg)); break;
+        case 'n': options.iterations = std::atol(optarg); break;
+        case 'b': options.batch = true; break;
+        case 'a': options.all = true; break;
+        case 's': options.serial = optarg; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (!isatty(STDOUT_FILENO))
+    {
+        options.batch = true;
+    }
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    // Rates need two samples: take the first one shortly before the first refresh
+    Monitor monitor(options);
+    {
+        std::string discard;
+        monitor.refresh(discard);
+        std::this_thread::sleep_for(std::chrono::duration<double>(std::min(options.delaySeconds, 0.5)));
+    }
+
+    for (long i = 0; !g_stop && (options.iterations < 0 || i < options.iterations); i++)
+    {
+        std::string out;
+        if (!options.batch)
+        {
+            out += "\033[H\033[2J";  // Home and clear, like top
+        }
+        monitor.refresh(out);
+        if (options.batch)
+        {
+            out += "\n";
+        }
+        std::fwrite(out.data(), 1, out.size(), stdout);
+        std::fflush(stdout);
+
+        if (options.iterations >= 0 && i + 1 >= options.iterations)
+        {
+            break;
+        }
+        const auto until = std::chrono::steady_clock::now() + std::chrono::duration<double>(options.delaySeconds);
+        while (!g_stop && std::chrono::steady_clock::now() < until)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+    return 0;
+}
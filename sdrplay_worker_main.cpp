@@ -8,6 +8,8 @@
 #include "SoapySDRPlayWorker.hpp"
 #include <SoapySDR/Logger.h>
 
+#include <cstdlib>
+
 int main(int argc, char* argv[])
 {
     // Check if we're being run as a worker
@@ -19,5 +21,8 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    // The proxy's process exports this worker's metrics page
+    unsetenv("SOAPY_SDRPLAY_METRICS_EXPORT");
+
     return SoapySDRPlayWorker::runAsWorker(argc, argv);
 }
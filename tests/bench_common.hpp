@@ -0,0 +1,316 @@
+/*
+ * Helpers shared by the benchmarks (-DENABLE_BENCHMARKS=ON)
+ *
+ * Benchmarks print one JSON document on stdout so that runs can be stored
+ * and compared across releases and hosts; progress goes to stderr.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// Number of heap allocations (malloc, calloc, realloc, operator new) made
+// by this process so far; see bench_alloc.cpp
+uint64_t benchAllocations();
+
+inline double benchNowSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// User + system CPU time of the whole process
+inline double benchProcessCpuSeconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    auto seconds = [](const FILETIME &t) {
+        return ((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 1e-7;
+    };
+    return seconds(kernel) + seconds(user);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+#endif
+}
+
+// CPU time of the calling thread
+inline double benchThreadCpuSeconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+    auto seconds = [](const FILETIME &t) {
+        return ((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 1e-7;
+    };
+    return seconds(kernel) + seconds(user);
+#else
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Pin the calling thread to one CPU; false where unsupported
+inline bool benchPinThread(int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu) != 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// Split "a,b,c"
+inline std::vector<std::string> benchSplit(const std::string &list)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// Minimal streaming JSON writer; commas are inserted automatically
+class JsonWriter
+{
+public:
+    explicit JsonWriter(FILE *out = stdout) : out_(out) {}
+
+    void beginObject(const char *key = nullptr) { open(key, '{'); }
+    void endObject() { close('}'); }
+    void beginArray(const char *key = nullptr) { open(key, '['); }
+    void endArray() { close(']'); }
+
+    void value(const char *key, const std::string &v)
+    {
+        prefix(key);
+        std::fputc('"', out_);
+        for (char c : v)
+        {
+            if (c == '"' || c == '\\') std::fprintf(out_, "\\%c", c);
+            else if (static_cast<unsigned char>(c) < 0x20) std::fprintf(out_, "\\u%04x", c);
+            else std::fputc(c, out_);
+        }
+        std::fputc('"', out_);
+    }
+    void value(const char *key, const char *v) { value(key, std::string(v)); }
+    void value(const char *key, double v)
+    {
+        prefix(key);
+        std::fprintf(out_, "%.6g", v);
+    }
+    void value(const char *key, uint64_t v)
+    {
+        prefix(key);
+        std::fprintf(out_, "%llu", static_cast<unsigned long long>(v));
+    }
+    void value(const char *key, int v)
+    {
+        prefix(key);
+        std::fprintf(out_, "%d", v);
+    }
+    void value(const char *key, unsigned int v) { value(key, static_cast<uint64_t>(v)); }
+    void value(const char *key, bool v)
+    {
+        prefix(key);
+        std::fputs(v ? "true" : "false", out_);
+    }
+
+    // Call once the document is complete
+    void finish()
+    {
+        std::fputc('\n', out_);
+        std::fflush(out_);
+    }
+
+private:
+    void prefix(const char *key)
+    {
+        if (!first_.empty())
+        {
+            if (!first_.back()) std::fputc(',', out_);
+            first_.back() = false;
+        }
+        if (key != nullptr)
+        {
+            std::fprintf(out_, "\"%s\":", key);
+        }
+    }
+    void open(const char *key, char c)
+    {
+        prefix(key);
+        std::fputc(c, out_);
+        first_.push_back(true);
+    }
+    void close(char c)
+    {
+        first_.pop_back();
+        std::fputc(c, out_);
+    }
+
+    FILE *out_;
+    std::vector<bool> first_;
+};
+
+// Histogram of durations in ns in the manner of HdrHistogram: each power
+// of two is split into 32 linear buckets, so any recorded value is known
+// to within about 3% and percentiles stay cheap to record and to merge
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() : counts_(SUB + 59 * HALF, 0) {}
+
+    void record(int64_t ns)
+    {
+        const uint64_t v = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+        counts_[indexOf(v)]++;
+        count_++;
+        sum_ += static_cast<double>(v);
+        if (v > max_)
+        {
+            max_ = v;
+        }
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ ? sum_ / count_ : 0.0; }
+
+    // Upper bound of the bucket holding the quantile (0..1), capped at the
+    // largest value recorded
+    uint64_t percentile(double quantile) const
+    {
+        if (count_ == 0)
+        {
+            return 0;
+        }
+        const uint64_t rank = static_cast<uint64_t>(quantile * (count_ - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); i++)
+        {
+            seen += counts_[i];
+            if (seen >= rank)
+            {
+                return std::min(upperOf(i), max_);
+            }
+        }
+        return max_;
+    }
+
+    // p50/p90/p99/p99.9/max in us
+    void write(JsonWriter &json, const char *key) const
+    {
+        json.beginObject(key);
+        json.value("count", count_);
+        json.value("mean_us", mean() / 1e3);
+        json.value("p50_us", percentile(0.5) / 1e3);
+        json.value("p90_us", percentile(0.9) / 1e3);
+        json.value("p99_us", percentile(0.99) / 1e3);
+        json.value("p99_9_us", percentile(0.999) / 1e3);
+        json.value("max_us", max_ / 1e3);
+        json.endObject();
+    }
+
+private:
+    static constexpr int SUB_BITS = 6;
+    static constexpr size_t SUB = static_cast<size_t>(1) << SUB_BITS;
+    static constexpr size_t HALF = SUB / 2;
+
+    static size_t indexOf(uint64_t v)
+    {
+        if (v < SUB)
+        {
+            return static_cast<size_t>(v);
+        }
+        int msb = 0;
+        while ((v >> msb) > 1)
+        {
+            msb++;
+        }
+        const int shift = msb - (SUB_BITS - 1);
+        return SUB + static_cast<size_t>(shift - 1) * HALF + static_cast<size_t>((v >> shift) - HALF);
+    }
+
+    static uint64_t upperOf(size_t index)
+    {
+        if (index < SUB)
+        {
+            return index;
+        }
+        const int shift = static_cast<int>((index - SUB) / HALF) + 1;
+        const uint64_t sub = (index - SUB) % HALF + HALF;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t count_ = 0;
+    uint64_t max_ = 0;
+    double sum_ = 0.0;
+};
+
+// Host description, so that results from different machines can be told
+// apart
+inline void benchWriteHost(JsonWriter &json)
+{
+    json.beginObject("host");
+    std::string cpu;
+#ifdef __linux__
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line))
+    {
+        if (line.compare(0, 10, "model name") == 0 && line.find(':') != std::string::npos)
+        {
+            cpu = line.substr(line.find(':') + 2);
+            break;
+        }
+    }
+#endif
+#ifndef _WIN32
+    char hostname[256] = {};
+    gethostname(hostname, sizeof(hostname) - 1);
+    json.value("hostname", hostname);
+#endif
+    json.value("cpu", cpu);
+    json.value("hardware_threads", std::thread::hardware_concurrency());
+#if defined(__VERSION__)
+    json.value("compiler", __VERSION__);
+#endif
+#ifdef NDEBUG
+    json.value("optimized", true);
+#else
+    json.value("optimized", false);
+#endif
+    json.endObject();
+}
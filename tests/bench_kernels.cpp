@@ -0,0 +1,394 @@
+/*
+ * Microbenchmarks of the inner kernels of the streaming and control paths
+ *
+ * Each kernel runs in isolation, on the same buffers every call, on a
+ * thread pinned to one CPU, after a warmup:
+ *   interleave_cs16, interleave_cf32  rx_callback's I/Q interleave loops
+ *   ring_write, ring_write_cs16       SharedRingBuffer producer side
+ *   ring_read                         SharedRingBuffer consumer side
+ *   cf32_to_cs16                      the proxy's CF32 to CS16 clamp loop
+ *   ipc_serialize, ipc_deserialize    IPCMessage of a typical command
+ *   gain_range                        getGainRange() (LNA table lookup)
+ *   set_gain                          setGain() LNA state/IFGR search
+ *
+ * The ring capacity is not a multiple of the call size, so writes and
+ * reads cross the wrap at a different offset every lap.
+ *
+ * Every kernel is repeated for -R runs of at least -d seconds each. The
+ * result is one JSON document on stdout with, per kernel and size, the
+ * median and best ns per sample (or per call for the control kernels) and
+ * GB/s, counting the bytes read plus the bytes written.
+ */
+#include "SoapySDRPlay.hpp"
+#include "SampleConvert.hpp"
+#include "RingBuffer.hpp"
+#include "IPCPipe.hpp"
+#include "mock_sdrplay_api.hpp"
+#include "bench_common.hpp"
+
+#include <SoapySDR/Logger.h>
+
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include <unistd.h>
+
+struct KernelOptions
+{
+    std::vector<std::string> kernels;       // empty: all
+    std::vector<size_t> sizes = {1008, 65536};
+    double durationSec = 0.2;
+    double warmupSec = 0.2;
+    int repetitions = 5;
+    int cpu = 0;                            // -1: do not pin
+};
+
+// One kernel at one size. run(calls) makes that many calls and returns the
+// ns spent in the measured part
+struct Kernel
+{
+    std::string name;
+    bool perSample;                         // false: items are calls
+    size_t itemsPerCall;
+    double bytesPerCall;                    // read + written
+    std::function<double(uint64_t calls)> run;
+};
+
+// Keeps results observable so that the loops are not optimized away
+static volatile uint64_t g_sink;
+
+static double elapsedNs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Times the whole loop of calls
+static std::function<double(uint64_t)> timedLoop(std::function<void()> call)
+{
+    return [call](uint64_t calls) {
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t c = 0; c < calls; c++)
+        {
+            call();
+        }
+        return elapsedNs(start);
+    };
+}
+
+static std::vector<short> makeComponents(size_t numSamples, int phase)
+{
+    std::vector<short> v(numSamples);
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        v[i] = static_cast<short>(((i * 97 + phase) % 65536) - 32768);
+    }
+    return v;
+}
+
+// Input of the clamp loop: full scale with some samples out of range
+static std::vector<std::complex<float>> makeCF32(size_t numSamples)
+{
+    std::vector<std::complex<float>> v(numSamples);
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        v[i] = std::complex<float>(((i * 37) % 1000) / 450.0f - 1.1f, ((i * 53) % 1000) / 450.0f - 1.1f);
+    }
+    return v;
+}
+
+static std::string ringName(const char *kernel, size_t numSamples)
+{
+    return std::string("/sdrplay_bench_kernels_") + kernel + "_" + std::to_string(numSamples) + "_" +
+           std::to_string(getpid());
+}
+
+// Capacity of the benchmark rings: a few calls, and not a multiple of one
+static size_t ringCapacity(size_t numSamples)
+{
+    return 3 * numSamples + numSamples / 2 + 7;
+}
+
+static void addConversionKernels(std::vector<Kernel> &kernels, size_t n)
+{
+    auto xi = std::make_shared<std::vector<short>>(makeComponents(n, 0));
+    auto xq = std::make_shared<std::vector<short>>(makeComponents(n, 16384));
+    auto outShort = std::make_shared<std::vector<short>>(2 * n);
+    auto outFloat = std::make_shared<std::vector<float>>(2 * n);
+    auto cf32 = std::make_shared<std::vector<std::complex<float>>>(makeCF32(n));
+
+    kernels.push_back({"interleave_cs16", true, n, n * 8.0, timedLoop([=]() {
+        interleaveCS16(xi->data(), xq->data(), outShort->data(), n);
+        g_sink = (*outShort)[n];
+    })});
+    kernels.push_back({"interleave_cf32", true, n, n * 12.0, timedLoop([=]() {
+        interleaveCF32(xi->data(), xq->data(), outFloat->data(), n);
+        g_sink = static_cast<uint64_t>((*outFloat)[n] * 32768.0f);
+    })});
+    kernels.push_back({"cf32_to_cs16", true, n, n * 12.0, timedLoop([=]() {
+        convertCF32ToCS16(cf32->data(), reinterpret_cast<int16_t *>(outShort->data()), n);
+        g_sink = (*outShort)[n];
+    })});
+}
+
+static void addRingKernels(std::vector<Kernel> &kernels, size_t n)
+{
+    // producer and consumer ends of one ring, alive for the whole run
+    struct Ring
+    {
+        std::unique_ptr<SharedRingBuffer> producer;
+        std::unique_ptr<SharedRingBuffer> consumer;
+    };
+    auto open = [n](const char *kernel) {
+        auto ring = std::make_shared<Ring>();
+        const std::string name = ringName(kernel, n);
+        ring->producer.reset(SharedRingBuffer::create(name, ringCapacity(n)));
+        ring->consumer.reset(ring->producer ? SharedRingBuffer::open(name) : nullptr);
+        return ring;
+    };
+    auto cf32 = std::make_shared<std::vector<std::complex<float>>>(makeCF32(n));
+    auto cs16 = std::make_shared<std::vector<short>>(makeComponents(2 * n, 0));
+    auto out = std::make_shared<std::vector<std::complex<float>>>(n);
+
+    // The producer kernels drain with advanceRead(), which copies nothing
+    auto write = open("write");
+    auto writeCS16 = open("write_cs16");
+    auto read = open("read");
+    if (!write->consumer || !writeCS16->consumer || !read->consumer)
+    {
+        std::cerr << "cannot create the benchmark rings" << std::endl;
+        return;
+    }
+    kernels.push_back({"ring_write", true, n, n * 16.0, timedLoop([=]() {
+        g_sink = write->producer->write(cf32->data(), n);
+        write->consumer->advanceRead(n);
+    })});
+    kernels.push_back({"ring_write_cs16", true, n, n * 12.0, timedLoop([=]() {
+        g_sink = writeCS16->producer->writeCS16(cs16->data(), n);
+        writeCS16->consumer->advanceRead(n);
+    })});
+
+    // The consumer kernel refills outside the measured part, so each read
+    // is timed on its own (the clock adds some tens of ns per call)
+    kernels.push_back({"ring_read", true, n, n * 16.0, [=](uint64_t calls) {
+        double ns = 0.0;
+        for (uint64_t c = 0; c < calls; c++)
+        {
+            read->producer->write(cf32->data(), n);
+            const auto start = std::chrono::steady_clock::now();
+            g_sink = read->consumer->read(out->data(), n, 0);
+            ns += elapsedNs(start);
+        }
+        return ns;
+    }});
+}
+
+// A command of the size the proxy sends on every retune
+static IPCMessage typicalMessage()
+{
+    IPCMessage msg(IPCMessageType::CMD_CONFIGURE);
+    msg.setParam("channel", static_cast<int64_t>(0));
+    msg.setParam("frequency", 100.1e6);
+    msg.setParam("sampleRate", 2e6);
+    msg.setParam("bandwidth", 1.536e6);
+    msg.setParam("gain", 40.0);
+    msg.setParam("agc", "false");
+    msg.setParam("antenna", "Antenna A");
+    msg.setParam("serial", "TEST0001");
+    return msg;
+}
+
+static void addIpcKernels(std::vector<Kernel> &kernels)
+{
+    auto msg = std::make_shared<IPCMessage>(typicalMessage());
+    auto data = std::make_shared<std::vector<uint8_t>>(msg->serialize());
+    const double bytes = static_cast<double>(data->size());
+
+    kernels.push_back({"ipc_serialize", false, 1, bytes, timedLoop([=]() {
+        g_sink = msg->serialize().size();
+    })});
+    kernels.push_back({"ipc_deserialize", false, 1, bytes, timedLoop([=]() {
+        g_sink = IPCMessage::deserialize(*data).params.size();
+    })});
+}
+
+static void addGainKernels(std::vector<Kernel> &kernels, std::shared_ptr<SoapySDRPlay> device)
+{
+    kernels.push_back({"gain_range", false, 1, 0.0, [=](uint64_t calls) {
+        device->setFrequency(SOAPY_SDR_RX, 0, 100e6);
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t c = 0; c < calls; c++)
+        {
+            g_sink = static_cast<uint64_t>(device->getGainRange(SOAPY_SDR_RX, 0).maximum());
+        }
+        return elapsedNs(start);
+    }});
+    kernels.push_back({"set_gain", false, 1, 0.0, [=](uint64_t calls) {
+        device->setFrequency(SOAPY_SDR_RX, 0, 100e6);
+        const double maxGain = device->getGainRange(SOAPY_SDR_RX, 0).maximum();
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t c = 0; c < calls; c++)
+        {
+            device->setGain(SOAPY_SDR_RX, 0, static_cast<double>(c % 64) * maxGain / 63.0);
+        }
+        return elapsedNs(start);
+    }});
+}
+
+struct KernelResult
+{
+    std::vector<double> nsPerItem;          // one per repetition
+};
+
+static KernelResult measure(const Kernel &kernel, const KernelOptions &options)
+{
+    // warmup, and find how many calls fill a repetition
+    uint64_t calls = 1;
+    double ns = kernel.run(calls);
+    const double warmupEnd = benchNowSeconds() + options.warmupSec;
+    while (benchNowSeconds() < warmupEnd || ns < 1e6)
+    {
+        calls *= 2;
+        ns = kernel.run(calls);
+    }
+    const uint64_t repetitionCalls = std::max<uint64_t>(1, static_cast<uint64_t>(calls * options.durationSec * 1e9 / ns));
+
+    KernelResult result;
+    for (int r = 0; r < options.repetitions; r++)
+    {
+        result.nsPerItem.push_back(kernel.run(repetitionCalls) / (repetitionCalls * kernel.itemsPerCall));
+    }
+    return result;
+}
+
+static void writeResult(JsonWriter &json, const Kernel &kernel, KernelResult result)
+{
+    std::sort(result.nsPerItem.begin(), result.nsPerItem.end());
+    const double median = result.nsPerItem[result.nsPerItem.size() / 2];
+    const double best = result.nsPerItem.front();
+    const double bytesPerItem = kernel.bytesPerCall / kernel.itemsPerCall;
+
+    json.beginObject();
+    json.value("kernel", kernel.name);
+    if (kernel.perSample)
+    {
+        json.value("samples_per_call", static_cast<uint64_t>(kernel.itemsPerCall));
+    }
+    json.value(kernel.perSample ? "ns_per_sample" : "ns_per_call", median);
+    json.value(kernel.perSample ? "best_ns_per_sample" : "best_ns_per_call", best);
+    if (bytesPerItem > 0.0)
+    {
+        json.value("gb_per_second", bytesPerItem / median);
+        json.value("best_gb_per_second", bytesPerItem / best);
+    }
+    json.value("spread_percent", 100.0 * (result.nsPerItem.back() - best) / best);
+    json.endObject();
+}
+
+static bool selected(const KernelOptions &options, const std::string &name)
+{
+    return options.kernels.empty() ||
+           std::find(options.kernels.begin(), options.kernels.end(), name) != options.kernels.end();
+}
+
+static void usage(const char *argv0)
+{
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -k KERNELS     comma separated (default all)\n"
+        "  -n SAMPLES     samples per call of the sample kernels, comma separated (default 1008,65536)\n"
+        "  -d SECONDS     time per repetition (default 0.2)\n"
+        "  -w SECONDS     warmup per kernel (default 0.2)\n"
+        "  -R N           repetitions (default 5)\n"
+        "  -c CPU         CPU to pin to, -1 not to pin (default 0)\n",
+        argv0);
+}
+
+int main(int argc, char *argv[])
+{
+    KernelOptions options;
+    int opt;
+    while ((opt = getopt(argc, argv, "k:n:d:w:R:c:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'k': options.kernels = benchSplit(optarg); break;
+        case 'n':
+            options.sizes.clear();
+            for (const std::string &size : benchSplit(optarg))
+            {
+                options.sizes.push_back(std::strtoul(size.c_str(), nullptr, 10));
+            }
+            break;
+        case 'd': options.durationSec = std::atof(optarg); break;
+        case 'w': options.warmupSec = std::atof(optarg); break;
+        case 'R': options.repetitions = std::atoi(optarg); break;
+        case 'c': options.cpu = std::atoi(optarg); break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (options.durationSec <= 0.0 || options.repetitions < 1 || options.sizes.empty() ||
+        std::find(options.sizes.begin(), options.sizes.end(), 0u) != options.sizes.end())
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    SoapySDR_setLogLevel(SOAPY_SDR_WARNING);
+    const bool pinned = options.cpu >= 0 && benchPinThread(options.cpu);
+
+    std::vector<Kernel> kernels;
+    for (size_t n : options.sizes)
+    {
+        addConversionKernels(kernels, n);
+        addRingKernels(kernels, n);
+    }
+    addIpcKernels(kernels);
+    std::shared_ptr<SoapySDRPlay> device;
+    if (selected(options, "gain_range") || selected(options, "set_gain"))
+    {
+        SoapySDRPlay::sdrplay_api::get_instance();
+        SoapySDR::Kwargs args;
+        args["serial"] = "TEST0001";
+        device = std::make_shared<SoapySDRPlay>(args);
+        addGainKernels(kernels, device);
+    }
+
+    JsonWriter json;
+    json.beginObject();
+    json.value("benchmark", "kernels");
+    benchWriteHost(json);
+    json.beginObject("config");
+    json.value("duration_seconds", options.durationSec);
+    json.value("warmup_seconds", options.warmupSec);
+    json.value("repetitions", options.repetitions);
+    json.value("cpu", pinned ? options.cpu : -1);
+    json.endObject();
+    json.beginArray("results");
+    for (const Kernel &kernel : kernels)
+    {
+        if (!selected(options, kernel.name))
+        {
+            continue;
+        }
+        std::cerr << kernel.name;
+        if (kernel.perSample)
+        {
+            std::cerr << " " << kernel.itemsPerCall << " samples";
+        }
+        std::cerr << std::endl;
+        writeResult(json, kernel, measure(kernel, options));
+    }
+    json.endArray();
+    json.endObject();
+    json.finish();
+    return 0;
+}
@@ -0,0 +1,342 @@
+/*
+ * Callback-to-application latency benchmark on the streaming mock API
+ *
+ * The mock stamps every callback with the host time just before calling
+ * rx_callback. When the last sample of a callback comes out of the read
+ * path, the time since that stamp is recorded in a histogram. Runs cover:
+ *   - each "bufflen" stream argument (the buffer fill threshold, divided
+ *     by the decimation factor as in the driver)
+ *   - each output sample rate; the rates below 2 MS/s select decimation
+ *   - two read paths: "direct" reads the driver with readStream() (CS16),
+ *     "ring" goes through a SharedRingBuffer as in proxy mode: a thread
+ *     plays the worker (driver readStream() in CF32, then write()), and
+ *     this thread reads the ring with the proxy's polling read()
+ *
+ * The result is one JSON document on stdout with p50/p90/p99/p99.9/max
+ * per run.
+ */
+#include "SoapySDRPlay.hpp"
+#include "RingBuffer.hpp"
+#include "mock_sdrplay_api.hpp"
+#include "bench_common.hpp"
+
+#include <SoapySDR/Logger.h>
+#include <SoapySDR/Time.hpp>
+
+#include <atomic>
+#include <complex>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <getopt.h>
+#include <unistd.h>
+
+struct LatencyOptions
+{
+    std::vector<std::string> paths = {"direct", "ring"};
+    std::vector<double> rates = {2e6, 500e3, 62.5e3};
+    std::vector<unsigned int> bufferLengths = {65536, 16384, 4096, 1024};
+    unsigned int callbackSize = 1008;
+    double durationSec = 2.0;
+};
+
+// Callback stamps, from the generator thread (single producer) to the
+// reading thread (single consumer)
+class StampQueue
+{
+public:
+    struct Stamp
+    {
+        uint64_t endTick;
+        int64_t hostNs;
+    };
+
+    void reset()
+    {
+        head_ = 0;
+        tail_ = 0;
+        lost_ = 0;
+        haveFirst_ = false;
+    }
+
+    // Generator thread; firstSampleNum is extended to 64 bits like the
+    // driver does
+    static void onCallback(void *context, unsigned int firstSampleNum, unsigned int numSamples, int64_t hostNs)
+    {
+        auto *self = static_cast<StampQueue *>(context);
+        if (!self->haveFirst_)
+        {
+            self->tick_ = firstSampleNum;
+            self->haveFirst_ = true;
+        }
+        else
+        {
+            self->tick_ += static_cast<unsigned int>(firstSampleNum - self->lastFirst_);
+        }
+        self->lastFirst_ = firstSampleNum;
+
+        const uint64_t head = self->head_.load(std::memory_order_relaxed);
+        if (head - self->tail_.load(std::memory_order_acquire) >= CAPACITY)
+        {
+            self->lost_++;
+            return;
+        }
+        self->stamps_[head % CAPACITY] = {self->tick_ + numSamples, hostNs};
+        self->head_.store(head + 1, std::memory_order_release);
+    }
+
+    // Reading thread: record every callback whose last sample is before
+    // endTick
+    void consume(uint64_t endTick, int64_t nowNs, LatencyHistogram &histogram)
+    {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        while (tail != head && stamps_[tail % CAPACITY].endTick <= endTick)
+        {
+            histogram.record(nowNs - stamps_[tail % CAPACITY].hostNs);
+            tail++;
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+    uint64_t lost() const { return lost_.load(); }
+
+private:
+    static constexpr size_t CAPACITY = 1 << 16;
+    Stamp stamps_[CAPACITY];
+    std::atomic<uint64_t> head_{0};
+    std::atomic<uint64_t> tail_{0};
+    std::atomic<uint64_t> lost_{0};
+    uint64_t tick_ = 0;
+    unsigned int lastFirst_ = 0;
+    bool haveFirst_ = false;
+};
+
+static int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct RunResult
+{
+    LatencyHistogram latency;
+    uint64_t overflows = 0;
+    uint64_t lostStamps = 0;
+};
+
+static void runDirect(SoapySDRPlay &device, SoapySDR::Stream *stream, double rate, StampQueue &stamps,
+                      const LatencyOptions &options, RunResult &result)
+{
+    const size_t mtu = device.getStreamMTU(stream);
+    std::vector<short> buff(2 * mtu);
+    void *buffs[] = { buff.data() };
+
+    const double warmupEnd = benchNowSeconds() + 0.3;
+    const double end = warmupEnd + options.durationSec;
+    LatencyHistogram warmup;
+    while (benchNowSeconds() < end)
+    {
+        int flags = 0;
+        long long timeNs = 0;
+        const int ret = device.readStream(stream, buffs, mtu, flags, timeNs, 100000);
+        const int64_t now = nowNs();
+        if (ret > 0)
+        {
+            // the tick of the first sample, from its hardware time
+            const uint64_t endTick = SoapySDR::timeNsToTicks(timeNs, rate) + static_cast<uint64_t>(ret);
+            stamps.consume(endTick, now, benchNowSeconds() < warmupEnd ? warmup : result.latency);
+        }
+        else if (ret == SOAPY_SDR_OVERFLOW)
+        {
+            result.overflows++;
+        }
+    }
+}
+
+static void runRing(SoapySDRPlay &device, SoapySDR::Stream *stream, double rate, StampQueue &stamps,
+                    const LatencyOptions &options, RunResult &result)
+{
+    const std::string name = "/sdrplay_bench_latency_" + std::to_string(getpid());
+    std::unique_ptr<SharedRingBuffer> producer(SharedRingBuffer::create(name, 4 * 1024 * 1024));
+    std::unique_ptr<SharedRingBuffer> consumer(producer ? SharedRingBuffer::open(name) : nullptr);
+    if (!consumer)
+    {
+        std::cerr << "cannot create ring " << name << std::endl;
+        return;
+    }
+
+    // the worker's streaming loop
+    std::atomic<bool> running{true};
+    std::atomic<int64_t> startTick{-1};
+    std::thread worker([&]() {
+        std::vector<std::complex<float>> buff(65536);
+        void *buffs[] = { buff.data() };
+        while (running)
+        {
+            int flags = 0;
+            long long timeNs = 0;
+            const int ret = device.readStream(stream, buffs, buff.size(), flags, timeNs, 100000);
+            if (ret > 0)
+            {
+                if (startTick.load() < 0)
+                {
+                    startTick = SoapySDR::timeNsToTicks(timeNs, rate);
+                }
+                producer->write(buff.data(), static_cast<size_t>(ret));
+            }
+        }
+    });
+
+    // the proxy's readStream(); the ring carries no time, so the tick is
+    // counted from that of the first sample the worker wrote
+    std::vector<std::complex<float>> buff(65536);
+    uint64_t readCount = 0;
+    const double warmupEnd = benchNowSeconds() + 0.3;
+    const double end = warmupEnd + options.durationSec;
+    LatencyHistogram warmup;
+    while (benchNowSeconds() < end)
+    {
+        const size_t count = consumer->read(buff.data(), buff.size(), 100000);
+        const int64_t now = nowNs();
+        if (count == 0)
+        {
+            continue;
+        }
+        readCount += count;
+        stamps.consume(static_cast<uint64_t>(startTick.load()) + readCount, now,
+                       benchNowSeconds() < warmupEnd ? warmup : result.latency);
+    }
+    result.overflows = producer->overflowCount();
+
+    running = false;
+    worker.join();
+}
+
+static void runOne(JsonWriter &json, const std::string &path, double rate, unsigned int bufferLength,
+                   const LatencyOptions &options)
+{
+    std::cerr << path << " " << rate << " S/s, bufflen " << bufferLength << std::endl;
+
+    static StampQueue stamps;
+    stamps.reset();
+    MockStreamConfig config;
+    config.enabled = true;
+    config.samplesPerCallback = options.callbackSize;
+    config.onCallback = &StampQueue::onCallback;
+    config.onCallbackContext = &stamps;
+    mock_sdrplay_set_stream_config(config);
+
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+    SoapySDRPlay device(args);
+    device.setSampleRate(SOAPY_SDR_RX, 0, rate);
+
+    RunResult result;
+    SoapySDR::Kwargs streamArgs;
+    streamArgs["bufflen"] = std::to_string(bufferLength);
+    SoapySDR::Stream *stream = device.setupStream(SOAPY_SDR_RX, path == "ring" ? "CF32" : "CS16",
+                                                  std::vector<size_t>(), streamArgs);
+    if (device.activateStream(stream) == 0)
+    {
+        if (path == "ring")
+        {
+            runRing(device, stream, rate, stamps, options, result);
+        }
+        else
+        {
+            runDirect(device, stream, rate, stamps, options, result);
+        }
+    }
+    const MockStreamStats stats = mock_sdrplay_stream_stats("TEST0001");
+    device.closeStream(stream);
+    result.lostStamps = stamps.lost();
+
+    json.beginObject();
+    json.value("path", path);
+    json.value("sample_rate", rate);
+    json.value("bufflen", bufferLength);
+    json.value("decimation", stats.decimationFactor);
+    json.value("buffer_threshold_samples", bufferLength / std::max(1u, stats.decimationFactor));
+    json.value("overflows", result.overflows);
+    json.value("lost_stamps", result.lostStamps);
+    result.latency.write(json, "latency");
+    json.endObject();
+}
+
+static void usage(const char *argv0)
+{
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -p PATHS       direct,ring (default both)\n"
+        "  -r RATES       output sample rates in S/s, comma separated (default 2e6,500e3,62.5e3)\n"
+        "  -l LENGTHS     bufflen values, comma separated (default 65536,16384,4096,1024)\n"
+        "  -c SAMPLES     samples per callback (default 1008)\n"
+        "  -d SECONDS     measurement time per run (default 2)\n",
+        argv0);
+}
+
+int main(int argc, char *argv[])
+{
+    LatencyOptions options;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:r:l:c:d:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p': options.paths = benchSplit(optarg); break;
+        case 'r':
+            options.rates.clear();
+            for (const std::string &rate : benchSplit(optarg))
+            {
+                options.rates.push_back(std::atof(rate.c_str()));
+            }
+            break;
+        case 'l':
+            options.bufferLengths.clear();
+            for (const std::string &length : benchSplit(optarg))
+            {
+                options.bufferLengths.push_back(static_cast<unsigned int>(std::strtoul(length.c_str(), nullptr, 10)));
+            }
+            break;
+        case 'c': options.callbackSize = static_cast<unsigned int>(std::strtoul(optarg, nullptr, 10)); break;
+        case 'd': options.durationSec = std::atof(optarg); break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    SoapySDR_setLogLevel(SOAPY_SDR_WARNING);
+    SoapySDRPlay::sdrplay_api::get_instance();
+
+    JsonWriter json;
+    json.beginObject();
+    json.value("benchmark", "latency");
+    benchWriteHost(json);
+    json.beginObject("config");
+    json.value("callback_samples", options.callbackSize);
+    json.value("duration_seconds", options.durationSec);
+    json.value("num_buffers", static_cast<unsigned int>(DEFAULT_NUM_BUFFERS));
+    json.endObject();
+    json.beginArray("results");
+    for (const std::string &path : options.paths)
+    {
+        for (double rate : options.rates)
+        {
+            for (unsigned int bufferLength : options.bufferLengths)
+            {
+                runOne(json, path, rate, bufferLength, options);
+            }
+        }
+    }
+    json.endArray();
+    json.endObject();
+    json.finish();
+
+    mock_sdrplay_set_stream_config(MockStreamConfig());
+    return 0;
+}
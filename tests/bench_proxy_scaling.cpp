@@ -0,0 +1,389 @@
+/*
+ * Proxy mode scaling benchmark with mock devices
+ *
+ * For each device count N, this process opens N SoapySDRPlayProxy devices
+ * (TEST0001, TEST0002, ...). Each proxy spawns a real worker process:
+ * sdrplay_mock_worker is sdrplay_worker built against the streaming mock
+ * API, configured through SOAPY_SDRPLAY_MOCK_STREAM and
+ * SOAPY_SDRPLAY_MOCK_DEVICES. Every worker pushes the configured rate
+ * through its SharedRingBuffer, and one reader thread per device in this
+ * process reads it with readStream().
+ *
+ * The devices are opened in parallel, as an application would open a rack
+ * of receivers. The startup time of a device runs from its proxy's
+ * construction to its first samples; N is started when all of them are.
+ *
+ * The result is one JSON document on stdout. For each N it gives:
+ *   startup_seconds           until the last device delivered samples
+ *   aggregate_msps            samples/s read over all devices
+ *   consumer_cpu_percent      CPU of this process (all reader threads)
+ *   devices                   per device: rate read, startup, overflows
+ *                             reported by readStream(), samples dropped by
+ *                             the worker on a full ring, worker CPU
+ */
+#include "SoapySDRPlayProxy.hpp"
+#include "DeviceMetrics.hpp"
+#include "mock_sdrplay_api.hpp"
+#include "bench_common.hpp"
+
+#include <SoapySDR/Formats.hpp>
+#include <SoapySDR/Logger.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <getopt.h>
+#include <unistd.h>
+
+struct ScalingOptions
+{
+    std::vector<unsigned int> deviceCounts = {1, 2, 4, 8, 16};
+    double rate = 2e6;
+    unsigned int callbackSize = 1008;
+    std::string format = SOAPY_SDR_CF32;
+    double durationSec = 3.0;
+    std::string workerPath;
+};
+
+struct DeviceResult
+{
+    std::string serial;
+    double startupSec = -1.0;
+    uint64_t delivered = 0;
+    uint64_t overflows = 0;
+    uint64_t droppedSamples = 0;
+    pid_t workerPid = -1;
+    double workerCpuSec = 0.0;
+    bool ok = false;
+};
+
+// User + system CPU time of another process (Linux); negative if unknown
+static double processCpuSeconds(pid_t pid)
+{
+#ifdef __linux__
+    std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+    std::string line;
+    if (!std::getline(stat, line) || line.rfind(')') == std::string::npos)
+    {
+        return -1.0;
+    }
+    // the fields after the command name start with the state (field 3);
+    // utime and stime are fields 14 and 15
+    std::istringstream fields(line.substr(line.rfind(')') + 2));
+    std::string field;
+    unsigned long long utime = 0, stime = 0;
+    for (int i = 3; i <= 15 && fields >> field; i++)
+    {
+        if (i == 14) utime = std::strtoull(field.c_str(), nullptr, 10);
+        if (i == 15) stime = std::strtoull(field.c_str(), nullptr, 10);
+    }
+    return static_cast<double>(utime + stime) / sysconf(_SC_CLK_TCK);
+#else
+    (void)pid;
+    return -1.0;
+#endif
+}
+
+// The worker of a device, from the driver metrics page it publishes
+static pid_t findWorkerPid(const std::string &serial)
+{
+    for (const std::string &name : DeviceMetrics::list())
+    {
+        std::unique_ptr<DeviceMetrics> metrics(DeviceMetrics::open(name));
+        if (metrics && metrics->page()->role == METRICS_ROLE_DRIVER && metrics->page()->pid != getpid() &&
+            serial == metrics->page()->serial && metrics->ownerAlive())
+        {
+            return metrics->page()->pid;
+        }
+    }
+    return -1;
+}
+
+static std::string mockSerial(unsigned int index)
+{
+    char serial[16];
+    std::snprintf(serial, sizeof(serial), "TEST%04u", index + 1);
+    return serial;
+}
+
+// Start line shared by the reader threads: the measurement starts once
+// every device is streaming (or has failed to)
+class StartLine
+{
+public:
+    explicit StartLine(size_t count) : remaining_(count) {}
+
+    void arrive()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (--remaining_ == 0)
+        {
+            cond_.notify_all();
+        }
+        cond_.wait(lock, [this]() { return remaining_ == 0 && start_ > 0.0; });
+    }
+
+    // Main thread: wait for all devices, then start the measurement
+    double waitAndStart(double durationSec)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]() { return remaining_ == 0; });
+        start_ = benchNowSeconds();
+        end_ = start_ + durationSec;
+        cond_.notify_all();
+        return start_;
+    }
+
+    double end() const { return end_; }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    size_t remaining_;
+    double start_ = 0.0;
+    double end_ = 0.0;
+};
+
+static void runDevice(unsigned int index, double openedAt, StartLine &startLine, const ScalingOptions &options,
+                      DeviceResult &result)
+{
+    result.serial = mockSerial(index);
+    std::unique_ptr<SoapySDRPlayProxy> proxy;
+    SoapySDR::Stream *stream = nullptr;
+    std::vector<char> buff;
+    size_t mtu = 0;
+    try
+    {
+        SoapySDR::Kwargs args;
+        args["serial"] = result.serial;
+        proxy.reset(new SoapySDRPlayProxy(args));
+        stream = proxy->setupStream(SOAPY_SDR_RX, options.format);
+        mtu = proxy->getStreamMTU(stream);
+        buff.resize(mtu * SoapySDR::formatToSize(options.format));
+        if (proxy->activateStream(stream) == 0)
+        {
+            const double deadline = benchNowSeconds() + 30.0;
+            while (!result.ok && benchNowSeconds() < deadline)
+            {
+                void *buffs[] = { buff.data() };
+                int flags = 0;
+                long long timeNs = 0;
+                result.ok = proxy->readStream(stream, buffs, mtu, flags, timeNs, 100000) > 0;
+            }
+        }
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << result.serial << ": " << ex.what() << std::endl;
+    }
+    if (result.ok)
+    {
+        result.startupSec = benchNowSeconds() - openedAt;
+        result.workerPid = findWorkerPid(result.serial);
+    }
+    startLine.arrive();
+
+    if (result.ok)
+    {
+        // discard what queued up while the other devices were starting
+        void *drain[] = { buff.data() };
+        int drainFlags = 0;
+        long long drainTimeNs = 0;
+        while (proxy->readStream(stream, drain, mtu, drainFlags, drainTimeNs, 0) > 0)
+        {
+        }
+
+        const double cpuBefore = result.workerPid > 0 ? processCpuSeconds(result.workerPid) : -1.0;
+        const uint64_t droppedBefore = std::strtoull(proxy->readSetting("dropped_samples").c_str(), nullptr, 10);
+        while (benchNowSeconds() < startLine.end())
+        {
+            void *buffs[] = { buff.data() };
+            int flags = 0;
+            long long timeNs = 0;
+            const int ret = proxy->readStream(stream, buffs, mtu, flags, timeNs, 100000);
+            if (ret > 0)
+            {
+                result.delivered += static_cast<uint64_t>(ret);
+            }
+            else if (ret == SOAPY_SDR_OVERFLOW)
+            {
+                result.overflows++;
+            }
+        }
+        const double cpuAfter = result.workerPid > 0 ? processCpuSeconds(result.workerPid) : -1.0;
+        result.workerCpuSec = cpuBefore >= 0.0 && cpuAfter >= 0.0 ? cpuAfter - cpuBefore : -1.0;
+        result.droppedSamples = std::strtoull(proxy->readSetting("dropped_samples").c_str(), nullptr, 10) - droppedBefore;
+    }
+
+    if (stream != nullptr)
+    {
+        proxy->deactivateStream(stream);
+        proxy->closeStream(stream);
+    }
+}
+
+static void runCount(JsonWriter &json, unsigned int count, const ScalingOptions &options)
+{
+    std::cerr << count << " devices" << std::endl;
+
+    StartLine startLine(count);
+    std::vector<DeviceResult> results(count);
+    std::vector<std::thread> threads;
+    const double openedAt = benchNowSeconds();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        threads.emplace_back(runDevice, i, openedAt, std::ref(startLine), std::cref(options), std::ref(results[i]));
+    }
+    const double start = startLine.waitAndStart(options.durationSec);
+    const double cpuBefore = benchProcessCpuSeconds();
+    std::this_thread::sleep_for(std::chrono::duration<double>(startLine.end() - benchNowSeconds()));
+    const double cpu = benchProcessCpuSeconds() - cpuBefore;
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    uint64_t delivered = 0;
+    uint64_t overflows = 0;
+    uint64_t dropped = 0;
+    unsigned int streaming = 0;
+    for (const DeviceResult &result : results)
+    {
+        delivered += result.delivered;
+        overflows += result.overflows;
+        dropped += result.droppedSamples;
+        streaming += result.ok ? 1 : 0;
+    }
+    const double aggregateMsps = delivered / options.durationSec / 1e6;
+
+    json.beginObject();
+    json.value("devices_requested", count);
+    json.value("devices_streaming", streaming);
+    json.value("startup_seconds", streaming == count ? start - openedAt : -1.0);
+    json.value("aggregate_msps", aggregateMsps);
+    json.value("target_msps", count * options.rate / 1e6);
+    json.value("sustained", streaming == count && overflows == 0 && dropped == 0 &&
+                            aggregateMsps >= 0.98 * count * options.rate / 1e6);
+    json.value("consumer_cpu_percent", 100.0 * cpu / options.durationSec);
+    json.beginArray("devices");
+    for (const DeviceResult &result : results)
+    {
+        json.beginObject();
+        json.value("serial", result.serial);
+        json.value("streaming", result.ok);
+        json.value("startup_seconds", result.startupSec);
+        json.value("msps", result.delivered / options.durationSec / 1e6);
+        json.value("overflows", result.overflows);
+        json.value("dropped_samples", result.droppedSamples);
+        json.value("worker_pid", static_cast<int>(result.workerPid));
+        json.value("worker_cpu_percent", result.workerCpuSec >= 0.0 ? 100.0 * result.workerCpuSec / options.durationSec : -1.0);
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+}
+
+static void usage(const char *argv0)
+{
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -n COUNTS      device counts, comma separated (default 1,2,4,8,16; at most %u)\n"
+        "  -r RATE        samples/s per device (default 2e6)\n"
+        "  -s SAMPLES     samples per mock callback (default 1008)\n"
+        "  -f FORMAT      CF32 or CS16 (default CF32)\n"
+        "  -d SECONDS     measurement time per count (default 3)\n"
+        "  -w PATH        worker executable (default sdrplay_mock_worker next to this one)\n",
+        argv0, MOCK_MAX_DEVICES);
+}
+
+int main(int argc, char *argv[])
+{
+    ScalingOptions options;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:s:f:d:w:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            options.deviceCounts.clear();
+            for (const std::string &count : benchSplit(optarg))
+            {
+                options.deviceCounts.push_back(static_cast<unsigned int>(std::strtoul(count.c_str(), nullptr, 10)));
+            }
+            break;
+        case 'r': options.rate = std::atof(optarg); break;
+        case 's': options.callbackSize = static_cast<unsigned int>(std::strtoul(optarg, nullptr, 10)); break;
+        case 'f': options.format = optarg; break;
+        case 'd': options.durationSec = std::atof(optarg); break;
+        case 'w': options.workerPath = optarg; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    unsigned int maxCount = 0;
+    for (unsigned int count : options.deviceCounts)
+    {
+        maxCount = std::max(maxCount, count);
+        if (count == 0 || count > MOCK_MAX_DEVICES)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.rate <= 0.0 || options.durationSec <= 0.0 || maxCount == 0 ||
+        (options.format != SOAPY_SDR_CF32 && options.format != SOAPY_SDR_CS16))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    if (options.workerPath.empty())
+    {
+        const std::string self(argv[0]);
+        const size_t slash = self.rfind('/');
+        options.workerPath = (slash == std::string::npos ? std::string(".") : self.substr(0, slash)) + "/sdrplay_mock_worker";
+    }
+    if (access(options.workerPath.c_str(), X_OK) != 0)
+    {
+        std::cerr << "worker executable not found: " << options.workerPath << std::endl;
+        return 1;
+    }
+
+    // inherited by the workers
+    const std::string mockStream = "rate=" + std::to_string(options.rate) + ",size=" + std::to_string(options.callbackSize);
+    setenv("SOAPY_SDRPLAY_WORKER", options.workerPath.c_str(), 1);
+    setenv("SOAPY_SDRPLAY_MOCK_STREAM", mockStream.c_str(), 1);
+    setenv("SOAPY_SDRPLAY_MOCK_DEVICES", std::to_string(maxCount).c_str(), 1);
+    setenv("SOAPY_SDR_LOG_LEVEL", "WARNING", 0);
+    SoapySDR_setLogLevel(SOAPY_SDR_WARNING);
+
+    JsonWriter json;
+    json.beginObject();
+    json.value("benchmark", "proxy_scaling");
+    benchWriteHost(json);
+    json.beginObject("config");
+    json.value("rate_per_device", options.rate);
+    json.value("callback_samples", options.callbackSize);
+    json.value("format", options.format);
+    json.value("duration_seconds", options.durationSec);
+    json.value("ring_samples", static_cast<uint64_t>(DEFAULT_RINGBUF_SAMPLES));
+    json.endObject();
+    json.beginArray("results");
+    for (unsigned int count : options.deviceCounts)
+    {
+        runCount(json, count, options);
+    }
+    json.endArray();
+    json.endObject();
+    json.finish();
+    return 0;
+}
@@ -0,0 +1,521 @@
+/*
+ * Fault recovery benchmark on the streaming mock API
+ *
+ * Each scenario streams from TEST0001 with the in-process driver, injects
+ * one fault through the mock and measures:
+ *   - detect_ms: from the fault until the driver reports it (health
+ *     callback, readStream() error or failed call), -1 if it never does
+ *   - recover_ms: from the detection (or the fault, if undetected) until
+ *     samples arrive again, by the application's own recovery where the
+ *     driver has none
+ *
+ * Scenarios:
+ *   callback_stall     callbacks stop until the next Init(); the watchdog
+ *                      flags the stream Stale and the application closes and
+ *                      reopens the stream
+ *   callback_pause     callbacks stop for a while; recovered when the
+ *                      watchdog reports Healthy again
+ *   device_removed     DeviceRemoved; the application reopens the device
+ *   update_error       sdrplay_api_Update() fails a few times; the
+ *                      application retries setFrequency()
+ *   get_devices_hang   sdrplay_api_GetDevices() blocks while the device is
+ *                      opened
+ *   init_hang          sdrplay_api_Init() blocks past the driver's timeout
+ *   uninit_hang        sdrplay_api_Uninit() blocks past the driver's timeout
+ *
+ * The result is one JSON document on stdout.
+ */
+#include "SoapySDRPlay.hpp"
+#include "DeviceMetrics.hpp"
+#include "mock_sdrplay_api.hpp"
+#include "bench_common.hpp"
+
+#include <SoapySDR/Logger.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <getopt.h>
+
+static const char *SERIAL = "TEST0001";
+
+struct RecoveryOptions
+{
+    std::vector<std::string> scenarios = {"callback_stall", "callback_pause", "device_removed", "update_error",
+                                          "get_devices_hang", "init_hang", "uninit_hang"};
+    unsigned int repeat = 1;
+    int callbackTimeoutMs = 2000;
+    int healthCheckIntervalMs = 500;
+    unsigned int pauseMs = 3000;
+    unsigned int hangMs = SDRPLAY_API_TIMEOUT_MS + 1000;
+    unsigned int getDevicesDelayMs = 2000;
+    unsigned int updateErrors = 3;
+    double giveUpSec = 30.0;                // Per phase of a scenario
+};
+
+struct ScenarioResult
+{
+    bool detected = false;
+    double detectMs = -1.0;
+    bool recovered = false;
+    double recoverMs = -1.0;
+};
+
+// Health transitions reported by the driver, from its watchdog thread
+class HealthLog
+{
+public:
+    void attach(SoapySDRPlay &device)
+    {
+        device.registerHealthCallback([this](DeviceHealthStatus status) {
+            const double now = benchNowSeconds();
+            if (status == DeviceHealthStatus::Stale)
+            {
+                double expected = 0.0;
+                staleAt_.compare_exchange_strong(expected, now);
+            }
+            else if (status == DeviceHealthStatus::Healthy && staleAt_.load() != 0.0)
+            {
+                double expected = 0.0;
+                healthyAt_.compare_exchange_strong(expected, now);
+            }
+        });
+    }
+
+    double staleAt() const { return staleAt_.load(); }
+    double healthyAt() const { return healthyAt_.load(); }
+
+private:
+    std::atomic<double> staleAt_{0.0};
+    std::atomic<double> healthyAt_{0.0};
+};
+
+class Session
+{
+public:
+    explicit Session(const RecoveryOptions &options) : options_(options)
+    {
+        open();
+    }
+
+    ~Session()
+    {
+        close();
+    }
+
+    void open()
+    {
+        SoapySDR::Kwargs args;
+        args["serial"] = SERIAL;
+        device_.reset(new SoapySDRPlay(args));
+        device_->setSampleRate(SOAPY_SDR_RX, 0, 2e6);
+
+        WatchdogConfig config = device_->getWatchdogConfig();
+        config.callbackTimeoutMs = options_.callbackTimeoutMs;
+        config.healthCheckIntervalMs = options_.healthCheckIntervalMs;
+        config.restartServiceOnFailure = false;
+        device_->setWatchdogConfig(config);
+        health_.reset(new HealthLog());
+        health_->attach(*device_);
+    }
+
+    void close()
+    {
+        closeStream();
+        device_.reset();
+    }
+
+    bool startStream()
+    {
+        stream_ = device_->setupStream(SOAPY_SDR_RX, "CS16", std::vector<size_t>(), SoapySDR::Kwargs());
+        buff_.resize(2 * device_->getStreamMTU(stream_));
+        return device_->activateStream(stream_) == 0;
+    }
+
+    void closeStream()
+    {
+        if (stream_ != nullptr)
+        {
+            device_->closeStream(stream_);
+            stream_ = nullptr;
+        }
+    }
+
+    // One readStream() with a short timeout: samples, 0 or an error
+    int read()
+    {
+        void *buffs[] = { buff_.data() };
+        int flags = 0;
+        long long timeNs = 0;
+        const int ret = device_->readStream(stream_, buffs, buff_.size() / 2, flags, timeNs, 50000);
+        return ret == SOAPY_SDR_TIMEOUT || ret == SOAPY_SDR_OVERFLOW ? 0 : ret;
+    }
+
+    // Time of the first samples read, 0 on error or after giveUpSec
+    double waitForSamples()
+    {
+        const double end = benchNowSeconds() + options_.giveUpSec;
+        while (benchNowSeconds() < end)
+        {
+            const int ret = read();
+            if (ret > 0)
+            {
+                return benchNowSeconds();
+            }
+            if (ret < 0)
+            {
+                return 0.0;
+            }
+        }
+        return 0.0;
+    }
+
+    // Read through the startup transient
+    bool settle()
+    {
+        if (waitForSamples() == 0.0)
+        {
+            return false;
+        }
+        const double end = benchNowSeconds() + 0.3;
+        while (benchNowSeconds() < end)
+        {
+            read();
+        }
+        return true;
+    }
+
+    // Keep reading, as an application would, until pred() or giveUpSec
+    template <typename Pred>
+    double readUntil(Pred pred)
+    {
+        const double end = benchNowSeconds() + options_.giveUpSec;
+        while (benchNowSeconds() < end)
+        {
+            read();
+            if (pred())
+            {
+                return benchNowSeconds();
+            }
+        }
+        return 0.0;
+    }
+
+    SoapySDRPlay &device() { return *device_; }
+    HealthLog &health() { return *health_; }
+
+private:
+    const RecoveryOptions &options_;
+    std::unique_ptr<SoapySDRPlay> device_;
+    std::unique_ptr<HealthLog> health_;
+    SoapySDR::Stream *stream_ = nullptr;
+    std::vector<short> buff_;
+};
+
+static void setDetected(ScenarioResult &result, double faultAt, double detectedAt)
+{
+    if (detectedAt != 0.0)
+    {
+        result.detected = true;
+        result.detectMs = (detectedAt - faultAt) * 1e3;
+    }
+}
+
+static void setRecovered(ScenarioResult &result, double from, double recoveredAt)
+{
+    if (recoveredAt != 0.0)
+    {
+        result.recovered = true;
+        result.recoverMs = (recoveredAt - from) * 1e3;
+    }
+}
+
+static void runCallbackStall(Session &session, ScenarioResult &result)
+{
+    const double faultAt = benchNowSeconds();
+    mock_sdrplay_stall_callbacks(SERIAL, 0);
+    setDetected(result, faultAt, session.readUntil([&session]() { return session.health().staleAt() != 0.0; }));
+    if (!result.detected)
+    {
+        return;
+    }
+
+    // the driver only flags the stream; reopening it is up to the application
+    const double detectedAt = session.health().staleAt();
+    session.closeStream();
+    if (session.startStream())
+    {
+        setRecovered(result, detectedAt, session.waitForSamples());
+    }
+}
+
+static void runCallbackPause(Session &session, const RecoveryOptions &options, ScenarioResult &result)
+{
+    const double faultAt = benchNowSeconds();
+    mock_sdrplay_stall_callbacks(SERIAL, options.pauseMs);
+    setDetected(result, faultAt, session.readUntil([&session]() { return session.health().staleAt() != 0.0; }));
+    if (result.detected)
+    {
+        session.readUntil([&session]() { return session.health().healthyAt() != 0.0; });
+        setRecovered(result, session.health().staleAt(), session.health().healthyAt());
+    }
+}
+
+static void runDeviceRemoved(Session &session, ScenarioResult &result)
+{
+    const double faultAt = benchNowSeconds();
+    mock_sdrplay_remove_device(SERIAL);
+    setDetected(result, faultAt, session.readUntil([&session]() { return session.read() < 0; }));
+    if (!result.detected)
+    {
+        return;
+    }
+
+    const double detectedAt = faultAt + result.detectMs * 1e-3;
+    session.close();
+    session.open();
+    if (session.startStream())
+    {
+        setRecovered(result, detectedAt, session.waitForSamples());
+    }
+}
+
+// The driver's own metrics page, which counts failed updates
+static const UpdateMetrics *frequencyUpdates()
+{
+    const UpdateMetrics *updates = nullptr;
+    DeviceMetrics::forEach([&updates](const DeviceMetrics &metrics) {
+        if (std::string(metrics.page()->serial) == SERIAL && metrics.page()->role == METRICS_ROLE_DRIVER)
+        {
+            updates = &metrics.page()->updates[METRICS_UPDATE_FREQUENCY];
+        }
+    });
+    return updates;
+}
+
+static void runUpdateError(Session &session, const RecoveryOptions &options, ScenarioResult &result)
+{
+    const UpdateMetrics *updates = frequencyUpdates();
+    if (updates == nullptr)
+    {
+        return;
+    }
+    const uint64_t failures = updates->failures.load();
+    const uint64_t successes = updates->count.load();
+
+    MockFaults faults = mock_sdrplay_faults();
+    faults.updateErrors = options.updateErrors;
+    mock_sdrplay_set_faults(faults);
+
+    // retune until an update goes through, to a new frequency each time
+    // since the driver skips the update when the frequency is unchanged
+    const double faultAt = benchNowSeconds();
+    double frequency = session.device().getFrequency(SOAPY_SDR_RX, 0);
+    double detectedAt = 0.0;
+    double recoveredAt = 0.0;
+    const double end = faultAt + options.giveUpSec;
+    while (recoveredAt == 0.0 && benchNowSeconds() < end)
+    {
+        frequency += 1e6;
+        session.device().setFrequency(SOAPY_SDR_RX, 0, frequency);
+        const double now = benchNowSeconds();
+        if (detectedAt == 0.0 && updates->failures.load() != failures)
+        {
+            detectedAt = now;
+        }
+        if (updates->count.load() != successes)
+        {
+            recoveredAt = now;
+        }
+        session.read();
+    }
+    setDetected(result, faultAt, detectedAt);
+    setRecovered(result, detectedAt != 0.0 ? detectedAt : faultAt, recoveredAt);
+}
+
+static void runGetDevicesHang(Session &session, const RecoveryOptions &options, ScenarioResult &result)
+{
+    MockFaults faults = mock_sdrplay_faults();
+    faults.getDevicesDelayMs = options.getDevicesDelayMs;
+    mock_sdrplay_set_faults(faults);
+
+    // the device constructor has no timeout on this call: the open blocks
+    const double faultAt = benchNowSeconds();
+    session.close();
+    session.open();
+    if (session.startStream())
+    {
+        setRecovered(result, faultAt, session.waitForSamples());
+    }
+}
+
+static void runInitHang(Session &session, const RecoveryOptions &options, ScenarioResult &result)
+{
+    session.closeStream();
+    MockFaults faults = mock_sdrplay_faults();
+    faults.initDelayMs = options.hangMs;
+    mock_sdrplay_set_faults(faults);
+
+    const double faultAt = benchNowSeconds();
+    const bool started = session.startStream();
+    const double detectedAt = benchNowSeconds();
+    mock_sdrplay_set_faults(MockFaults());
+    if (!started)
+    {
+        setDetected(result, faultAt, detectedAt);
+        session.closeStream();
+        if (session.startStream())
+        {
+            setRecovered(result, detectedAt, session.waitForSamples());
+        }
+    }
+
+    // the abandoned Init() still completes later and restarts the callbacks;
+    // let it before the device is closed
+    const double hangEnd = faultAt + options.hangMs * 1e-3 + 0.2;
+    while (benchNowSeconds() < hangEnd)
+    {
+        session.read();
+    }
+}
+
+static void runUninitHang(Session &session, const RecoveryOptions &options, ScenarioResult &result)
+{
+    MockFaults faults = mock_sdrplay_faults();
+    faults.uninitDelayMs = options.hangMs;
+    mock_sdrplay_set_faults(faults);
+
+    const double faultAt = benchNowSeconds();
+    session.closeStream();
+    const double detectedAt = benchNowSeconds();
+    mock_sdrplay_set_faults(MockFaults());
+    if (detectedAt - faultAt >= SDRPLAY_API_TIMEOUT_MS * 1e-3)
+    {
+        setDetected(result, faultAt, detectedAt);
+    }
+    if (session.startStream())
+    {
+        setRecovered(result, detectedAt, session.waitForSamples());
+    }
+
+    // the abandoned Uninit() returns later without stopping the new stream
+    const double hangEnd = faultAt + options.hangMs * 1e-3 + 0.2;
+    while (benchNowSeconds() < hangEnd)
+    {
+        session.read();
+    }
+}
+
+static void runOne(JsonWriter &json, const std::string &scenario, unsigned int run, const RecoveryOptions &options)
+{
+    std::cerr << scenario << " (run " << run + 1 << ")" << std::endl;
+    mock_sdrplay_set_faults(MockFaults());
+
+    MockStreamConfig config;
+    config.enabled = true;
+    mock_sdrplay_set_stream_config(config);
+
+    ScenarioResult result;
+    const double start = benchNowSeconds();
+    {
+        Session session(options);
+        if (session.startStream() && session.settle())
+        {
+            if (scenario == "callback_stall") runCallbackStall(session, result);
+            else if (scenario == "callback_pause") runCallbackPause(session, options, result);
+            else if (scenario == "device_removed") runDeviceRemoved(session, result);
+            else if (scenario == "update_error") runUpdateError(session, options, result);
+            else if (scenario == "get_devices_hang") runGetDevicesHang(session, options, result);
+            else if (scenario == "init_hang") runInitHang(session, options, result);
+            else if (scenario == "uninit_hang") runUninitHang(session, options, result);
+            else std::cerr << "unknown scenario " << scenario << std::endl;
+        }
+        mock_sdrplay_set_faults(MockFaults());
+    }
+
+    json.beginObject();
+    json.value("scenario", scenario);
+    json.value("run", run);
+    json.value("detected", result.detected);
+    json.value("detect_ms", result.detectMs);
+    json.value("recovered", result.recovered);
+    json.value("recover_ms", result.recoverMs);
+    json.value("scenario_seconds", benchNowSeconds() - start);
+    json.endObject();
+}
+
+static void usage(const char *argv0)
+{
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -s SCENARIOS   comma separated (default callback_stall,callback_pause,device_removed,\n"
+        "                 update_error,get_devices_hang,init_hang,uninit_hang)\n"
+        "  -r COUNT       runs per scenario (default 1)\n"
+        "  -t MS          watchdog callback timeout (default 2000)\n"
+        "  -i MS          watchdog check interval (default 500)\n"
+        "  -p MS          callback_pause length (default 3000)\n"
+        "  -H MS          init_hang/uninit_hang length (default %u)\n"
+        "  -g MS          get_devices_hang length (default 2000)\n"
+        "  -u COUNT       update_error failures (default 3)\n",
+        argv0, SDRPLAY_API_TIMEOUT_MS + 1000);
+}
+
+int main(int argc, char *argv[])
+{
+    RecoveryOptions options;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:r:t:i:p:H:g:u:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 's': options.scenarios = benchSplit(optarg); break;
+        case 'r': options.repeat = static_cast<unsigned int>(std::strtoul(optarg, nullptr, 10)); break;
+        case 't': options.callbackTimeoutMs = std::atoi(optarg); break;
+        case 'i': options.healthCheckIntervalMs = std::atoi(optarg); break;
+        case 'p': options.pauseMs = static_cast<unsigned int>(std::strtoul(optarg, nullptr, 10)); break;
+        case 'H': options.hangMs = static_cast<unsigned int>(std::strtoul(optarg, nullptr, 10)); break;
+        case 'g': options.getDevicesDelayMs = static_cast<unsigned int>(std::strtoul(optarg, nullptr, 10)); break;
+        case 'u': options.updateErrors = static_cast<unsigned int>(std::strtoul(optarg, nullptr, 10)); break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    // every scenario makes the driver log warnings and errors
+    SoapySDR_setLogLevel(SOAPY_SDR_CRITICAL);
+    SoapySDRPlay::sdrplay_api::get_instance();
+
+    JsonWriter json;
+    json.beginObject();
+    json.value("benchmark", "recovery");
+    benchWriteHost(json);
+    json.beginObject("config");
+    json.value("callback_timeout_ms", options.callbackTimeoutMs);
+    json.value("health_check_interval_ms", options.healthCheckIntervalMs);
+    json.value("api_timeout_ms", static_cast<unsigned int>(SDRPLAY_API_TIMEOUT_MS));
+    json.value("pause_ms", options.pauseMs);
+    json.value("hang_ms", options.hangMs);
+    json.value("get_devices_delay_ms", options.getDevicesDelayMs);
+    json.value("update_errors", options.updateErrors);
+    json.endObject();
+    json.beginArray("results");
+    for (const std::string &scenario : options.scenarios)
+    {
+        for (unsigned int run = 0; run < options.repeat; run++)
+        {
+            runOne(json, scenario, run, options);
+        }
+    }
+    json.endArray();
+    json.endObject();
+    json.finish();
+
+    mock_sdrplay_set_stream_config(MockStreamConfig());
+    return 0;
+}
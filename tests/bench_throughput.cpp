@@ -0,0 +1,279 @@
+/*
+ * End-to-end throughput benchmark on the streaming mock API
+ *
+ * The mock's generator thread calls rx_callback at a synthetic rate and
+ * callback size while this thread reads the stream with readStream() (or
+ * acquireReadBuffer()/releaseReadBuffer() with -a direct). For each format
+ * and callback size the rate is doubled until the stream stops keeping up,
+ * then refined by bisection. A rate is sustained if the reader saw no
+ * overflow and no gap and received at least 98% of the generated samples.
+ *
+ * The result is one JSON document on stdout:
+ *   max_sustained_msps      highest sustained rate
+ *   cpu_percent_per_msps    process CPU (driver, reader and the mock's
+ *                           generator) per MS/s at that rate
+ *   allocations_per_second  heap allocations at that rate
+ */
+#include "SoapySDRPlay.hpp"
+#include "mock_sdrplay_api.hpp"
+#include "bench_common.hpp"
+
+#include <SoapySDR/Logger.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <getopt.h>
+
+struct ThroughputOptions
+{
+    std::vector<std::string> formats = {"CS16", "CF32"};
+    std::vector<unsigned int> callbackSizes = {252, 1008, 4032};
+    double durationSec = 1.0;
+    double startMsps = 1.0;
+    double maxMsps = 1024.0;
+    int refineSteps = 3;
+    bool direct = false;
+};
+
+struct StepResult
+{
+    double targetMsps = 0.0;
+    double achievedMsps = 0.0;
+    double cpuPercent = 0.0;
+    double allocationsPerSec = 0.0;
+    uint64_t overflows = 0;
+    uint64_t gaps = 0;
+    bool sustained = false;
+};
+
+// Stream at one rate: warm up, then measure for durationSec
+static StepResult runStep(SoapySDRPlay &device, const std::string &format, unsigned int callbackSize,
+                          double msps, const ThroughputOptions &options)
+{
+    MockStreamConfig config;
+    config.enabled = true;
+    config.sampleRate = msps * 1e6;
+    config.samplesPerCallback = callbackSize;
+    mock_sdrplay_set_stream_config(config);
+
+    SoapySDR::Stream *stream = device.setupStream(SOAPY_SDR_RX, format);
+    const size_t mtu = device.getStreamMTU(stream);
+    std::vector<float> buff(2 * mtu);
+    void *buffs[] = { buff.data() };
+
+    StepResult result;
+    result.targetMsps = msps;
+    if (device.activateStream(stream) != 0)
+    {
+        device.closeStream(stream);
+        return result;
+    }
+
+    uint64_t delivered = 0;
+    auto read = [&]() {
+        int flags = 0;
+        long long timeNs = 0;
+        int ret;
+        if (options.direct)
+        {
+            size_t handle = 0;
+            const void *direct[1] = { nullptr };
+            ret = device.acquireReadBuffer(stream, handle, direct, flags, timeNs, 100000);
+            if (ret > 0)
+            {
+                device.releaseReadBuffer(stream, handle);
+            }
+        }
+        else
+        {
+            ret = device.readStream(stream, buffs, mtu, flags, timeNs, 100000);
+        }
+        if (ret > 0)
+        {
+            delivered += static_cast<uint64_t>(ret);
+        }
+        else if (ret == SOAPY_SDR_OVERFLOW)
+        {
+            result.overflows++;
+        }
+    };
+
+    // fill the pipeline and let the rate settle
+    const double warmupEnd = benchNowSeconds() + 0.2;
+    while (benchNowSeconds() < warmupEnd)
+    {
+        read();
+    }
+
+    result.overflows = 0;
+    delivered = 0;
+    const MockStreamStats statsBefore = mock_sdrplay_stream_stats("TEST0001");
+    const double cpuBefore = benchProcessCpuSeconds();
+    const uint64_t allocationsBefore = benchAllocations();
+    const double start = benchNowSeconds();
+    double now = start;
+    while (now < start + options.durationSec)
+    {
+        read();
+        now = benchNowSeconds();
+    }
+    const double elapsed = now - start;
+    const uint64_t allocations = benchAllocations() - allocationsBefore;
+    const double cpu = benchProcessCpuSeconds() - cpuBefore;
+    const MockStreamStats statsAfter = mock_sdrplay_stream_stats("TEST0001");
+
+    device.closeStream(stream);
+
+    const uint64_t generated = statsAfter.samples - statsBefore.samples;
+    result.gaps = statsAfter.gaps - statsBefore.gaps;
+    result.achievedMsps = delivered / elapsed / 1e6;
+    result.cpuPercent = 100.0 * cpu / elapsed;
+    result.allocationsPerSec = allocations / elapsed;
+    result.sustained = result.overflows == 0 && result.gaps == 0 &&
+                       generated >= 0.98 * msps * 1e6 * elapsed &&
+                       delivered >= 0.98 * generated;
+    return result;
+}
+
+static void writeStep(JsonWriter &json, const StepResult &step)
+{
+    json.beginObject();
+    json.value("target_msps", step.targetMsps);
+    json.value("achieved_msps", step.achievedMsps);
+    json.value("cpu_percent", step.cpuPercent);
+    json.value("allocations_per_second", step.allocationsPerSec);
+    json.value("overflows", step.overflows);
+    json.value("gaps", step.gaps);
+    json.value("sustained", step.sustained);
+    json.endObject();
+}
+
+static void runFormat(JsonWriter &json, const std::string &format, unsigned int callbackSize,
+                      const ThroughputOptions &options)
+{
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+    SoapySDRPlay device(args);
+
+    std::vector<StepResult> steps;
+    const StepResult *best = nullptr;
+    double pass = 0.0;
+    double fail = 0.0;
+    for (double msps = options.startMsps; msps <= options.maxMsps; msps *= 2)
+    {
+        std::cerr << format << " " << callbackSize << " samples/callback: " << msps << " MS/s" << std::endl;
+        steps.push_back(runStep(device, format, callbackSize, msps, options));
+        if (!steps.back().sustained)
+        {
+            fail = msps;
+            break;
+        }
+        pass = msps;
+    }
+    for (int i = 0; i < options.refineSteps && fail > 0.0 && pass > 0.0; i++)
+    {
+        const double msps = (pass + fail) / 2;
+        std::cerr << format << " " << callbackSize << " samples/callback: " << msps << " MS/s" << std::endl;
+        steps.push_back(runStep(device, format, callbackSize, msps, options));
+        (steps.back().sustained ? pass : fail) = msps;
+    }
+    for (const StepResult &step : steps)
+    {
+        if (step.sustained && step.targetMsps == pass)
+        {
+            best = &step;
+        }
+    }
+
+    json.beginObject();
+    json.value("format", format);
+    json.value("callback_samples", callbackSize);
+    json.value("max_sustained_msps", best ? best->achievedMsps : 0.0);
+    json.value("limited_by_max_rate", fail == 0.0 && best != nullptr);
+    json.value("cpu_percent_per_msps", best && best->achievedMsps > 0 ? best->cpuPercent / best->achievedMsps : 0.0);
+    json.value("allocations_per_second", best ? best->allocationsPerSec : 0.0);
+    json.beginArray("steps");
+    for (const StepResult &step : steps)
+    {
+        writeStep(json, step);
+    }
+    json.endArray();
+    json.endObject();
+}
+
+static void usage(const char *argv0)
+{
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -f FORMATS     comma separated (default CS16,CF32)\n"
+        "  -s SIZES       samples per callback, comma separated (default 252,1008,4032)\n"
+        "  -d SECONDS     measurement time per rate (default 1)\n"
+        "  -r MSPS        first rate (default 1)\n"
+        "  -m MSPS        highest rate tried (default 1024)\n"
+        "  -b N           bisection steps after the first failure (default 3)\n"
+        "  -a read|direct read with readStream() or acquireReadBuffer() (default read)\n",
+        argv0);
+}
+
+int main(int argc, char *argv[])
+{
+    ThroughputOptions options;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:s:d:r:m:b:a:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f': options.formats = benchSplit(optarg); break;
+        case 's':
+            options.callbackSizes.clear();
+            for (const std::string &size : benchSplit(optarg))
+            {
+                options.callbackSizes.push_back(static_cast<unsigned int>(std::strtoul(size.c_str(), nullptr, 10)));
+            }
+            break;
+        case 'd': options.durationSec = std::atof(optarg); break;
+        case 'r': options.startMsps = std::atof(optarg); break;
+        case 'm': options.maxMsps = std::atof(optarg); break;
+        case 'b': options.refineSteps = std::atoi(optarg); break;
+        case 'a': options.direct = std::string(optarg) == "direct"; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (options.durationSec <= 0.0 || options.startMsps <= 0.0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    SoapySDR_setLogLevel(SOAPY_SDR_WARNING);
+    SoapySDRPlay::sdrplay_api::get_instance();
+
+    JsonWriter json;
+    json.beginObject();
+    json.value("benchmark", "throughput");
+    benchWriteHost(json);
+    json.beginObject("config");
+    json.value("api", options.direct ? "direct" : "read");
+    json.value("duration_seconds", options.durationSec);
+    json.value("buffer_samples", static_cast<unsigned int>(DEFAULT_BUFFER_LENGTH));
+    json.value("num_buffers", static_cast<unsigned int>(DEFAULT_NUM_BUFFERS));
+    json.endObject();
+    json.beginArray("results");
+    for (const std::string &format : options.formats)
+    {
+        for (unsigned int size : options.callbackSizes)
+        {
+            runFormat(json, format, size, options);
+        }
+    }
+    json.endArray();
+    json.endObject();
+    json.finish();
+
+    mock_sdrplay_set_stream_config(MockStreamConfig());
+    return 0;
+}
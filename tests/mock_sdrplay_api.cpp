@@ -1,7 +1,18 @@
 #include <sdrplay_api.h>
 
+#include "mock_sdrplay_api.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace {
 
@@ -16,12 +27,88 @@ struct MockDeviceState
     bool initialized = false;
 };
 
+// Streaming state of one device, apart from MockDeviceState because that
+// is reset with memset
+struct MockGenerator
+{
+    std::thread thread;
+    std::atomic<bool> running{false};     // Until Uninit()
+    std::atomic<bool> streaming{false};   // Until Uninit() or DeviceRemoved
+    sdrplay_api_CallbackFnsT callbacks{};
+    void *context = nullptr;
+    sdrplay_api_TunerSelectT tuner = sdrplay_api_Tuner_A;
+    MockStreamConfig config;
+    std::atomic<double> sampleRate{0.0};
+
+    // Callback number at which to raise the flag, 0 if none is pending
+    std::atomic<uint64_t> grAt{0};
+    std::atomic<uint64_t> rfAt{0};
+    std::atomic<uint64_t> fsAt{0};
+    std::atomic<unsigned int> pendingGap{0};
+    std::atomic<bool> removeRequested{false};
+    std::atomic<int64_t> stallUntilNs{0};     // steady_clock; INT64_MAX until the next Init()
+    std::atomic<bool> stalled{false};
+    std::atomic<uint64_t> inits{0};           // Init() calls, so that a late Uninit() is ignored
+
+    std::atomic<uint64_t> issued{0};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> gaps{0};
+    std::atomic<uint64_t> gapSamples{0};
+    std::atomic<uint64_t> events{0};
+    std::atomic<uint64_t> stalls{0};
+
+    void stop()
+    {
+        running = false;
+        if (thread.joinable())
+        {
+            if (thread.get_id() == std::this_thread::get_id())
+            {
+                thread.detach();
+            }
+            else
+            {
+                thread.join();
+            }
+        }
+        streaming = false;
+    }
+
+    ~MockGenerator() { stop(); }
+};
+
+// Power of two, so that the tone table can be indexed by the sample number
+constexpr unsigned int TONE_PERIOD = 64;
+
 std::once_flag g_init_flag;
-MockDeviceState g_devices[2];
+MockDeviceState g_devices[MOCK_MAX_DEVICES];
+MockGenerator g_generators[MOCK_MAX_DEVICES];
+unsigned int g_num_devices = 2;
 sdrplay_api_ErrorInfoT g_last_error{};
-sdrplay_api_CallbackFnsT g_callbacks{};
-void *g_cb_context = nullptr;
 std::mutex g_mutex;
+MockStreamConfig g_stream_config;
+MockFaults g_faults;
+std::mutex g_config_mutex;
+
+int64_t steady_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Block for a fault delay (outside any mock lock)
+void fault_delay(unsigned int MockFaults::*delay)
+{
+    unsigned int ms;
+    {
+        std::lock_guard<std::mutex> lock(g_config_mutex);
+        ms = g_faults.*delay;
+    }
+    if (ms != 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+}
 
 void init_channel_defaults(sdrplay_api_RxChannelParamsT &channel)
 {
@@ -62,22 +149,132 @@ void init_device(MockDeviceState &state, const char *serial)
     init_channel_defaults(state.rxB);
 }
 
+// Call fn(key, value) for each key=value pair of a comma separated list
+template <typename Fn>
+void for_each_key_value(const std::string &spec, Fn fn)
+{
+    size_t pos = 0;
+    while (pos < spec.size())
+    {
+        size_t end = spec.find(',', pos);
+        if (end == std::string::npos)
+        {
+            end = spec.size();
+        }
+        const std::string item = spec.substr(pos, end - pos);
+        pos = end + 1;
+        const size_t eq = item.find('=');
+        if (eq == std::string::npos)
+        {
+            continue;
+        }
+        fn(item.substr(0, eq), item.c_str() + eq + 1);
+    }
+}
+
+// SOAPY_SDRPLAY_MOCK_STREAM: "1", or key=value pairs separated by commas
+void load_stream_config_from_env()
+{
+    const char *env = std::getenv("SOAPY_SDRPLAY_MOCK_STREAM");
+    if (env == nullptr || *env == '\0' || std::strcmp(env, "0") == 0 || std::strcmp(env, "off") == 0)
+    {
+        return;
+    }
+
+    MockStreamConfig config;
+    config.enabled = true;
+    for_each_key_value(env, [&config](const std::string &key, const char *value) {
+        if (key == "rate") config.sampleRate = std::atof(value);
+        else if (key == "size") config.samplesPerCallback = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+        else if (key == "paced") config.paced = std::atoi(value) != 0;
+        else if (key == "first") config.firstSampleNum = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+        else if (key == "gap_every") config.gapEvery = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+        else if (key == "gap") config.gapSamples = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+        else if (key == "update_delay") config.updateDelayCallbacks = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+        else if (key == "dual") config.dualTuner = std::atoi(value) != 0;
+        else if (key == "remove_after") config.removeAfterCallbacks = std::strtoull(value, nullptr, 10);
+        else if (key == "stall_after") config.stallAfterCallbacks = std::strtoull(value, nullptr, 10);
+        else if (key == "stall_ms") config.stallMs = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+    });
+
+    std::lock_guard<std::mutex> lock(g_config_mutex);
+    g_stream_config = config;
+}
+
+// SOAPY_SDRPLAY_MOCK_RSPDUO: serials separated by commas
+void load_rspduo_from_env()
+{
+    const char *env = std::getenv("SOAPY_SDRPLAY_MOCK_RSPDUO");
+    if (env == nullptr)
+    {
+        return;
+    }
+
+    const std::string serials = std::string(",") + env + ",";
+    for (MockDeviceState &state : g_devices)
+    {
+        if (serials.find(std::string(",") + state.device.SerNo + ",") != std::string::npos)
+        {
+            state.device.hwVer = SDRPLAY_RSPduo_ID;
+            state.device.tuner = sdrplay_api_Tuner_Both;
+            state.device.rspDuoMode = static_cast<sdrplay_api_RspDuoModeT>(
+                sdrplay_api_RspDuoMode_Single_Tuner | sdrplay_api_RspDuoMode_Dual_Tuner | sdrplay_api_RspDuoMode_Master);
+        }
+    }
+}
+
+// SOAPY_SDRPLAY_MOCK_FAULTS: key=value pairs separated by commas
+void load_faults_from_env()
+{
+    const char *env = std::getenv("SOAPY_SDRPLAY_MOCK_FAULTS");
+    if (env == nullptr || *env == '\0')
+    {
+        return;
+    }
+
+    MockFaults faults;
+    for_each_key_value(env, [&faults](const std::string &key, const char *value) {
+        const unsigned int n = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+        if (key == "init_delay") faults.initDelayMs = n;
+        else if (key == "uninit_delay") faults.uninitDelayMs = n;
+        else if (key == "get_devices_delay") faults.getDevicesDelayMs = n;
+        else if (key == "update_errors") faults.updateErrors = n;
+    });
+
+    std::lock_guard<std::mutex> lock(g_config_mutex);
+    g_faults = faults;
+}
+
 void init_mock_devices()
 {
     std::call_once(g_init_flag, []() {
-        init_device(g_devices[0], "TEST0001");
-        init_device(g_devices[1], "TEST0002");
+        for (unsigned int i = 0; i < MOCK_MAX_DEVICES; i++)
+        {
+            char serial[16];
+            std::snprintf(serial, sizeof(serial), "TEST%04u", i + 1);
+            init_device(g_devices[i], serial);
+        }
+        // SOAPY_SDRPLAY_MOCK_DEVICES: number of devices enumerated
+        const char *env = std::getenv("SOAPY_SDRPLAY_MOCK_DEVICES");
+        if (env != nullptr && *env != '\0')
+        {
+            const unsigned long count = std::strtoul(env, nullptr, 10);
+            g_num_devices = static_cast<unsigned int>(std::max(1ul, std::min<unsigned long>(MOCK_MAX_DEVICES, count)));
+        }
         std::memset(&g_last_error, 0, sizeof(g_last_error));
+        load_rspduo_from_env();
+        load_stream_config_from_env();
+        load_faults_from_env();
     });
 }
 
 MockDeviceState *find_device_by_serial(const char *serial)
 {
-    for (auto &state : g_devices)
+    for (unsigned int i = 0; i < g_num_devices; i++)
     {
-        if (std::strncmp(state.device.SerNo, serial, sizeof(state.device.SerNo)) == 0)
+        if (std::strncmp(g_devices[i].device.SerNo, serial, sizeof(g_devices[i].device.SerNo)) == 0)
         {
-            return &state;
+            return &g_devices[i];
         }
     }
     return nullptr;
@@ -95,8 +292,312 @@ MockDeviceState *find_device_by_handle(HANDLE dev)
     return nullptr;
 }
 
+MockGenerator *find_generator(const MockDeviceState *state)
+{
+    return &g_generators[state - g_devices];
+}
+
+MockGenerator *find_generator_by_serial(const char *serial)
+{
+    init_mock_devices();
+    MockDeviceState *state = find_device_by_serial(serial);
+    return state != nullptr ? find_generator(state) : nullptr;
+}
+
+// Output rate of the device as configured by the driver (called from the
+// driver's thread, which writes the parameters)
+double device_sample_rate(const MockDeviceState &state)
+{
+    const sdrplay_api_RxChannelParamsT &channel = state.device.tuner == sdrplay_api_Tuner_B ? state.rxB : state.rxA;
+    double fsHz = state.devParams.fsFreq.fsHz;
+    // low IF modes: the API downconverts to 2 MS/s
+    if ((fsHz == 6.0e6 && channel.tunerParams.ifType == sdrplay_api_IF_1_620) ||
+        (fsHz == 8.0e6 && channel.tunerParams.ifType == sdrplay_api_IF_2_048))
+    {
+        fsHz = 2.0e6;
+    }
+    if (channel.ctrlParams.decimation.enable && channel.ctrlParams.decimation.decimationFactor > 1)
+    {
+        fsHz /= channel.ctrlParams.decimation.decimationFactor;
+    }
+    return fsHz;
+}
+
+// Raise the flag at a later callback; an earlier pending one is kept
+void schedule_flag(MockGenerator &gen, std::atomic<uint64_t> &flagAt, unsigned int delay)
+{
+    uint64_t expected = 0;
+    flagAt.compare_exchange_strong(expected, gen.issued.load() + delay);
+}
+
+int take_flag(std::atomic<uint64_t> &flagAt, uint64_t callback)
+{
+    uint64_t at = flagAt.load();
+    return (at != 0 && callback >= at && flagAt.compare_exchange_strong(at, 0)) ? 1 : 0;
+}
+
+void request_stall(MockGenerator &gen, unsigned int ms)
+{
+    gen.stallUntilNs = ms == 0 ? INT64_MAX : steady_ns() + static_cast<int64_t>(ms) * 1000000;
+}
+
+// counted before the callback: the driver may act on it (and a test
+// read the count) before EventCbFn returns
+void send_event(MockGenerator &gen, sdrplay_api_EventT eventId)
+{
+    gen.events++;
+    if (gen.callbacks.EventCbFn != nullptr)
+    {
+        sdrplay_api_EventParamsT params{};
+        gen.callbacks.EventCbFn(eventId, gen.tuner, &params, gen.context);
+    }
+}
+
+void generator_loop(MockGenerator *gen)
+{
+    const MockStreamConfig config = gen->config;
+    const unsigned int size = config.samplesPerCallback > 0 ? config.samplesPerCallback : 1;
+
+    // a tone at 1/TONE_PERIOD of the rate; each callback points into the
+    // table at its phase, so nothing is computed per sample
+    std::vector<short> toneI(size + TONE_PERIOD);
+    std::vector<short> toneQ(size + TONE_PERIOD);
+    for (size_t k = 0; k < toneI.size(); k++)
+    {
+        const double phase = 2.0 * M_PI * static_cast<double>(k % TONE_PERIOD) / TONE_PERIOD;
+        toneI[k] = static_cast<short>(std::lrint(8192.0 * std::cos(phase)));
+        toneQ[k] = static_cast<short>(std::lrint(8192.0 * std::sin(phase)));
+    }
+
+    unsigned int sampleNum = config.firstSampleNum;
+    unsigned int reset = 1;
+    bool stallScripted = false;
+    auto deadline = std::chrono::steady_clock::now();
+    while (gen->running.load())
+    {
+        const uint64_t callback = gen->issued.load() + 1;
+        if (gen->removeRequested.load() ||
+            (config.removeAfterCallbacks != 0 && callback > config.removeAfterCallbacks))
+        {
+            send_event(*gen, sdrplay_api_DeviceRemoved);
+            break;
+        }
+
+        // no callbacks while stalled; the samples of that time are lost
+        if (config.stallAfterCallbacks != 0 && callback > config.stallAfterCallbacks && !stallScripted)
+        {
+            stallScripted = true;
+            request_stall(*gen, config.stallMs);
+        }
+        if (gen->stallUntilNs.load() > steady_ns())
+        {
+            const int64_t stallStart = steady_ns();
+            gen->stalled = true;
+            gen->stalls++;
+            while (gen->running.load() && gen->stallUntilNs.load() > steady_ns())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            gen->stalled = false;
+            if (!gen->running.load())
+            {
+                break;
+            }
+            gen->pendingGap += static_cast<unsigned int>((steady_ns() - stallStart) * 1e-9 * gen->sampleRate.load());
+            deadline = std::chrono::steady_clock::now();
+        }
+
+        unsigned int gap = gen->pendingGap.exchange(0);
+        if (config.gapEvery != 0 && callback % config.gapEvery == 0)
+        {
+            gap += config.gapSamples;
+        }
+        if (gap != 0)
+        {
+            sampleNum += gap;
+            gen->gaps++;
+            gen->gapSamples += gap;
+        }
+
+        sdrplay_api_StreamCbParamsT params{};
+        params.firstSampleNum = sampleNum;
+        params.grChanged = take_flag(gen->grAt, callback);
+        params.rfChanged = take_flag(gen->rfAt, callback);
+        params.fsChanged = take_flag(gen->fsAt, callback);
+        params.numSamples = size;
+
+        const unsigned int offset = sampleNum & (TONE_PERIOD - 1);
+        if (config.onCallback != nullptr)
+        {
+            const int64_t hostNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            config.onCallback(config.onCallbackContext, sampleNum, size, hostNs);
+        }
+        if (gen->callbacks.StreamACbFn != nullptr)
+        {
+            sdrplay_api_StreamCbParamsT paramsA = params;
+            gen->callbacks.StreamACbFn(&toneI[offset], &toneQ[offset], &paramsA, size, reset, gen->context);
+        }
+        if (config.dualTuner && gen->callbacks.StreamBCbFn != nullptr)
+        {
+            sdrplay_api_StreamCbParamsT paramsB = params;
+            gen->callbacks.StreamBCbFn(&toneI[offset], &toneQ[offset], &paramsB, size, reset, gen->context);
+        }
+        reset = 0;
+        sampleNum += size;
+        gen->samples += size;
+        gen->issued.store(callback);
+
+        const double rate = gen->sampleRate.load();
+        if (config.paced && rate > 0.0)
+        {
+            deadline += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(size / rate));
+            const auto now = std::chrono::steady_clock::now();
+            // a driver that blocked the callback for long does not get a
+            // burst of catch-up callbacks
+            if (deadline + std::chrono::milliseconds(100) < now)
+            {
+                deadline = now;
+            }
+            std::this_thread::sleep_until(deadline);
+        }
+    }
+    gen->streaming = false;
+}
+
+void start_generator(MockDeviceState &state, const sdrplay_api_CallbackFnsT &callbacks, void *context)
+{
+    MockStreamConfig config;
+    {
+        std::lock_guard<std::mutex> lock(g_config_mutex);
+        config = g_stream_config;
+    }
+
+    MockGenerator &gen = *find_generator(&state);
+    gen.stop();
+    gen.callbacks = callbacks;
+    gen.context = context;
+    gen.tuner = state.device.tuner;
+    gen.config = config;
+    gen.sampleRate = config.sampleRate > 0.0 ? config.sampleRate : device_sample_rate(state);
+    gen.grAt = 0;
+    gen.rfAt = 0;
+    gen.fsAt = 0;
+    gen.pendingGap = 0;
+    gen.removeRequested = false;
+    gen.stallUntilNs = 0;
+    gen.stalled = false;
+    gen.stalls = 0;
+    gen.inits++;
+    gen.issued = 0;
+    gen.samples = 0;
+    gen.gaps = 0;
+    gen.gapSamples = 0;
+    gen.events = 0;
+    if (!config.enabled)
+    {
+        return;
+    }
+    gen.running = true;
+    gen.streaming = true;
+    gen.thread = std::thread(generator_loop, &gen);
+}
+
 } // namespace
 
+void mock_sdrplay_set_stream_config(const MockStreamConfig &config)
+{
+    init_mock_devices();
+    std::lock_guard<std::mutex> lock(g_config_mutex);
+    g_stream_config = config;
+}
+
+MockStreamConfig mock_sdrplay_stream_config()
+{
+    init_mock_devices();
+    std::lock_guard<std::mutex> lock(g_config_mutex);
+    return g_stream_config;
+}
+
+void mock_sdrplay_inject_change(const char *serial, bool grChanged, bool rfChanged, bool fsChanged)
+{
+    MockGenerator *gen = find_generator_by_serial(serial);
+    if (gen == nullptr)
+    {
+        return;
+    }
+    if (grChanged) schedule_flag(*gen, gen->grAt, 1);
+    if (rfChanged) schedule_flag(*gen, gen->rfAt, 1);
+    if (fsChanged) schedule_flag(*gen, gen->fsAt, 1);
+}
+
+void mock_sdrplay_inject_gap(const char *serial, unsigned int samples)
+{
+    MockGenerator *gen = find_generator_by_serial(serial);
+    if (gen != nullptr)
+    {
+        gen->pendingGap += samples;
+    }
+}
+
+void mock_sdrplay_stall_callbacks(const char *serial, unsigned int ms)
+{
+    MockGenerator *gen = find_generator_by_serial(serial);
+    if (gen != nullptr)
+    {
+        request_stall(*gen, ms);
+    }
+}
+
+bool mock_sdrplay_remove_device(const char *serial)
+{
+    MockGenerator *gen = find_generator_by_serial(serial);
+    if (gen == nullptr || !gen->streaming.load())
+    {
+        return false;
+    }
+    gen->removeRequested = true;
+    return true;
+}
+
+MockStreamStats mock_sdrplay_stream_stats(const char *serial)
+{
+    MockStreamStats stats{};
+    MockGenerator *gen = find_generator_by_serial(serial);
+    if (gen != nullptr)
+    {
+        const MockDeviceState &state = g_devices[gen - g_generators];
+        const sdrplay_api_DecimationT &decimation =
+            (state.device.tuner == sdrplay_api_Tuner_B ? state.rxB : state.rxA).ctrlParams.decimation;
+        stats.decimationFactor = decimation.enable ? decimation.decimationFactor : 1;
+        stats.sampleRate = gen->sampleRate.load();
+        stats.callbacks = gen->issued.load();
+        stats.samples = gen->samples.load();
+        stats.gaps = gen->gaps.load();
+        stats.gapSamples = gen->gapSamples.load();
+        stats.events = gen->events.load();
+        stats.stalls = gen->stalls.load();
+        stats.streaming = gen->streaming.load();
+        stats.stalled = gen->stalled.load();
+    }
+    return stats;
+}
+
+void mock_sdrplay_set_faults(const MockFaults &faults)
+{
+    init_mock_devices();
+    std::lock_guard<std::mutex> lock(g_config_mutex);
+    g_faults = faults;
+}
+
+MockFaults mock_sdrplay_faults()
+{
+    init_mock_devices();
+    std::lock_guard<std::mutex> lock(g_config_mutex);
+    return g_faults;
+}
+
 extern "C" {
 
 sdrplay_api_ErrT sdrplay_api_Open(void)
@@ -139,9 +640,9 @@ sdrplay_api_ErrT sdrplay_api_GetDevices(sdrplay_api_DeviceT *devices,
         return sdrplay_api_InvalidParam;
     }
     init_mock_devices();
+    fault_delay(&MockFaults::getDevicesDelayMs);
 
-    const unsigned int available = static_cast<unsigned int>(sizeof(g_devices) / sizeof(g_devices[0]));
-    const unsigned int count = (available < maxDevs) ? available : maxDevs;
+    const unsigned int count = (g_num_devices < maxDevs) ? g_num_devices : maxDevs;
     for (unsigned int i = 0; i < count; i++)
     {
         devices[i] = g_devices[i].device;
@@ -167,9 +668,13 @@ sdrplay_api_ErrT sdrplay_api_SelectDevice(sdrplay_api_DeviceT *device)
     state->selected = true;
     device->dev = state->device.dev;
     device->hwVer = state->device.hwVer;
-    device->tuner = state->device.tuner;
-    device->rspDuoMode = state->device.rspDuoMode;
-    device->rspDuoSampleFreq = state->device.rspDuoSampleFreq;
+    // an RSPduo is opened in the mode and with the tuner the caller chose
+    if (state->device.hwVer != SDRPLAY_RSPduo_ID)
+    {
+        device->tuner = state->device.tuner;
+        device->rspDuoMode = state->device.rspDuoMode;
+        device->rspDuoSampleFreq = state->device.rspDuoSampleFreq;
+    }
     device->valid = 1;
     return sdrplay_api_Success;
 }
@@ -242,6 +747,7 @@ sdrplay_api_ErrT sdrplay_api_GetDeviceParams(HANDLE dev, sdrplay_api_DeviceParam
 sdrplay_api_ErrT sdrplay_api_Init(HANDLE dev, sdrplay_api_CallbackFnsT *callbackFns, void *cbContext)
 {
     init_mock_devices();
+    fault_delay(&MockFaults::initDelayMs);
 
     std::lock_guard<std::mutex> lock(g_mutex);
     MockDeviceState *state = find_device_by_handle(dev);
@@ -249,12 +755,13 @@ sdrplay_api_ErrT sdrplay_api_Init(HANDLE dev, sdrplay_api_CallbackFnsT *callback
     {
         return sdrplay_api_InvalidParam;
     }
+    sdrplay_api_CallbackFnsT callbacks{};
     if (callbackFns != nullptr)
     {
-        g_callbacks = *callbackFns;
+        callbacks = *callbackFns;
     }
-    g_cb_context = cbContext;
     state->initialized = true;
+    start_generator(*state, callbacks, cbContext);
     return sdrplay_api_Success;
 }
 
@@ -262,13 +769,30 @@ sdrplay_api_ErrT sdrplay_api_Uninit(HANDLE dev)
 {
     init_mock_devices();
 
-    std::lock_guard<std::mutex> lock(g_mutex);
-    MockDeviceState *state = find_device_by_handle(dev);
+    MockDeviceState *state;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        state = find_device_by_handle(dev);
+    }
     if (state == nullptr)
     {
         return sdrplay_api_InvalidParam;
     }
-    state->initialized = false;
+    // an Uninit() that hung past a new Init() does not stop the new stream
+    MockGenerator *gen = find_generator(state);
+    const uint64_t inits = gen->inits.load();
+    fault_delay(&MockFaults::uninitDelayMs);
+    if (gen->inits.load() != inits)
+    {
+        return sdrplay_api_Success;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        state->initialized = false;
+    }
+    // no callbacks after Uninit() returns; the lock is not held because a
+    // callback in progress may call into the API
+    gen->stop();
     return sdrplay_api_Success;
 }
 
@@ -277,10 +801,51 @@ sdrplay_api_ErrT sdrplay_api_Update(HANDLE dev,
                                     sdrplay_api_ReasonForUpdateT reasonForUpdate,
                                     sdrplay_api_ReasonForUpdateExtension1T reasonForUpdateExt1)
 {
-    (void)dev;
     (void)tuner;
-    (void)reasonForUpdate;
     (void)reasonForUpdateExt1;
+    init_mock_devices();
+
+    {
+        std::lock_guard<std::mutex> lock(g_config_mutex);
+        if (g_faults.updateErrors != 0)
+        {
+            g_faults.updateErrors--;
+            return sdrplay_api_Fail;
+        }
+    }
+
+    MockDeviceState *state = find_device_by_handle(dev);
+    if (state == nullptr)
+    {
+        return sdrplay_api_Success;
+    }
+    MockGenerator &gen = *find_generator(state);
+    if (!gen.streaming.load())
+    {
+        return sdrplay_api_Success;
+    }
+
+    // confirmed in the stream a few callbacks later, as by the hardware
+    const unsigned int delay = gen.config.updateDelayCallbacks;
+    if (reasonForUpdate & sdrplay_api_Update_Tuner_Gr)
+    {
+        schedule_flag(gen, gen.grAt, delay);
+    }
+    if (reasonForUpdate & sdrplay_api_Update_Tuner_Frf)
+    {
+        schedule_flag(gen, gen.rfAt, delay);
+    }
+    if (reasonForUpdate & (sdrplay_api_Update_Dev_Fs | sdrplay_api_Update_Ctrl_Decimation | sdrplay_api_Update_Tuner_IfType))
+    {
+        if (gen.config.sampleRate <= 0.0)
+        {
+            gen.sampleRate = device_sample_rate(*state);
+        }
+        if (reasonForUpdate & sdrplay_api_Update_Dev_Fs)
+        {
+            schedule_flag(gen, gen.fsAt, delay);
+        }
+    }
     return sdrplay_api_Success;
 }
 
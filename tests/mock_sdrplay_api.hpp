@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+
+// Control of the streaming side of the mock SDRplay API
+// (tests/mock_sdrplay_api.cpp).
+//
+// When enabled, sdrplay_api_Init() starts a generator thread for the
+// device that calls StreamACbFn (and StreamBCbFn for two tuners) with a
+// tone at the configured rate, like the API's own callback thread. The
+// firstSampleNum sequence is continuous except for injected gaps, and
+// sdrplay_api_Update() of the gain, frequency or sample rate is confirmed
+// with grChanged/rfChanged/fsChanged a few callbacks later.
+// sdrplay_api_Uninit() stops the generator before returning.
+//
+// Processes that cannot call these functions (e.g. a worker linked
+// against the mock) can enable it with SOAPY_SDRPLAY_MOCK_STREAM, a comma
+// separated list of key=value pairs: rate, size, paced, first, gap_every,
+// gap, update_delay, dual, remove_after, stall_after, stall_ms ("1"
+// alone enables the defaults).
+//
+// Faults of the API calls themselves are set with mock_sdrplay_set_faults()
+// or SOAPY_SDRPLAY_MOCK_FAULTS (keys init_delay, uninit_delay,
+// get_devices_delay, update_errors).
+
+// The mock enumerates TEST0001 and TEST0002; SOAPY_SDRPLAY_MOCK_DEVICES
+// raises that to up to MOCK_MAX_DEVICES devices (TEST0001, TEST0002, ...).
+// They are RSPdx-R2s, except the comma separated serials listed in
+// SOAPY_SDRPLAY_MOCK_RSPDUO, which are RSPduos offering the single tuner,
+// dual tuner and master modes (read when the mock is first used).
+constexpr unsigned int MOCK_MAX_DEVICES = 16;
+
+struct MockStreamConfig
+{
+    bool enabled = false;                   // Stream after sdrplay_api_Init()
+    double sampleRate = 0.0;                // Samples/s per tuner; 0 follows the device's fsHz and decimation
+    unsigned int samplesPerCallback = 1008;
+    bool paced = true;                      // false: call back as fast as the driver returns
+    unsigned int firstSampleNum = 0;        // Of the first callback
+    unsigned int gapEvery = 0;              // Skip gapSamples every gapEvery callbacks (0: never)
+    unsigned int gapSamples = 0;
+    unsigned int updateDelayCallbacks = 2;  // Callbacks until an update is flagged
+    bool dualTuner = false;                 // Also call StreamBCbFn
+    uint64_t removeAfterCallbacks = 0;      // Send DeviceRemoved after this many callbacks (0: never)
+    uint64_t stallAfterCallbacks = 0;       // Stop calling back after this many callbacks (0: never)
+    unsigned int stallMs = 0;               // For this long (0: until the next sdrplay_api_Init())
+
+    // Called by the generator thread just before each StreamACbFn, with
+    // the steady_clock time in ns (e.g. to measure latency)
+    void (*onCallback)(void *context, unsigned int firstSampleNum, unsigned int numSamples, int64_t hostNs) = nullptr;
+    void *onCallbackContext = nullptr;
+};
+
+// Faults of the API calls, for the recovery paths of the driver; they stay
+// in effect until changed
+struct MockFaults
+{
+    unsigned int initDelayMs = 0;           // sdrplay_api_Init() blocks this long first
+    unsigned int uninitDelayMs = 0;         // sdrplay_api_Uninit() blocks this long first
+    unsigned int getDevicesDelayMs = 0;     // sdrplay_api_GetDevices() blocks this long first
+    unsigned int updateErrors = 0;          // The next sdrplay_api_Update() calls fail (counted down)
+};
+
+struct MockStreamStats
+{
+    uint64_t callbacks;                     // Per tuner
+    uint64_t samples;
+    uint64_t gaps;
+    uint64_t gapSamples;
+    uint64_t events;
+    uint64_t stalls;
+    bool streaming;
+    bool stalled;                           // Not calling back because of a stall
+    double sampleRate;                      // Current generator rate
+    unsigned int decimationFactor;          // As set by the driver, 1 if disabled
+};
+
+// Used by the next sdrplay_api_Init() of any device
+void mock_sdrplay_set_stream_config(const MockStreamConfig &config);
+MockStreamConfig mock_sdrplay_stream_config();
+
+// Flag the next callback of a streaming device
+void mock_sdrplay_inject_change(const char *serial, bool grChanged, bool rfChanged, bool fsChanged);
+
+// Skip samples in the firstSampleNum sequence before the next callback
+void mock_sdrplay_inject_gap(const char *serial, unsigned int samples);
+
+// Stop the callbacks of a streaming device for ms (0: until the next
+// sdrplay_api_Init()); the samples of that time are skipped, as if the
+// USB transfers had been lost
+void mock_sdrplay_stall_callbacks(const char *serial, unsigned int ms);
+
+// Send DeviceRemoved from the generator thread and stop streaming; false
+// if the device is not streaming
+bool mock_sdrplay_remove_device(const char *serial);
+
+MockStreamStats mock_sdrplay_stream_stats(const char *serial);
+
+void mock_sdrplay_set_faults(const MockFaults &faults);
+MockFaults mock_sdrplay_faults();
@@ -0,0 +1,200 @@
+/*
+ * Steady-state allocation test
+ *
+ * Streams from the mock API and counts heap allocations in this process
+ * (tests/bench_alloc.cpp) while the application reads. After a warmup the
+ * read paths must not allocate at all:
+ *   - the in-process driver, with readStream() and acquireReadBuffer(), in
+ *     CS16 and CF32, with and without sample gaps
+ *   - the proxy's readStream() in CS16 and CF32 (a worker built against the
+ *     mock is spawned; its path is the first argument), with reads smaller
+ *     and larger than the MTU
+ *
+ * The count covers every thread of the process: the mock's callback
+ * thread, the driver's watchdog and the proxy's reactor and monitor. Logging
+ * stays at the default level (with a handler that drops the messages), so a
+ * message formatted on a read path is counted too.
+ */
+#include "SoapySDRPlay.hpp"
+#include "SoapySDRPlayProxy.hpp"
+#include "mock_sdrplay_api.hpp"
+#include "bench_common.hpp"
+
+#include <SoapySDR/Formats.hpp>
+#include <SoapySDR/Logger.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+static int g_failed = 0;
+
+static void dropLogMessage(const SoapySDRLogLevel, const char *)
+{
+}
+
+static const double WARMUP_SEC = 0.5;
+static const double MEASURE_SEC = 1.0;
+
+struct ReadCount
+{
+    uint64_t allocations = 0;
+    uint64_t samples = 0;
+};
+
+// Read for WARMUP_SEC, then count allocations over MEASURE_SEC of reads
+template <typename ReadFn>
+static ReadCount measure(ReadFn read)
+{
+    const double warmupEnd = benchNowSeconds() + WARMUP_SEC;
+    while (benchNowSeconds() < warmupEnd)
+    {
+        read();
+    }
+
+    ReadCount count;
+    const uint64_t before = benchAllocations();
+    const double end = benchNowSeconds() + MEASURE_SEC;
+    while (benchNowSeconds() < end)
+    {
+        const int ret = read();
+        if (ret > 0)
+        {
+            count.samples += static_cast<uint64_t>(ret);
+        }
+    }
+    count.allocations = benchAllocations() - before;
+    return count;
+}
+
+static void check(const std::string &name, const ReadCount &count)
+{
+    const bool ok = count.allocations == 0 && count.samples > 0;
+    std::cout << (ok ? "ok   " : "FAIL ") << name << ": " << count.allocations << " allocations, "
+              << count.samples << " samples" << std::endl;
+    if (!ok)
+    {
+        g_failed++;
+    }
+}
+
+static void testDriver(const std::string &format, bool direct, unsigned int gapEvery)
+{
+    MockStreamConfig config;
+    config.enabled = true;
+    config.gapEvery = gapEvery;
+    config.gapSamples = 100;
+    mock_sdrplay_set_stream_config(config);
+
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+    SoapySDRPlay device(args);
+    device.setSampleRate(SOAPY_SDR_RX, 0, 2e6);
+    if (gapEvery != 0)
+    {
+        // the watchdog logs the gaps: off the read paths, but counted here
+        device.writeSetting("watchdog_enabled", "false");
+    }
+    SoapySDR::Stream *stream = device.setupStream(SOAPY_SDR_RX, format);
+    const size_t mtu = device.getStreamMTU(stream);
+    std::vector<char> buff(mtu * SoapySDR::formatToSize(format));
+    ReadCount count;
+    if (device.activateStream(stream) == 0)
+    {
+        count = measure([&]() {
+            int flags = 0;
+            long long timeNs = 0;
+            if (direct)
+            {
+                size_t handle = 0;
+                const void *buffs[1] = { nullptr };
+                const int ret = device.acquireReadBuffer(stream, handle, buffs, flags, timeNs, 100000);
+                if (ret > 0)
+                {
+                    device.releaseReadBuffer(stream, handle);
+                }
+                return ret;
+            }
+            void *buffs[] = { buff.data() };
+            return device.readStream(stream, buffs, mtu, flags, timeNs, 100000);
+        });
+    }
+    device.closeStream(stream);
+    mock_sdrplay_set_stream_config(MockStreamConfig());
+
+    check(std::string("driver ") + (direct ? "acquireReadBuffer " : "readStream ") + format +
+          (gapEvery != 0 ? " with gaps" : ""), count);
+}
+
+static void testProxy(const std::string &format)
+{
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+    std::unique_ptr<SoapySDRPlayProxy> proxy;
+    SoapySDR::Stream *stream = nullptr;
+    ReadCount count;
+    try
+    {
+        proxy.reset(new SoapySDRPlayProxy(args));
+        stream = proxy->setupStream(SOAPY_SDR_RX, format);
+        const size_t mtu = proxy->getStreamMTU(stream);
+
+        // alternate reads of a fraction of the MTU and of several MTUs
+        std::vector<char> buff(4 * mtu * SoapySDR::formatToSize(format));
+        size_t reads = 0;
+        if (proxy->activateStream(stream) == 0)
+        {
+            count = measure([&]() {
+                void *buffs[] = { buff.data() };
+                int flags = 0;
+                long long timeNs = 0;
+                const size_t numElems = (reads++ % 2 == 0) ? mtu / 16 : 4 * mtu;
+                return proxy->readStream(stream, buffs, numElems, flags, timeNs, 100000);
+            });
+            proxy->deactivateStream(stream);
+        }
+        proxy->closeStream(stream);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "proxy: " << ex.what() << std::endl;
+    }
+    proxy.reset();
+
+    check("proxy readStream " + format, count);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || access(argv[1], X_OK) != 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " <worker executable built against the mock>" << std::endl;
+        return 1;
+    }
+
+    // inherited by the proxy's worker
+    setenv("SOAPY_SDRPLAY_WORKER", argv[1], 1);
+    setenv("SOAPY_SDRPLAY_MOCK_STREAM", "1", 1);
+    SoapySDR_registerLogHandler(dropLogMessage);
+    SoapySDRPlay::sdrplay_api::get_instance();
+
+    for (const char *format : {SOAPY_SDR_CS16, SOAPY_SDR_CF32})
+    {
+        testDriver(format, false, 0);
+        testDriver(format, true, 0);
+        testDriver(format, false, 50);
+    }
+    testProxy(SOAPY_SDR_CS16);
+    testProxy(SOAPY_SDR_CF32);
+
+    if (g_failed != 0)
+    {
+        std::cerr << g_failed << " read paths allocated in steady state" << std::endl;
+        return 1;
+    }
+    std::cout << "No steady-state allocations." << std::endl;
+    return 0;
+}
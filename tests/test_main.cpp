@@ -1,21 +1,46 @@
 #include "SoapySDRPlay.hpp"
+#include "SoapySDRPlayWorker.hpp"
+#include "SoapySDRPlayProxy.hpp"
+#include "RingBuffer.hpp"
+#include "IPCReactor.hpp"
+#include "EnumerationCache.hpp"
+#include "SDRplayBroker.hpp"
+#include "DeviceMetrics.hpp"
+#include "MetricsExporter.hpp"
+#include "Trace.hpp"
+#ifdef SOAPYSDRPLAY_MOCK_API
+#include "mock_sdrplay_api.hpp"
+#endif
 
 #include <SoapySDR/Errors.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <chrono>
 #include <cstdlib>
 #include <cmath>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 #ifdef _WIN32
 #include <direct.h>
 #include <process.h>
 #include <sys/stat.h>
 #else
+#include <csignal>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #endif
 
@@ -340,6 +365,17 @@ static void test_stream_read_cs16()
     EXPECT_EQ(buff[7], 8);
 
     device.closeStream(stream);
+
+    // "bufflen" sets the samples per buffer within the allocated length
+    SoapySDR::Kwargs streamArgs;
+    streamArgs["bufflen"] = "4096";
+    stream = device.setupStream(SOAPY_SDR_RX, "CS16", std::vector<size_t>(), streamArgs);
+    EXPECT_EQ(device.getStreamMTU(stream), static_cast<size_t>(4096));
+    device.closeStream(stream);
+    streamArgs["bufflen"] = "1000000";
+    stream = device.setupStream(SOAPY_SDR_RX, "CS16", std::vector<size_t>(), streamArgs);
+    EXPECT_EQ(device.getStreamMTU(stream), static_cast<size_t>(DEFAULT_BUFFER_LENGTH));
+    device.closeStream(stream);
 }
 
 static void test_stream_read_cf32()
@@ -382,7 +418,1484 @@ static void test_stream_read_cf32()
     device.closeStream(stream);
 }
 
-int main()
+static void test_hybrid_tuning_nco()
+{
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0002";
+
+    SoapySDRPlay device(args);
+    device.setBandwidth(SOAPY_SDR_RX, 0, 1536000);
+    device.writeSetting("hybrid_tuning", "true");
+    EXPECT_EQ(device.readSetting("hybrid_tuning"), std::string("true"));
+
+    SoapySDR::Stream *stream = device.setupStream(SOAPY_SDR_RX, "CF32");
+    EXPECT_EQ(device.activateStream(stream), 0);
+
+    // a quarter of the sample rate is inside the passband: NCO only
+    const double lo = device.getFrequency(SOAPY_SDR_RX, 0);
+    const double offset = device.getSampleRate(SOAPY_SDR_RX, 0) / 4;
+    device.setFrequency(SOAPY_SDR_RX, 0, lo + offset);
+    EXPECT_NEAR(device.getFrequency(SOAPY_SDR_RX, 0), lo + offset, 1e-3);
+    EXPECT_NEAR(std::stod(device.readSetting("nco_offset")), offset, 1e-3);
+
+    auto *playStream = reinterpret_cast<SoapySDRPlay::SoapySDRPlayStream *>(stream);
+    playStream->reset = false;
+    const unsigned int preSamples = 4;
+    const unsigned int flushSamples = DEFAULT_BUFFER_LENGTH - preSamples;
+    short xi[preSamples] = { 16384, 16384, 16384, 16384 };
+    short xq[preSamples] = { 0, 0, 0, 0 };
+    std::vector<short> xiFlush(flushSamples, 0);
+    std::vector<short> xqFlush(flushSamples, 0);
+    sdrplay_api_StreamCbParamsT params{};
+    params.numSamples = preSamples;
+    {
+        std::lock_guard<std::mutex> lock(playStream->mutex);
+        device.rx_callback(xi, xq, &params, preSamples, playStream);
+        params.numSamples = flushSamples;
+        device.rx_callback(xiFlush.data(), xqFlush.data(), &params, flushSamples, playStream);
+    }
+
+    // DC input mixed down by fs/4 rotates by -90 degrees per sample
+    float buff[8] = {};
+    void *buffs[] = { buff };
+    int flags = 0;
+    long long timeNs = 0;
+    int ret = device.readStream(stream, buffs, preSamples, flags, timeNs, 100000);
+    EXPECT_EQ(ret, static_cast<int>(preSamples));
+    EXPECT_NEAR(buff[0], 0.5, 1e-5);
+    EXPECT_NEAR(buff[1], 0.0, 1e-5);
+    EXPECT_NEAR(buff[2], 0.0, 1e-5);
+    EXPECT_NEAR(buff[3], -0.5, 1e-5);
+    EXPECT_NEAR(buff[4], -0.5, 1e-5);
+    EXPECT_NEAR(buff[5], 0.0, 1e-5);
+    EXPECT_NEAR(buff[6], 0.0, 1e-5);
+    EXPECT_NEAR(buff[7], 0.5, 1e-5);
+
+    // far outside the passband: the LO is retuned and the NCO cleared
+    device.setFrequency(SOAPY_SDR_RX, 0, lo + 100e6);
+    EXPECT_NEAR(device.getFrequency(SOAPY_SDR_RX, 0), lo + 100e6, 1e-3);
+    EXPECT_NEAR(std::stod(device.readSetting("nco_offset")), 0.0, 1e-9);
+
+    // disabling hybrid tuning folds the NCO offset into the LO
+    device.setFrequency(SOAPY_SDR_RX, 0, lo + 100e6 + offset);
+    device.writeSetting("hybrid_tuning", "false");
+    EXPECT_NEAR(device.getFrequency(SOAPY_SDR_RX, 0), lo + 100e6 + offset, 1.0);
+    EXPECT_NEAR(std::stod(device.readSetting("nco_offset")), 0.0, 1e-9);
+
+    device.closeStream(stream);
+}
+
+static void test_sweep_engine()
+{
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+
+    SoapySDRPlay device(args);
+    SoapySDR::Stream *stream = device.setupStream(SOAPY_SDR_RX, "CS16");
+    EXPECT_EQ(device.activateStream(stream), 0);
+    auto *playStream = reinterpret_cast<SoapySDRPlay::SoapySDRPlayStream *>(stream);
+    playStream->reset = false;
+
+    // first step is the current LO, so no retune is needed to start
+    const double lo = device.getFrequency(SOAPY_SDR_RX, 0);
+    device.writeSetting("sweep_frequencies", std::to_string(static_cast<uint64_t>(lo)) + ",101000000");
+    device.writeSetting("sweep_settle", "2");
+    device.writeSetting("sweep_dwell", "4");
+
+    // rejected values are logged and leave the configuration untouched
+    device.writeSetting("sweep_dwell", "0");
+    device.writeSetting("sweep_dwell", "4x");
+    device.writeSetting("sweep_settle", "-1");
+    device.writeSetting("sweep_frequencies", "");
+    device.writeSetting("sweep_frequencies", "101e6,abc");
+    device.writeSetting("sweep_frequencies", "1e12");
+    EXPECT_EQ(device.readSetting("sweep_dwell"), std::string("4"));
+    EXPECT_EQ(device.readSetting("sweep_settle"), std::string("2"));
+
+    device.writeSetting("sweep", "true");
+    EXPECT_EQ(device.readSetting("sweep"), std::string("true"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    short xi[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    short xq[8] = { -1, -2, -3, -4, -5, -6, -7, -8 };
+    sdrplay_api_StreamCbParamsT params{};
+    params.numSamples = 8;
+    {
+        std::lock_guard<std::mutex> lock(playStream->mutex);
+        device.rx_callback(xi, xq, &params, 8, playStream);
+    }
+
+    // settle samples are dropped and the dwell block ends the burst
+    short buff[16] = {};
+    void *buffs[] = { buff };
+    int flags = 0;
+    long long timeNs = 0;
+    int ret = device.readStream(stream, buffs, 8, flags, timeNs, 100000);
+    EXPECT_EQ(ret, 4);
+    EXPECT_EQ(buff[0], 3);
+    EXPECT_EQ(buff[1], -3);
+    EXPECT_EQ(buff[6], 6);
+    EXPECT_TRUE((flags & SOAPY_SDR_END_BURST) != 0);
+    EXPECT_EQ(device.readSetting("sweep_frequency"), std::to_string(static_cast<uint64_t>(lo)));
+
+    // the sweep thread has retuned; samples before rfChanged are ignored
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_NEAR(device.getFrequency(SOAPY_SDR_RX, 0), 101000000, 1e-3);
+    {
+        std::lock_guard<std::mutex> lock(playStream->mutex);
+        device.rx_callback(xi, xq, &params, 8, playStream);
+        for (auto &v : xi) v += 10;
+        params.rfChanged = 1;
+        device.rx_callback(xi, xq, &params, 8, playStream);
+    }
+    flags = 0;
+    ret = device.readStream(stream, buffs, 8, flags, timeNs, 100000);
+    EXPECT_EQ(ret, 4);
+    EXPECT_EQ(buff[0], 13);
+    EXPECT_EQ(buff[6], 16);
+    EXPECT_TRUE((flags & SOAPY_SDR_END_BURST) != 0);
+    EXPECT_EQ(device.readSetting("sweep_frequency"), std::string("101000000"));
+
+    // integrated power mode on a single step at the current LO
+    device.writeSetting("sweep", "false");
+    device.writeSetting("sweep_output", "power");
+    device.writeSetting("sweep_frequencies", "101000000");
+    device.writeSetting("sweep", "true");
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    short pi[8] = { 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384 };
+    short pq[8] = {};
+    // the previous sweep may already have moved the LO back to its first
+    // step, in which case this step retunes and waits for rfChanged
+    params.rfChanged = 1;
+    {
+        std::lock_guard<std::mutex> lock(playStream->mutex);
+        device.rx_callback(pi, pq, &params, 8, playStream);
+    }
+    EXPECT_EQ(device.readSetting("sweep_count"), std::string("1"));
+    const std::string power = device.readSetting("sweep_power");
+    EXPECT_EQ(power.substr(0, 10), std::string("101000000:"));
+    EXPECT_NEAR(std::stod(power.substr(10)), -6.0206, 1e-3);
+
+    device.writeSetting("sweep", "false");
+    device.closeStream(stream);
+}
+
+static void test_timed_commands()
+{
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+
+    SoapySDRPlay device(args);
+    EXPECT_TRUE(device.hasHardwareTime());
+    SoapySDR::Stream *stream = device.setupStream(SOAPY_SDR_RX, "CS16");
+
+    // 2 MS/s: one tick is 500 ns; start streaming at tick 10
+    EXPECT_EQ(device.activateStream(stream, SOAPY_SDR_HAS_TIME, 5000), 0);
+    auto *playStream = reinterpret_cast<SoapySDRPlay::SoapySDRPlayStream *>(stream);
+    playStream->reset = false;
+
+    short xi[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    short xq[8] = {};
+    sdrplay_api_StreamCbParamsT params{};
+    params.numSamples = 8;
+    params.firstSampleNum = 4;
+    {
+        std::lock_guard<std::mutex> lock(playStream->mutex);
+        device.rx_callback(xi, xq, &params, 8, playStream);
+    }
+
+    // retune at tick 16: queued, not applied yet
+    const double lo = device.getFrequency(SOAPY_SDR_RX, 0);
+    device.setCommandTime(8000);
+    device.setFrequency(SOAPY_SDR_RX, 0, lo + 1e6);
+    device.setCommandTime(0);
+    EXPECT_NEAR(device.getFrequency(SOAPY_SDR_RX, 0), lo, 1e-3);
+
+    // the stream reaches tick 20 and the command thread applies the change
+    params.firstSampleNum = 12;
+    {
+        std::lock_guard<std::mutex> lock(playStream->mutex);
+        device.rx_callback(xi, xq, &params, 8, playStream);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // rfChanged starts a new buffer at the time of the change
+    params.firstSampleNum = 20;
+    params.rfChanged = 1;
+    {
+        std::lock_guard<std::mutex> lock(playStream->mutex);
+        device.rx_callback(xi, xq, &params, 8, playStream);
+    }
+    EXPECT_NEAR(device.getFrequency(SOAPY_SDR_RX, 0), lo + 1e6, 1e-3);
+    EXPECT_EQ(device.readSetting("last_command_time"), std::string("10000"));
+    EXPECT_EQ(device.getHardwareTime(), 14000);
+
+    // an unchanged frequency issues no update: a later rfChanged packet
+    // does not split a buffer; the gaps before ticks 40 and 100 do
+    device.setCommandTime(22000);
+    device.setFrequency(SOAPY_SDR_RX, 0, lo + 1e6);
+    device.setCommandTime(0);
+    params.rfChanged = 0;
+    params.firstSampleNum = 40;
+    {
+        std::lock_guard<std::mutex> lock(playStream->mutex);
+        device.rx_callback(xi, xq, &params, 8, playStream);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    params.rfChanged = 1;
+    params.firstSampleNum = 48;
+    {
+        std::lock_guard<std::mutex> lock(playStream->mutex);
+        device.rx_callback(xi, xq, &params, 8, playStream);
+        params.rfChanged = 0;
+        params.firstSampleNum = 100;
+        device.rx_callback(xi, xq, &params, 8, playStream);
+    }
+    EXPECT_EQ(device.readSetting("last_command_time"), std::string("10000"));
+
+    // samples before the activation time were dropped
+    short buff[32] = {};
+    void *buffs[] = { buff };
+    int flags = 0;
+    long long timeNs = 0;
+    int ret = device.readStream(stream, buffs, 4, flags, timeNs, 100000);
+    EXPECT_EQ(ret, 4);
+    EXPECT_EQ(buff[0], 7);
+    EXPECT_TRUE((flags & SOAPY_SDR_HAS_TIME) != 0);
+    EXPECT_EQ(timeNs, 5000);
+    flags = 0;
+    ret = device.readStream(stream, buffs, 16, flags, timeNs, 100000);
+    EXPECT_EQ(ret, 6);
+    EXPECT_EQ(timeNs, 7000);
+    flags = 0;
+    ret = device.readStream(stream, buffs, 16, flags, timeNs, 100000);
+    EXPECT_EQ(ret, 8);
+    EXPECT_EQ(timeNs, 10000);
+    flags = 0;
+    ret = device.readStream(stream, buffs, 16, flags, timeNs, 100000);
+    EXPECT_EQ(ret, 16);
+    EXPECT_EQ(timeNs, 20000);
+
+    device.closeStream(stream);
+}
+
+static void test_finite_burst()
+{
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+
+    SoapySDRPlay device(args);
+    SoapySDR::Stream *stream = device.setupStream(SOAPY_SDR_RX, "CS16");
+    EXPECT_EQ(device.activateStream(stream, SOAPY_SDR_END_BURST, 0, 10), 0);
+    auto *playStream = reinterpret_cast<SoapySDRPlay::SoapySDRPlayStream *>(stream);
+    playStream->reset = false;
+
+    short xi[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    short xq[8] = {};
+    sdrplay_api_StreamCbParamsT params{};
+    params.numSamples = 8;
+    {
+        std::lock_guard<std::mutex> lock(playStream->mutex);
+        for (int i = 0; i < 3; i++)
+        {
+            params.firstSampleNum = 8 * i;
+            device.rx_callback(xi, xq, &params, 8, playStream);
+        }
+    }
+
+    // exactly numElems samples, END_BURST on the last fragment only
+    short buff[32] = {};
+    void *buffs[] = { buff };
+    int flags = 0;
+    long long timeNs = 0;
+    int ret = device.readStream(stream, buffs, 6, flags, timeNs, 100000);
+    EXPECT_EQ(ret, 6);
+    EXPECT_TRUE((flags & SOAPY_SDR_END_BURST) == 0);
+    flags = 0;
+    ret = device.readStream(stream, buffs, 16, flags, timeNs, 100000);
+    EXPECT_EQ(ret, 4);
+    EXPECT_EQ(buff[2], 8);
+    EXPECT_TRUE((flags & SOAPY_SDR_END_BURST) != 0);
+    flags = 0;
+    EXPECT_EQ(device.readStream(stream, buffs, 16, flags, timeNs, 1000), SOAPY_SDR_TIMEOUT);
+
+    // re-arm the running stream for another burst
+    EXPECT_EQ(device.activateStream(stream, SOAPY_SDR_END_BURST, 0, 4), 0);
+    playStream->reset = false;
+    {
+        std::lock_guard<std::mutex> lock(playStream->mutex);
+        params.firstSampleNum = 24;
+        device.rx_callback(xi, xq, &params, 8, playStream);
+    }
+    flags = 0;
+    ret = device.readStream(stream, buffs, 16, flags, timeNs, 100000);
+    EXPECT_EQ(ret, 4);
+    EXPECT_TRUE((flags & SOAPY_SDR_END_BURST) != 0);
+
+    // numElems without END_BURST streams continuously: no burst is cut off
+    EXPECT_EQ(device.activateStream(stream, 0, 0, 4), 0);
+    playStream->reset = false;
+    {
+        std::lock_guard<std::mutex> lock(playStream->mutex);
+        params.firstSampleNum = 32;
+        device.rx_callback(xi, xq, &params, 8, playStream);
+    }
+    flags = 0;
+    EXPECT_EQ(device.readStream(stream, buffs, 16, flags, timeNs, 1000), SOAPY_SDR_TIMEOUT);
+
+    EXPECT_EQ(device.activateStream(stream, SOAPY_SDR_END_BURST, 0, 0), SOAPY_SDR_NOT_SUPPORTED);
+    device.closeStream(stream);
+}
+
+static void test_hot_standby()
+{
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+
+    SoapySDRPlay device(args);
+    SoapySDR::Stream *stream = device.setupStream(SOAPY_SDR_RX, "CS16");
+    EXPECT_EQ(device.activateStream(stream), 0);
+    auto *playStream = reinterpret_cast<SoapySDRPlay::SoapySDRPlayStream *>(stream);
+    playStream->reset = false;
+
+    // standby keeps the stream initialised but drops callback samples
+    EXPECT_EQ(device.deactivateStream(stream), 0);
+    EXPECT_EQ(device.deactivateStream(stream), 0);
+
+    short xi[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    short xq[8] = {};
+    sdrplay_api_StreamCbParamsT params{};
+    params.numSamples = 8;
+    {
+        std::lock_guard<std::mutex> lock(playStream->mutex);
+        device.rx_callback(xi, xq, &params, 8, playStream);
+        EXPECT_EQ(playStream->shortBuffs[playStream->tail].size(), 0u);
+    }
+
+    // reactivation only opens the gate again
+    EXPECT_EQ(device.activateStream(stream), 0);
+    playStream->reset = false;
+    {
+        std::lock_guard<std::mutex> lock(playStream->mutex);
+        params.firstSampleNum = 8;
+        device.rx_callback(xi, xq, &params, 8, playStream);
+        EXPECT_EQ(playStream->shortBuffs[playStream->tail].size(), 16u);
+    }
+
+    device.closeStream(stream);
+}
+
+static void test_worker_pool_size()
+{
+    EXPECT_EQ(WorkerPool::configuredSize(), 0u);
+    {
+        ScopedEnvVar pool("SOAPY_SDRPLAY_WORKER_POOL", "4");
+        EXPECT_EQ(WorkerPool::configuredSize(), 4u);
+    }
+    {
+        ScopedEnvVar pool("SOAPY_SDRPLAY_WORKER_POOL", "1000");
+        EXPECT_EQ(WorkerPool::configuredSize(), 16u);
+    }
+    {
+        ScopedEnvVar pool("SOAPY_SDRPLAY_WORKER_POOL", "-2");
+        EXPECT_EQ(WorkerPool::configuredSize(), 0u);
+    }
+    {
+        ScopedEnvVar pool("SOAPY_SDRPLAY_WORKER_POOL", "4x");
+        EXPECT_EQ(WorkerPool::configuredSize(), 0u);
+    }
+}
+
+static void test_ring_buffer_gap_marker()
+{
+    const std::string name = generateShmName("GAPTEST");
+    std::unique_ptr<SharedRingBuffer> producer(SharedRingBuffer::create(name, 64));
+    EXPECT_TRUE(producer != nullptr);
+    if (!producer)
+    {
+        return;
+    }
+    std::unique_ptr<SharedRingBuffer> consumer(SharedRingBuffer::open(name));
+    EXPECT_TRUE(consumer != nullptr);
+    if (!consumer)
+    {
+        return;
+    }
+
+    std::complex<float> in[10];
+    for (int i = 0; i < 10; i++)
+    {
+        in[i] = std::complex<float>(static_cast<float>(i), 0.0f);
+    }
+    std::complex<float> out[32];
+    uint64_t lost = 0;
+
+    // a restarted producer keeps writing after the marked gap
+    producer->write(in, 10);
+    producer->markGap(1234);
+    producer->write(in, 10);
+
+    // the read stops at the gap, which is then reported exactly once
+    EXPECT_EQ(consumer->read(out, 32), 10u);
+    EXPECT_TRUE(consumer->takeGap(lost));
+    EXPECT_EQ(lost, 1234u);
+    EXPECT_TRUE(!consumer->takeGap(lost));
+    EXPECT_EQ(consumer->read(out, 32), 10u);
+    EXPECT_NEAR(out[9].real(), 9.0, 1e-6);
+
+    // a second gap before the first is read does not overwrite it; two
+    // gaps at the same position are reported together
+    producer->markGap(100);
+    producer->write(in, 10);
+    producer->markGap(200);
+    producer->markGap(300);
+    producer->write(in, 10);
+    EXPECT_TRUE(consumer->takeGap(lost));
+    EXPECT_EQ(lost, 100u);
+    EXPECT_EQ(consumer->read(out, 32), 10u);
+    EXPECT_TRUE(consumer->takeGap(lost));
+    EXPECT_EQ(lost, 500u);
+    EXPECT_TRUE(!consumer->takeGap(lost));
+    EXPECT_EQ(consumer->read(out, 32), 10u);
+
+    // the estimate follows the time since the last write
+    producer->setSampleRate(1000000);
+    producer->write(in, 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    lost = producer->markResumeGap();
+    EXPECT_TRUE(lost >= 15000 && lost < 1000000);
+    EXPECT_EQ(consumer->read(out, 32), 1u);
+    uint64_t reported = 0;
+    EXPECT_TRUE(consumer->takeGap(reported));
+    EXPECT_EQ(reported, lost);
+}
+
+static void test_channel_shm_names()
+{
+    // channel 0 keeps the base name so single-channel workers are unchanged
+    const std::string base = generateShmName("DUO1");
+    EXPECT_EQ(channelShmName(base, 0), base);
+    EXPECT_EQ(channelShmName(base, 1), base + "_ch1");
+}
+
+static void test_enumeration_cache()
+{
+    const std::string path = "/tmp/soapy_sdrplay_enum_test_" + std::to_string(getpid()) + ".cache";
+    EnumerationCache cache(path);
+    cache.invalidate();
+
+    EnumerationCache::DeviceMap loaded;
+    EXPECT_TRUE(!cache.load(loaded));
+
+    EnumerationCache::DeviceMap devices;
+    devices["TEST0001"] = {{"serial", "TEST0001"}, {"label", "SDRplay Dev0 RSP1A TEST0001"}};
+    devices["TEST0002@DT"] = {{"serial", "TEST0002"}, {"mode", "DT"},
+                              {"label", "SDRplay Dev1 RSPduo TEST0002 - Dual Tuner"}};
+    EXPECT_TRUE(cache.store(devices));
+    EXPECT_TRUE(cache.load(loaded));
+    EXPECT_EQ(loaded.size(), devices.size());
+    EXPECT_TRUE(loaded == devices);
+
+    // the file is private; one that others could have written is ignored
+    struct stat st;
+    EXPECT_EQ(stat(path.c_str(), &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, 0600u);
+    EXPECT_EQ(chmod(path.c_str(), 0666), 0);
+    EXPECT_TRUE(!cache.load(loaded));
+    EXPECT_EQ(chmod(path.c_str(), 0600), 0);
+    EXPECT_TRUE(cache.load(loaded));
+
+    // by default a per-user file, never one shared through /tmp
+    {
+        ScopedEnvVar unset("SOAPY_SDRPLAY_ENUM_CACHE", "");
+        {
+            ScopedEnvVar runtime("XDG_RUNTIME_DIR", "/tmp");
+            EXPECT_EQ(EnumerationCache::defaultPath(), std::string("/tmp/soapy_sdrplay_enum.cache"));
+        }
+        ScopedEnvVar runtime("XDG_RUNTIME_DIR", "");
+        EXPECT_EQ(EnumerationCache::defaultPath(),
+                  "/tmp/soapy_sdrplay_enum." + std::to_string(getuid()) + ".cache");
+    }
+
+    // a cache written for another service instance or USB device set is ignored
+    {
+        std::ofstream out(path, std::ios::trunc);
+        out << "SoapySDRPlay enumeration cache 1\n"
+            << "service=1:42 usb=1-1:1:7\n"
+            << "TEST0001\tserial=TEST0001\n";
+    }
+    EXPECT_TRUE(!cache.load(loaded));
+
+    EXPECT_TRUE(cache.store(devices));
+    cache.invalidate();
+    EXPECT_TRUE(!cache.load(loaded));
+
+    // hotplug events: only add/remove of an SDRplay USB device count
+    const char addEvent[] = "add@/devices/pci0000:00/usb1/1-2\0ACTION=add\0SUBSYSTEM=usb\0"
+                            "DEVTYPE=usb_device\0PRODUCT=1df7/3020/200\0";
+    const char interfaceEvent[] = "add@/devices/pci0000:00/usb1/1-2/1-2:1.0\0ACTION=add\0"
+                                  "SUBSYSTEM=usb\0DEVTYPE=usb_interface\0PRODUCT=1df7/3020/200\0";
+    const char otherVendor[] = "remove@/devices/pci0000:00/usb1/1-3\0ACTION=remove\0"
+                               "SUBSYSTEM=usb\0DEVTYPE=usb_device\0PRODUCT=bda/2838/100\0";
+    const char changeEvent[] = "change@/devices/pci0000:00/usb1/1-2\0ACTION=change\0"
+                               "DEVTYPE=usb_device\0PRODUCT=1df7/3020/200\0";
+    EXPECT_TRUE(HotplugWatcher::isSdrplayUevent(addEvent, sizeof(addEvent)));
+    EXPECT_TRUE(!HotplugWatcher::isSdrplayUevent(interfaceEvent, sizeof(interfaceEvent)));
+    EXPECT_TRUE(!HotplugWatcher::isSdrplayUevent(otherVendor, sizeof(otherVendor)));
+    EXPECT_TRUE(!HotplugWatcher::isSdrplayUevent(changeEvent, sizeof(changeEvent)));
+}
+
+static void test_broker_protocol()
+{
+    // descriptors survive the trip over a Unix socket
+    int sock[2];
+    int pipeFds[2];
+    EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sock), 0);
+    EXPECT_EQ(pipe(pipeFds), 0);
+    EXPECT_TRUE(sendDescriptors(sock[0], {pipeFds[1]}));
+    std::vector<int> received;
+    EXPECT_TRUE(receiveDescriptors(sock[1], received, 1000));
+    EXPECT_EQ(received.size(), static_cast<size_t>(1));
+    if (received.size() == 1)
+    {
+        const char byte = 'x';
+        char readBack = 0;
+        EXPECT_EQ(write(received[0], &byte, 1), 1);
+        EXPECT_EQ(read(pipeFds[0], &readBack, 1), 1);
+        EXPECT_EQ(readBack, 'x');
+        close(received[0]);
+    }
+    // both ends see who is on the other side
+    uid_t uid = static_cast<uid_t>(-1);
+    gid_t gid = static_cast<gid_t>(-1);
+    EXPECT_TRUE(peerCredentials(sock[0], uid, gid));
+    EXPECT_EQ(uid, geteuid());
+    EXPECT_EQ(gid, getegid());
+    for (int fd : {sock[0], sock[1], pipeFds[0], pipeFds[1]})
+    {
+        close(fd);
+    }
+
+    // the broker answers listings from its own enumeration
+    const std::string path = "/tmp/soapy_sdrplay_broker_test_" + std::to_string(getpid()) + ".sock";
+    SDRplayBroker broker(path, []() {
+        std::vector<SoapySDR::Kwargs> devices;
+        devices.push_back({{"driver", "sdrplay"}, {"serial", "TEST0001"}, {"label", "RSP1A TEST0001"}});
+        devices.push_back({{"driver", "sdrplay"}, {"serial", "TEST0002"}, {"mode", "ST"}});
+        devices.push_back({{"driver", "sdrplay"}, {"serial", "TEST0002"}, {"mode", "DT"}});
+        return devices;
+    });
+    std::thread brokerThread([&broker]() { broker.run(); });
+
+    std::vector<SoapySDR::Kwargs> devices;
+    bool listed = false;
+    for (int attempt = 0; attempt < 100 && !listed; attempt++)
+    {
+        listed = BrokerClient::list(devices, path) && !devices.empty();
+        if (!listed)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    EXPECT_TRUE(listed);
+    struct stat st;
+    EXPECT_EQ(stat(path.c_str(), &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, 0660u);
+    EXPECT_EQ(devices.size(), static_cast<size_t>(3));
+    if (devices.size() == 3)
+    {
+        EXPECT_EQ(devices[0]["serial"], std::string("TEST0001"));
+        EXPECT_EQ(devices[0]["label"], std::string("RSP1A TEST0001"));
+        EXPECT_EQ(devices[0]["leased"], std::string("0"));
+        EXPECT_EQ(devices[2]["mode"], std::string("DT"));
+    }
+
+    // a second broker does not steal the socket
+    SDRplayBroker second(path, []() { return std::vector<SoapySDR::Kwargs>(); });
+    EXPECT_EQ(second.run(), 1);
+
+    // unknown devices cannot be leased
+    IPCPipePair* pipes = nullptr;
+    bool ready = false;
+    int leaseFd = -1;
+    SoapySDR::Kwargs args = {{"serial", "NOSUCH"}};
+    EXPECT_EQ(BrokerClient::lease(args, &pipes, ready, leaseFd, path), -1);
+    EXPECT_TRUE(pipes == nullptr);
+
+    broker.stop();
+    brokerThread.join();
+    EXPECT_TRUE(!BrokerClient::list(devices, path));
+}
+
+static void test_sdrplay_lock_fifo()
+{
+    const std::string path = "/tmp/soapy_sdrplay_test_" + std::to_string(getpid()) + ".lock";
+    unlink(path.c_str());
+
+    SDRplayLock holder(path);
+    EXPECT_TRUE(holder.acquire(1000, 0));
+    EXPECT_EQ(holder.currentCooldownMs(), 0.0);
+
+    // a waiter that times out leaves the queue again
+    {
+        SDRplayLock impatient(path);
+        EXPECT_TRUE(!impatient.acquire(50, 0));
+        EXPECT_EQ(holder.queueDepth(), static_cast<size_t>(0));
+    }
+
+    // waiters queue up one after another and are granted in arrival order
+    const int numWaiters = 4;
+    std::vector<std::unique_ptr<SDRplayLock>> locks;
+    std::vector<std::thread> threads;
+    std::vector<int> order;
+    std::mutex orderMutex;
+    for (int i = 0; i < numWaiters; i++)
+    {
+        locks.emplace_back(new SDRplayLock(path));
+        SDRplayLock* lock = locks.back().get();
+        threads.emplace_back([lock, i, &order, &orderMutex]() {
+            if (lock->acquire(5000, 0))
+            {
+                {
+                    std::lock_guard<std::mutex> guard(orderMutex);
+                    order.push_back(i);
+                }
+                lock->release();
+            }
+        });
+        for (int wait = 0; wait < 200 && holder.queueDepth() < static_cast<size_t>(i + 1); wait++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    EXPECT_EQ(holder.queueDepth(), static_cast<size_t>(numWaiters));
+    holder.release();
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    EXPECT_EQ(order.size(), static_cast<size_t>(numWaiters));
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        EXPECT_EQ(order[i], static_cast<int>(i));
+    }
+
+    // failures back the cooldown off exponentially, successes shrink it
+    EXPECT_TRUE(holder.acquire(1000, 0));
+    holder.release(false);
+    EXPECT_EQ(holder.currentCooldownMs(), SDRplayLock::MIN_BACKOFF_MS);
+    EXPECT_TRUE(holder.acquire(1000, 0));
+    holder.release(false);
+    EXPECT_EQ(holder.currentCooldownMs(), 2 * SDRplayLock::MIN_BACKOFF_MS);
+    for (int i = 0; i < 5; i++)
+    {
+        EXPECT_TRUE(holder.acquire(1000, 0));
+        holder.release(true);
+    }
+    EXPECT_EQ(holder.currentCooldownMs(), 0.0);
+
+    // the guard reports an operation as failed unless marked successful
+    {
+        SDRplayLockGuard guard(holder, 1000, 0);
+    }
+    EXPECT_EQ(holder.currentCooldownMs(), SDRplayLock::MIN_BACKOFF_MS);
+    {
+        SDRplayLockGuard guard(holder, 1000, 0);
+        guard.markSucceeded();
+    }
+    EXPECT_TRUE(holder.currentCooldownMs() < SDRplayLock::MIN_BACKOFF_MS);
+
+    unlink(path.c_str());
+}
+
+static void test_ring_buffer_heartbeat()
+{
+    const std::string name = generateShmName("BEATTEST");
+    std::unique_ptr<SharedRingBuffer> producer(SharedRingBuffer::create(name, 64));
+    EXPECT_TRUE(producer != nullptr);
+    if (!producer)
+    {
+        return;
+    }
+    std::unique_ptr<SharedRingBuffer> consumer(SharedRingBuffer::open(name));
+    EXPECT_TRUE(consumer != nullptr);
+    if (!consumer)
+    {
+        return;
+    }
+
+    // nothing published before a worker attaches
+    EXPECT_EQ(consumer->producerState(), RINGBUF_STATE_NONE);
+    EXPECT_EQ(consumer->heartbeatAgeMs(), -1);
+    EXPECT_EQ(consumer->streamHeartbeatAgeMs(), -1);
+
+    producer->heartbeat(RINGBUF_STATE_STREAMING);
+    producer->streamHeartbeat();
+    EXPECT_EQ(consumer->producerState(), RINGBUF_STATE_STREAMING);
+    EXPECT_TRUE(consumer->heartbeatAgeMs() >= 0 && consumer->heartbeatAgeMs() < 1000);
+
+    // a stalled streaming loop ages independently of the command loop
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    producer->heartbeat(RINGBUF_STATE_STREAMING);
+    EXPECT_TRUE(consumer->streamHeartbeatAgeMs() >= 25);
+    EXPECT_TRUE(consumer->heartbeatAgeMs() < consumer->streamHeartbeatAgeMs());
+
+    producer->heartbeat(RINGBUF_STATE_EXITING);
+    EXPECT_EQ(consumer->producerState(), RINGBUF_STATE_EXITING);
+}
+
+static void test_capability_snapshot()
+{
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+    SoapySDRPlay device(args);
+
+    // round trip through the STATUS_OPENED wire format
+    const DeviceCapabilities caps = DeviceCapabilities::query(device);
+    IPCMessage opened(IPCMessageType::STATUS_OPENED);
+    caps.encode(opened);
+    const DeviceCapabilities copy = DeviceCapabilities::decode(IPCMessage::deserialize(opened.serialize()));
+
+    EXPECT_EQ(caps.numChannels, 1u);
+    EXPECT_EQ(copy.numChannels, caps.numChannels);
+    EXPECT_TRUE(!caps.antennas.empty());
+    EXPECT_TRUE(copy.antennas == caps.antennas);
+    EXPECT_TRUE(copy.gains == caps.gains);
+    EXPECT_EQ(copy.hardwareKey, caps.hardwareKey);
+    EXPECT_TRUE(copy.hardwareInfo == caps.hardwareInfo);
+    EXPECT_EQ(copy.hasGainMode, caps.hasGainMode);
+    EXPECT_NEAR(copy.gainRange.maximum(), caps.gainRange.maximum(), 1e-9);
+    for (const auto &name : caps.gains)
+    {
+        EXPECT_NEAR(copy.elementGainRanges.at(name).maximum(), caps.elementGainRanges.at(name).maximum(), 1e-9);
+    }
+    EXPECT_EQ(copy.frequencyRange.size(), caps.frequencyRange.size());
+    EXPECT_NEAR(copy.frequencyRange.back().maximum(), caps.frequencyRange.back().maximum(), 1e-3);
+    EXPECT_TRUE(copy.sampleRates == caps.sampleRates);
+    EXPECT_TRUE(copy.bandwidths == caps.bandwidths);
+
+    EXPECT_TRUE(!caps.settingInfo.empty());
+    EXPECT_EQ(copy.settingInfo.size(), caps.settingInfo.size());
+    for (size_t i = 0; i < caps.settingInfo.size() && i < copy.settingInfo.size(); i++)
+    {
+        EXPECT_EQ(copy.settingInfo[i].key, caps.settingInfo[i].key);
+        EXPECT_EQ(copy.settingInfo[i].value, caps.settingInfo[i].value);
+        EXPECT_EQ(copy.settingInfo[i].description, caps.settingInfo[i].description);
+        EXPECT_TRUE(copy.settingInfo[i].type == caps.settingInfo[i].type);
+        EXPECT_TRUE(copy.settingInfo[i].options == caps.settingInfo[i].options);
+    }
+}
+
+static void test_ipc_reactor()
+{
+    // many workers' status pipes served by the single reactor thread
+    const size_t numWorkers = 24;
+    std::vector<std::unique_ptr<IPCPipePair>> pairs;
+    std::vector<std::shared_ptr<IPCStatusChannel>> channels;
+    for (size_t i = 0; i < numWorkers; i++)
+    {
+        pairs.emplace_back(IPCPipePair::create());
+        channels.push_back(IPCReactor::instance().attach(pairs.back()->childToParent()->fd()));
+        EXPECT_TRUE(channels.back() != nullptr);
+    }
+    EXPECT_EQ(IPCReactor::instance().channelCount(), numWorkers);
+
+    // asynchronous overflow notices are counted without being read as replies
+    for (size_t i = 0; i < numWorkers; i++)
+    {
+        IPCMessage overflow(IPCMessageType::STATUS_OVERFLOW);
+        overflow.setParam("dropped", static_cast<int64_t>(100 + i));
+        pairs[i]->childSend()->send(overflow);
+        IPCMessage ack(IPCMessageType::STATUS_ACK);
+        ack.setParam("worker", static_cast<int64_t>(i));
+        pairs[i]->childSend()->send(ack);
+    }
+    for (size_t i = 0; i < numWorkers; i++)
+    {
+        IPCMessage reply;
+        EXPECT_TRUE(channels[i]->waitReply(reply, 1000));
+        EXPECT_TRUE(reply.type == IPCMessageType::STATUS_ACK);
+        EXPECT_EQ(reply.getParamInt("worker"), static_cast<int64_t>(i));
+        EXPECT_EQ(channels[i]->overflowEvents(), 1u);
+        EXPECT_EQ(channels[i]->droppedSamples(), 100u + i);
+    }
+
+    // a message larger than the pipe buffer is reassembled from partial reads
+    {
+        IPCMessage big(IPCMessageType::STATUS_STATS);
+        big.setParam("blob", std::string(200000, 'x'));
+        std::thread sender([&]{ pairs[0]->childSend()->send(big, 2000); });
+        IPCMessage reply;
+        EXPECT_TRUE(channels[0]->waitReply(reply, 2000));
+        sender.join();
+        EXPECT_EQ(reply.getParam("blob").size(), 200000u);
+        EXPECT_EQ(channels[0]->lastStats().getParam("blob").size(), 200000u);
+    }
+
+    // a worker that exits closes its end: waiters fail at once
+    pairs[1]->closeChildSide();
+    IPCMessage reply;
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(!channels[1]->waitReply(reply, 5000));
+    EXPECT_TRUE(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+    EXPECT_TRUE(channels[1]->closed());
+    EXPECT_EQ(IPCReactor::instance().channelCount(), numWorkers - 1);
+
+    for (size_t i = 0; i < numWorkers; i++)
+    {
+        IPCReactor::instance().detach(pairs[i]->childToParent()->fd());
+        pairs[i]->closeChildSide();
+    }
+    EXPECT_EQ(IPCReactor::instance().channelCount(), 0u);
+}
+
+static void test_device_metrics()
+{
+    // log2 buckets: 0 below 1 us, then [2^(i-1), 2^i) us
+    EXPECT_EQ(MetricsHistogram::bucketOf(500), 0u);
+    EXPECT_EQ(MetricsHistogram::bucketOf(1000), 1u);
+    EXPECT_EQ(MetricsHistogram::bucketOf(3000), 2u);
+    uint64_t counts[METRICS_HISTOGRAM_BUCKETS] = {};
+    counts[4] = 90;
+    counts[10] = 10;
+    EXPECT_EQ(MetricsHistogram::quantileUs(counts, 0.5), 16u);
+    EXPECT_EQ(MetricsHistogram::quantileUs(counts, 0.99), 1024u);
+
+    std::string name;
+    {
+        SoapySDR::Kwargs args;
+        args["serial"] = "TEST0001";
+        SoapySDRPlay device(args);
+        name = device.readSetting("metrics_page");
+        EXPECT_EQ(name, DeviceMetrics::pageName("TEST0001", getpid()));
+
+        SoapySDR::Stream *stream = device.setupStream(SOAPY_SDR_RX, "CS16");
+        EXPECT_EQ(device.activateStream(stream), 0);
+        auto *playStream = reinterpret_cast<SoapySDRPlay::SoapySDRPlayStream *>(stream);
+
+        // three callbacks, the last one after 100 missing samples
+        short xi[8] = {};
+        short xq[8] = {};
+        sdrplay_api_StreamCbParamsT params{};
+        params.numSamples = 8;
+        {
+            std::lock_guard<std::mutex> lock(playStream->mutex);
+            params.firstSampleNum = 1;
+            device.rx_callback(xi, xq, &params, 8, playStream);
+            params.firstSampleNum = 9;
+            device.rx_callback(xi, xq, &params, 8, playStream);
+            params.firstSampleNum = 117;
+            device.rx_callback(xi, xq, &params, 8, playStream);
+        }
+
+        std::unique_ptr<DeviceMetrics> reader(DeviceMetrics::open(name));
+        EXPECT_TRUE(reader != nullptr);
+        if (reader)
+        {
+            const DeviceMetricsPage *page = reader->page();
+            EXPECT_EQ(page->role, METRICS_ROLE_DRIVER);
+            EXPECT_EQ(std::string(page->serial), std::string("TEST0001"));
+            EXPECT_EQ(page->streaming.load(), 1u);
+            EXPECT_TRUE(reader->ownerAlive());
+            const ChannelMetrics &channel = page->channels[0];
+            EXPECT_EQ(channel.callbacks.load(), 3u);
+            EXPECT_EQ(channel.samples.load(), 24u);
+            EXPECT_EQ(channel.gaps.load(), 1u);
+            EXPECT_EQ(channel.gapSamples.load(), 100u);
+            EXPECT_TRUE(channel.intervalMeanNs.load() > 0);
+            EXPECT_EQ(channel.queueCapacity.load(), static_cast<uint32_t>(DEFAULT_NUM_BUFFERS));
+        }
+#ifdef __linux__
+        const std::vector<std::string> names = DeviceMetrics::list();
+        EXPECT_TRUE(std::find(names.begin(), names.end(), name) != names.end());
+#endif
+
+        device.closeStream(stream);
+        if (reader)
+        {
+            EXPECT_EQ(reader->page()->streaming.load(), 0u);
+        }
+    }
+
+    // the page is removed with the device
+    std::unique_ptr<DeviceMetrics> gone(DeviceMetrics::open(name));
+    EXPECT_TRUE(gone == nullptr);
+
+    // update latency per type; failures are counted apart
+    std::unique_ptr<DeviceMetrics> metrics(DeviceMetrics::create("TEST0041", METRICS_ROLE_PROXY));
+    metrics->recordUpdate(METRICS_UPDATE_GAIN, 2000000, true);
+    metrics->recordUpdate(METRICS_UPDATE_GAIN, 4000000, true);
+    metrics->recordUpdate(METRICS_UPDATE_GAIN, 0, false);
+    const UpdateMetrics &gain = metrics->page()->updates[METRICS_UPDATE_GAIN];
+    EXPECT_EQ(gain.count.load(), 2u);
+    EXPECT_EQ(gain.failures.load(), 1u);
+    EXPECT_EQ(gain.maxNs.load(), 4000000);
+    EXPECT_EQ(gain.totalNs.load(), 6000000u);
+
+    // a second page for the same device in this process stays private
+    std::unique_ptr<DeviceMetrics> second(DeviceMetrics::create("TEST0041", METRICS_ROLE_PROXY));
+    EXPECT_TRUE(second->name().empty());
+    EXPECT_EQ(second->page()->magic.load(), METRICS_MAGIC);
+
+    {
+        ScopedEnvVar disabled("SOAPY_SDRPLAY_METRICS", "0");
+        std::unique_ptr<DeviceMetrics> off(DeviceMetrics::create("TEST0042", METRICS_ROLE_DRIVER));
+        EXPECT_TRUE(off->name().empty());
+    }
+}
+
+static void test_metrics_exporter()
+{
+    std::unique_ptr<DeviceMetrics> metrics(DeviceMetrics::create("TEST0001", METRICS_ROLE_DRIVER));
+    metrics->recordUpdate(METRICS_UPDATE_FREQUENCY, 3000000, true);
+    metrics->channel(0).recordCallback(1000000, 8);
+    metrics->channel(0).recordCallback(2000000, 8);
+
+    const std::string text = MetricsExporter::render();
+    EXPECT_TRUE(text.find("# TYPE sdrplay_callbacks counter") != std::string::npos);
+    EXPECT_TRUE(text.find("sdrplay_callbacks_total{serial=\"TEST0001\",role=\"driver\",channel=\"0\"} 2") != std::string::npos);
+    EXPECT_TRUE(text.find("sdrplay_update_latency_seconds_count{serial=\"TEST0001\",role=\"driver\",type=\"frequency\"} 1") != std::string::npos);
+    EXPECT_TRUE(text.size() >= 6 && text.compare(text.size() - 6, 6, "# EOF\n") == 0);
+
+#ifndef _WIN32
+    // served as HTTP to a GET on a Unix socket
+    const std::string path = "/tmp/soapy_sdrplay_metrics_test_" + std::to_string(getpid()) + ".sock";
+    MetricsExporter &exporter = MetricsExporter::instance();
+    EXPECT_TRUE(exporter.start("unix:" + path));
+    EXPECT_TRUE(exporter.running());
+    EXPECT_EQ(exporter.endpoint(), "unix:" + path);
+
+    std::string response;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0)
+    {
+        const char request[] = "GET /metrics HTTP/1.0\r\n\r\n";
+        EXPECT_TRUE(send(fd, request, sizeof(request) - 1, 0) == static_cast<ssize_t>(sizeof(request) - 1));
+        char buf[4096];
+        ssize_t n;
+        while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+        {
+            response.append(buf, static_cast<size_t>(n));
+        }
+    }
+    close(fd);
+    EXPECT_TRUE(response.compare(0, 15, "HTTP/1.0 200 OK") == 0);
+    EXPECT_TRUE(response.find("application/openmetrics-text") != std::string::npos);
+    EXPECT_TRUE(response.find("# EOF") != std::string::npos);
+
+    // a client that trickles its request and never reads does not hold up stop()
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    std::atomic<bool> dripping{connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0};
+    EXPECT_TRUE(dripping.load());
+    std::thread drip([fd, &dripping]() {
+        for (int i = 0; i < 100 && dripping; i++)
+        {
+            if (send(fd, "G", 1, MSG_NOSIGNAL) != 1)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    const auto stopStart = std::chrono::steady_clock::now();
+    exporter.stop();
+    EXPECT_TRUE(std::chrono::steady_clock::now() - stopStart < std::chrono::milliseconds(1000));
+    dripping = false;
+    drip.join();
+    close(fd);
+    EXPECT_TRUE(!exporter.running());
+    EXPECT_TRUE(access(path.c_str(), F_OK) != 0);
+#endif
+}
+
+static size_t count_occurrences(const std::string &text, const std::string &pattern)
+{
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+    {
+        count++;
+    }
+    return count;
+}
+
+static std::string read_file(const std::string &path)
+{
+    std::ifstream file(path);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void test_tracer()
+{
+    Tracer &tracer = Tracer::instance();
+    EXPECT_TRUE(tracer.writeSetting("trace", "true"));
+    EXPECT_TRUE(Tracer::enabled());
+
+    {
+        TraceScope scope("test_scope", 7);
+        Tracer::instant("test_instant");
+    }
+
+    // a ring that wrapped drops the end whose begin was overwritten
+    std::thread writer([]() {
+        Tracer::setThreadName("test writer");
+        for (size_t i = 0; i < Tracer::TRACE_RING_EVENTS; i++)
+        {
+            TraceScope scope("test_wrap");
+        }
+        Tracer::instant("test_last");
+    });
+    writer.join();
+
+    const std::string json = tracer.render();
+    EXPECT_TRUE(json.compare(0, 15, "{\"displayTimeUn") == 0);
+    EXPECT_TRUE(json.find("{\"name\":\"test_scope\",\"ph\":\"B\"") != std::string::npos);
+    EXPECT_TRUE(json.find("{\"name\":\"test_scope\",\"ph\":\"E\"") != std::string::npos);
+    EXPECT_TRUE(json.find("\"args\":{\"arg\":7}") != std::string::npos);
+    EXPECT_TRUE(json.find("{\"name\":\"test_instant\",\"ph\":\"i\"") != std::string::npos);
+    EXPECT_TRUE(json.find("\"args\":{\"name\":\"test writer\"}") != std::string::npos);
+    const size_t begins = count_occurrences(json, "\"test_wrap\",\"ph\":\"B\"");
+    EXPECT_EQ(begins, Tracer::TRACE_RING_EVENTS / 2 - 1);
+    EXPECT_EQ(count_occurrences(json, "\"test_wrap\",\"ph\":\"E\""), begins);
+    EXPECT_TRUE(json.size() >= 3 && json.compare(json.size() - 3, 3, "]}\n") == 0);
+
+    // disabled: nothing is recorded
+    EXPECT_TRUE(tracer.writeSetting("trace", "false"));
+    std::string value;
+    EXPECT_TRUE(tracer.readSetting("trace", value));
+    EXPECT_EQ(value, "false");
+    Tracer::instant("test_disabled");
+    {
+        TraceScope scope("test_disabled");
+    }
+    EXPECT_TRUE(tracer.render().find("test_disabled") == std::string::npos);
+
+    // dumps
+    const std::string path = "test-config/trace.json";
+    EXPECT_TRUE(tracer.writeSetting("trace_dump", path));
+    EXPECT_TRUE(read_file(path).find("test_scope") != std::string::npos);
+    EXPECT_TRUE(!tracer.dump("test-config/missing/trace.json"));
+    EXPECT_TRUE(!tracer.readSetting("metrics_export", value));
+
+    EXPECT_EQ(Tracer::workerPath("/tmp/trace.json"), "/tmp/trace-worker.json");
+    EXPECT_EQ(Tracer::workerPath("/tmp.d/trace"), "/tmp.d/trace-worker");
+    EXPECT_EQ(Tracer::workerPath("trace"), "trace-worker");
+}
+
+#ifdef SOAPYSDRPLAY_MOCK_API
+static void test_mock_streaming()
+{
+    MockStreamConfig config;
+    config.enabled = true;
+    config.samplesPerCallback = 1008;
+    config.gapEvery = 50;
+    config.gapSamples = 100;
+    mock_sdrplay_set_stream_config(config);
+
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+    SoapySDRPlay device(args);
+    device.setSampleRate(SOAPY_SDR_RX, 0, 2e6);
+    SoapySDR::Stream *stream = device.setupStream(SOAPY_SDR_RX, "CS16");
+    EXPECT_EQ(device.activateStream(stream), 0);
+
+    // the generator's callbacks go through rx_callback to readStream
+    std::vector<short> buff(2 * 4096);
+    void *buffs[] = { buff.data() };
+    size_t received = 0;
+    bool nonZero = false;
+    for (int i = 0; i < 200 && received < 200000; i++)
+    {
+        int flags = 0;
+        long long timeNs = 0;
+        const int ret = device.readStream(stream, buffs, 4096, flags, timeNs, 100000);
+        if (ret > 0)
+        {
+            received += static_cast<size_t>(ret);
+            nonZero = nonZero || std::any_of(buff.begin(), buff.begin() + 2 * ret, [](short v) { return v != 0; });
+        }
+    }
+    EXPECT_TRUE(received >= 200000);
+    EXPECT_TRUE(nonZero);
+    const MockStreamStats stats = mock_sdrplay_stream_stats("TEST0001");
+    EXPECT_TRUE(stats.streaming);
+    EXPECT_TRUE(stats.gaps > 0);
+
+    // a sample rate change is confirmed with fsChanged, well before the
+    // update timeout
+    device.setSampleRate(SOAPY_SDR_RX, 0, 4e6);
+    std::unique_ptr<DeviceMetrics> reader(DeviceMetrics::open(device.readSetting("metrics_page")));
+    EXPECT_TRUE(reader != nullptr);
+    if (reader)
+    {
+        const UpdateMetrics &rate = reader->page()->updates[METRICS_UPDATE_SAMPLE_RATE];
+        EXPECT_TRUE(rate.count.load() >= 1u);
+        EXPECT_TRUE(rate.maxNs.load() < 100000000);
+        EXPECT_TRUE(reader->page()->channels[0].gaps.load() > 0u);
+    }
+
+    // DeviceRemoved ends the stream
+    EXPECT_TRUE(mock_sdrplay_remove_device("TEST0001"));
+    int ret = 0;
+    for (int i = 0; i < 100 && ret != SOAPY_SDR_NOT_SUPPORTED; i++)
+    {
+        int flags = 0;
+        long long timeNs = 0;
+        ret = device.readStream(stream, buffs, 4096, flags, timeNs, 100000);
+    }
+    EXPECT_EQ(ret, SOAPY_SDR_NOT_SUPPORTED);
+    EXPECT_EQ(mock_sdrplay_stream_stats("TEST0001").events, 1u);
+
+    device.closeStream(stream);
+    EXPECT_TRUE(!mock_sdrplay_stream_stats("TEST0001").streaming);
+    mock_sdrplay_set_stream_config(MockStreamConfig());
+}
+
+static void test_mock_faults()
+{
+    MockStreamConfig config;
+    config.enabled = true;
+    mock_sdrplay_set_stream_config(config);
+
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+    SoapySDRPlay device(args);
+    WatchdogConfig watchdog = device.getWatchdogConfig();
+    watchdog.callbackTimeoutMs = 300;
+    watchdog.healthCheckIntervalMs = 100;
+    watchdog.restartServiceOnFailure = false;
+    device.setWatchdogConfig(watchdog);
+    std::atomic<bool> stale{false};
+    device.registerHealthCallback([&stale](DeviceHealthStatus status) {
+        if (status == DeviceHealthStatus::Stale)
+        {
+            stale = true;
+        }
+    });
+    SoapySDR::Stream *stream = device.setupStream(SOAPY_SDR_RX, "CS16");
+    EXPECT_EQ(device.activateStream(stream), 0);
+
+    // failed updates are counted, then the API accepts them again
+    MockFaults faults;
+    faults.updateErrors = 2;
+    mock_sdrplay_set_faults(faults);
+    const double frequency = device.getFrequency(SOAPY_SDR_RX, 0);
+    for (int i = 1; i <= 3; i++)
+    {
+        device.setFrequency(SOAPY_SDR_RX, 0, frequency + i * 1e6);
+    }
+    EXPECT_EQ(mock_sdrplay_faults().updateErrors, 0u);
+    std::unique_ptr<DeviceMetrics> reader(DeviceMetrics::open(device.readSetting("metrics_page")));
+    if (reader)
+    {
+        const UpdateMetrics &updates = reader->page()->updates[METRICS_UPDATE_FREQUENCY];
+        EXPECT_EQ(updates.failures.load(), 2u);
+        EXPECT_EQ(updates.count.load(), 1u);
+    }
+
+    // stalled callbacks make the watchdog flag the stream, and closing it
+    // from the health callback's notification must not wait on the
+    // watchdog's recovery attempt
+    mock_sdrplay_stall_callbacks("TEST0001", 0);
+    std::vector<short> buff(2 * 4096);
+    void *buffs[] = { buff.data() };
+    for (int i = 0; i < 40 && !stale; i++)
+    {
+        int flags = 0;
+        long long timeNs = 0;
+        device.readStream(stream, buffs, 4096, flags, timeNs, 50000);
+    }
+    EXPECT_TRUE(stale.load());
+    const MockStreamStats stats = mock_sdrplay_stream_stats("TEST0001");
+    EXPECT_EQ(stats.stalls, 1u);
+    EXPECT_TRUE(stats.stalled);
+    device.closeStream(stream);
+    EXPECT_TRUE(!mock_sdrplay_stream_stats("TEST0001").streaming);
+
+    mock_sdrplay_set_faults(MockFaults());
+    mock_sdrplay_set_stream_config(MockStreamConfig());
+}
+
+static void test_mock_trace()
+{
+    MockStreamConfig config;
+    config.enabled = true;
+    mock_sdrplay_set_stream_config(config);
+
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+    SoapySDRPlay device(args);
+    device.writeSetting("trace", "true");
+    EXPECT_EQ(device.readSetting("trace"), "true");
+    SoapySDR::Stream *stream = device.setupStream(SOAPY_SDR_RX, "CS16");
+    EXPECT_EQ(device.activateStream(stream), 0);
+
+    std::vector<short> buff(2 * 4096);
+    void *buffs[] = { buff.data() };
+    int flags = 0;
+    long long timeNs = 0;
+    for (int i = 0; i < 20; i++)
+    {
+        device.readStream(stream, buffs, 4096, flags, timeNs, 100000);
+    }
+    device.setFrequency(SOAPY_SDR_RX, 0, device.getFrequency(SOAPY_SDR_RX, 0) + 1e6);
+
+    const std::string path = "test-config/trace_stream.json";
+    device.writeSetting("trace_dump", path);
+    const std::string json = read_file(path);
+    EXPECT_TRUE(json.find("\"rx_callback\",\"ph\":\"B\"") != std::string::npos);
+    EXPECT_TRUE(json.find("\"buffer_ready\",\"ph\":\"i\"") != std::string::npos);
+    EXPECT_TRUE(json.find("\"read_wait\",\"ph\":\"E\"") != std::string::npos);
+    EXPECT_TRUE(json.find("\"Tuner_Frf\",\"ph\":\"B\"") != std::string::npos);
+
+    // the armed dump is written once, at the next overflow
+    const std::string overflowPath = "test-config/trace_overflow.json";
+    device.writeSetting("trace_overflow_dump", overflowPath);
+    EXPECT_EQ(device.readSetting("trace_overflow_dump"), overflowPath);
+    int ret = 0;
+    for (int i = 0; i < 20 && ret != SOAPY_SDR_OVERFLOW; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        ret = device.readStream(stream, buffs, 4096, flags, timeNs, 100000);
+    }
+    EXPECT_EQ(ret, SOAPY_SDR_OVERFLOW);
+    EXPECT_TRUE(read_file(overflowPath).find("\"overflow\",\"ph\":\"i\"") != std::string::npos);
+    EXPECT_EQ(device.readSetting("trace_overflow_dump"), "");
+
+    device.closeStream(stream);
+    device.writeSetting("trace", "false");
+    mock_sdrplay_set_stream_config(MockStreamConfig());
+}
+#endif
+
+// RSPduo dual tuner mode through a proxy: the worker streams both tuners
+// and the two rings carry the same sample times (the mock sends the same
+// tone to both tuners, so the channels are identical)
+static void test_proxy_dual_tuner(const std::string &workerPath)
+{
+    ScopedEnvVar worker("SOAPY_SDRPLAY_WORKER", workerPath);
+    ScopedEnvVar stream("SOAPY_SDRPLAY_MOCK_STREAM", "dual=1");
+    ScopedEnvVar rspduo("SOAPY_SDRPLAY_MOCK_RSPDUO", "TEST0002");
+
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0002";
+    args["mode"] = "DT";
+    size_t samples[2] = {0, 0};
+    bool identical = true;
+    try
+    {
+        SoapySDRPlayProxy proxy(args);
+        EXPECT_EQ(proxy.getNumChannels(SOAPY_SDR_RX), 2u);
+        SoapySDR::Stream *rxStream = proxy.setupStream(SOAPY_SDR_RX, "CS16", {0, 1});
+        EXPECT_EQ(proxy.activateStream(rxStream), 0);
+
+        std::vector<short> buffA(2 * 8192), buffB(2 * 8192);
+        void *buffs[] = { buffA.data(), buffB.data() };
+        for (int i = 0; i < 50 && samples[0] < 100000; i++)
+        {
+            int flags = 0;
+            long long timeNs = 0;
+            const int ret = proxy.readStream(rxStream, buffs, 8192, flags, timeNs, 200000);
+            if (ret <= 0)
+            {
+                continue;
+            }
+            const size_t n = static_cast<size_t>(ret);
+            samples[0] += n;
+            samples[1] += static_cast<size_t>(std::count_if(buffB.begin(), buffB.begin() + 2 * n,
+                                                            [](short v) { return v != 0; })) / 2;
+            identical = identical && std::equal(buffA.begin(), buffA.begin() + 2 * n, buffB.begin());
+        }
+        proxy.deactivateStream(rxStream);
+        proxy.closeStream(rxStream);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "proxy: " << ex.what() << std::endl;
+    }
+
+    EXPECT_TRUE(samples[0] >= 100000);
+    EXPECT_TRUE(samples[1] > 0);
+    EXPECT_TRUE(identical);
+}
+
+// A gap in the ring is reported once through the direct buffer API as well,
+// before the samples after it (the test marks it as a restarted worker would)
+static void test_proxy_direct_buffer_gap(const std::string &workerPath)
+{
+    ScopedEnvVar worker("SOAPY_SDRPLAY_WORKER", workerPath);
+    ScopedEnvVar stream("SOAPY_SDRPLAY_MOCK_STREAM", "1");
+
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+    int overflows = 0;
+    size_t samplesAfter = 0;
+    std::string lost;
+    try
+    {
+        SoapySDRPlayProxy proxy(args);
+        SoapySDR::Stream *rxStream = proxy.setupStream(SOAPY_SDR_RX, "CF32");
+        EXPECT_EQ(proxy.activateStream(rxStream), 0);
+        SharedRingBuffer *ring = reinterpret_cast<SoapySDRPlayProxyStream *>(rxStream)->ringBuffer;
+
+        bool marked = false;
+        for (int i = 0; i < 200 && samplesAfter < 100000; i++)
+        {
+            size_t handle = 0;
+            const void *buffs[1] = { nullptr };
+            int flags = 0;
+            long long timeNs = 0;
+            const int ret = proxy.acquireReadBuffer(rxStream, handle, buffs, flags, timeNs, 200000);
+            if (ret == SOAPY_SDR_OVERFLOW)
+            {
+                overflows++;
+                continue;
+            }
+            if (ret <= 0)
+            {
+                continue;
+            }
+            proxy.releaseReadBuffer(rxStream, handle);
+            if (!marked)
+            {
+                ring->markGap(1234);
+                marked = true;
+            }
+            else if (overflows > 0)
+            {
+                samplesAfter += static_cast<size_t>(ret);
+            }
+        }
+        lost = proxy.readSetting("lost_samples");
+        proxy.deactivateStream(rxStream);
+        proxy.closeStream(rxStream);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "proxy: " << ex.what() << std::endl;
+    }
+
+    EXPECT_EQ(overflows, 1);
+    EXPECT_TRUE(samplesAfter >= 100000);
+    EXPECT_EQ(lost, "1234");
+}
+
+// The proxy's gain ranges follow the LNA band of the frequency the worker is
+// tuned to (the mock is an RSPdx-R2: 27 LNA states up to 250 MHz, 19 above
+// 1 GHz); the first range comes with the configure, the second with the retune
+static void test_proxy_gain_range_retune(const std::string &workerPath)
+{
+    ScopedEnvVar worker("SOAPY_SDRPLAY_WORKER", workerPath);
+
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+    SoapySDR::Range rfgr[2], total[2];
+    try
+    {
+        SoapySDRPlayProxy proxy(args);
+        proxy.setFrequency(SOAPY_SDR_RX, 0, 100e6);
+        rfgr[0] = proxy.getGainRange(SOAPY_SDR_RX, 0, "RFGR");
+        total[0] = proxy.getGainRange(SOAPY_SDR_RX, 0);
+        proxy.setFrequency(SOAPY_SDR_RX, 0, 1500e6);
+        rfgr[1] = proxy.getGainRange(SOAPY_SDR_RX, 0, "RFGR");
+        total[1] = proxy.getGainRange(SOAPY_SDR_RX, 0);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "proxy: " << ex.what() << std::endl;
+    }
+
+    EXPECT_EQ(rfgr[0].maximum(), 26.0);
+    EXPECT_EQ(total[0].maximum(), 84.0 + 39.0);
+    EXPECT_EQ(rfgr[1].maximum(), 18.0);
+    EXPECT_EQ(total[1].maximum(), 65.0 + 39.0);
+}
+
+// Stream CS16 from a proxy device; returns the number of samples read
+static size_t read_proxy_samples(SoapySDRPlayProxy &proxy, size_t wanted)
+{
+    size_t samples = 0;
+    SoapySDR::Stream *rxStream = proxy.setupStream(SOAPY_SDR_RX, "CS16");
+    if (proxy.activateStream(rxStream) == 0)
+    {
+        std::vector<short> buff(2 * 8192);
+        void *buffs[] = { buff.data() };
+        for (int i = 0; i < 50 && samples < wanted; i++)
+        {
+            int flags = 0;
+            long long timeNs = 0;
+            const int ret = proxy.readStream(rxStream, buffs, 8192, flags, timeNs, 200000);
+            if (ret > 0)
+            {
+                samples += static_cast<size_t>(ret);
+            }
+        }
+        proxy.deactivateStream(rxStream);
+    }
+    proxy.closeStream(rxStream);
+    return samples;
+}
+
+// SOAPY_SDRPLAY_WORKER_POOL=1: a proxy takes the warm worker from the pool,
+// assigns it the device (CMD_ASSIGN) and the pool spawns the next one. A
+// pooled worker that died is dropped and the proxy spawns its own instead.
+static void test_worker_pool(const std::string &workerPath)
+{
+    ScopedEnvVar worker("SOAPY_SDRPLAY_WORKER", workerPath);
+    ScopedEnvVar stream("SOAPY_SDRPLAY_MOCK_STREAM", "1");
+    ScopedEnvVar pool("SOAPY_SDRPLAY_WORKER_POOL", "1");
+
+    SoapySDR::Kwargs args;
+    args["serial"] = "TEST0001";
+
+    WorkerPool::instance().fill();
+    std::vector<pid_t> warm = WorkerPool::instance().idlePids();
+    EXPECT_EQ(warm.size(), 1u);
+    if (warm.size() != 1)
+    {
+        return;
+    }
+    try
+    {
+        SoapySDRPlayProxy proxy(args);
+        EXPECT_TRUE(read_proxy_samples(proxy, 100000) >= 100000);
+        EXPECT_EQ(proxy.readSetting("worker_pid"), std::to_string(warm[0]));
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "proxy: " << ex.what() << std::endl;
+    }
+
+    // kill the refill before the next open (waiting for its exit, without
+    // reaping it)
+    warm = WorkerPool::instance().idlePids();
+    EXPECT_EQ(warm.size(), 1u);
+    if (warm.size() != 1)
+    {
+        return;
+    }
+    kill(warm[0], SIGKILL);
+    siginfo_t info;
+    waitid(P_PID, static_cast<id_t>(warm[0]), &info, WEXITED | WNOWAIT);
+    try
+    {
+        SoapySDRPlayProxy proxy(args);
+        EXPECT_TRUE(read_proxy_samples(proxy, 100000) >= 100000);
+        const std::string pid = proxy.readSetting("worker_pid");
+        EXPECT_TRUE(pid != std::to_string(warm[0]) && pid != "-1");
+        // a spawned worker does not refill the pool
+        EXPECT_TRUE(WorkerPool::instance().idlePids().empty());
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "proxy: " << ex.what() << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
 {
     std::string baseDir = "test-config";
     create_dir(baseDir);
@@ -400,6 +1913,36 @@ int main()
     test_readStream_timeout_when_inactive();
     test_stream_read_cs16();
     test_stream_read_cf32();
+    test_hybrid_tuning_nco();
+    test_sweep_engine();
+    test_timed_commands();
+    test_finite_burst();
+    test_hot_standby();
+    test_worker_pool_size();
+    test_ring_buffer_gap_marker();
+    test_ring_buffer_heartbeat();
+    test_channel_shm_names();
+    test_ipc_reactor();
+    test_capability_snapshot();
+    test_sdrplay_lock_fifo();
+    test_enumeration_cache();
+    test_broker_protocol();
+    test_device_metrics();
+    test_metrics_exporter();
+    test_tracer();
+#ifdef SOAPYSDRPLAY_MOCK_API
+    test_mock_streaming();
+    test_mock_faults();
+    test_mock_trace();
+    // the worker built against the mock, for the proxy tests
+    if (argc > 1)
+    {
+        test_proxy_dual_tuner(argv[1]);
+        test_proxy_gain_range_retune(argv[1]);
+        test_proxy_direct_buffer_gap(argv[1]);
+        test_worker_pool(argv[1]);
+    }
+#endif
 
     if (g_stats.failed != 0)
     {